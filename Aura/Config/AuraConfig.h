@@ -28,6 +28,15 @@
 // #define ORBIS_TASK_MANAGER
 #endif
 
+// Built-in aura::alloc/aura::dealloc. Only enable if the host doesn't define them. Off by default since hosts normally
+// route Aura allocations through their own allocator, the headless tests in ./Tests turn it on.
+// #define ENABLE_DEFAULT_MEMORY_MANAGER
+
+#if defined(__linux__) || defined(__APPLE__)
+// Built-in pthread work-stealing task manager, see initDefaultTaskManager
+#define ENABLE_DEFAULT_TASK_MANAGER
+#endif
+
 #if USE_COMPUTE_SHADERS
 #define RESOURCE_STATE_LPV RESOURCE_STATE_UNORDERED_ACCESS
 #else
@@ -53,6 +53,9 @@ struct LightPropagationVolumeParams
     float    fSpecPow;
     float    fFresnel;
     uint32_t userDebug;
+    //	Per-cascade grid resolution: 16, 24, 32, 48 or 64. 0 uses the default GridRes. Read by initAura.
+    //	Last, so hosts that brace-initialize the fields above are unaffected.
+    uint32_t iGridRes[3];
 };
 
 struct ScreenSpaceGIParams
@@ -64,9 +67,17 @@ struct ScreenSpaceGIParams
 
 struct CPUPropagationParams
 {
-    MTTypes eMTMode;
-    bool    bDecoupled;
-    bool    bAdvancedDirections;
+    MTTypes  eMTMode;
+    bool     bDecoupled;
+    bool     bAdvancedDirections;
+    //	Decoupled mode: minimum number of frames between launching a propagation and applying its result.
+    //	The result is applied later if the propagation hasn't finished yet.
+    uint32_t uDecoupledLatency;
+    //	Grid slices per propagation task. 0 picks the size from the worker count and the measured cost of a slice.
+    uint32_t uSlicesPerTask;
+    //	Reuse the last result while the injected light doesn't change and only propagate the change of the light when it
+    //	changes a little. Needs twice the CPU grid memory.
+    bool     bIncremental;
 };
 
 struct Params
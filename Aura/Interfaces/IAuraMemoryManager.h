@@ -11,6 +11,8 @@
 #ifndef __AURAMEMORYMANAGER_H_D70DE54E_FCDE_44B9_A627_3B56D1457959_INCLUDED__
 #define __AURAMEMORYMANAGER_H_D70DE54E_FCDE_44B9_A627_3B56D1457959_INCLUDED__
 
+#include "../Config/AuraConfig.h"
+
 #if defined(_WIN32) || defined(__WIN32) || defined(__linux__) || defined(NX64)
 // For conf_alloca().
 #include <malloc.h>
@@ -18,12 +20,54 @@
 // #include <conf_alloca.h>
 #endif
 
+#include <stdint.h>
 #include <stdlib.h>
 
 namespace aura
 {
+//	Provided by the host unless ENABLE_DEFAULT_MEMORY_MANAGER is defined
 void* alloc(size_t size);
 void  dealloc(void* ptr);
+
+struct MemoryStats
+{
+    size_t   mLiveBytes;       //	Requested bytes currently allocated
+    size_t   mPeakBytes;       //	Highest mLiveBytes so far
+    size_t   mReservedBytes;   //	Bytes held from the system to serve the live allocations
+    uint32_t mLiveAllocations;
+    float    mFragmentation;   //	Share of mReservedBytes that doesn't back live allocations
+};
+
+//	Linear arena for long-lived storage such as the CPU propagation grids. Allocations are 64-byte aligned.
+//	Memory is reused only once every allocation has been freed. Not thread-safe.
+struct LinearArena
+{
+    uint8_t* pBase;
+    void*    pAllocation;
+    size_t   mCapacity;
+    size_t   mOffset;
+    size_t   mPeakOffset;
+    size_t   mLiveBytes;
+    uint32_t mLiveAllocations;
+};
+
+static const size_t ARENA_ALIGNMENT = 64;
+
+void  initLinearArena(size_t capacity, LinearArena* pArena);
+void  exitLinearArena(LinearArena* pArena);
+//	Returns NULL when the arena is exhausted
+void* arenaAlloc(LinearArena* pArena, size_t size);
+void  arenaDealloc(LinearArena* pArena, void* ptr, size_t size);
+bool  arenaOwns(const LinearArena* pArena, const void* ptr);
+void  getLinearArenaStats(const LinearArena* pArena, MemoryStats* pStats);
+
+#ifdef ENABLE_DEFAULT_MEMORY_MANAGER
+//	Statistics of the built-in alloc/dealloc: small requests come from thread-safe fixed size pools,
+//	larger ones from the system heap with 64-byte alignment.
+void getMemoryStats(MemoryStats* pStats);
+//	Returns pool chunks without live allocations to the system. exitAura calls it, pools grow again on demand.
+void trimMemoryPools();
+#endif
 } // namespace aura
 
-#endif //__AURAMEMORYMANAGER_H_D70DE54E_FCDE_44B9_A627_3B56D1457959_INCLUDED__
\ No newline at end of file
+#endif //__AURAMEMORYMANAGER_H_D70DE54E_FCDE_44B9_A627_3B56D1457959_INCLUDED__
@@ -38,10 +38,20 @@ public:
     virtual void waitForTaskSet(ITASKSETHANDLE hTaskSet) = 0;
     virtual bool isTaskDone(ITASKSETHANDLE hTaskSet) = 0;
     virtual void waitAll() = 0;
+    //	Number of threads executing tasks, including a thread that helps while waiting. 0 if unknown.
+    virtual uint32_t getThreadCount() { return 0; }
 };
 
 void initTaskManager(ITaskManager** ppTaskManager);
 void removeTaskManager(ITaskManager* pTaskManager);
+
+#ifdef ENABLE_DEFAULT_TASK_MANAGER
+//	Reference implementation backed by a fixed pool of worker threads with per-worker deques and work stealing.
+//	Threads waiting in waitForTaskSet/waitAll execute queued tasks instead of idling.
+//	workerCount == 0 uses one worker per hardware thread minus the calling thread.
+void initDefaultTaskManager(uint32_t workerCount, ITaskManager** ppTaskManager);
+void removeDefaultTaskManager(ITaskManager* pTaskManager);
+#endif
 } // namespace aura
 
 #endif //__AURATASKMANAGER_H_9E2034BB_D65C_4EAE_9621_057ACCF12866_INCLUDED__
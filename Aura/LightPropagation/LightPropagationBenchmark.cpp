@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "LightPropagationBenchmark.h"
+
+#include "LightPropagationCPUContext.h"
+
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+#define NO_FSL_DEFINITIONS
+#include "../Shaders/FSL/lightPropagation.h"
+
+namespace aura
+{
+static uint32_t nextRandom(uint32_t* pState)
+{
+    //	xorshift32, state must not be 0
+    uint32_t x = *pState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *pState = x;
+    return x;
+}
+
+static float nextRandomFloat(uint32_t* pState) { return (float)(nextRandom(pState) >> 8) * (1.0f / 16777216.0f); }
+
+//	Lit cells get a cosine lobe pointing in a random direction, channels differ in intensity only.
+//	Only cells in the box of lightExtent at the grid center can be lit.
+static void injectSyntheticLight(LightPropagationCPUContext* pContext, float lightDensity, float lightExtent, uint32_t seed)
+{
+    const uint32_t gridRes = pContext->getGridRes();
+    const uint32_t cellCount = gridRes * gridRes * gridRes;
+    const float    channelScale[3] = { 1.0f, 0.8f, 0.6f };
+
+    const uint32_t boxSize = max(1U, (uint32_t)(lightExtent * gridRes + 0.5f));
+    const uint32_t boxMin = (gridRes - min(boxSize, gridRes)) / 2;
+    const uint32_t boxMax = boxMin + min(boxSize, gridRes);
+
+    for (uint32_t c = 0; c < 3; ++c)
+        memset(pContext->getCPUGrid(c), 0, cellCount * sizeof(vec4));
+
+    uint32_t state = seed ? seed : 1;
+    for (uint32_t cell = 0; cell < cellCount; ++cell)
+    {
+        const uint32_t i = cell / (gridRes * gridRes);
+        const uint32_t j = (cell / gridRes) % gridRes;
+        const uint32_t k = cell % gridRes;
+        if (i < boxMin || i >= boxMax || j < boxMin || j >= boxMax || k < boxMin || k >= boxMax)
+            continue;
+
+        if (nextRandomFloat(&state) >= lightDensity)
+            continue;
+
+        float       x = nextRandomFloat(&state) * 2.0f - 1.0f;
+        float       y = nextRandomFloat(&state) * 2.0f - 1.0f;
+        float       z = nextRandomFloat(&state) * 2.0f - 1.0f;
+        const float len = sqrtf(x * x + y * y + z * z);
+        if (len > 1e-3f)
+        {
+            x /= len;
+            y /= len;
+            z /= len;
+        }
+        else
+        {
+            x = 0.0f;
+            y = 0.0f;
+            z = 1.0f;
+        }
+
+        const float intensity = 0.5f + nextRandomFloat(&state);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            const float scale = intensity * channelScale[c];
+            //	Same band order as SHRotate
+            pContext->getCPUGrid(c)[cell] = vec4(0.886227f * scale, -1.023328f * y * scale, 1.023328f * z * scale, -1.023328f * x * scale);
+        }
+    }
+}
+
+//	Scales the light of a few cells at the grid center, like a flickering light
+static void changeSyntheticLight(LightPropagationCPUContext* pContext, float scale)
+{
+    const uint32_t gridRes = pContext->getGridRes();
+    const uint32_t boxMin = gridRes / 2 - 2;
+    const uint32_t boxMax = gridRes / 2 + 2;
+
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        vec4* pGrid = pContext->getCPUGrid(c);
+        for (uint32_t i = boxMin; i < boxMax; ++i)
+            for (uint32_t j = boxMin; j < boxMax; ++j)
+                for (uint32_t k = boxMin; k < boxMax; ++k)
+                    pGrid[(i * gridRes + j) * gridRes + k] *= scale;
+    }
+}
+
+//	Relative to pReference, over all channels
+static double getRelativeError(const LightPropagationCPUContext* pContext, const vec4* pReference)
+{
+    const uint32_t gridRes = pContext->getGridRes();
+    const uint32_t cellCount = gridRes * gridRes * gridRes;
+
+    double error = 0.0;
+    double norm = 0.0;
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        const vec4* pGrid = pContext->getCPUGrid(c);
+        for (uint32_t cell = 0; cell < cellCount; ++cell)
+        {
+            const vec4 reference = pReference[c * cellCount + cell];
+            const vec4 delta = pGrid[cell] - reference;
+            error += dot(delta, delta);
+            norm += dot(reference, reference);
+        }
+    }
+    return norm > 0.0 ? sqrt(error / norm) : sqrt(error);
+}
+
+static double getAccumulatedLight(const LightPropagationCPUContext* pContext)
+{
+    const uint32_t gridRes = pContext->getGridRes();
+    const uint32_t cellCount = gridRes * gridRes * gridRes;
+
+    double sum = 0.0;
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        const vec4* pGrid = pContext->getCPUGrid(c);
+        for (uint32_t cell = 0; cell < cellCount; ++cell)
+            sum += pGrid[cell].x;
+    }
+    return sum;
+}
+
+//	changeLight scales the light at the grid center by a different amount in every iteration
+static void measurePropagation(const CPUPropagationBenchmarkDesc* pDesc, LightPropagationCPUContext* pContext, ITaskManager* pTaskManager,
+                               MTTypes mtMode, float lightExtent, bool changeLight, float* pAvgMs, float* pMinMs, float* pMaxMs)
+{
+    const uint32_t totalIterations = pDesc->mWarmupIterations + pDesc->mIterations;
+
+    double totalMs = 0.0;
+    float  minMs = 0.0f;
+    float  maxMs = 0.0f;
+    for (uint32_t it = 0; it < totalIterations; ++it)
+    {
+        //	Propagation leaves the accumulated light in the source grids
+        injectSyntheticLight(pContext, pDesc->mLightDensity, lightExtent, pDesc->mSeed);
+        if (changeLight)
+            changeSyntheticLight(pContext, 1.0f + 0.01f * (float)(it % 8));
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        pContext->propagate(pTaskManager, mtMode);
+        const float ms = (float)std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (it < pDesc->mWarmupIterations)
+            continue;
+
+        totalMs += ms;
+        minMs = (it == pDesc->mWarmupIterations) ? ms : min(minMs, ms);
+        maxMs = max(maxMs, ms);
+    }
+
+    *pAvgMs = pDesc->mIterations ? (float)(totalMs / pDesc->mIterations) : 0.0f;
+    *pMinMs = minMs;
+    *pMaxMs = maxMs;
+}
+
+static void runConfiguration(const CPUPropagationBenchmarkDesc* pDesc, LightPropagationCPUContext* pContext, ITaskManager* pTaskManager,
+                             MTTypes mtMode, float lightExtent, CPUPropagationBenchmarkResult* pResult)
+{
+    float avgMs = 0.0f;
+    float minMs = 0.0f;
+    float maxMs = 0.0f;
+
+    pContext->setSparsePropagation(false);
+    measurePropagation(pDesc, pContext, pTaskManager, mtMode, lightExtent, false, &avgMs, &minMs, &maxMs);
+    const float  denseMs = avgMs;
+    const double denseLight = getAccumulatedLight(pContext);
+
+    //	Incremental measurements below overwrite the sparse results
+    pContext->setSparsePropagation(true);
+    measurePropagation(pDesc, pContext, pTaskManager, mtMode, lightExtent, false, &avgMs, &minMs, &maxMs);
+    //	Sparse propagation has to give the same result
+    const double sparseLight = getAccumulatedLight(pContext);
+    const bool   sparseMatchesDense = sparseLight == denseLight;
+    const float  occupancy = pContext->getPropagationOccupancy();
+
+    //	The first propagation fills the cache, unchanged light then reuses the result of the full propagation
+    float unusedMs = 0.0f;
+    float staticMs = 0.0f;
+    pContext->setIncrementalPropagation(true);
+    injectSyntheticLight(pContext, pDesc->mLightDensity, lightExtent, pDesc->mSeed);
+    pContext->propagate(pTaskManager, mtMode);
+    measurePropagation(pDesc, pContext, pTaskManager, mtMode, lightExtent, false, &staticMs, &unusedMs, &unusedMs);
+    const bool staticMatchesFull = getAccumulatedLight(pContext) == sparseLight;
+
+    //	Includes the full propagations that limit the error of consecutive delta propagations
+    float changedMs = 0.0f;
+    measurePropagation(pDesc, pContext, pTaskManager, mtMode, lightExtent, true, &changedMs, &unusedMs, &unusedMs);
+
+    //	Full propagation of the light of the last iteration
+    const uint32_t gridRes = pContext->getGridRes();
+    const size_t   gridSize = (size_t)gridRes * gridRes * gridRes * sizeof(vec4);
+    vec4*          pIncremental = (vec4*)aura::alloc(3 * gridSize);
+    for (uint32_t c = 0; c < 3; ++c)
+        memcpy((uint8_t*)pIncremental + c * gridSize, pContext->getCPUGrid(c), gridSize);
+
+    const uint32_t lastIteration = pDesc->mWarmupIterations + pDesc->mIterations - 1;
+    pContext->setIncrementalPropagation(false);
+    injectSyntheticLight(pContext, pDesc->mLightDensity, lightExtent, pDesc->mSeed);
+    changeSyntheticLight(pContext, 1.0f + 0.01f * (float)(lastIteration % 8));
+    pContext->propagate(pTaskManager, mtMode);
+
+    vec4* pFull = (vec4*)aura::alloc(3 * gridSize);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        memcpy((uint8_t*)pFull + c * gridSize, pContext->getCPUGrid(c), gridSize);
+        memcpy(pContext->getCPUGrid(c), (uint8_t*)pIncremental + c * gridSize, gridSize);
+    }
+    const float incrementalError = (float)getRelativeError(pContext, pFull);
+    aura::dealloc(pFull);
+    aura::dealloc(pIncremental);
+
+    const double   cellUpdates = 3.0 * gridRes * gridRes * gridRes * pDesc->mPropagationSteps;
+
+    pResult->eMTMode = mtMode;
+    pResult->mThreadCount = (mtMode == MT_None) ? 1 : pTaskManager->getThreadCount();
+    pResult->mPropagationSteps = pDesc->mPropagationSteps;
+    pResult->mPropagationMs = avgMs;
+    pResult->mMinPropagationMs = minMs;
+    pResult->mMaxPropagationMs = maxMs;
+    pResult->mStepMs = pDesc->mPropagationSteps ? avgMs / pDesc->mPropagationSteps : 0.0f;
+    pResult->mCellsPerSecond = avgMs > 0.0f ? cellUpdates * 1000.0 / avgMs : 0.0;
+    pResult->mSpeedup = 1.0f;
+    pResult->mAccumulatedLight = sparseLight;
+    pResult->mLightExtent = lightExtent;
+    pResult->mOccupancy = occupancy;
+    pResult->mDensePropagationMs = denseMs;
+    pResult->mSparseSpeedup = avgMs > 0.0f ? denseMs / avgMs : 0.0f;
+    pResult->mStaticLightMs = staticMs;
+    pResult->mChangedLightMs = changedMs;
+    pResult->mIncrementalError = incrementalError;
+    pResult->bSparseMatchesDense = sparseMatchesDense;
+    pResult->bStaticMatchesFull = staticMatchesFull;
+}
+
+uint32_t getCPUPropagationBenchmarkResultCount(const CPUPropagationBenchmarkDesc* pDesc)
+{
+    const uint32_t extentCount = pDesc->pLightExtents ? pDesc->mLightExtentCount : 1;
+    return pDesc->mCascadeCount * extentCount * 2 * (1 + pDesc->mTaskManagerCount);
+}
+
+uint32_t runCPUPropagationBenchmark(const CPUPropagationBenchmarkDesc* pDesc, CPUPropagationBenchmarkResult* pResults)
+{
+    ASSERT(pDesc->mPropagationSteps > 0 && pDesc->mLightDensity > 0.0f);
+
+    uint32_t resultCount = 0;
+    for (uint32_t cascade = 0; cascade < pDesc->mCascadeCount; ++cascade)
+    {
+        const uint32_t gridRes = pDesc->pGridRes[cascade] ? pDesc->pGridRes[cascade] : GridRes;
+
+        LightPropagationCPUContext* pContext = (LightPropagationCPUContext*)aura::alloc(sizeof(LightPropagationCPUContext));
+        pContext->loadHeadless(gridRes, NULL);
+        pContext->setPropagationSteps((int)pDesc->mPropagationSteps);
+
+        const uint32_t extentCount = pDesc->pLightExtents ? pDesc->mLightExtentCount : 1;
+        for (uint32_t extent = 0; extent < extentCount; ++extent)
+        {
+            const float lightExtent = pDesc->pLightExtents ? pDesc->pLightExtents[extent] : 1.0f;
+            ASSERT(lightExtent > 0.0f && lightExtent <= 1.0f);
+
+            for (uint32_t advanced = 0; advanced < 2; ++advanced)
+            {
+                pContext->setAdvancedDirections(advanced != 0);
+                //	Advanced directions always go through the reference path
+                const PropagationKernelType kernel = advanced ? PROPAGATION_KERNEL_SCALAR : pContext->getPropagationKernel();
+
+                CPUPropagationBenchmarkResult* pSingleThreaded = &pResults[resultCount];
+                for (uint32_t run = 0; run < 1 + pDesc->mTaskManagerCount; ++run)
+                {
+                    CPUPropagationBenchmarkResult* pResult = &pResults[resultCount++];
+                    memset(pResult, 0, sizeof(*pResult));
+                    pResult->mCascade = cascade;
+                    pResult->mGridRes = gridRes;
+                    pResult->bAdvancedDirections = advanced != 0;
+                    pResult->pKernelName = getPropagationKernel(kernel).pName;
+
+                    if (run == 0)
+                    {
+                        runConfiguration(pDesc, pContext, NULL, MT_None, lightExtent, pResult);
+                        continue;
+                    }
+
+                    runConfiguration(pDesc, pContext, pDesc->ppTaskManagers[run - 1], MT_ExtremeTasks, lightExtent, pResult);
+                    if (pResult->mPropagationMs > 0.0f)
+                        pResult->mSpeedup = pSingleThreaded->mPropagationMs / pResult->mPropagationMs;
+                }
+            }
+        }
+
+        pContext->unloadHeadless(pDesc->mTaskManagerCount ? pDesc->ppTaskManagers[0] : NULL);
+        aura::dealloc(pContext);
+    }
+
+    return resultCount;
+}
+
+void writeCPUPropagationBenchmarkCSV(const CPUPropagationBenchmarkResult* pResults, uint32_t resultCount, FILE* pFile)
+{
+    fprintf(pFile, "cascade,grid_res,mt_mode,advanced_directions,kernel,threads,steps,propagation_ms,min_ms,max_ms,step_ms,"
+                   "cells_per_second,speedup,accumulated_light,light_extent,occupancy,dense_ms,sparse_speedup,static_ms,changed_ms,"
+                   "incremental_error,sparse_matches_dense,static_matches_full\n");
+    for (uint32_t i = 0; i < resultCount; ++i)
+    {
+        const CPUPropagationBenchmarkResult& r = pResults[i];
+        fprintf(pFile, "%u,%u,%s,%d,%s,%u,%u,%.4f,%.4f,%.4f,%.4f,%.0f,%.3f,%.6g,%.3f,%.4f,%.4f,%.3f,%.4f,%.4f,%.6f,%d,%d\n", r.mCascade,
+                r.mGridRes, r.eMTMode == MT_None ? "none" : "extreme_tasks", r.bAdvancedDirections ? 1 : 0, r.pKernelName, r.mThreadCount,
+                r.mPropagationSteps, r.mPropagationMs, r.mMinPropagationMs, r.mMaxPropagationMs, r.mStepMs, r.mCellsPerSecond, r.mSpeedup,
+                r.mAccumulatedLight, r.mLightExtent, r.mOccupancy, r.mDensePropagationMs, r.mSparseSpeedup, r.mStaticLightMs,
+                r.mChangedLightMs, r.mIncrementalError, r.bSparseMatchesDense ? 1 : 0, r.bStaticMatchesFull ? 1 : 0);
+    }
+}
+
+void writeCPUPropagationBenchmarkJSON(const CPUPropagationBenchmarkResult* pResults, uint32_t resultCount, FILE* pFile)
+{
+    fprintf(pFile, "[\n");
+    for (uint32_t i = 0; i < resultCount; ++i)
+    {
+        const CPUPropagationBenchmarkResult& r = pResults[i];
+        fprintf(pFile,
+                "  { \"cascade\": %u, \"grid_res\": %u, \"mt_mode\": \"%s\", \"advanced_directions\": %s, \"kernel\": \"%s\", "
+                "\"threads\": %u, \"steps\": %u, \"propagation_ms\": %.4f, \"min_ms\": %.4f, \"max_ms\": %.4f, \"step_ms\": %.4f, "
+                "\"cells_per_second\": %.0f, \"speedup\": %.3f, \"accumulated_light\": %.6g, \"light_extent\": %.3f, "
+                "\"occupancy\": %.4f, \"dense_ms\": %.4f, \"sparse_speedup\": %.3f, \"static_ms\": %.4f, \"changed_ms\": %.4f, "
+                "\"incremental_error\": %.6f, \"sparse_matches_dense\": %s, \"static_matches_full\": %s }%s\n",
+                r.mCascade, r.mGridRes, r.eMTMode == MT_None ? "none" : "extreme_tasks", r.bAdvancedDirections ? "true" : "false",
+                r.pKernelName, r.mThreadCount, r.mPropagationSteps, r.mPropagationMs, r.mMinPropagationMs, r.mMaxPropagationMs, r.mStepMs,
+                r.mCellsPerSecond, r.mSpeedup, r.mAccumulatedLight, r.mLightExtent, r.mOccupancy, r.mDensePropagationMs, r.mSparseSpeedup,
+                r.mStaticLightMs, r.mChangedLightMs, r.mIncrementalError, r.bSparseMatchesDense ? "true" : "false",
+                r.bStaticMatchesFull ? "true" : "false", i + 1 < resultCount ? "," : "");
+    }
+    fprintf(pFile, "]\n");
+}
+} // namespace aura
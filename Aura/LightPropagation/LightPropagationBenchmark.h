@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include "../Config/AuraParams.h"
+#include "../Interfaces/IAuraTaskManager.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace aura
+{
+//	Headless benchmark of the CPU propagation. Grids are filled with synthetic injected light and propagated
+//	without a renderer, so the propagation cost can be tracked on its own.
+struct CPUPropagationBenchmarkDesc
+{
+    //	Resolution of each benchmarked cascade
+    const uint32_t* pGridRes;
+    uint32_t        mCascadeCount;
+    //	MT_ExtremeTasks runs once per task manager. Pass managers with different thread counts to measure scaling.
+    //	MT_None runs on the calling thread and uses none of them.
+    ITaskManager**  ppTaskManagers;
+    uint32_t        mTaskManagerCount;
+    uint32_t        mPropagationSteps;
+    uint32_t        mWarmupIterations;
+    uint32_t        mIterations;
+    //	Share of cells that receive injected light, in (0, 1]
+    float           mLightDensity;
+    uint32_t        mSeed;
+    //	Every configuration runs once per extent. Light is only injected into a box at the grid center covering this share
+    //	of the grid along each axis, in (0, 1]. NULL runs the whole grid only.
+    const float*    pLightExtents;
+    uint32_t        mLightExtentCount;
+};
+
+struct CPUPropagationBenchmarkResult
+{
+    uint32_t    mCascade;
+    uint32_t    mGridRes;
+    MTTypes     eMTMode;
+    bool        bAdvancedDirections;
+    const char* pKernelName;
+    uint32_t    mThreadCount;      //	1 for MT_None, getThreadCount of the task manager otherwise
+    uint32_t    mPropagationSteps;
+    float       mPropagationMs;    //	Average time of propagating all three channels
+    float       mMinPropagationMs;
+    float       mMaxPropagationMs;
+    float       mStepMs;           //	mPropagationMs / mPropagationSteps
+    double      mCellsPerSecond;   //	Cell updates per second over all channels and steps
+    float       mSpeedup;          //	Relative to MT_None with the same cascade and directions
+    double      mAccumulatedLight; //	Sum of the band 0 coefficients of the result, to catch output changes
+    float       mLightExtent;
+    float       mOccupancy;        //	Share of rows the sparse propagation computed, see getPropagationOccupancy
+    float       mDensePropagationMs;
+    float       mSparseSpeedup;    //	mDensePropagationMs / mPropagationMs
+    float       mStaticLightMs;    //	Incremental propagation of light that didn't change
+    float       mChangedLightMs;   //	Incremental propagation of light changing in a small box every frame
+    float       mIncrementalError; //	Relative error of the last changed light result against a full propagation
+    bool        bSparseMatchesDense; //	Sparse propagation gave exactly the dense result
+    bool        bStaticMatchesFull;  //	Incremental propagation of unchanged light gave exactly the full result
+};
+
+//	Number of results runCPUPropagationBenchmark writes for the description
+uint32_t getCPUPropagationBenchmarkResultCount(const CPUPropagationBenchmarkDesc* pDesc);
+//	Runs every cascade and light extent with basic and advanced directions, first MT_None and then MT_ExtremeTasks on each
+//	task manager. Each run is timed with sparse propagation, which is used for the results, with dense propagation and with
+//	incremental propagation of unchanged and of changing light.
+//	pResults has to hold getCPUPropagationBenchmarkResultCount entries. Returns the number of results written.
+//	Mismatching results are reported through bSparseMatchesDense and bStaticMatchesFull, the benchmark doesn't stop on them.
+uint32_t runCPUPropagationBenchmark(const CPUPropagationBenchmarkDesc* pDesc, CPUPropagationBenchmarkResult* pResults);
+
+//	Machine-readable output: one CSV line per result after a header line, or a JSON array of result objects
+void writeCPUPropagationBenchmarkCSV(const CPUPropagationBenchmarkResult* pResults, uint32_t resultCount, FILE* pFile);
+void writeCPUPropagationBenchmarkJSON(const CPUPropagationBenchmarkResult* pResults, uint32_t resultCount, FILE* pFile);
+} // namespace aura
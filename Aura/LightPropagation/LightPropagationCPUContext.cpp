@@ -13,6 +13,9 @@
 #include "../../../The-Forge/Common_3/Resources/ResourceLoader/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_apis.h"
 #include "../../../The-Forge/Common_3/Resources/ResourceLoader/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
 
+#include <chrono>
+#include <string.h>
+
 #define ARRAY_COUNT(a) sizeof(a) / sizeof(a[0])
 
 #ifdef XBOX
@@ -55,8 +58,25 @@ namespace aura
 {
 static void cmdCopyResource(Cmd* pCmd, const TextureDesc* pDesc, Texture* pSrc, Buffer* pDst);
 static void queryTextureFootprint(const Renderer* pRenderer, const RenderTarget* pRT, TextureFootprint* pFootprint);
-
-const uint32_t lpvElementCount = GridRes * GridRes * GridRes * 4;
+static void initAdvancedDirections(AdvancedDirection* pDirections);
+static void resolveFirstStep(vec4* targetStep, vec4* targetAccum, const vec4* pPrevInjection, vec4* pPrevFirstStep,
+                             const uint64_t* pStepLitRows, int gridRes, int iMinSlice, int iMaxSlice);
+static void resolveAccum(vec4* targetAccum, vec4* pCachedAccum, bool deltaPropagation, int gridRes, int iMinSlice, int iMaxSlice);
+static const char* getPropagationStepName(int step);
+
+//	Adaptive chunking: aim for this many tasks per thread in every step so stealing can even out the load,
+//	but don't make tasks shorter than the cost of scheduling them.
+static const uint32_t gAdaptiveTasksPerThread = 4;
+static const float    gAdaptiveMinTaskNs = 20000.0f;
+static const float    gSliceCostSmoothing = 0.25f;
+
+//	Incremental propagation runs in full when more rows than this share of the grid changed, delta propagations wouldn't
+//	be faster. Every few delta propagations run in full too, since the error of consecutive deltas adds up.
+static const float    gIncrementalMaxChangedRows = 0.25f;
+static const uint32_t gIncrementalMaxDeltaPropagations = 16;
+
+//	Task set names of the propagation steps
+static const int gPropagationStepNameCount = 64;
 
 void LightPropagationCPUContext::readData(Cmd* pCmd, Renderer* pRenderer, RenderTarget* m_LightGrids[3], uint32_t numGrids)
 {
@@ -77,9 +97,9 @@ void LightPropagationCPUContext::readData(Cmd* pCmd, Renderer* pRenderer, Render
     {
         Texture*    lightGridTexture = m_LightGrids[i]->pTexture;
         TextureDesc desc = {};
-        desc.mWidth = GridRes;
-        desc.mHeight = GridRes;
-        desc.mDepth = GridRes;
+        desc.mWidth = m_GridRes;
+        desc.mHeight = m_GridRes;
+        desc.mDepth = m_GridRes;
         desc.mFormat = TinyImageFormat_R16G16B16A16_SFLOAT;
         cmdCopyResource(pCmd, &desc, lightGridTexture, m_ReadbackLightGrids[i]);
     }
@@ -96,18 +116,151 @@ void LightPropagationCPUContext::readData(Cmd* pCmd, Renderer* pRenderer, Render
 void LightPropagationCPUContext::processData(Renderer* pRenderer, ITaskManager* pTaskManager, MTTypes propagationMTType)
 {
     convertGPUtoCPU(pRenderer);
+    propagate(pTaskManager, propagationMTType);
+}
 
+void LightPropagationCPUContext::propagate(ITaskManager* pTaskManager, MTTypes propagationMTType)
+{
     switch (propagationMTType)
     {
     case MT_None:
         doPropagate();
         break;
     case MT_ExtremeTasks:
-        launchPropagateMultiTask(pTaskManager, 32);
+        launchPropagateMultiTask(pTaskManager);
+        break;
+    default:
+        return;
+    }
+}
+
+void LightPropagationCPUContext::setPropagationSteps(int propagationSteps)
+{
+    ASSERT(propagationSteps >= 0 && propagationSteps <= m_nMaxPropagationSteps);
+    m_nPropagationSteps = propagationSteps;
+}
+
+void LightPropagationCPUContext::setIncrementalPropagation(bool incremental)
+{
+    ASSERT(m_hLastTask == ITASKSETHANDLE_INVALID && m_nPendingSteps == 0);
+
+    if (incremental && !m_IncrementalGrids[0])
+    {
+        for (uint32_t i = 0; i < ARRAY_COUNT(m_IncrementalGrids); ++i)
+            m_IncrementalGrids[i] = (vec4*)aura::alloc(m_ElementCount * sizeof(float));
+    }
+
+    if (!incremental)
+        m_IncrementalCacheValid = false;
+    m_UseIncrementalPropagation = incremental;
+}
+
+void LightPropagationCPUContext::beginProcessData(Renderer* pRenderer, ITaskManager* pTaskManager, MTTypes propagationMTType)
+{
+    ASSERT(m_hLastTask == ITASKSETHANDLE_INVALID && m_nPendingSteps == 0);
+
+    convertGPUtoCPU(pRenderer);
+    beginPropagate(pTaskManager, propagationMTType);
+}
+
+void LightPropagationCPUContext::beginPropagate(ITaskManager* pTaskManager, MTTypes propagationMTType)
+{
+    ASSERT(m_hLastTask == ITASKSETHANDLE_INVALID && m_nPendingSteps == 0);
+
+    m_applyState = m_captureState;
+
+    switch (propagationMTType)
+    {
+    case MT_None:
+        launchPropagateSingleTask(pTaskManager);
+        break;
+    case MT_ExtremeTasks:
+        launchPropagateMultiTask(pTaskManager, false);
         break;
     default:
         return;
     }
+
+    eState = PROPAGATING_LIGHT;
+}
+
+bool LightPropagationCPUContext::isProcessDataDone(ITaskManager* pTaskManager)
+{
+    if (m_hLastTask != ITASKSETHANDLE_INVALID && !pTaskManager->isTaskDone(m_hLastTask))
+        return false;
+
+    //	Each step depends on the previous one, so the last step finishes last
+    if (m_nPendingSteps > 0 && !pTaskManager->isTaskDone(m_hTasks[m_nPendingSteps - 1]))
+        return false;
+
+    return true;
+}
+
+void LightPropagationCPUContext::endProcessData(ITaskManager* pTaskManager)
+{
+    SyncToLastTask(pTaskManager);
+
+    if (m_nPendingSteps > 0)
+    {
+        pTaskManager->waitForTaskSet(m_hTasks[m_nPendingSteps - 1]);
+
+#if !defined(ORBIS_TASK_MANAGER)
+        pTaskManager->releaseTasks(m_hTasks, m_nPendingSteps);
+#endif
+        m_nPendingSteps = 0;
+        updateSliceCost();
+    }
+
+    eState = PROPAGATED_LIGHT;
+}
+
+void scheduleDecoupledPropagation(LightPropagationCPUContext* pContexts, uint32_t contextCount, uint32_t readIndex, uint32_t frame,
+                                  uint32_t latency, const LightPropagationCascade::State& captureState, ITaskManager* pTaskManager,
+                                  const DecoupledPropagationOps& ops)
+{
+    ASSERT(readIndex < contextCount);
+
+    //	Apply in launch order so an older result never overwrites a newer one
+    LightPropagationCPUContext* pOldest = NULL;
+    for (uint32_t i = 0; i < contextCount; ++i)
+    {
+        if (LightPropagationCPUContext::PROPAGATING_LIGHT == pContexts[i].eState &&
+            (!pOldest || (int32_t)(pContexts[i].mLaunchFrame - pOldest->mLaunchFrame) < 0))
+        {
+            pOldest = &pContexts[i];
+        }
+    }
+
+    const bool bApply = pOldest && frame - pOldest->mLaunchFrame >= latency && pOldest->isProcessDataDone(pTaskManager);
+    if (bApply)
+        pOldest->endProcessData(pTaskManager);
+
+    //	The upload of the propagated light lands in the light grids, so the readback has to be recorded first.
+    //	Otherwise the next propagation of this context starts from light that was already propagated.
+    LightPropagationCPUContext* pContext = &pContexts[readIndex];
+    const bool                  bCapture = LightPropagationCPUContext::PROPAGATING_LIGHT != pContext->eState;
+    if (bCapture)
+        ops.capture(ops.pUserData, pContext);
+
+    if (bApply)
+    {
+        ops.apply(ops.pUserData, pOldest);
+        pOldest->eState = LightPropagationCPUContext::APPLIED_PROPAGATION;
+    }
+
+    if (!bCapture)
+        return;
+
+    //	The light captured contextCount frames ago is in the readback buffer by now. The launch converts it before the GPU runs
+    //	the capture recorded above.
+    if (pContext->bLightCaptured)
+    {
+        ops.launch(ops.pUserData, pContext);
+        pContext->mLaunchFrame = frame;
+    }
+
+    pContext->setCaptureState(captureState);
+    pContext->bLightCaptured = true;
 }
 
 void LightPropagationCPUContext::applyData(Cmd* pCmd, Renderer* pRenderer, RenderTarget* m_LightGrids[3])
@@ -131,21 +284,25 @@ void LightPropagationCPUContext::applyData(Cmd* pCmd, Renderer* pRenderer, Rende
         beginUpdateResource(&updateDesc);
         TextureSubresourceUpdate subresource = updateDesc.getSubresourceUpdateDesc(0, 0);
 
-        const uint32_t srcRowSize = GridRes * 4 * sizeof(float);
-        const uint32_t srcSliceSize = srcRowSize * GridRes;
+        const uint32_t srcRowSize = m_GridRes * 4 * sizeof(float);
+        const uint32_t srcSliceSize = srcRowSize * m_GridRes;
 
-        for (uint32_t z = 0; z < GridRes; ++z)
+        for (uint32_t z = 0; z < m_GridRes; ++z)
         {
             uint8_t* dstSliceData = subresource.pMappedData + subresource.mDstSliceStride * z;
             uint8_t* srcSliceData = (uint8_t*)m_CPUGrids[i] + srcSliceSize * z;
+            //	Tightly packed destination rows convert as one slice
+            if (subresource.mDstRowStride == m_GridRes * 4 * sizeof(half))
+            {
+                convertFloatToHalf((float*)srcSliceData, (half*)dstSliceData, subresource.mRowCount * m_GridRes * 4);
+                continue;
+            }
+
             for (uint32_t r = 0; r < subresource.mRowCount; ++r)
             {
                 half*  dstRowData = (half*)(dstSliceData + subresource.mDstRowStride * r);
                 float* srcRowData = (float*)(srcSliceData + srcRowSize * r);
-                for (uint32_t c = 0; c < GridRes * 4; ++c)
-                {
-                    dstRowData[c] = srcRowData[c];
-                }
+                convertFloatToHalf(srcRowData, dstRowData, m_GridRes * 4);
             }
         }
 
@@ -174,12 +331,17 @@ void LightPropagationCPUContext::convertGPUtoCPU(Renderer* pRenderer)
         {
             const size_t rowItemCount = (size_t)m_ReadbackFootprint.mRowPitch / sizeof(half);
             float*       floatBuf = (float*)m_CPUGrids[i];
-            for (uint64_t yz = 0; yz < GridRes * GridRes; ++yz) // Y * Z
+            if (rowItemCount == m_GridRes * 4)
             {
-                const half* src = lightPropagationGridData + yz * rowItemCount;
-                for (uint32_t x = 0; x < GridRes * 4; ++x) // X * ChannelCount
+                convertHalfToFloat(lightPropagationGridData, floatBuf, m_ElementCount);
+            }
+            else
+            {
+                for (uint64_t yz = 0; yz < m_GridRes * m_GridRes; ++yz) // Y * Z
                 {
-                    *floatBuf++ = *src++;
+                    const half* src = lightPropagationGridData + yz * rowItemCount;
+                    convertHalfToFloat(src, floatBuf, m_GridRes * 4); // X * ChannelCount
+                    floatBuf += m_GridRes * 4;
                 }
             }
 
@@ -188,15 +350,16 @@ void LightPropagationCPUContext::convertGPUtoCPU(Renderer* pRenderer)
     }
 }
 
-bool LightPropagationCPUContext::load(Renderer* pRenderer, RenderTarget* m_LightGrids[3])
+size_t LightPropagationCPUContext::getGridStorageSize(uint32_t gridRes)
 {
-    m_hLastTask = ITASKSETHANDLE_INVALID;
-    m_nPropagationSteps = 12;
-
-    for (uint32_t i = 0; i < ARRAY_COUNT(m_CPUGrids); ++i)
-        m_CPUGrids[i] = 0;
+    //	Every grid starts on an arena alignment boundary
+    const size_t gridSize = (size_t)gridRes * gridRes * gridRes * 4 * sizeof(float);
+    return ARRAY_COUNT(m_CPUGrids) * ((gridSize + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1));
+}
 
-    eState = APPLIED_PROPAGATION;
+bool LightPropagationCPUContext::load(Renderer* pRenderer, RenderTarget* m_LightGrids[3], uint32_t gridRes, LinearArena* pArena)
+{
+    loadGrids(gridRes, pArena);
 
     queryTextureFootprint(pRenderer, m_LightGrids[0], &m_ReadbackFootprint);
 
@@ -213,24 +376,72 @@ bool LightPropagationCPUContext::load(Renderer* pRenderer, RenderTarget* m_Light
         ASSERT(m_ReadbackLightGrids[i]->mSize >= m_ReadbackFootprint.mTotalByteCount);
     }
 
-    for (uint32_t i = 0; i < ARRAY_COUNT(m_CPUGrids); ++i)
-        m_CPUGrids[i] = (vec4*)aura::alloc(lpvElementCount * sizeof(float));
+    return true;
+}
 
+bool LightPropagationCPUContext::loadHeadless(uint32_t gridRes, LinearArena* pArena)
+{
+    loadGrids(gridRes, pArena);
     return true;
 }
 
-void LightPropagationCPUContext::unload(Renderer* pRenderer, ITaskManager* pTaskManager)
+void LightPropagationCPUContext::loadGrids(uint32_t gridRes, LinearArena* pArena)
 {
-    if (m_hLastTask != ITASKSETHANDLE_INVALID)
+    ASSERT(isValidGridRes(gridRes) && gridRes <= (uint32_t)m_nMaxGridRes);
+    m_GridRes = gridRes;
+    m_ElementCount = gridRes * gridRes * gridRes * 4;
+
+    const int res = (int)gridRes;
+    const int inputOffset[] = { +1, -1, res, -res, res * res, -res * res };
+    memcpy(m_InputOffset, inputOffset, sizeof(m_InputOffset));
+    initAdvancedDirections(m_AdvancedDirections);
+    memcpy(m_LinearAdvancedDirections, m_AdvancedDirections, sizeof(m_LinearAdvancedDirections));
+    for (uint32_t i = 0; i < ARRAY_COUNT(m_LinearAdvancedDirections); ++i)
+        m_LinearAdvancedDirections[i].mMinLuminance = -FLT_MAX;
+
+    m_hLastTask = ITASKSETHANDLE_INVALID;
+    m_nPropagationSteps = 12;
+    m_PropagationKernel = getBestPropagationKernel();
+    m_nPendingSteps = 0;
+    m_SlicesPerTask = 0;
+    m_SliceCostNs = 0.0f;
+    m_MeasuredNs.store(0);
+    m_MeasuredSlices.store(0);
+    m_UseSparsePropagation = true;
+    m_ComputedRows.store(0);
+    m_UseIncrementalPropagation = false;
+    m_IncrementalCacheValid = false;
+    m_DeltaPropagationCount = 0;
+    m_LastPropagationMode = PROPAGATION_FULL;
+    //	Headless contexts never set the states, incremental propagation compares the grid position
+    memset(&m_applyState, 0, sizeof(m_applyState));
+    memset(&m_captureState, 0, sizeof(m_captureState));
+    bLightCaptured = false;
+    mLaunchFrame = 0;
+
+    for (uint32_t i = 0; i < ARRAY_COUNT(m_CPUGrids); ++i)
+        m_CPUGrids[i] = 0;
+    for (uint32_t i = 0; i < ARRAY_COUNT(m_IncrementalGrids); ++i)
+        m_IncrementalGrids[i] = NULL;
+
+    eState = APPLIED_PROPAGATION;
+
+    m_ReadbackFootprint = {};
+    for (uint32_t i = 0; i < ARRAY_COUNT(m_ReadbackLightGrids); ++i)
+        m_ReadbackLightGrids[i] = NULL;
+
+    m_pGridArena = pArena;
+    for (uint32_t i = 0; i < ARRAY_COUNT(m_CPUGrids); ++i)
     {
-        pTaskManager->waitForTaskSet(m_hLastTask);
-#if !defined(ORBIS_TASK_MANAGER)
-        pTaskManager->releaseTask(m_hLastTask);
-#endif
-        m_hLastTask = ITASKSETHANDLE_INVALID;
+        m_CPUGrids[i] = pArena ? (vec4*)arenaAlloc(pArena, m_ElementCount * sizeof(float)) : NULL;
+        if (!m_CPUGrids[i])
+            m_CPUGrids[i] = (vec4*)aura::alloc(m_ElementCount * sizeof(float));
     }
+}
 
-    SyncToLastTask(pTaskManager);
+void LightPropagationCPUContext::unload(Renderer* pRenderer, ITaskManager* pTaskManager)
+{
+    unloadGrids(pTaskManager);
 
     for (uint32_t i = 0; i < ARRAY_COUNT(m_ReadbackLightGrids); i++)
     {
@@ -244,9 +455,41 @@ void LightPropagationCPUContext::unload(Renderer* pRenderer, ITaskManager* pTask
     {
         removeBuffer(pRenderer, m_ReadbackLightGrids[i]);
     }
+}
 
-    for (uint32_t i = 0; i < ARRAY_COUNT(m_CPUGrids); ++i)
-        aura::dealloc(m_CPUGrids[i]);
+void LightPropagationCPUContext::unloadHeadless(ITaskManager* pTaskManager) { unloadGrids(pTaskManager); }
+
+void LightPropagationCPUContext::unloadGrids(ITaskManager* pTaskManager)
+{
+    if (m_hLastTask != ITASKSETHANDLE_INVALID)
+    {
+        pTaskManager->waitForTaskSet(m_hLastTask);
+#if !defined(ORBIS_TASK_MANAGER)
+        pTaskManager->releaseTask(m_hLastTask);
+#endif
+        m_hLastTask = ITASKSETHANDLE_INVALID;
+    }
+
+    SyncToLastTask(pTaskManager);
+
+    //	Decoupled propagation may still be running
+    if (m_nPendingSteps > 0)
+        endProcessData(pTaskManager);
+
+    //	Incremental propagation swaps grids between both sets, so either can hold arena memory
+    vec4** ppGridSets[] = { m_CPUGrids, m_IncrementalGrids };
+    for (uint32_t set = 0; set < ARRAY_COUNT(ppGridSets); ++set)
+    {
+        for (uint32_t i = 0; i < ARRAY_COUNT(m_CPUGrids); ++i)
+        {
+            vec4*& pGrid = ppGridSets[set][i];
+            if (m_pGridArena && arenaOwns(m_pGridArena, pGrid))
+                arenaDealloc(m_pGridArena, pGrid, m_ElementCount * sizeof(float));
+            else
+                aura::dealloc(pGrid);
+            pGrid = NULL;
+        }
+    }
 }
 
 void LightPropagationCPUContext::launchPropagateSingleTask(ITaskManager* pTaskManager)
@@ -254,51 +497,96 @@ void LightPropagationCPUContext::launchPropagateSingleTask(ITaskManager* pTaskMa
     pTaskManager->createTaskSet(0, TaskDoPropagate, this, 1, NULL, 0, "Single Task Propagate", &m_hLastTask);
 }
 
-void LightPropagationCPUContext::launchPropagateMultiTask(ITaskManager* pTaskManager, const int iTasksPerStep /*= 1*/)
+uint32_t LightPropagationCPUContext::getTasksPerChannel(ITaskManager* pTaskManager) const
+{
+    uint32_t slicesPerTask = m_SlicesPerTask;
+    if (slicesPerTask == 0)
+    {
+        //	Unknown thread count keeps one slice per task
+        slicesPerTask = 1;
+
+        const uint32_t threadCount = pTaskManager->getThreadCount();
+        if (threadCount > 0)
+            slicesPerTask = max(1U, 3 * m_GridRes / (threadCount * gAdaptiveTasksPerThread));
+
+        if (m_SliceCostNs > 0.0f)
+            slicesPerTask = max(slicesPerTask, (uint32_t)ceilf(gAdaptiveMinTaskNs / m_SliceCostNs));
+    }
+
+    slicesPerTask = min(slicesPerTask, m_GridRes);
+    return (m_GridRes + slicesPerTask - 1) / slicesPerTask;
+}
+
+void LightPropagationCPUContext::updateSliceCost()
 {
-    if (m_nPropagationSteps == 0)
+    const uint32_t slices = m_MeasuredSlices.exchange(0);
+    const uint64_t ns = m_MeasuredNs.exchange(0);
+    if (slices == 0)
+        return;
+
+    const float sliceCostNs = (float)ns / (float)slices;
+    m_SliceCostNs = (m_SliceCostNs > 0.0f) ? lerp(m_SliceCostNs, sliceCostNs, gSliceCostSmoothing) : sliceCostNs;
+}
+
+//	Channels are independent, so every step is a single task set with the chunks of all three channels.
+//	Step N+1 reads the neighbouring slices of step N and writes the grid step N reads, so steps stay serialized.
+void LightPropagationCPUContext::launchPropagateMultiTask(ITaskManager* pTaskManager, bool bWait /*= true*/)
+{
+    m_ComputedRows.store(0);
+    m_LastPropagationMode = beginIncrementalPropagation();
+
+    if (m_nPropagationSteps == 0 || m_LastPropagationMode == PROPAGATION_REUSED)
     {
         return;
     }
-    ITASKSETHANDLE m_hTask[m_nMaxPropagationSteps][3];
+
+    const uint32_t taskCount = 3 * getTasksPerChannel(pTaskManager);
+    const bool     incremental = m_UseIncrementalPropagation;
+    const bool     delta = m_LastPropagationMode == PROPAGATION_DELTA;
+    //	Delta propagations always skip the rows the change of the light didn't reach
+    const bool     sparse = m_UseSparsePropagation || delta;
 
     int iSrc = 0;
     int iTargetStep = 1;
     int iTsrgetAccum = 2;
-    {
-        for (int j = 0; j < 3; ++j)
-        {
-            m_Contexts[0][j].pContext = this;
-            m_Contexts[0][j].src = m_CPUGrids[iSrc * 3 + j];
-            m_Contexts[0][j].targetStep = m_CPUGrids[iTargetStep * 3 + j];
-            m_Contexts[0][j].targetAccum = m_CPUGrids[iTsrgetAccum * 3 + j];
 
-            pTaskManager->createTaskSet(j, TaskStep1, &m_Contexts[0][j], iTasksPerStep, NULL, 0, "Propagate first step", &m_hTask[0][j]);
-        }
+    static_assert(m_nMaxPropagationSteps <= gPropagationStepNameCount, "Every step needs a task name");
 
-        int pTmp;
-        pTmp = iSrc;
-        iSrc = iTargetStep;
-        iTargetStep = pTmp;
-    }
-
-    static char taskLabel[m_nMaxPropagationSteps][256];
-
-    for (int i = 1; i < m_nPropagationSteps; ++i)
+    for (int i = 0; i < m_nPropagationSteps; ++i)
     {
-        snprintf(taskLabel[i], ARRAY_COUNT(taskLabel[i]), "Propagate step: %d", i);
-
         for (int j = 0; j < 3; ++j)
         {
-            m_Contexts[i][j].pContext = this;
-            m_Contexts[i][j].src = m_CPUGrids[iSrc * 3 + j];
-            m_Contexts[i][j].targetStep = m_CPUGrids[iTargetStep * 3 + j];
-            m_Contexts[i][j].targetAccum = m_CPUGrids[iTsrgetAccum * 3 + j];
-
-            pTaskManager->createTaskSet(i - 1, TaskStepN, &m_Contexts[i][j], iTasksPerStep, &m_hTask[i - 1][j], 1, taskLabel[i],
-                                        &m_hTask[i][j]);
+            StepContext& context = m_Contexts[i][j];
+            context.pContext = this;
+            context.src = m_CPUGrids[iSrc * 3 + j];
+            context.targetStep = m_CPUGrids[iTargetStep * 3 + j];
+            context.targetAccum = m_CPUGrids[iTsrgetAccum * 3 + j];
+            //	The first step finds the lit rows of the injected light itself
+            context.pSrcLitRows = (sparse && i > 0) ? m_LitRows[j][i & 1] : NULL;
+            context.pStepLitRows = sparse ? m_LitRows[j][(i + 1) & 1] : NULL;
+            //	A delta propagation is linear after the first step
+            context.pAdvancedDirections = (delta && i > 0) ? m_LinearAdvancedDirections : m_AdvancedDirections;
+            context.pPrevInjection = NULL;
+            context.pPrevFirstStep = NULL;
+            context.pCachedAccum = (incremental && i == m_nPropagationSteps - 1) ? m_IncrementalGrids[6 + j] : NULL;
+            context.bDeltaPropagation = delta;
+
+            //	The injected light was swapped into the cache, the source grid holds the cached injected light
+            if (incremental && i == 0)
+            {
+                context.src = m_IncrementalGrids[j];
+                context.pPrevInjection = delta ? m_CPUGrids[j] : NULL;
+                context.pPrevFirstStep = m_IncrementalGrids[3 + j];
+                context.pSrcLitRows = delta ? m_ChangedRows[j] : NULL;
+            }
         }
 
+        if (i == 0)
+            pTaskManager->createTaskSet(0, TaskStep<true>, m_Contexts[0], taskCount, NULL, 0, getPropagationStepName(0), &m_hTasks[0]);
+        else
+            pTaskManager->createTaskSet(i, TaskStep<false>, m_Contexts[i], taskCount, &m_hTasks[i - 1], 1, getPropagationStepName(i),
+                                        &m_hTasks[i]);
+
         int pTmp;
         pTmp = iSrc;
         iSrc = iTargetStep;
@@ -314,24 +602,97 @@ void LightPropagationCPUContext::launchPropagateMultiTask(ITaskManager* pTaskMan
         m_CPUGrids[i + 2 * 3] = pTmp;
     }
 
-    pTaskManager->waitAll();
+    if (!bWait)
+    {
+        //	Tasks are released by endProcessData
+        m_nPendingSteps = m_nPropagationSteps;
+        return;
+    }
+
+    pTaskManager->waitForTaskSet(m_hTasks[m_nPropagationSteps - 1]);
 
 #if !defined(ORBIS_TASK_MANAGER)
-    pTaskManager->releaseTasks(m_hTask[0], 3 * m_nPropagationSteps);
+    pTaskManager->releaseTasks(m_hTasks, m_nPropagationSteps);
 #endif
+
+    updateSliceCost();
+}
+
+float LightPropagationCPUContext::benchmarkPropagation(ITaskManager* pTaskManager, uint32_t slicesPerTask, uint32_t iterations)
+{
+    ASSERT(m_hLastTask == ITASKSETHANDLE_INVALID && m_nPendingSteps == 0);
+    if (iterations == 0)
+        return 0.0f;
+
+    //	Every iteration propagates the same light, otherwise the accumulated values keep growing
+    const size_t gridSize = m_ElementCount * sizeof(float);
+    vec4*        pSavedGrids = (vec4*)aura::alloc(3 * gridSize);
+    for (uint32_t i = 0; i < 3; ++i)
+        memcpy((uint8_t*)pSavedGrids + i * gridSize, m_CPUGrids[i], gridSize);
+
+    const uint32_t savedSlicesPerTask = m_SlicesPerTask;
+    m_SlicesPerTask = slicesPerTask;
+    //	Incremental propagation would only copy the result after the first iteration
+    const bool incremental = m_UseIncrementalPropagation;
+    m_UseIncrementalPropagation = false;
+
+    double totalMs = 0.0;
+    for (uint32_t it = 0; it < iterations; ++it)
+    {
+        for (uint32_t i = 0; i < 3; ++i)
+            memcpy(m_CPUGrids[i], (uint8_t*)pSavedGrids + i * gridSize, gridSize);
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        launchPropagateMultiTask(pTaskManager);
+        totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    m_SlicesPerTask = savedSlicesPerTask;
+    m_UseIncrementalPropagation = incremental;
+    aura::dealloc(pSavedGrids);
+
+    return (float)(totalMs / iterations);
 }
 
 void LightPropagationCPUContext::doPropagate()
 {
+    m_ComputedRows.store(0);
+    m_LastPropagationMode = beginIncrementalPropagation();
+
+    if (m_LastPropagationMode == PROPAGATION_REUSED)
+        return;
+
+    const bool incremental = m_UseIncrementalPropagation && m_nPropagationSteps > 0;
+    const bool delta = m_LastPropagationMode == PROPAGATION_DELTA;
+    //	Delta propagations always skip the rows the change of the light didn't reach
+    const bool sparse = m_UseSparsePropagation || delta;
+    //	A delta propagation is linear after the first step
+    const AdvancedDirection* pAdvancedDirections = delta ? m_LinearAdvancedDirections : m_AdvancedDirections;
+
     for (int iChan = 0; iChan < 3; ++iChan)
     {
+        //	The first step finds the lit rows of the injected light itself
+        uint64_t* pStepLitRows = sparse ? m_LitRows[iChan][1] : NULL;
+
+        //	The injected light was swapped into the cache, the source grid holds the cached injected light
+        vec4*           pInjected = incremental ? m_IncrementalGrids[iChan] : m_CPUGrids[iChan];
+        const uint64_t* pChangedRows = delta ? m_ChangedRows[iChan] : NULL;
+
         if (m_UseAdvancedDirections)
         {
-            propagateStep<true, true>(m_CPUGrids[iChan], m_CPUGrids[3], m_CPUGrids[4], 0, GridRes);
+            propagateStep<true, true>(pInjected, m_CPUGrids[3], m_CPUGrids[4], m_AdvancedDirections, pChangedRows, pStepLitRows, 0,
+                                      m_GridRes);
         }
         else
         {
-            propagateStep<true, false>(m_CPUGrids[iChan], m_CPUGrids[3], m_CPUGrids[4], 0, GridRes);
+            propagateStep<true, false>(pInjected, m_CPUGrids[3], m_CPUGrids[4], m_AdvancedDirections, pChangedRows, pStepLitRows, 0,
+                                       m_GridRes);
+        }
+
+        if (incremental)
+        {
+            resolveFirstStep(m_CPUGrids[3], m_CPUGrids[4], delta ? m_CPUGrids[iChan] : NULL, m_IncrementalGrids[3 + iChan], pStepLitRows,
+                             m_GridRes, 0, m_GridRes);
         }
 
         vec4* pTmp;
@@ -345,23 +706,37 @@ void LightPropagationCPUContext::doPropagate()
         //	Use ping-pong rt changes to propagate only previous step light
         for (int i = 1; i < nPropagationSteps; ++i)
         {
+            const uint64_t* pSrcLitRows = sparse ? m_LitRows[iChan][i & 1] : NULL;
+            pStepLitRows = sparse ? m_LitRows[iChan][(i + 1) & 1] : NULL;
+
             if (m_UseAdvancedDirections)
             {
-                propagateStep<false, true>(m_CPUGrids[3], m_CPUGrids[4], m_CPUGrids[iChan], 0, GridRes);
+                propagateStep<false, true>(m_CPUGrids[3], m_CPUGrids[4], m_CPUGrids[iChan], pAdvancedDirections, pSrcLitRows, pStepLitRows,
+                                           0, m_GridRes);
             }
             else
             {
-                propagateStep<false, false>(m_CPUGrids[3], m_CPUGrids[4], m_CPUGrids[iChan], 0, GridRes);
+                propagateStep<false, false>(m_CPUGrids[3], m_CPUGrids[4], m_CPUGrids[iChan], pAdvancedDirections, pSrcLitRows,
+                                            pStepLitRows, 0, m_GridRes);
             }
 
             pTmp = m_CPUGrids[3];
             m_CPUGrids[3] = m_CPUGrids[4];
             m_CPUGrids[4] = pTmp;
         }
+
+        if (incremental)
+            resolveAccum(m_CPUGrids[iChan], m_IncrementalGrids[6 + iChan], delta, m_GridRes, 0, m_GridRes);
     }
 
     // convertCPUtoGPU();
 }
+
+float LightPropagationCPUContext::getPropagationOccupancy() const
+{
+    const double rowCount = 3.0 * m_nPropagationSteps * m_GridRes * m_GridRes;
+    return rowCount > 0.0 ? (float)(m_ComputedRows.load() / rowCount) : 1.0f;
+}
 /************************************************************************/
 // Math
 /************************************************************************/
@@ -406,10 +781,6 @@ DEFINE_ALIGNED(static const float3 vConeDirs[], 16) = {
     float3(1, 0, 0), float3(-1, 0, 0), float3(0, 1, 0), float3(0, -1, 0), float3(0, 0, 1), float3(0, 0, -1),
 };
 
-static const int inputOffset[] = {
-    +1, -1, GridRes, -(int)GridRes, GridRes* GridRes, -(int)(GridRes* GridRes),
-};
-
 DEFINE_ALIGNED(static const float4 vCone90Degree[], 16) = {
     Cone90Degree(-vConeDirs[0]), Cone90Degree(-vConeDirs[1]), Cone90Degree(-vConeDirs[2]),
     Cone90Degree(-vConeDirs[3]), Cone90Degree(-vConeDirs[4]), Cone90Degree(-vConeDirs[5]),
@@ -481,9 +852,9 @@ __declspec(noalias) inline float getSolidAngle(const __m128 dir, const __m128 fa
         return faceASolidAngle; //	Side face
 }
 
-__declspec(noalias) inline __m128 SHEvaluateFunction(const __m128 vcDir, const __m128 data)
+__declspec(noalias) inline __m128 SHEvaluateWeights(const __m128 vcDir)
 {
-    // return dot(data, float4(1.0f, vcDir.y, vcDir.z, vcDir.x)*SHBasis);
+    // return float4(1.0f, vcDir.y, vcDir.z, vcDir.x)*SHBasis;
 
     const float one = 1.0f;
 
@@ -493,7 +864,7 @@ __declspec(noalias) inline __m128 SHEvaluateFunction(const __m128 vcDir, const _
     __m128 permVcDir = _mm_shuffle_ps(vcDir, vcDir, _MM_SHUFFLE(0, 2, 1, 3)); // [0 vcDir.y vcDir.z vcDir.x]
     permVcDir = _mm_move_ss(permVcDir, ones);                                 // [1 vcDir.y vcDir.z vcDir.x]
 
-    return _mm_dp_ps(data, _mm_mul_ps(permVcDir, shBasis), 0xFF);
+    return _mm_mul_ps(permVcDir, shBasis);
 }
 
 // Cosine lobe
@@ -513,51 +884,30 @@ __declspec(noalias) inline __m128 SSENormalize(const __m128 vec)
     return _mm_mul_ps(vec, dp);
 }
 
-__declspec(noalias) inline __m128 IVPropagateVirtualDirIntrin(const float4& srcF4, int dirIndex, int virtualDirIndex)
+__declspec(noalias) inline __m128 IVPropagateVirtualDirIntrin(const float4& srcF4, const AdvancedDirection& dir)
 {
-    const float   zeroPoint5F = 0.5f;
-    const float3& nOffsetFloat3 = vConeDirs[dirIndex];
-    const float3& virtDirFloat3 = vConeDirs[virtualDirIndex];
-
-    DEFINE_ALIGNED(const float nOffsetArray[], 16) = { -nOffsetFloat3.x, -nOffsetFloat3.y, -nOffsetFloat3.z, 0.0f };
-    DEFINE_ALIGNED(const float virtDirArray[], 16) = { virtDirFloat3.x, virtDirFloat3.y, virtDirFloat3.z, 0.0f };
-
-    __m128 nOffset = _mm_load_ps(nOffsetArray);
-    __m128 virtDir = _mm_load_ps(virtDirArray);
-
-    float solidAngle = getSolidAngle(nOffset, virtDir);
-
-    if (solidAngle <= 0)
+    if (dir.mFactor <= 0)
         return _mm_setzero_ps();
 
-    __m128 zeroPoint5 = _mm_load_ss(&zeroPoint5F);
-    __m128 virtDirDiv2 = _mm_mul_ss(zeroPoint5, virtDir);
-
-    const __m128 propDir = SSENormalize(_mm_add_ps(nOffset, virtDirDiv2));
     const __m128 src = _mm_load_ps(&srcF4.x);
 
-    const float  propagationFactorF = solidAngle * 0.5f; //(4*PI);
-    const __m128 propagationFactor = _mm_load_ps1(&propagationFactorF);
-    // const float reprojectionFactor = 1.0f;// /PI;
-    // const float reprojLuminance = propagationFactor * reprojectionFactor * max(SHEvaluateFunction(propDir, src), 0.0f);
-
-    const __m128 reprojLuminance = _mm_mul_ps(propagationFactor, _mm_max_ps(SHEvaluateFunction(propDir, src), _mm_setzero_ps()));
-
-    const __m128 shIncomingDirFunction = SHProjectCone(virtDir);
+    const __m128 propagationFactor = _mm_load_ps1(&dir.mFactor);
+    const __m128 luminance = _mm_dp_ps(src, _mm_loadu_ps(&dir.mEvalWeights.x), 0xFF);
+    const __m128 reprojLuminance = _mm_mul_ps(propagationFactor, _mm_max_ps(luminance, _mm_load_ps1(&dir.mMinLuminance)));
 
-    return _mm_mul_ps(shIncomingDirFunction, reprojLuminance);
+    return _mm_mul_ps(_mm_loadu_ps(&dir.mCone.x), reprojLuminance);
 }
 
-__declspec(noalias) inline __m128 IVPropagateDirAdvancedIntrin(const float4& src, int dirIndex)
+__declspec(noalias) inline __m128 IVPropagateDirAdvancedIntrin(const float4& src, const AdvancedDirection* pDirs)
 {
     __m128 res = _mm_setzero_ps();
 
-    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, dirIndex, 0));
-    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, dirIndex, 1));
-    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, dirIndex, 2));
-    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, dirIndex, 3));
-    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, dirIndex, 4));
-    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, dirIndex, 5));
+    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, pDirs[0]));
+    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, pDirs[1]));
+    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, pDirs[2]));
+    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, pDirs[3]));
+    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, pDirs[4]));
+    res = _mm_add_ps(res, IVPropagateVirtualDirIntrin(src, pDirs[5]));
 
     return res;
 }
@@ -566,7 +916,8 @@ __declspec(noalias) inline __m128 IVPropagateDirAdvancedIntrin(const float4& src
 
 template<bool bFirstStep, bool isAdvanced, bool isIMin, bool isIMax, bool isJMin, bool isJMax, bool isKMin, bool isKMax>
 __declspec(noalias) __forceinline void propagateCell(vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum,
-                                                     const int i, const int j, const int k, const int readOffset)
+                                                     const int* inputOffset, const AdvancedDirection* advancedDirections, const int i,
+                                                     const int j, const int k, const int readOffset)
 {
     UNREF_PARAM(i);
     UNREF_PARAM(i);
@@ -578,27 +929,27 @@ __declspec(noalias) __forceinline void propagateCell(vec4* __restrict src, vec4*
     {
         // if (k<GridRes-1)
         if (!isKMax)
-            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[0]], 0));
+            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[0]], advancedDirections + 0 * 6));
         //	float3(-1, 0, 0),
         // if (k>0)
         if (!isKMin)
-            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[1]], 1));
+            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[1]], advancedDirections + 1 * 6));
         // float3( 0, 1, 0),
         // if (j<GridRes-1)
         if (!isJMax)
-            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[2]], 2));
+            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[2]], advancedDirections + 2 * 6));
         // float3( 0, -1, 0),
         // if (j>0)
         if (!isJMin)
-            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[3]], 3));
+            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[3]], advancedDirections + 3 * 6));
         // float3( 0, 0, 1),
         // if (i<GridRes-1)
         if (!isIMax)
-            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[4]], 4));
+            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[4]], advancedDirections + 4 * 6));
         // float3( 0, 0, -1),
         // if (i>0)
         if (!isIMin)
-            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[5]], 5));
+            res = _mm_add_ps(res, IVPropagateDirAdvancedIntrin(src[readOffset + inputOffset[5]], advancedDirections + 5 * 6));
     }
     else
     {
@@ -677,11 +1028,6 @@ inline float getSolidAngle(const float3& dir, const float3& faceDir)
         return faceASolidAngle;
 }
 
-inline float SHEvaluateFunction(const float3& vcDir, const float4& data)
-{
-    return dot(data, float4(1.0f, vcDir.y, vcDir.z, vcDir.x) * SHBasis);
-}
-
 // Cosine lobe
 __forceinline float4 SHProjectCone(const float3& vcDir)
 {
@@ -689,51 +1035,41 @@ __forceinline float4 SHProjectCone(const float3& vcDir)
     return SHRotate(vcDir, vZHCoeffs);
 }
 
-__forceinline float4 IVPropagateVirtualDir(const float4& src, int dirIndex, int virtualDirIndex)
+__forceinline float4 IVPropagateVirtualDir(const float4& src, const AdvancedDirection& dir)
 {
-    const float3& nOffset = vConeDirs[dirIndex];
-    const float3& virtDir = vConeDirs[virtualDirIndex];
-
-    float solidAngle = getSolidAngle(-nOffset, virtDir);
-
-    if (solidAngle <= 0)
+    if (dir.mFactor <= 0)
         return float4(0.0f, 0.0f, 0.0f, 0.0f);
 
-    const float3 propDir = normalize(-nOffset + 0.5f * virtDir);
-
-    const float propagationFactor = solidAngle * 0.5f; //(4*PI);
-    const float reprojectionFactor = 1.0f;             // /PI;
-    const float reprojLuminance = propagationFactor * reprojectionFactor * max(SHEvaluateFunction(propDir, src), 0.0f);
+    const float reprojLuminance = dir.mFactor * max(dot(src, dir.mEvalWeights), dir.mMinLuminance);
 
-    float4 shIncomingDirFunction = SHProjectCone(virtDir);
-
-    return shIncomingDirFunction * reprojLuminance;
+    return dir.mCone * reprojLuminance;
 }
 
 template<bool isIMin, bool isIMax, bool isJMin, bool isJMax, bool isKMin, bool isKMax>
-__forceinline float4 IVPropagateDirAdvanced(const float4& src, int dirIndex)
+__forceinline float4 IVPropagateDirAdvanced(const float4& src, const AdvancedDirection* pDirs)
 {
     float4 res = float4(0.0f, 0.0f, 0.0f, 0.0f);
 
     if (!isKMax)
-        res += IVPropagateVirtualDir(src, dirIndex, 0);
+        res += IVPropagateVirtualDir(src, pDirs[0]);
     if (!isKMin)
-        res += IVPropagateVirtualDir(src, dirIndex, 1);
+        res += IVPropagateVirtualDir(src, pDirs[1]);
     if (!isJMax)
-        res += IVPropagateVirtualDir(src, dirIndex, 2);
+        res += IVPropagateVirtualDir(src, pDirs[2]);
     if (!isJMin)
-        res += IVPropagateVirtualDir(src, dirIndex, 3);
+        res += IVPropagateVirtualDir(src, pDirs[3]);
     if (!isIMax)
-        res += IVPropagateVirtualDir(src, dirIndex, 4);
+        res += IVPropagateVirtualDir(src, pDirs[4]);
     if (!isIMin)
-        res += IVPropagateVirtualDir(src, dirIndex, 5);
+        res += IVPropagateVirtualDir(src, pDirs[5]);
 
     return res;
 }
 
 template<bool bFirstStep, bool isAdvanced, bool isIMin, bool isIMax, bool isJMin, bool isJMax, bool isKMin, bool isKMax>
 __declspec(noalias) __forceinline void propagateCell(vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum,
-                                                     const int i, const int j, const int k, const int readOffset)
+                                                     const int* inputOffset, const AdvancedDirection* advancedDirections, const int i,
+                                                     const int j, const int k, const int readOffset)
 {
     float4 res = float4(0.0f, 0.0f, 0.0f, 0.0f);
 
@@ -741,22 +1077,28 @@ __declspec(noalias) __forceinline void propagateCell(vec4* __restrict src, vec4*
     {
         // VIRTUAL DIRECTIONS
         if (!isKMax)
-            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[0]], 0);
+            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[0]],
+                                                                                          advancedDirections + 0 * 6);
         //	float3(-1, 0, 0),
         if (!isKMin)
-            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[1]], 1);
+            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[1]],
+                                                                                          advancedDirections + 1 * 6);
         // float3( 0, 1, 0),
         if (!isJMax)
-            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[2]], 2);
+            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[2]],
+                                                                                          advancedDirections + 2 * 6);
         // float3( 0, -1, 0),
         if (!isJMin)
-            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[3]], 3);
+            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[3]],
+                                                                                          advancedDirections + 3 * 6);
         // float3( 0, 0, 1),
         if (!isIMax)
-            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[4]], 4);
+            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[4]],
+                                                                                          advancedDirections + 4 * 6);
         // float3( 0, 0, -1),
         if (!isIMin)
-            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[5]], 5);
+            res += IVPropagateDirAdvanced<isIMin, isIMax, isJMin, isJMax, isKMin, isKMax>(src[readOffset + inputOffset[5]],
+                                                                                          advancedDirections + 5 * 6);
     }
     else
     {
@@ -795,6 +1137,43 @@ __declspec(noalias) __forceinline void propagateCell(vec4* __restrict src, vec4*
 
 #endif
 
+//	Everything IVPropagateVirtualDir needs besides the light of the neighbour, built with the same math the kernel used per cell
+static void initAdvancedDirections(AdvancedDirection* pDirections)
+{
+    for (int dirIndex = 0; dirIndex < 6; ++dirIndex)
+    {
+        for (int virtualDirIndex = 0; virtualDirIndex < 6; ++virtualDirIndex)
+        {
+            AdvancedDirection* pDir = &pDirections[dirIndex * 6 + virtualDirIndex];
+            const float3&      nOffsetFloat3 = vConeDirs[dirIndex];
+            const float3&      virtDirFloat3 = vConeDirs[virtualDirIndex];
+
+#if defined(INTRIN_USE)
+            const float zeroPoint5F = 0.5f;
+            DEFINE_ALIGNED(const float nOffsetArray[], 16) = { -nOffsetFloat3.x, -nOffsetFloat3.y, -nOffsetFloat3.z, 0.0f };
+            DEFINE_ALIGNED(const float virtDirArray[], 16) = { virtDirFloat3.x, virtDirFloat3.y, virtDirFloat3.z, 0.0f };
+
+            const __m128 nOffset = _mm_load_ps(nOffsetArray);
+            const __m128 virtDir = _mm_load_ps(virtDirArray);
+            const __m128 virtDirDiv2 = _mm_mul_ss(_mm_load_ss(&zeroPoint5F), virtDir);
+            const __m128 propDir = SSENormalize(_mm_add_ps(nOffset, virtDirDiv2));
+
+            _mm_storeu_ps(&pDir->mEvalWeights.x, SHEvaluateWeights(propDir));
+            _mm_storeu_ps(&pDir->mCone.x, SHProjectCone(virtDir));
+            pDir->mFactor = getSolidAngle(nOffset, virtDir) * 0.5f; //(4*PI);
+#else
+            const float3 propDir = normalize(-nOffsetFloat3 + 0.5f * virtDirFloat3);
+
+            pDir->mEvalWeights = float4(1.0f, propDir.y, propDir.z, propDir.x) * SHBasis;
+            pDir->mCone = SHProjectCone(virtDirFloat3);
+            //	reprojectionFactor is 1
+            pDir->mFactor = getSolidAngle(-nOffsetFloat3, virtDirFloat3) * 0.5f; //(4*PI);
+#endif
+            pDir->mMinLuminance = 0.0f;
+        }
+    }
+}
+
 /************************************************************************/
 /************************************************************************/
 void LightPropagationCPUContext::SyncToLastTask(ITaskManager* pTaskManager)
@@ -813,69 +1192,355 @@ void LightPropagationCPUContext::SyncToLastTask(ITaskManager* pTaskManager)
 /************************************************************************/
 template<bool bFirstStep, bool isAdvanced, bool isIMin, bool isIMax, bool isJMin, bool isJMax>
 __declspec(noalias) __forceinline void propagateRow(vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum,
+                                                    const int* inputOffset, const AdvancedDirection* advancedDirections, const int gridRes,
                                                     const int i, const int j, int& readOffset)
 {
     //	Igor: partially unroll the loop. This unroll ifs too.
-    propagateCell<bFirstStep, isAdvanced, isIMin, isIMax, isJMin, isJMax, true, false>(src, targetStep, targetAccum, i, j, 0, readOffset);
+    propagateCell<bFirstStep, isAdvanced, isIMin, isIMax, isJMin, isJMax, true, false>(src, targetStep, targetAccum, inputOffset,
+                                                                                       advancedDirections, i, j, 0, readOffset);
     ++readOffset;
 
-    for (int k = 1; k < static_cast<int>(GridRes - 1); ++k, ++readOffset)
+    for (int k = 1; k < gridRes - 1; ++k, ++readOffset)
     {
-        propagateCell<bFirstStep, isAdvanced, isIMin, isIMax, isJMin, isJMax, false, false>(src, targetStep, targetAccum, i, j, k,
-                                                                                            readOffset);
+        propagateCell<bFirstStep, isAdvanced, isIMin, isIMax, isJMin, isJMax, false, false>(src, targetStep, targetAccum, inputOffset,
+                                                                                            advancedDirections, i, j, k, readOffset);
     }
 
-    propagateCell<bFirstStep, isAdvanced, isIMin, isIMax, isJMin, isJMax, false, true>(src, targetStep, targetAccum, i, j, GridRes - 1,
-                                                                                       readOffset);
+    propagateCell<bFirstStep, isAdvanced, isIMin, isIMax, isJMin, isJMax, false, true>(src, targetStep, targetAccum, inputOffset,
+                                                                                       advancedDirections, i, j, gridRes - 1, readOffset);
     ++readOffset;
 }
 
+//	Sparse propagation. A cell only receives light from its six neighbours, so a row stays dark in a step unless the row itself,
+//	one of the rows next to it in the slice or the same row of a neighbouring slice held light in the previous step.
+//	Bit j of a slice mask stands for row j of the slice.
+static inline uint64_t getSliceRowMask(const int gridRes) { return gridRes >= 64 ? ~0ull : (1ull << gridRes) - 1; }
+
+static inline uint64_t getActiveRows(const uint64_t* pLitRows, const int gridRes, const int i)
+{
+    const uint64_t litRows = pLitRows[i];
+    uint64_t       activeRows = litRows | (litRows << 1) | (litRows >> 1);
+    if (i > 0)
+        activeRows |= pLitRows[i - 1];
+    if (i < gridRes - 1)
+        activeRows |= pLitRows[i + 1];
+    return activeRows & getSliceRowMask(gridRes);
+}
+
+//	Lit rows of the injected light. Compares bits, so -0 counts as light and rows found dark are exactly the rows
+//	the dense path reads +0 from.
+static inline uint64_t getLitRows(const vec4* pSlice, const int gridRes)
+{
+    uint64_t litRows = 0;
+    for (int j = 0; j < gridRes; ++j)
+    {
+        const uint8_t* pRow = (const uint8_t*)(pSlice + j * gridRes);
+        for (size_t n = 0; n < gridRes * sizeof(vec4); n += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, pRow + n, sizeof(word));
+            if (word)
+            {
+                litRows |= 1ull << j;
+                break;
+            }
+        }
+    }
+    return litRows;
+}
+
+static inline uint32_t getRowCount(uint64_t rows)
+{
+    uint32_t count = 0;
+    for (; rows; rows &= rows - 1)
+        ++count;
+    return count;
+}
+
+//	Rows of the injected light that differ from the cached injected light, compared bit by bit
+static inline uint64_t getChangedRows(const vec4* pSlice, const vec4* pPrevSlice, const int gridRes)
+{
+    uint64_t changedRows = 0;
+    for (int j = 0; j < gridRes; ++j)
+    {
+        if (memcmp(pSlice + j * gridRes, pPrevSlice + j * gridRes, gridRes * sizeof(vec4)))
+            changedRows |= 1ull << j;
+    }
+    return changedRows;
+}
+
+//	Dark rows get no light, so the dense path writes +0 to the step and keeps the accumulated light.
+//	The source row is dark too, so on the first step the accumulated light is +0 as well.
+template<bool bFirstStep>
+static inline void clearRows(vec4* targetStep, vec4* targetAccum, const int offset, const int count)
+{
+    memset(targetStep + offset, 0, count * sizeof(vec4));
+    if (bFirstStep)
+        memset(targetAccum + offset, 0, count * sizeof(vec4));
+}
+
 template<bool bFirstStep, bool isAdvanced, bool isIMin, bool isIMax>
 __declspec(noalias) __forceinline void propagateSlice(vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum,
-                                                      const int i, int& readOffset)
+                                                      const int* inputOffset, const AdvancedDirection* advancedDirections,
+                                                      const int gridRes, const int i, const uint64_t activeRows, int& readOffset)
 {
-    propagateRow<bFirstStep, isAdvanced, isIMin, isIMax, true, false>(src, targetStep, targetAccum, i, 0, readOffset);
+    if (activeRows & 1)
+    {
+        propagateRow<bFirstStep, isAdvanced, isIMin, isIMax, true, false>(src, targetStep, targetAccum, inputOffset, advancedDirections,
+                                                                          gridRes, i, 0, readOffset);
+    }
+    else
+    {
+        clearRows<bFirstStep>(targetStep, targetAccum, readOffset, gridRes);
+        readOffset += gridRes;
+    }
 
-    for (int j = 1; j < static_cast<int>(GridRes - 1); ++j)
+    for (int j = 1; j < gridRes - 1; ++j)
     {
-        propagateRow<bFirstStep, isAdvanced, isIMin, isIMax, false, false>(src, targetStep, targetAccum, i, j, readOffset);
+        if ((activeRows >> j) & 1)
+        {
+            propagateRow<bFirstStep, isAdvanced, isIMin, isIMax, false, false>(src, targetStep, targetAccum, inputOffset,
+                                                                              advancedDirections, gridRes, i, j, readOffset);
+        }
+        else
+        {
+            clearRows<bFirstStep>(targetStep, targetAccum, readOffset, gridRes);
+            readOffset += gridRes;
+        }
     }
 
-    propagateRow<bFirstStep, isAdvanced, isIMin, isIMax, false, true>(src, targetStep, targetAccum, i, GridRes - 1, readOffset);
+    if ((activeRows >> (gridRes - 1)) & 1)
+    {
+        propagateRow<bFirstStep, isAdvanced, isIMin, isIMax, false, true>(src, targetStep, targetAccum, inputOffset, advancedDirections,
+                                                                         gridRes, i, gridRes - 1, readOffset);
+    }
+    else
+    {
+        clearRows<bFirstStep>(targetStep, targetAccum, readOffset, gridRes);
+        readOffset += gridRes;
+    }
 }
 
+//	pStepLitRows NULL propagates every row. Otherwise dark rows are skipped and the rows that were propagated are written to it,
+//	so the lit rows grow by one row per step. pSrcLitRows has to be set from the second step on. The first step finds the lit
+//	rows of the injected light when it is NULL.
 template<bool bFirstStep, bool isAdvanced>
 __declspec(noalias) void LightPropagationCPUContext::propagateStep(vec4* __restrict src, vec4* __restrict targetStep,
-                                                                   vec4* __restrict targetAccum, int iMinSlice /*=0*/,
-                                                                   int iMaxSlice /*=GridRes*/)
+                                                                   vec4* __restrict targetAccum,
+                                                                   const AdvancedDirection* pAdvancedDirections,
+                                                                   const uint64_t* pSrcLitRows, uint64_t* pStepLitRows,
+                                                                   int iMinSlice /*=0*/, int iMaxSlice /*=m_GridRes*/)
 {
-    int readOffset = iMinSlice * (GridRes * GridRes);
+    const int      gridRes = (int)m_GridRes;
+    const int      sliceSize = gridRes * gridRes;
+    const uint64_t allRows = getSliceRowMask(gridRes);
+
+    //	Only the slices this call reads are filled
+    uint64_t injectedLitRows[m_nMaxGridRes];
+    if (bFirstStep && pStepLitRows && !pSrcLitRows)
+    {
+        for (int i = max(iMinSlice - 1, 0); i < min(iMaxSlice + 1, gridRes); ++i)
+            injectedLitRows[i] = getLitRows(src + i * sliceSize, gridRes);
+        pSrcLitRows = injectedLitRows;
+    }
+
+    //	Basic directions go through the SoA kernels when the CPU supports one of them
+    const bool               useKernel = !isAdvanced && m_PropagationKernel != PROPAGATION_KERNEL_SCALAR;
+    const PropagationKernel& kernel = aura::getPropagationKernel(useKernel ? m_PropagationKernel : PROPAGATION_KERNEL_SCALAR);
+
+    uint32_t computedRows = 0;
+    for (int i = iMinSlice; i < iMaxSlice; ++i)
+    {
+        int            readOffset = i * sliceSize;
+        const uint64_t activeRows = pStepLitRows ? getActiveRows(pSrcLitRows, gridRes, i) : allRows;
+
+        if (!activeRows)
+        {
+            clearRows<bFirstStep>(targetStep, targetAccum, readOffset, sliceSize);
+        }
+        else if (useKernel)
+        {
+            if (activeRows == allRows)
+            {
+                kernel.propagateSlice(src, targetStep, targetAccum, vCone90Degree, gridRes, i, bFirstStep);
+            }
+            else
+            {
+                for (int j = 0; j < gridRes; ++j, readOffset += gridRes)
+                {
+                    if ((activeRows >> j) & 1)
+                        kernel.propagateRow(src, targetStep, targetAccum, vCone90Degree, gridRes, i, j, bFirstStep);
+                    else
+                        clearRows<bFirstStep>(targetStep, targetAccum, readOffset, gridRes);
+                }
+            }
+        }
+        else if (i == 0)
+        {
+            propagateSlice<bFirstStep, isAdvanced, true, false>(src, targetStep, targetAccum, m_InputOffset, pAdvancedDirections, gridRes,
+                                                                i, activeRows, readOffset);
+        }
+        else if (i < gridRes - 1)
+        {
+            propagateSlice<bFirstStep, isAdvanced, false, false>(src, targetStep, targetAccum, m_InputOffset, pAdvancedDirections, gridRes,
+                                                                 i, activeRows, readOffset);
+        }
+        else
+        {
+            propagateSlice<bFirstStep, isAdvanced, false, true>(src, targetStep, targetAccum, m_InputOffset, pAdvancedDirections, gridRes,
+                                                                i, activeRows, readOffset);
+        }
+
+        //	Rows that were not propagated are dark
+        if (pStepLitRows)
+            pStepLitRows[i] = activeRows;
 
-    bool bLastSlice = false;
+        computedRows += getRowCount(activeRows);
+    }
+
+    m_ComputedRows.fetch_add(computedRows, std::memory_order_relaxed);
+}
 
-    if (iMaxSlice == GridRes)
+/************************************************************************/
+// Incremental propagation
+/************************************************************************/
+//	Propagation is linear apart from dropping light that leaves through the back of a lobe. A delta propagation runs the
+//	first step on the changed rows of the new and of the cached injected light, where that clamp matters most, and the
+//	other steps linearly on the change of the first step. The change is added to the cached result.
+LightPropagationCPUContext::PropagationMode LightPropagationCPUContext::beginIncrementalPropagation()
+{
+    if (!m_UseIncrementalPropagation || m_nPropagationSteps == 0)
     {
-        bLastSlice = true;
-        --iMaxSlice;
+        m_IncrementalCacheValid = false;
+        return PROPAGATION_FULL;
     }
 
-    if (iMinSlice == 0)
+    const int    gridRes = (int)m_GridRes;
+    const int    sliceSize = gridRes * gridRes;
+    const size_t gridSize = m_ElementCount * sizeof(float);
+
+    //	The grid snapped to a new position in setGridCenter or the propagation settings changed
+    const bool cacheValid = m_IncrementalCacheValid && m_IncrementalGridTranslate == m_applyState.mWorldToGridTranslate &&
+                            m_IncrementalPropagationSteps == m_nPropagationSteps &&
+                            m_IncrementalAdvancedDirections == m_UseAdvancedDirections;
+
+    PropagationMode mode = PROPAGATION_FULL;
+    if (cacheValid)
     {
-        ++iMinSlice;
-        propagateSlice<bFirstStep, isAdvanced, true, false>(src, targetStep, targetAccum, 0, readOffset);
+        uint32_t changedRows = 0;
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int i = 0; i < gridRes; ++i)
+            {
+                m_ChangedRows[c][i] = getChangedRows(m_CPUGrids[c] + i * sliceSize, m_IncrementalGrids[c] + i * sliceSize, gridRes);
+                changedRows += getRowCount(m_ChangedRows[c][i]);
+            }
+        }
+
+        //	Basic directions clamp the light of every step, so there is no linear propagation to run a delta with
+        if (changedRows == 0)
+            mode = PROPAGATION_REUSED;
+        else if (m_UseAdvancedDirections && changedRows <= gIncrementalMaxChangedRows * 3 * sliceSize &&
+                 m_DeltaPropagationCount < gIncrementalMaxDeltaPropagations)
+            mode = PROPAGATION_DELTA;
     }
 
+    if (mode == PROPAGATION_REUSED)
+    {
+        for (int c = 0; c < 3; ++c)
+            memcpy(m_CPUGrids[c], m_IncrementalGrids[6 + c], gridSize);
+        return mode;
+    }
+
+    m_IncrementalCacheValid = true;
+    m_IncrementalGridTranslate = m_applyState.mWorldToGridTranslate;
+    m_IncrementalPropagationSteps = m_nPropagationSteps;
+    m_IncrementalAdvancedDirections = m_UseAdvancedDirections;
+    m_DeltaPropagationCount = (mode == PROPAGATION_DELTA) ? m_DeltaPropagationCount + 1 : 0;
+
+    //	The injected light becomes the cached one. The source grids keep the old cached injected light for the first step,
+    //	the later steps use them as step grids.
+    for (int c = 0; c < 3; ++c)
+    {
+        vec4* pTmp = m_CPUGrids[c];
+        m_CPUGrids[c] = m_IncrementalGrids[c];
+        m_IncrementalGrids[c] = pTmp;
+    }
+
+    return mode;
+}
+
+//	Keeps the first step for the next delta propagation. With pPrevInjection the cached first step and injected light are
+//	subtracted, so the following steps propagate the change of the light. Rows the first step didn't compute didn't change.
+static void resolveFirstStep(vec4* targetStep, vec4* targetAccum, const vec4* pPrevInjection, vec4* pPrevFirstStep,
+                             const uint64_t* pStepLitRows, int gridRes, int iMinSlice, int iMaxSlice)
+{
+    const int sliceSize = gridRes * gridRes;
+    if (!pPrevInjection)
+    {
+        memcpy(pPrevFirstStep + iMinSlice * sliceSize, targetStep + iMinSlice * sliceSize,
+               (iMaxSlice - iMinSlice) * sliceSize * sizeof(vec4));
+        return;
+    }
+
+    ASSERT(pStepLitRows);
     for (int i = iMinSlice; i < iMaxSlice; ++i)
     {
-        propagateSlice<bFirstStep, isAdvanced, false, false>(src, targetStep, targetAccum, i, readOffset);
+        for (int j = 0; j < gridRes; ++j)
+        {
+            if (!((pStepLitRows[i] >> j) & 1))
+                continue;
+
+            const int readOffset = i * sliceSize + j * gridRes;
+            for (int k = readOffset; k < readOffset + gridRes; ++k)
+            {
+                const vec4 prevFirstStep = pPrevFirstStep[k];
+                pPrevFirstStep[k] = targetStep[k];
+                targetStep[k] -= prevFirstStep;
+                targetAccum[k] -= pPrevInjection[k] + prevFirstStep;
+            }
+        }
     }
+}
 
-    if (bLastSlice)
+//	Full propagations replace the cached result, delta propagations add their change to it
+static void resolveAccum(vec4* targetAccum, vec4* pCachedAccum, bool deltaPropagation, int gridRes, int iMinSlice, int iMaxSlice)
+{
+    const int sliceSize = gridRes * gridRes;
+    if (!deltaPropagation)
     {
-        propagateSlice<bFirstStep, isAdvanced, false, true>(src, targetStep, targetAccum, GridRes - 1, readOffset);
+        memcpy(pCachedAccum + iMinSlice * sliceSize, targetAccum + iMinSlice * sliceSize,
+               (iMaxSlice - iMinSlice) * sliceSize * sizeof(vec4));
+        return;
+    }
+
+    for (int k = iMinSlice * sliceSize; k < iMaxSlice * sliceSize; ++k)
+    {
+        pCachedAccum[k] += targetAccum[k];
+        targetAccum[k] = pCachedAccum[k];
     }
 }
 
+//	Task managers keep the name pointers, so the names are built once and never change.
+//	Contexts launching on several threads only read them.
+static const char* getPropagationStepName(int step)
+{
+    struct StepNames
+    {
+        char mNames[gPropagationStepNameCount][32];
+
+        StepNames()
+        {
+            for (int i = 0; i < gPropagationStepNameCount; ++i)
+                snprintf(mNames[i], ARRAY_COUNT(mNames[i]), "Propagate step: %d", i);
+        }
+    };
+    static const StepNames names;
+
+    ASSERT(step >= 0 && step < gPropagationStepNameCount);
+    return names.mNames[step];
+}
+
 /************************************************************************/
 // Task callbacks
 /************************************************************************/
@@ -894,42 +1559,54 @@ void LightPropagationCPUContext::TaskDoPropagate(void* pvInfo, int32_t iContext,
 #define TEMP_DISABLE_CPU_PROPAGATION
 #endif
 
-void LightPropagationCPUContext::TaskStep1(void* pvInfo, int32_t iContext, uint32_t uTaskId, uint32_t uTaskCount)
+//	pvInfo points to the three channel contexts of a step. Task ids are interleaved across channels.
+template<bool bFirstStep>
+void LightPropagationCPUContext::TaskStep(void* pvInfo, int32_t iContext, uint32_t uTaskId, uint32_t uTaskCount)
 {
     UNREF_PARAM(iContext);
 #ifndef TEMP_DISABLE_CPU_PROPAGATION
-    int iMinSlice = uTaskId * GridRes / uTaskCount;
-    int iMaxSlice = (uTaskId + 1) * GridRes / uTaskCount;
+    StepContext*                pContext = (StepContext*)pvInfo + uTaskId % 3;
+    LightPropagationCPUContext* pCPUContext = pContext->pContext;
+
+    const uint32_t tasksPerChannel = uTaskCount / 3;
+    const uint32_t chunk = uTaskId / 3;
+    int            iMinSlice = chunk * pCPUContext->m_GridRes / tasksPerChannel;
+    int            iMaxSlice = (chunk + 1) * pCPUContext->m_GridRes / tasksPerChannel;
 
-    StepContext* pContext = (StepContext*)pvInfo;
-    if (pContext->pContext->m_UseAdvancedDirections)
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (pCPUContext->m_UseAdvancedDirections)
     {
-        pContext->pContext->propagateStep<true, true>(pContext->src, pContext->targetStep, pContext->targetAccum, iMinSlice, iMaxSlice);
+        pCPUContext->propagateStep<bFirstStep, true>(pContext->src, pContext->targetStep, pContext->targetAccum,
+                                                     pContext->pAdvancedDirections, pContext->pSrcLitRows, pContext->pStepLitRows,
+                                                     iMinSlice, iMaxSlice);
     }
     else
     {
-        pContext->pContext->propagateStep<true, false>(pContext->src, pContext->targetStep, pContext->targetAccum, iMinSlice, iMaxSlice);
+        pCPUContext->propagateStep<bFirstStep, false>(pContext->src, pContext->targetStep, pContext->targetAccum,
+                                                      pContext->pAdvancedDirections, pContext->pSrcLitRows, pContext->pStepLitRows,
+                                                      iMinSlice, iMaxSlice);
     }
-#endif
-}
-
-void LightPropagationCPUContext::TaskStepN(void* pvInfo, int32_t iContext, uint32_t uTaskId, uint32_t uTaskCount)
-{
-    UNREF_PARAM(iContext);
-#ifndef TEMP_DISABLE_CPU_PROPAGATION
-    int iMinSlice = uTaskId * GridRes / uTaskCount;
-    int iMaxSlice = (uTaskId + 1) * GridRes / uTaskCount;
 
-    StepContext* pContext = (StepContext*)pvInfo;
-    if (pContext->pContext->m_UseAdvancedDirections)
+    //	Both only touch the slices of this task
+    if (bFirstStep && pContext->pPrevFirstStep)
     {
-        pContext->pContext->propagateStep<false, true>(pContext->src, pContext->targetStep, pContext->targetAccum, iMinSlice, iMaxSlice);
+        resolveFirstStep(pContext->targetStep, pContext->targetAccum, pContext->pPrevInjection, pContext->pPrevFirstStep,
+                         pContext->pStepLitRows, pCPUContext->m_GridRes, iMinSlice, iMaxSlice);
     }
-    else
+    if (pContext->pCachedAccum)
     {
-        pContext->pContext->propagateStep<false, false>(pContext->src, pContext->targetStep, pContext->targetAccum, iMinSlice, iMaxSlice);
+        resolveAccum(pContext->targetAccum, pContext->pCachedAccum, pContext->bDeltaPropagation, pCPUContext->m_GridRes, iMinSlice,
+                     iMaxSlice);
     }
 
+    const uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    pCPUContext->m_MeasuredNs.fetch_add(ns, std::memory_order_relaxed);
+    pCPUContext->m_MeasuredSlices.fetch_add(iMaxSlice - iMinSlice, std::memory_order_relaxed);
+#else
+    UNREF_PARAM(pvInfo);
+    UNREF_PARAM(uTaskId);
+    UNREF_PARAM(uTaskCount);
 #endif
 }
 
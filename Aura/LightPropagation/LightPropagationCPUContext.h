@@ -10,12 +10,17 @@
 
 #pragma once
 
+#include "../Interfaces/IAuraMemoryManager.h"
 #include "../Interfaces/IAuraTaskManager.h"
 
+#include <atomic>
+
+#include "../Math/AuraHalf.h"
 #include "../Math/AuraMath.h"
 #include "../Math/AuraVector.h"
 
 #include "LightPropagationCascade.h"
+#include "LightPropagationKernels.h"
 #include "LightPropagationRenderer.h"
 
 #ifdef _MSC_VER
@@ -32,6 +37,16 @@ struct TextureFootprint
     uint64_t mRowPitch;
 };
 
+//	Light a neighbour sends through one face of the cell with advanced directions.
+//	Only depends on the neighbour and the face, so it is built once at load instead of per cell.
+struct AdvancedDirection
+{
+    vec4  mEvalWeights;  //	SH basis for the propagation direction, dotted with the light of the neighbour
+    vec4  mCone;         //	Cosine lobe around the face normal
+    float mFactor;       //	Half the solid angle of the face, 0 for the face the light enters through
+    float mMinLuminance; //	0 drops light leaving through the back of the lobe, -FLT_MAX keeps the propagation linear
+};
+
 class LightPropagationCPUContext
 {
 public:
@@ -41,22 +56,63 @@ public:
         vec4*                       src;
         vec4*                       targetStep;
         vec4*                       targetAccum;
+        //	Lit rows of src and of targetStep, see m_LitRows. NULL without sparse propagation.
+        const uint64_t*             pSrcLitRows;
+        uint64_t*                   pStepLitRows;
+        const AdvancedDirection*    pAdvancedDirections;
+        //	Incremental propagation, NULL otherwise. The first step keeps its result in pPrevFirstStep and for a delta propagation
+        //	turns targetStep and targetAccum into the change of the light. The last step updates pCachedAccum.
+        const vec4*                 pPrevInjection;
+        vec4*                       pPrevFirstStep;
+        vec4*                       pCachedAccum;
+        bool                        bDeltaPropagation;
+    };
+
+    //	How the last propagation got its result
+    enum PropagationMode
+    {
+        PROPAGATION_FULL,   //	All steps on the injected light
+        PROPAGATION_REUSED, //	Injected light didn't change, the cached result was copied
+        PROPAGATION_DELTA   //	Only the change of the injected light was propagated and added to the cached result
     };
 
     enum LP_STATE
     {
         CAPTURED_LIGHT,
+        PROPAGATING_LIGHT,
         PROPAGATED_LIGHT,
         APPLIED_PROPAGATION
     } eState;
 
+    //	Decoupled mode: readback buffer holds light that wasn't propagated yet
+    bool     bLightCaptured;
+    //	Decoupled mode: frame the propagation was launched on
+    uint32_t mLaunchFrame;
+
 public:
     void readData(Cmd* pCmd, Renderer* pRenderer, RenderTarget* m_LightGrids[3], uint32_t numGrids);
     void processData(Renderer* pRenderer, ITaskManager* pTaskManager, MTTypes propagationMTType);
+    //	Propagates the light currently held in the CPU grids, without reading back from the GPU first
+    void propagate(ITaskManager* pTaskManager, MTTypes propagationMTType);
     void applyData(Cmd* pCmd, Renderer* pRenderer, RenderTarget* m_LightGrids[3]);
 
-    bool load(Renderer* pRenderer, RenderTarget* m_LightGrids[3]);
+    //	Decoupled propagation. beginProcessData converts the last readback and launches the propagation
+    //	on worker tasks without waiting. The result can be applied once isProcessDataDone returns true
+    //	and endProcessData has released the tasks.
+    void beginProcessData(Renderer* pRenderer, ITaskManager* pTaskManager, MTTypes propagationMTType);
+    //	beginProcessData without the readback: launches the propagation of the light currently held in the CPU grids
+    void beginPropagate(ITaskManager* pTaskManager, MTTypes propagationMTType);
+    bool isProcessDataDone(ITaskManager* pTaskManager);
+    void endProcessData(ITaskManager* pTaskManager);
+
+    //	CPU grids come from pArena while it has space, from aura::alloc otherwise.
+    //	gridRes has to match the resolution of m_LightGrids.
+    bool load(Renderer* pRenderer, RenderTarget* m_LightGrids[3], uint32_t gridRes, LinearArena* pArena);
     void unload(Renderer* pRenderer, ITaskManager* pTaskManager);
+    //	CPU grids only, no readback buffers: readData, processData and applyData can't be used.
+    //	Light is written straight to getCPUGrid and propagated with propagate.
+    bool loadHeadless(uint32_t gridRes, LinearArena* pArena);
+    void unloadHeadless(ITaskManager* pTaskManager);
 
     // returns false if all staging buffers aren't locked and ready to propagate
     // bool propagateLight(Cmd* pCmd, ITaskManager* pTaskManager, RenderTarget* m_LightGrids[3], MTTypes propagationMTType, int
@@ -65,41 +121,139 @@ public:
     void applyPropagatedLight(Cmd* pCmd, ITaskManager* pTaskManager, RenderTarget* m_LightGrids[3], bool decoupled);
 
     const LightPropagationCascade::State& getApplyState() const { return m_applyState; }
+    const LightPropagationCascade::State& getCaptureState() const { return m_captureState; }
+    void                                  setCaptureState(const LightPropagationCascade::State& val) { m_captureState = val; }
     void                                  setApplyState(const LightPropagationCascade::State& val) { m_applyState = val; }
     void                                  setAdvancedDirections(bool advancedDirections) { m_UseAdvancedDirections = advancedDirections; }
+    //	Kernel used for basic directions. PROPAGATION_KERNEL_SCALAR selects the reference per-cell path.
+    void                                  setPropagationKernel(PropagationKernelType kernel) { m_PropagationKernel = kernel; }
+    PropagationKernelType                 getPropagationKernel() const { return m_PropagationKernel; }
+    //	Grid slices per multi-task propagation task, 0 for adaptive chunking
+    void                                  setSlicesPerTask(uint32_t slicesPerTask) { m_SlicesPerTask = slicesPerTask; }
+    //	Moving average of the time one channel slice takes to propagate, 0 until measured
+    float                                 getSliceCostNs() const { return m_SliceCostNs; }
+    //	Sparse propagation only computes the rows next to light of the previous step and zero-fills the others.
+    //	The result is the same as the dense propagation. On by default.
+    void                                  setSparsePropagation(bool sparse) { m_UseSparsePropagation = sparse; }
+    //	Share of grid rows the last propagation computed over all steps and channels, 1 without sparse propagation
+    float                                 getPropagationOccupancy() const;
+    //	Incremental propagation keeps the injected light and the result of the last propagation. Unchanged light reuses the
+    //	result, small changes with advanced directions only propagate the difference. Everything else, a snapped grid and
+    //	every few delta propagations run in full. Off by default. Can't be changed while a propagation is running.
+    void                                  setIncrementalPropagation(bool incremental);
+    PropagationMode                       getLastPropagationMode() const { return m_LastPropagationMode; }
+
+    //	Runs the multi-task propagation iterations times on the light currently held in the CPU grids and
+    //	returns the average time of one propagation in milliseconds. slicesPerTask 0 uses adaptive chunking.
+    float benchmarkPropagation(ITaskManager* pTaskManager, uint32_t slicesPerTask, uint32_t iterations);
+
+    uint32_t getGridRes() const { return m_GridRes; }
+    //	Number of propagation steps, at most 64
+    void     setPropagationSteps(int propagationSteps);
+    int      getPropagationSteps() const { return m_nPropagationSteps; }
+    //	SH light of a channel, gridRes^3 cells in (i * gridRes + j) * gridRes + k order.
+    //	Holds the injected light before propagate and the accumulated light after it.
+    vec4*    getCPUGrid(uint32_t channel) const { return m_CPUGrids[channel]; }
+
+    //	Bytes of CPU grid storage one context needs for the resolution
+    static size_t getGridStorageSize(uint32_t gridRes);
 
 private:
     void convertGPUtoCPU(Renderer* pRenderer);
     void convertCPUtoGPU();
 
+    void loadGrids(uint32_t gridRes, LinearArena* pArena);
+    void unloadGrids(ITaskManager* pTaskManager);
+
     void launchPropagateSingleTask(ITaskManager* pTaskManager);
-    void launchPropagateMultiTask(ITaskManager* pTaskManager, const int iTasksPerStep = 1);
+    void     launchPropagateMultiTask(ITaskManager* pTaskManager, bool bWait = true);
+    uint32_t getTasksPerChannel(ITaskManager* pTaskManager) const;
+    void     updateSliceCost();
 
     void doPropagate();
 
+    //	Picks the mode of the next propagation. Fills m_ChangedRows for a delta propagation and copies the cached
+    //	result into the source grids when it can be reused.
+    PropagationMode beginIncrementalPropagation();
+
     void SyncToLastTask(ITaskManager* pTaskManager);
 
     template<bool bFirstStep, bool isAdvanced>
 #ifdef _MSC_VER
     __declspec(noalias)
 #endif
-        void propagateStep(vec4* src, vec4* targetStep, vec4* targetAccum, int iMinSlice, int iMaxSlice);
+        void propagateStep(vec4* src, vec4* targetStep, vec4* targetAccum, const AdvancedDirection* pAdvancedDirections,
+                           const uint64_t* pSrcLitRows, uint64_t* pStepLitRows, int iMinSlice, int iMaxSlice);
 
     //	Task handlers
     static void TaskDoPropagate(void* pvInfo, int32_t iContext, uint32_t uTaskId, uint32_t uTaskCount);
-    static void TaskStep1(void* pvInfo, int32_t iContext, uint32_t uTaskId, uint32_t uTaskCount);
-    static void TaskStepN(void* pvInfo, int32_t iContext, uint32_t uTaskId, uint32_t uTaskCount);
+    template<bool bFirstStep>
+    static void TaskStep(void* pvInfo, int32_t iContext, uint32_t uTaskId, uint32_t uTaskCount);
 
 private:
     static const int m_nMaxPropagationSteps = 64;
+    //	MaxGridRes, the rows of a slice are the bits of a uint64_t
+    static const int m_nMaxGridRes = 64;
 
     Buffer*                        m_ReadbackLightGrids[3];
     TextureFootprint               m_ReadbackFootprint;
     vec4*                          m_CPUGrids[9];
+    LinearArena*                   m_pGridArena;
+    uint32_t                       m_GridRes;
+    uint32_t                       m_ElementCount;   //	Floats per grid
+    int                            m_InputOffset[6]; //	Neighbour cell offsets: +k, -k, +j, -j, +i, -i
+    AdvancedDirection              m_AdvancedDirections[6 * 6]; //	Neighbour * 6 + face, both in m_InputOffset order
+    AdvancedDirection              m_LinearAdvancedDirections[6 * 6]; //	Without the clamp, for delta propagations
     ITASKSETHANDLE                 m_hLastTask;
     int                            m_nPropagationSteps;
     bool                           m_UseAdvancedDirections;
+    bool                           m_UseSparsePropagation;
+    PropagationKernelType          m_PropagationKernel;
     StepContext                    m_Contexts[m_nMaxPropagationSteps][3];
     LightPropagationCascade::State m_applyState;
+    LightPropagationCascade::State m_captureState;
+    //	One task set per step covers all three channels
+    ITASKSETHANDLE                 m_hTasks[m_nMaxPropagationSteps];
+    int                            m_nPendingSteps; //	Steps launched by a non-waiting launchPropagateMultiTask
+    uint32_t                       m_SlicesPerTask;
+    float                          m_SliceCostNs;
+    std::atomic<uint64_t>          m_MeasuredNs;
+    std::atomic<uint32_t>          m_MeasuredSlices;
+    //	Per channel, the lit rows of the two step grids. Bit j of slice i is set if row j may hold light.
+    uint64_t                       m_LitRows[3][2][m_nMaxGridRes];
+    std::atomic<uint32_t>          m_ComputedRows;
+    //	Incremental propagation. Per channel the injected light, the first step and the result of the last propagation.
+    //	Allocated by setIncrementalPropagation.
+    bool                           m_UseIncrementalPropagation;
+    vec4*                          m_IncrementalGrids[9];
+    bool                           m_IncrementalCacheValid;
+    //	Settings the cached result was propagated with
+    vec3                           m_IncrementalGridTranslate;
+    int                            m_IncrementalPropagationSteps;
+    bool                           m_IncrementalAdvancedDirections;
+    uint32_t                       m_DeltaPropagationCount; //	Since the last full propagation
+    PropagationMode                m_LastPropagationMode;
+    //	Per channel, rows of the injected light that differ from the cached injected light
+    uint64_t                       m_ChangedRows[3][m_nMaxGridRes];
 };
+
+//	Commands scheduleDecoupledPropagation records for a cascade
+struct DecoupledPropagationOps
+{
+    //	Records the readback of the light grids into the context, see readData
+    void (*capture)(void* pUserData, LightPropagationCPUContext* pContext);
+    //	Records the upload of the propagated light of the context into the light grids, see applyData
+    void (*apply)(void* pUserData, LightPropagationCPUContext* pContext);
+    //	Launches the propagation of the light the context captured, see beginProcessData
+    void (*launch)(void* pUserData, LightPropagationCPUContext* pContext);
+    void* pUserData;
+};
+
+//	One frame of the decoupled propagation of a cascade. Applies the oldest propagation of pContexts that finished at least
+//	latency frames after its launch, launches the light pContexts[readIndex] captured contextCount frames ago and captures
+//	new light into it. The capture is recorded before the apply, so the readback never sees the propagated light.
+//	Doesn't wait on the task manager.
+void scheduleDecoupledPropagation(LightPropagationCPUContext* pContexts, uint32_t contextCount, uint32_t readIndex, uint32_t frame,
+                                  uint32_t latency, const LightPropagationCascade::State& captureState, ITaskManager* pTaskManager,
+                                  const DecoupledPropagationOps& ops);
 } // namespace aura
@@ -14,19 +14,20 @@
 
 namespace aura
 {
-void addLightPropagationCascade(Renderer* pRenderer, float gridSpan, float gridIntensity, uint32_t flags,
+void addLightPropagationCascade(Renderer* pRenderer, float gridSpan, float gridIntensity, uint32_t gridRes, uint32_t flags,
                                 LightPropagationCascade** ppCascade)
 {
     LightPropagationCascade* pCascade = (LightPropagationCascade*)aura::alloc(sizeof(*pCascade));
 
     pCascade->mGridSpan = gridSpan;
     pCascade->mGridIntensity = gridIntensity;
+    pCascade->mGridRes = gridRes;
     pCascade->mFlags = flags;
 
     for (uint32_t i = 0; i < NUM_GRIDS_PER_CASCADE; ++i)
-        addLightPropagationGrid(pRenderer, &pCascade->pLightGrids[i], "LPV Grid RT");
+        addLightPropagationGrid(pRenderer, gridRes, &pCascade->pLightGrids[i], "LPV Grid RT");
 
-    addLightPropagationGrid(pRenderer, &pCascade->pOccluderGrid, "LPV Occlusion Grid RT");
+    addLightPropagationGrid(pRenderer, gridRes, &pCascade->pOccluderGrid, "LPV Occlusion Grid RT");
 
     *ppCascade = pCascade;
 }
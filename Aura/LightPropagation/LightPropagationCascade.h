@@ -33,6 +33,7 @@ typedef struct LightPropagationCascade
 
     float    mGridSpan;
     float    mGridIntensity;
+    uint32_t mGridRes;
     uint32_t mFlags;
 
     State mInjectState;
@@ -41,7 +42,7 @@ typedef struct LightPropagationCascade
     bool mOccludersInjected;
 } LightPropagationCascade;
 
-void addLightPropagationCascade(Renderer* pRenderer, float gridSpan, float gridIntensity, uint32_t flags,
+void addLightPropagationCascade(Renderer* pRenderer, float gridSpan, float gridIntensity, uint32_t gridRes, uint32_t flags,
                                 LightPropagationCascade** ppCascade);
 void removeLightPropagationCascade(Renderer* pRenderer, LightPropagationCascade* pCascade);
 } // namespace aura
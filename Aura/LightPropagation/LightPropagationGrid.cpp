@@ -19,18 +19,20 @@
 
 namespace aura
 {
-void addLightPropagationGrid(Renderer* pRenderer, RenderTarget** ppGrid, const char* pName)
+void addLightPropagationGrid(Renderer* pRenderer, uint32_t gridRes, RenderTarget** ppGrid, const char* pName)
 {
+    ASSERT(isValidGridRes(gridRes));
+
     RenderTargetDesc gridRTDesc = {};
     gridRTDesc.mArraySize = 1;
     gridRTDesc.mClearValue = {};
-    gridRTDesc.mDepth = GridRes;
+    gridRTDesc.mDepth = gridRes;
     gridRTDesc.mDescriptors = DESCRIPTOR_TYPE_TEXTURE;
 #if defined(XBOX)
     gridRTDesc.mFlags |= TEXTURE_CREATION_FLAG_ESRAM;
 #endif
     gridRTDesc.mFormat = TinyImageFormat_R16G16B16A16_SFLOAT;
-    gridRTDesc.mHeight = GridRes;
+    gridRTDesc.mHeight = gridRes;
     gridRTDesc.mSampleCount = SAMPLE_COUNT_1;
 #if USE_COMPUTE_SHADERS
     gridRTDesc.mDescriptors |= DESCRIPTOR_TYPE_RW_TEXTURE;
@@ -38,7 +40,7 @@ void addLightPropagationGrid(Renderer* pRenderer, RenderTarget** ppGrid, const c
 #else
     gridRTDesc.mStartState = RESOURCE_STATE_RENDER_TARGET;
 #endif
-    gridRTDesc.mWidth = GridRes;
+    gridRTDesc.mWidth = gridRes;
     gridRTDesc.pName = pName;
     addRenderTarget(pRenderer, &gridRTDesc, ppGrid);
 }
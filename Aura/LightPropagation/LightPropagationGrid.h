@@ -14,6 +14,6 @@
 
 namespace aura
 {
-void addLightPropagationGrid(Renderer* pRenderer, RenderTarget** ppGrid, const char* pName);
+void addLightPropagationGrid(Renderer* pRenderer, uint32_t gridRes, RenderTarget** ppGrid, const char* pName);
 void removeLightPropagationGrid(Renderer* pRenderer, RenderTarget* pGrid);
 } // namespace aura
@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "LightPropagationKernels.h"
+
+#define NO_FSL_DEFINITIONS
+#include "../Shaders/FSL/lightPropagation.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define KERNEL_TARGET(x)
+#else
+#define KERNEL_TARGET(x) __attribute__((target(x)))
+#endif
+
+namespace aura
+{
+//	Neighbour order matches inputOffset[] and vCone90Degree[] of the reference path:
+//	+k, -k, +j, -j, +i, -i. Missing neighbours along k read the zero padding of the row copy,
+//	missing rows and slices are skipped, so the accumulation order is the same as in propagateCell.
+struct RowNeighbours
+{
+    vec4         paddedRow[MaxGridRes + 2];
+    const float* pNeighbour[6];
+    int          rowOffset;
+};
+
+static inline void setupRowNeighbours(const vec4* src, int res, int i, int j, RowNeighbours* pRow)
+{
+    pRow->rowOffset = (i * res + j) * res;
+
+    memset(&pRow->paddedRow[0], 0, sizeof(vec4));
+    memcpy(&pRow->paddedRow[1], src + pRow->rowOffset, res * sizeof(vec4));
+    memset(&pRow->paddedRow[res + 1], 0, sizeof(vec4));
+
+    pRow->pNeighbour[0] = &pRow->paddedRow[2].x;
+    pRow->pNeighbour[1] = &pRow->paddedRow[0].x;
+    pRow->pNeighbour[2] = (j < res - 1) ? &src[pRow->rowOffset + res].x : NULL;
+    pRow->pNeighbour[3] = (j > 0) ? &src[pRow->rowOffset - res].x : NULL;
+    pRow->pNeighbour[4] = (i < res - 1) ? &src[pRow->rowOffset + res * res].x : NULL;
+    pRow->pNeighbour[5] = (i > 0) ? &src[pRow->rowOffset - res * res].x : NULL;
+}
+
+#if defined(KERNELS_X86)
+/************************************************************************/
+// SSE4.1: 4 cells per iteration
+/************************************************************************/
+KERNEL_TARGET("sse4.1")
+static inline void accumulateSSE41(const float* pSrc, const __m128* cone, __m128* acc)
+{
+    __m128 c0 = _mm_loadu_ps(pSrc + 0);
+    __m128 c1 = _mm_loadu_ps(pSrc + 4);
+    __m128 c2 = _mm_loadu_ps(pSrc + 8);
+    __m128 c3 = _mm_loadu_ps(pSrc + 12);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    __m128 vDot = _mm_mul_ps(c0, cone[0]);
+    vDot = _mm_add_ps(vDot, _mm_mul_ps(c1, cone[1]));
+    vDot = _mm_add_ps(vDot, _mm_mul_ps(c2, cone[2]));
+    vDot = _mm_add_ps(vDot, _mm_mul_ps(c3, cone[3]));
+    vDot = _mm_max_ps(vDot, _mm_setzero_ps());
+
+    acc[0] = _mm_add_ps(acc[0], _mm_mul_ps(cone[0], vDot));
+    acc[1] = _mm_add_ps(acc[1], _mm_mul_ps(cone[1], vDot));
+    acc[2] = _mm_add_ps(acc[2], _mm_mul_ps(cone[2], vDot));
+    acc[3] = _mm_add_ps(acc[3], _mm_mul_ps(cone[3], vDot));
+}
+
+KERNEL_TARGET("sse4.1")
+static void propagateRowSSE41(const vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum, const vec4* pCones,
+                              int res, int i, int j, bool bFirstStep)
+{
+    RowNeighbours row;
+    setupRowNeighbours(src, res, i, j, &row);
+
+    __m128 cones[6][4];
+    for (int d = 0; d < 6; ++d)
+    {
+        cones[d][0] = _mm_set1_ps(pCones[d].x);
+        cones[d][1] = _mm_set1_ps(pCones[d].y);
+        cones[d][2] = _mm_set1_ps(pCones[d].z);
+        cones[d][3] = _mm_set1_ps(pCones[d].w);
+    }
+
+    const float* pBase = bFirstStep ? &src[row.rowOffset].x : &targetAccum[row.rowOffset].x;
+    float*       pStep = &targetStep[row.rowOffset].x;
+    float*       pAccum = &targetAccum[row.rowOffset].x;
+
+    for (int k = 0; k < res; k += 4)
+    {
+        __m128 acc[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+        for (int d = 0; d < 6; ++d)
+        {
+            if (row.pNeighbour[d])
+                accumulateSSE41(row.pNeighbour[d] + k * 4, cones[d], acc);
+        }
+
+        _MM_TRANSPOSE4_PS(acc[0], acc[1], acc[2], acc[3]);
+        for (int c = 0; c < 4; ++c)
+        {
+            const int offset = (k + c) * 4;
+            _mm_storeu_ps(pStep + offset, acc[c]);
+            _mm_storeu_ps(pAccum + offset, _mm_add_ps(acc[c], _mm_loadu_ps(pBase + offset)));
+        }
+    }
+}
+
+KERNEL_TARGET("sse4.1")
+static void propagateSliceSSE41(const vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum, const vec4* pCones,
+                                int res, int i, bool bFirstStep)
+{
+    for (int j = 0; j < res; ++j)
+        propagateRowSSE41(src, targetStep, targetAccum, pCones, res, i, j, bFirstStep);
+}
+
+/************************************************************************/
+// AVX2: 8 cells per iteration. Cells k..k+3 go to the low lane, k+4..k+7 to the high lane.
+/************************************************************************/
+KERNEL_TARGET("avx2")
+static inline void transposeAVX2(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+{
+    const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    const __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    const __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+KERNEL_TARGET("avx2")
+static inline __m256 loadCellPairAVX2(const float* pLow, const float* pHigh)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pLow)), _mm_loadu_ps(pHigh), 1);
+}
+
+KERNEL_TARGET("avx2")
+static inline void accumulateAVX2(const float* pSrc, const __m256* cone, __m256* acc)
+{
+    __m256 c0 = loadCellPairAVX2(pSrc + 0, pSrc + 16);
+    __m256 c1 = loadCellPairAVX2(pSrc + 4, pSrc + 20);
+    __m256 c2 = loadCellPairAVX2(pSrc + 8, pSrc + 24);
+    __m256 c3 = loadCellPairAVX2(pSrc + 12, pSrc + 28);
+    transposeAVX2(c0, c1, c2, c3);
+
+    __m256 vDot = _mm256_mul_ps(c0, cone[0]);
+    vDot = _mm256_add_ps(vDot, _mm256_mul_ps(c1, cone[1]));
+    vDot = _mm256_add_ps(vDot, _mm256_mul_ps(c2, cone[2]));
+    vDot = _mm256_add_ps(vDot, _mm256_mul_ps(c3, cone[3]));
+    vDot = _mm256_max_ps(vDot, _mm256_setzero_ps());
+
+    acc[0] = _mm256_add_ps(acc[0], _mm256_mul_ps(cone[0], vDot));
+    acc[1] = _mm256_add_ps(acc[1], _mm256_mul_ps(cone[1], vDot));
+    acc[2] = _mm256_add_ps(acc[2], _mm256_mul_ps(cone[2], vDot));
+    acc[3] = _mm256_add_ps(acc[3], _mm256_mul_ps(cone[3], vDot));
+}
+
+KERNEL_TARGET("avx2")
+static void propagateRowAVX2(const vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum, const vec4* pCones,
+                             int res, int i, int j, bool bFirstStep)
+{
+    RowNeighbours row;
+    setupRowNeighbours(src, res, i, j, &row);
+
+    __m256 cones[6][4];
+    for (int d = 0; d < 6; ++d)
+    {
+        cones[d][0] = _mm256_set1_ps(pCones[d].x);
+        cones[d][1] = _mm256_set1_ps(pCones[d].y);
+        cones[d][2] = _mm256_set1_ps(pCones[d].z);
+        cones[d][3] = _mm256_set1_ps(pCones[d].w);
+    }
+
+    const float* pBase = bFirstStep ? &src[row.rowOffset].x : &targetAccum[row.rowOffset].x;
+    float*       pStep = &targetStep[row.rowOffset].x;
+    float*       pAccum = &targetAccum[row.rowOffset].x;
+
+    for (int k = 0; k < res; k += 8)
+    {
+        __m256 acc[4] = { _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps() };
+        for (int d = 0; d < 6; ++d)
+        {
+            if (row.pNeighbour[d])
+                accumulateAVX2(row.pNeighbour[d] + k * 4, cones[d], acc);
+        }
+
+        transposeAVX2(acc[0], acc[1], acc[2], acc[3]);
+        for (int c = 0; c < 4; ++c)
+        {
+            const int    offsetLow = (k + c) * 4;
+            const int    offsetHigh = (k + c + 4) * 4;
+            const __m128 resLow = _mm256_castps256_ps128(acc[c]);
+            const __m128 resHigh = _mm256_extractf128_ps(acc[c], 1);
+            _mm_storeu_ps(pStep + offsetLow, resLow);
+            _mm_storeu_ps(pStep + offsetHigh, resHigh);
+            _mm_storeu_ps(pAccum + offsetLow, _mm_add_ps(resLow, _mm_loadu_ps(pBase + offsetLow)));
+            _mm_storeu_ps(pAccum + offsetHigh, _mm_add_ps(resHigh, _mm_loadu_ps(pBase + offsetHigh)));
+        }
+    }
+}
+
+KERNEL_TARGET("avx2")
+static void propagateSliceAVX2(const vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum, const vec4* pCones,
+                               int res, int i, bool bFirstStep)
+{
+    for (int j = 0; j < res; ++j)
+        propagateRowAVX2(src, targetStep, targetAccum, pCones, res, i, j, bFirstStep);
+}
+
+/************************************************************************/
+// CPU feature detection
+/************************************************************************/
+static void cpuid(int leaf, int subLeaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, leaf, subLeaf);
+    for (int i = 0; i < 4; ++i)
+        regs[i] = (unsigned int)info[i];
+#else
+    __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long xgetbv0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+static bool cpuSupportsSSE41()
+{
+    unsigned int regs[4];
+    cpuid(1, 0, regs);
+    return (regs[2] & (1u << 19)) != 0;
+}
+
+static bool cpuSupportsAVX2()
+{
+    unsigned int regs[4];
+    cpuid(0, 0, regs);
+    if (regs[0] < 7)
+        return false;
+
+    cpuid(1, 0, regs);
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    //	OS has to save YMM state on context switches
+    if (!osxsave || !avx || (xgetbv0() & 0x6) != 0x6)
+        return false;
+
+    cpuid(7, 0, regs);
+    return (regs[1] & (1u << 5)) != 0;
+}
+#endif // KERNELS_X86
+
+#if defined(KERNELS_NEON)
+/************************************************************************/
+// NEON: 4 cells per iteration, vld4/vst4 do the transposition
+/************************************************************************/
+static inline void accumulateNEON(const float* pSrc, const float32x4_t* cone, float32x4_t* acc)
+{
+    const float32x4x4_t c = vld4q_f32(pSrc);
+
+    float32x4_t vDot = vmulq_f32(c.val[0], cone[0]);
+    vDot = vaddq_f32(vDot, vmulq_f32(c.val[1], cone[1]));
+    vDot = vaddq_f32(vDot, vmulq_f32(c.val[2], cone[2]));
+    vDot = vaddq_f32(vDot, vmulq_f32(c.val[3], cone[3]));
+    vDot = vmaxq_f32(vDot, vdupq_n_f32(0.0f));
+
+    acc[0] = vaddq_f32(acc[0], vmulq_f32(cone[0], vDot));
+    acc[1] = vaddq_f32(acc[1], vmulq_f32(cone[1], vDot));
+    acc[2] = vaddq_f32(acc[2], vmulq_f32(cone[2], vDot));
+    acc[3] = vaddq_f32(acc[3], vmulq_f32(cone[3], vDot));
+}
+
+static void propagateRowNEON(const vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum, const vec4* pCones,
+                             int res, int i, int j, bool bFirstStep)
+{
+    RowNeighbours row;
+    setupRowNeighbours(src, res, i, j, &row);
+
+    float32x4_t cones[6][4];
+    for (int d = 0; d < 6; ++d)
+    {
+        cones[d][0] = vdupq_n_f32(pCones[d].x);
+        cones[d][1] = vdupq_n_f32(pCones[d].y);
+        cones[d][2] = vdupq_n_f32(pCones[d].z);
+        cones[d][3] = vdupq_n_f32(pCones[d].w);
+    }
+
+    const float* pBase = bFirstStep ? &src[row.rowOffset].x : &targetAccum[row.rowOffset].x;
+    float*       pStep = &targetStep[row.rowOffset].x;
+    float*       pAccum = &targetAccum[row.rowOffset].x;
+
+    for (int k = 0; k < res; k += 4)
+    {
+        float32x4x4_t out;
+        for (int c = 0; c < 4; ++c)
+            out.val[c] = vdupq_n_f32(0.0f);
+
+        for (int d = 0; d < 6; ++d)
+        {
+            if (row.pNeighbour[d])
+                accumulateNEON(row.pNeighbour[d] + k * 4, cones[d], out.val);
+        }
+
+        vst4q_f32(pStep + k * 4, out);
+
+        float32x4x4_t base = vld4q_f32(pBase + k * 4);
+        for (int c = 0; c < 4; ++c)
+            base.val[c] = vaddq_f32(out.val[c], base.val[c]);
+        vst4q_f32(pAccum + k * 4, base);
+    }
+}
+
+static void propagateSliceNEON(const vec4* __restrict src, vec4* __restrict targetStep, vec4* __restrict targetAccum, const vec4* pCones,
+                               int res, int i, bool bFirstStep)
+{
+    for (int j = 0; j < res; ++j)
+        propagateRowNEON(src, targetStep, targetAccum, pCones, res, i, j, bFirstStep);
+}
+#endif // KERNELS_NEON
+
+/************************************************************************/
+// Dispatch
+/************************************************************************/
+static const PropagationKernel gPropagationKernels[PROPAGATION_KERNEL_COUNT] = {
+    { "Scalar", NULL, NULL },
+#if defined(KERNELS_X86)
+    { "SSE4.1", propagateRowSSE41, propagateSliceSSE41 },
+    { "AVX2", propagateRowAVX2, propagateSliceAVX2 },
+#else
+    { "SSE4.1", NULL, NULL },
+    { "AVX2", NULL, NULL },
+#endif
+#if defined(KERNELS_NEON)
+    { "NEON", propagateRowNEON, propagateSliceNEON },
+#else
+    { "NEON", NULL, NULL },
+#endif
+};
+
+const PropagationKernel& getPropagationKernel(PropagationKernelType type) { return gPropagationKernels[type]; }
+
+bool isPropagationKernelSupported(PropagationKernelType type)
+{
+    switch (type)
+    {
+    case PROPAGATION_KERNEL_SCALAR:
+        return true;
+#if defined(KERNELS_X86)
+    case PROPAGATION_KERNEL_SSE41:
+        return cpuSupportsSSE41();
+    case PROPAGATION_KERNEL_AVX2:
+        return cpuSupportsAVX2();
+#endif
+#if defined(KERNELS_NEON)
+    case PROPAGATION_KERNEL_NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+static PropagationKernelType findBestPropagationKernel()
+{
+    int best = PROPAGATION_KERNEL_SCALAR;
+    for (int i = PROPAGATION_KERNEL_SCALAR + 1; i < PROPAGATION_KERNEL_COUNT; ++i)
+    {
+        if (isPropagationKernelSupported((PropagationKernelType)i))
+            best = i;
+    }
+    return (PropagationKernelType)best;
+}
+
+PropagationKernelType getBestPropagationKernel()
+{
+    //	Initialized once, concurrent first calls wait for it
+    static const PropagationKernelType bestKernel = findBestPropagationKernel();
+    return bestKernel;
+}
+} // namespace aura
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include "../Math/AuraVector.h"
+
+namespace aura
+{
+//	Structure-of-arrays propagation kernels. Each call handles a whole row (or slice) of the grid.
+//	The grid stays in the vec4-per-cell layout, kernels transpose blocks of cells into registers.
+enum PropagationKernelType
+{
+    PROPAGATION_KERNEL_SCALAR = 0, //	Reference per-cell path in LightPropagationCPUContext.cpp
+    PROPAGATION_KERNEL_SSE41,
+    PROPAGATION_KERNEL_AVX2,
+    PROPAGATION_KERNEL_NEON,
+    PROPAGATION_KERNEL_COUNT
+};
+
+//	(src, targetStep, targetAccum, cones, grid resolution, slice, row, first step)
+//	The resolution has to be a multiple of GridResGranularity no larger than MaxGridRes.
+typedef void (*PROPAGATEROWFUNC)(const vec4*, vec4*, vec4*, const vec4*, int, int, int, bool);
+//	(src, targetStep, targetAccum, cones, grid resolution, slice, first step)
+typedef void (*PROPAGATESLICEFUNC)(const vec4*, vec4*, vec4*, const vec4*, int, int, bool);
+
+struct PropagationKernel
+{
+    const char*        pName;
+    PROPAGATEROWFUNC   propagateRow;
+    PROPAGATESLICEFUNC propagateSlice;
+};
+
+//	Returns NULL functions for PROPAGATION_KERNEL_SCALAR and for kernels not compiled for this architecture.
+const PropagationKernel& getPropagationKernel(PropagationKernelType type);
+bool                     isPropagationKernelSupported(PropagationKernelType type);
+//	Fastest kernel supported by the CPU we are running on. Detected once.
+PropagationKernelType    getBestPropagationKernel();
+} // namespace aura
@@ -33,7 +33,20 @@ namespace aura
 {
 Aura* gAura = NULL;
 
-float getCellSize(LightPropagationCascade* pCascade) { return pCascade->mGridSpan / GridRes; }
+float getCellSize(LightPropagationCascade* pCascade) { return pCascade->mGridSpan / pCascade->mGridRes; }
+
+RenderTarget** getWorkingGrids(Aura* pAura, uint32_t cascade) { return pAura->pWorkingGrids + cascade * NUM_GRIDS_PER_CASCADE * 2; }
+
+//	Index of the first cascade with the same resolution, it owns the working grids
+uint32_t getWorkingGridsOwner(Aura* pAura, uint32_t cascade)
+{
+    for (uint32_t i = 0; i < cascade; ++i)
+    {
+        if (pAura->pCascades[i]->mGridRes == pAura->pCascades[cascade]->mGridRes)
+            return i;
+    }
+    return cascade;
+}
 
 float getSideHalf(LightPropagationCascade* pCascade) { return pCascade->mGridSpan / 2.0f; }
 
@@ -137,16 +150,35 @@ void initAura(Renderer* pRenderer, uint32_t rtWidth, uint32_t rtHeight, LightPro
     gAura->pCascades = (LightPropagationCascade**)aura::alloc(gAura->mCascadeCount * sizeof(*gAura->pCascades));
     for (uint32_t i = 0; i < gAura->mCascadeCount; ++i)
     {
-        addLightPropagationCascade(gAura->pRenderer, pCascades[i].mGridSpan, pCascades[i].mGridIntensity, pCascades[i].mFlags,
+        const bool     bHasGridRes = i < sizeof(params.iGridRes) / sizeof(params.iGridRes[0]) && params.iGridRes[i] != 0;
+        const uint32_t gridRes = bHasGridRes ? params.iGridRes[i] : GridRes;
+        ASSERT(isValidGridRes(gridRes));
+        addLightPropagationCascade(gAura->pRenderer, pCascades[i].mGridSpan, pCascades[i].mGridIntensity, gridRes, pCascades[i].mFlags,
                                    &gAura->pCascades[i]);
     }
 
-    for (uint32_t i = 0; i < 6; ++i)
-        addLightPropagationGrid(gAura->pRenderer, &gAura->pWorkingGrids[i], "LPV Working Grid RT");
-        /************************************************************************/
-        // CPU contexts
-        /************************************************************************/
+    gAura->pWorkingGrids =
+        (RenderTarget**)aura::alloc(gAura->mCascadeCount * NUM_GRIDS_PER_CASCADE * 2 * sizeof(*gAura->pWorkingGrids));
+    for (uint32_t i = 0; i < gAura->mCascadeCount; ++i)
+    {
+        RenderTarget** ppWorkingGrids = getWorkingGrids(gAura, i);
+        const uint32_t owner = getWorkingGridsOwner(gAura, i);
+        for (uint32_t j = 0; j < NUM_GRIDS_PER_CASCADE * 2; ++j)
+        {
+            if (owner == i)
+                addLightPropagationGrid(gAura->pRenderer, gAura->pCascades[i]->mGridRes, &ppWorkingGrids[j], "LPV Working Grid RT");
+            else
+                ppWorkingGrids[j] = getWorkingGrids(gAura, owner)[j];
+        }
+    }
+    /************************************************************************/
+    // CPU contexts
+    /************************************************************************/
 #ifdef ENABLE_CPU_PROPAGATION
+    size_t gridStorageSize = 0;
+    for (uint32_t i = 0; i < gAura->mCascadeCount; ++i)
+        gridStorageSize += NUM_GRIDS_PER_CASCADE * LightPropagationCPUContext::getGridStorageSize(gAura->pCascades[i]->mGridRes);
+    initLinearArena(gridStorageSize, &gAura->mGridArena);
     loadCPUPropagationResources(pRenderer, gAura);
 #endif
     /************************************************************************/
@@ -206,7 +238,8 @@ void loadCPUPropagationResources(Renderer* pRenderer, Aura* pAura)
         pAura->m_CPUContexts[i] = (LightPropagationCPUContext*)aura::alloc(NUM_GRIDS_PER_CASCADE * sizeof(LightPropagationCPUContext));
         for (uint32_t j = 0; j < NUM_GRIDS_PER_CASCADE; ++j)
         {
-            pAura->m_CPUContexts[i][j].load(pRenderer, pAura->pCascades[0]->pLightGrids);
+            LightPropagationCascade* pCascade = pAura->pCascades[i];
+            pAura->m_CPUContexts[i][j].load(pRenderer, pCascade->pLightGrids, pCascade->mGridRes, &pAura->mGridArena);
         }
     }
 #endif
@@ -255,19 +288,34 @@ void exitAura(Renderer* pRenderer, ITaskManager* pTaskManager, Aura* pAura)
     // CPU contexts
     /************************************************************************/
     unloadCPUPropagationResources(pRenderer, pTaskManager, pAura);
+#ifdef ENABLE_CPU_PROPAGATION
+    exitLinearArena(&pAura->mGridArena);
+#endif
 
     /************************************************************************/
     /************************************************************************/
     for (uint32_t i = 0; i < pAura->mCascadeCount; ++i)
     {
-        removeLightPropagationCascade(pAura->pRenderer, pAura->pCascades[i]);
+        if (getWorkingGridsOwner(pAura, i) != i)
+            continue;
+
+        RenderTarget** ppWorkingGrids = getWorkingGrids(pAura, i);
+        for (uint32_t j = 0; j < NUM_GRIDS_PER_CASCADE * 2; ++j)
+            removeLightPropagationGrid(pAura->pRenderer, ppWorkingGrids[j]);
     }
 
-    for (uint32_t i = 0; i < 6; ++i)
-        removeLightPropagationGrid(pAura->pRenderer, pAura->pWorkingGrids[i]);
+    for (uint32_t i = 0; i < pAura->mCascadeCount; ++i)
+    {
+        removeLightPropagationCascade(pAura->pRenderer, pAura->pCascades[i]);
+    }
 
+    aura::dealloc(pAura->pWorkingGrids);
     aura::dealloc(pAura->pCascades);
     aura::dealloc(pAura);
+
+#ifdef ENABLE_DEFAULT_MEMORY_MANAGER
+    trimMemoryPools();
+#endif
 }
 
 bool doAlternateGPUUpdates(Aura* pAura)
@@ -344,7 +392,7 @@ void injectRSM(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t iVolume, co
     //	and surfel area.
 
     float gridArea = pCascade->mGridSpan * pCascade->mGridSpan;
-    float gridCellArea = gridArea / (GridRes * GridRes);
+    float gridCellArea = gridArea / (pCascade->mGridRes * pCascade->mGridRes);
     float blockingPotentialFactor = RSMSurfelAreaScaleFactor / gridCellArea;
 #ifdef PRESCALE_LIGHT_VALUES
     blockingPotentialFactor *= pCascade->mGridIntensity;
@@ -367,6 +415,7 @@ void injectRSM(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t iVolume, co
     data.smoothGridPosOffset = pCascade->mInjectState.mSmoothTCOffset;
     data.WorldToGridScale = pCascade->mInjectState.mWorldToGridScale;
     data.WorldToGridTranslate = pCascade->mInjectState.mWorldToGridTranslate;
+    data.gridRes = pCascade->mGridRes;
     memcpy(pAura->pUniformBufferInjectRSM[pAura->mFrameIdx][iVolume]->pCpuMappedAddress, &data, sizeof(LightInjectionData));
 
     BindRenderTargetsDesc bindRenderTargets = {};
@@ -376,8 +425,8 @@ void injectRSM(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t iVolume, co
         bindRenderTargets.mRenderTargets[i] = { pCascade->pLightGrids[i], LOAD_ACTION_CLEAR };
     }
     cmdBindRenderTargets(pCmd, &bindRenderTargets);
-    cmdSetViewport(pCmd, 0.0f, 0.0f, (float)GridRes, (float)GridRes, 0.0f, 1.0f);
-    cmdSetScissor(pCmd, 0, 0, GridRes, GridRes);
+    cmdSetViewport(pCmd, 0.0f, 0.0f, (float)pCascade->mGridRes, (float)pCascade->mGridRes, 0.0f, 1.0f);
+    cmdSetScissor(pCmd, 0, 0, pCascade->mGridRes, pCascade->mGridRes);
     cmdBindPipeline(pCmd, pAura->pPipelineInjectRSMLight);
     DescriptorData params[4] = {};
     params[0].pName = "uniforms";
@@ -430,6 +479,12 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
     Pipeline* pPipelinePropagateN =
         pAura->pPipelineLightPropagateN[pAura->mParams.bUseMultipleReflections][pAura->mParams.bUseAdvancedPropagation];
     LightPropagationCascade* pCascade = pAura->pCascades[cascade];
+    RenderTarget**           ppWorkingGrids = getWorkingGrids(pAura, cascade);
+    const uint32_t           gridRes = pCascade->mGridRes;
+
+    PropagationSetupRootConstant rootConstant = {};
+    rootConstant.fPropagationScale = pAura->mParams.fPropagationScale;
+    rootConstant.uGridRes = gridRes;
 
 #if USE_COMPUTE_SHADERS
     /************************************************************************/
@@ -438,8 +493,8 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
     cmdBindPipeline(pCmd, pPipelinePropagate1);
     cmdBindDescriptorSet(pCmd, cascade, pAura->pDescriptorSetLightPropagate1);
     cmdBindPushConstants(pCmd, pAura->pRootSignatureLightPropagate1, pAura->mPropagation1RootConstantIndex,
-                         &pAura->mParams.fPropagationScale);
-    cmdDispatch(pCmd, GridRes / WorkGroupSize, GridRes / WorkGroupSize, GridRes / WorkGroupSize);
+                         &rootConstant);
+    cmdDispatch(pCmd, gridRes / WorkGroupSize, gridRes / WorkGroupSize, gridRes / WorkGroupSize);
     /************************************************************************/
     // Barriers
     /************************************************************************/
@@ -447,7 +502,7 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
     for (uint32_t i = 0; i < NUM_GRIDS_PER_CASCADE; ++i)
     {
         barriers[i * 2] = { pCascade->pLightGrids[i], RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS };
-        barriers[i * 2 + 1] = { pAura->pWorkingGrids[i], RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_SHADER_RESOURCE };
+        barriers[i * 2 + 1] = { ppWorkingGrids[i], RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_SHADER_RESOURCE };
     }
     cmdResourceBarrier(pCmd, 0, NULL, 0, NULL, NUM_GRIDS_PER_CASCADE * 2, barriers);
     /************************************************************************/
@@ -455,7 +510,7 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
     /************************************************************************/
     cmdBindPipeline(pCmd, pAura->pPipelineLightCopy);
     cmdBindDescriptorSet(pCmd, cascade, pAura->pDescriptorSetLightCopy);
-    cmdDispatch(pCmd, GridRes / WorkGroupSize, GridRes / WorkGroupSize, GridRes / WorkGroupSize);
+    cmdDispatch(pCmd, gridRes / WorkGroupSize, gridRes / WorkGroupSize, gridRes / WorkGroupSize);
     /************************************************************************/
     /************************************************************************/
 #else
@@ -466,16 +521,16 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
     bindRenderTargets.mRenderTargetCount = NUM_GRIDS_PER_CASCADE;
     for (uint32_t i = 0; i < NUM_GRIDS_PER_CASCADE; ++i)
     {
-        bindRenderTargets.mRenderTargets[i] = { pAura->pWorkingGrids[i], LOAD_ACTION_CLEAR };
+        bindRenderTargets.mRenderTargets[i] = { ppWorkingGrids[i], LOAD_ACTION_CLEAR };
     }
     cmdBindRenderTargets(pCmd, &bindRenderTargets);
-    cmdSetViewport(pCmd, 0.0f, 0.0f, (float)GridRes, (float)GridRes, 0.0f, 1.0f);
-    cmdSetScissor(pCmd, 0, 0, GridRes, GridRes);
+    cmdSetViewport(pCmd, 0.0f, 0.0f, (float)gridRes, (float)gridRes, 0.0f, 1.0f);
+    cmdSetScissor(pCmd, 0, 0, gridRes, gridRes);
     cmdBindPipeline(pCmd, pPipelinePropagate1);
     cmdBindDescriptorSet(pCmd, cascade, pAura->pDescriptorSetLightPropagate1[pAura->mParams.bUseAdvancedPropagation]);
     cmdBindPushConstants(pCmd, pAura->pRootSignatureLightPropagate1[pAura->mParams.bUseAdvancedPropagation],
-                         pAura->mPropagation1RootConstantIndex[pAura->mParams.bUseAdvancedPropagation], &pAura->mParams.fPropagationScale);
-    cmdDrawInstanced(pCmd, 3, 0, GridRes, 0);
+                         pAura->mPropagation1RootConstantIndex[pAura->mParams.bUseAdvancedPropagation], &rootConstant);
+    cmdDrawInstanced(pCmd, 3, 0, gridRes, 0);
     cmdBindRenderTargets(pCmd, NULL);
     /************************************************************************/
     // Barriers
@@ -484,7 +539,7 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
     for (uint32_t i = 0; i < NUM_GRIDS_PER_CASCADE; ++i)
     {
         barriers[i * 2] = { pCascade->pLightGrids[i], RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET };
-        barriers[i * 2 + 1] = { pAura->pWorkingGrids[i], RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE };
+        barriers[i * 2 + 1] = { ppWorkingGrids[i], RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE };
     }
     cmdResourceBarrier(pCmd, 0, NULL, 0, NULL, NUM_GRIDS_PER_CASCADE * 2, barriers);
     /************************************************************************/
@@ -499,7 +554,8 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
     cmdBindRenderTargets(pCmd, &bindRenderTargets);
     cmdBindPipeline(pCmd, pAura->pPipelineLightCopy);
     cmdBindDescriptorSet(pCmd, cascade * 2 + 0, pAura->pDescriptorSetLightCopy);
-    cmdDrawInstanced(pCmd, 3, 0, GridRes, 0);
+    cmdBindPushConstants(pCmd, pAura->pRootSignatureLightCopy, pAura->mLightCopyRootConstantIndex, &rootConstant);
+    cmdDrawInstanced(pCmd, 3, 0, gridRes, 0);
     cmdBindRenderTargets(pCmd, NULL);
     /************************************************************************/
     /************************************************************************/
@@ -516,14 +572,14 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
 #if USE_COMPUTE_SHADERS
         cmdBindPipeline(pCmd, pPipelinePropagateN);
         cmdBindPushConstants(pCmd, pAura->pRootSignatureLightPropagateN, pAura->mPropagationNRootConstantIndex,
-                             &pAura->mParams.fPropagationScale);
+                             &rootConstant);
         cmdBindDescriptorSet(pCmd, cascade * 2 + !(i & 0x1), pAura->pDescriptorSetLightPropagateN);
-        cmdDispatch(pCmd, GridRes / WorkGroupSize, GridRes / WorkGroupSize, GridRes / WorkGroupSize);
+        cmdDispatch(pCmd, gridRes / WorkGroupSize, gridRes / WorkGroupSize, gridRes / WorkGroupSize);
 
         for (uint32_t j = 0; j < NUM_GRIDS_PER_CASCADE; ++j)
         {
-            barriers[j * 2] = { pAura->pWorkingGrids[3 * bPhase + j], RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_SHADER_RESOURCE };
-            barriers[j * 2 + 1] = { pAura->pWorkingGrids[3 * !bPhase + j], RESOURCE_STATE_SHADER_RESOURCE,
+            barriers[j * 2] = { ppWorkingGrids[3 * bPhase + j], RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_SHADER_RESOURCE };
+            barriers[j * 2 + 1] = { ppWorkingGrids[3 * !bPhase + j], RESOURCE_STATE_SHADER_RESOURCE,
                                     RESOURCE_STATE_UNORDERED_ACCESS };
         }
         cmdResourceBarrier(pCmd, 0, NULL, 0, NULL, NUM_GRIDS_PER_CASCADE * 2, barriers);
@@ -546,7 +602,7 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
         bindRenderTargets.mRenderTargetCount = NUM_GRIDS_PER_CASCADE;
         for (uint32_t j = 0; j < NUM_GRIDS_PER_CASCADE; ++j)
         {
-            bindRenderTargets.mRenderTargets[j] = { pAura->pWorkingGrids[3 * bPhase + j], LOAD_ACTION_LOAD };
+            bindRenderTargets.mRenderTargets[j] = { ppWorkingGrids[3 * bPhase + j], LOAD_ACTION_LOAD };
         }
         cmdBindRenderTargets(pCmd, &bindRenderTargets);
 #endif // PROPAGATE_ACCUMULATE_ONE_PASS
@@ -555,8 +611,8 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
         cmdBindDescriptorSet(pCmd, cascade * 2 + !(i & 0x1), pAura->pDescriptorSetLightPropagateN[pAura->mParams.bUseAdvancedPropagation]);
         cmdBindPushConstants(pCmd, pAura->pRootSignatureLightPropagateN[pAura->mParams.bUseAdvancedPropagation],
                              pAura->mPropagationNRootConstantIndex[pAura->mParams.bUseAdvancedPropagation],
-                             &pAura->mParams.fPropagationScale);
-        cmdDrawInstanced(pCmd, 3, 0, GridRes, 0);
+                             &rootConstant);
+        cmdDrawInstanced(pCmd, 3, 0, gridRes, 0);
 
 #ifdef PROPOGATE_ACCUMULATE_ONE_PASS
 #else
@@ -568,8 +624,8 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
 #if !defined(PROPAGATE_ACCUMULATE_ONE_PASS) && !USE_COMPUTE_SHADERS
         for (uint32_t j = 0; j < NUM_GRIDS_PER_CASCADE; ++j)
         {
-            barriers[j * 2] = { pAura->pWorkingGrids[3 * bPhase + j], RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE };
-            barriers[j * 2 + 1] = { pAura->pWorkingGrids[3 * !bPhase + j], RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET };
+            barriers[j * 2] = { ppWorkingGrids[3 * bPhase + j], RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_SHADER_RESOURCE };
+            barriers[j * 2 + 1] = { ppWorkingGrids[3 * !bPhase + j], RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET };
         }
         cmdResourceBarrier(pCmd, 0, NULL, 0, NULL, NUM_GRIDS_PER_CASCADE * 2, barriers);
 
@@ -583,7 +639,8 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
         cmdBindRenderTargets(pCmd, &bindRenderTargets);
         cmdBindPipeline(pCmd, pAura->pPipelineLightCopy);
         cmdBindDescriptorSet(pCmd, cascade * 2 + (i & 0x1), pAura->pDescriptorSetLightCopy);
-        cmdDrawInstanced(pCmd, 3, 0, GridRes, 0);
+        cmdBindPushConstants(pCmd, pAura->pRootSignatureLightCopy, pAura->mLightCopyRootConstantIndex, &rootConstant);
+        cmdDrawInstanced(pCmd, 3, 0, gridRes, 0);
         cmdBindRenderTargets(pCmd, NULL);
 #endif // PROPAGATE_ACCUMULATE_ONE_PASS
 
@@ -593,7 +650,7 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
 
     for (uint32_t i = 0; i < NUM_GRIDS_PER_CASCADE; ++i)
     {
-        barriers[i] = { pAura->pWorkingGrids[3 * !bPhase + i], RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_LPV };
+        barriers[i] = { ppWorkingGrids[3 * !bPhase + i], RESOURCE_STATE_SHADER_RESOURCE, RESOURCE_STATE_LPV };
     }
     cmdResourceBarrier(pCmd, 0, NULL, 0, NULL, NUM_GRIDS_PER_CASCADE, barriers);
     /************************************************************************/
@@ -604,6 +661,75 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t cascad
     cmdEndDebugMarker(pCmd);
 }
 
+#ifdef ENABLE_CPU_PROPAGATION
+struct DecoupledPropagationFrame
+{
+    Cmd*          pCmd;
+    Renderer*     pRenderer;
+    ITaskManager* pTaskManager;
+    Aura*         pAura;
+    uint32_t      mCascade;
+};
+
+static void captureLightDecoupled(void* pUserData, LightPropagationCPUContext* pContext)
+{
+    DecoupledPropagationFrame* pFrame = (DecoupledPropagationFrame*)pUserData;
+    pContext->readData(pFrame->pCmd, pFrame->pRenderer, pFrame->pAura->pCascades[pFrame->mCascade]->pLightGrids, NUM_GRIDS_PER_CASCADE);
+}
+
+static void applyLightDecoupled(void* pUserData, LightPropagationCPUContext* pContext)
+{
+    DecoupledPropagationFrame* pFrame = (DecoupledPropagationFrame*)pUserData;
+    LightPropagationCascade*   pCascade = pFrame->pAura->pCascades[pFrame->mCascade];
+    pContext->applyData(pFrame->pCmd, pFrame->pRenderer, pCascade->pLightGrids);
+    pCascade->mApplyState = pContext->getApplyState();
+}
+
+static void launchLightDecoupled(void* pUserData, LightPropagationCPUContext* pContext)
+{
+    DecoupledPropagationFrame* pFrame = (DecoupledPropagationFrame*)pUserData;
+    const CPUPropagationParams& params = pFrame->pAura->mCPUParams;
+    pContext->setAdvancedDirections(params.bAdvancedDirections);
+    pContext->setSlicesPerTask(params.uSlicesPerTask);
+    pContext->setIncrementalPropagation(params.bIncremental);
+    pContext->beginProcessData(pFrame->pRenderer, pFrame->pTaskManager, params.eMTMode);
+}
+
+//	Propagation runs on worker tasks across frame boundaries. Every frame we capture new light into this frame's
+//	context, apply the oldest finished propagation of each cascade and launch the light captured into this frame's
+//	context mInFlightFrameCount frames ago. Nothing here waits on the task manager.
+static void propagateLightDecoupled(Cmd* pCmd, Renderer* pRenderer, ITaskManager* pTaskManager, Aura* pAura)
+{
+    const uint32_t frame = pAura->mCPUPropagationFrame++;
+    const uint32_t readIndex = pAura->mFrameIdx % pAura->mInFlightFrameCount;
+
+    DecoupledPropagationFrame     decoupledFrame = { pCmd, pRenderer, pTaskManager, pAura, 0 };
+    const DecoupledPropagationOps ops = { captureLightDecoupled, applyLightDecoupled, launchLightDecoupled, &decoupledFrame };
+
+    for (uint32_t i = 0; i < pAura->mCascadeCount; ++i)
+    {
+        decoupledFrame.mCascade = i;
+        scheduleDecoupledPropagation(pAura->m_CPUContexts[i], pAura->mInFlightFrameCount, readIndex, frame,
+                                     pAura->mCPUParams.uDecoupledLatency, pAura->pCascades[i]->mInjectState, pTaskManager, ops);
+    }
+}
+#endif
+
+#ifdef ENABLE_CPU_PROPAGATION
+void benchmarkCPUPropagation(ITaskManager* pTaskManager, Aura* pAura, uint32_t cascade, const uint32_t* pSlicesPerTask,
+                             uint32_t configCount, uint32_t iterations, float* pOutMs)
+{
+    ASSERT(cascade < pAura->mCascadeCount);
+    LightPropagationCPUContext* pContext = &pAura->m_CPUContexts[cascade][0];
+    if (LightPropagationCPUContext::PROPAGATING_LIGHT == pContext->eState)
+        pContext->endProcessData(pTaskManager);
+
+    pContext->setAdvancedDirections(pAura->mCPUParams.bAdvancedDirections);
+    for (uint32_t i = 0; i < configCount; ++i)
+        pOutMs[i] = pContext->benchmarkPropagation(pTaskManager, pSlicesPerTask[i], iterations);
+}
+#endif
+
 void propagateLight(Cmd* pCmd, Renderer* pRenderer, ITaskManager* pTaskManager, Aura* pAura)
 {
 #ifdef ENABLE_CPU_PROPAGATION
@@ -614,16 +740,27 @@ void propagateLight(Cmd* pCmd, Renderer* pRenderer, ITaskManager* pTaskManager,
     }
     pAura->bUseCPUPropagationPreviousFrame = pAura->mParams.bUseCPUPropagation;
 
-    if (pAura->mParams.bUseCPUPropagation)
+    if (pAura->mParams.bUseCPUPropagation && pAura->mCPUParams.bDecoupled)
+    {
+        propagateLightDecoupled(pCmd, pRenderer, pTaskManager, pAura);
+    }
+    else if (pAura->mParams.bUseCPUPropagation)
     {
         int readIndex = pAura->mFrameIdx % pAura->mInFlightFrameCount;
 
         for (uint32_t i = 0; i < pAura->mCascadeCount; ++i)
         {
+            //	Propagation launched in decoupled mode still owns the CPU grids
+            if (LightPropagationCPUContext::PROPAGATING_LIGHT == pAura->m_CPUContexts[i][readIndex].eState)
+                pAura->m_CPUContexts[i][readIndex].endProcessData(pTaskManager);
+
+            pAura->m_CPUContexts[i][readIndex].bLightCaptured = false;
             pAura->m_CPUContexts[i][readIndex].readData(pCmd, pRenderer, pAura->pCascades[i]->pLightGrids, NUM_GRIDS_PER_CASCADE);
             pAura->m_CPUContexts[i][readIndex].setApplyState(pAura->pCascades[i]->mInjectState);
             pAura->m_CPUContexts[i][readIndex].eState = LightPropagationCPUContext::CAPTURED_LIGHT;
             pAura->m_CPUContexts[i][readIndex].setAdvancedDirections(pAura->mCPUParams.bAdvancedDirections);
+            pAura->m_CPUContexts[i][readIndex].setSlicesPerTask(pAura->mCPUParams.uSlicesPerTask);
+            pAura->m_CPUContexts[i][readIndex].setIncrementalPropagation(pAura->mCPUParams.bIncremental);
         }
 
         int propagateIndex = (pAura->mFrameIdx - pAura->mInFlightFrameCount) % pAura->mInFlightFrameCount;
@@ -682,14 +819,15 @@ void getLightApplyData(Aura* pAura, const mat4& invVP, const vec3& camPos, Light
     data->camPos = camPos;
     data->invMvp = transpose(invVP);
     data->lumScale = float3(pAura->mParams.fFresnel, pAura->mParams.fSpecScale, pAura->mParams.fSpecPow);
-    data->normalScale = float3(1.0f / GridRes);
+    //	One cell of the finest cascade, the apply shader offsets the sample position along the normal by it
+    data->normalScale = float3(1.0f / pAura->pCascades[0]->mGridRes);
     data->cascadeCount = pAura->mCascadeCount;
     data->GIStrength = pAura->mParams.fGIStrength;
 
     for (uint32_t i = 0; i < pAura->mCascadeCount; i++)
     {
         LightPropagationCascade* pCascade = pAura->pCascades[i];
-        const float              cellSize = (pCascade->mGridSpan / GridRes);
+        const float              cellSize = getCellSize(pCascade);
 
         data->cascade[i].WorldToGridScale = pCascade->mApplyState.mWorldToGridScale;
         data->cascade[i].WorldToGridTranslate = pCascade->mApplyState.mWorldToGridTranslate;
@@ -755,6 +893,7 @@ void drawLpvVisualization(Cmd* cmd, Renderer* pRenderer, Aura* pAura, RenderTarg
     data.invView = transpose(inverseView);
     data.probeRadius = probeRadius;
     data.lightScale = pAura->mParams.fLightScale[cascadeIndex];
+    data.gridRes = cascade->mGridRes;
     memcpy(pAura->pUniformBufferVisualizationData[pAura->mFrameIdx]->pCpuMappedAddress, &data, sizeof(data));
 
     DescriptorData params[2] = {};
@@ -766,7 +905,7 @@ void drawLpvVisualization(Cmd* cmd, Renderer* pRenderer, Aura* pAura, RenderTarg
     updateDescriptorSet(pRenderer, pAura->mFrameIdx, pAura->pDescriptorSetVisualizeLPV, 2, params);
     cmdBindDescriptorSet(cmd, pAura->mFrameIdx, pAura->pDescriptorSetVisualizeLPV);
 
-    cmdDraw(cmd, QuadVertexCount * GridRes * GridRes * GridRes, 0);
+    cmdDraw(cmd, QuadVertexCount * cascade->mGridRes * cascade->mGridRes * cascade->mGridRes, 0);
 
     cmdBindRenderTargets(cmd, NULL);
 
@@ -953,6 +1092,7 @@ void addRootSignatures()
     copyRootDesc.ppStaticSamplerNames = pStaticSamplerNames;
     copyRootDesc.ppStaticSamplers = pStaticSamplers;
     addRootSignature(gAura->pRenderer, &copyRootDesc, &gAura->pRootSignatureLightCopy);
+    gAura->mLightCopyRootConstantIndex = getDescriptorIndexFromName(gAura->pRootSignatureLightCopy, "PropagationSetupRootConstant");
 
     RootSignatureDesc visualizeLPVRootDesc = { &gAura->pShaderLPVVisualize, 1 };
     visualizeLPVRootDesc.mStaticSamplerCount = 1;
@@ -1202,7 +1342,7 @@ void prepareDescriptorSets()
         for (uint32_t i = 0; i < NUM_GRIDS_PER_CASCADE; ++i)
             pTex[i] = gAura->pCascades[cascade]->pLightGrids[i]->pTexture;
         for (uint32_t i = 0; i < NUM_GRIDS_PER_CASCADE * 2; ++i)
-            pWorkingTex[i] = gAura->pWorkingGrids[i]->pTexture;
+            pWorkingTex[i] = getWorkingGrids(gAura, cascade)[i]->pTexture;
 
         // Light propagate 1
         {
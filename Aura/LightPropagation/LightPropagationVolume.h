@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include "../Interfaces/IAuraMemoryManager.h"
 #include "../Interfaces/IAuraTaskManager.h"
 
 #include "../Config/AuraParams.h"
@@ -67,10 +68,15 @@ typedef struct Aura
     bool                         bUseCPUPropagationPreviousFrame; // Used to detect if switching between CPU and GPU propagation.
     // The CPU propagation runs behind the GPU by this many frames so that data is always available.
     uint32_t                     mInFlightFrameCount;
+    // Monotonic frame counter used to order decoupled propagations.
+    uint32_t                     mCPUPropagationFrame;
+    // Storage of the CPU grids of every context, sized for all cascades at initAura.
+    LinearArena                  mGridArena;
 #endif
     int32_t mGPUPropagationCurrentGrid;
 
-    RenderTarget*             pWorkingGrids[6];
+    //	Six ping-pong grids per cascade. Cascades of the same resolution share the grids of the first one.
+    RenderTarget**            pWorkingGrids;
     uint32_t                  mCascadeCount;
     LightPropagationCascade** pCascades;
 
@@ -105,6 +111,7 @@ typedef struct Aura
     RootSignature* pRootSignatureVisualizeLPV;
     uint32_t       mPropagation1RootConstantIndex[2];
     uint32_t       mPropagationNRootConstantIndex[2];
+    uint32_t       mLightCopyRootConstantIndex;
 
     DescriptorSet* pDescriptorSetInjectRSMLight;
     DescriptorSet* pDescriptorSetLightPropagate1[2];
@@ -149,6 +156,12 @@ void injectRSM(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, uint32_t iVolume, co
 void captureLight(Cmd* pCmd, Aura* pAura);
 
 void propagateLight(Cmd* pCmd, Renderer* pRenderer, ITaskManager* pTaskManager, Aura* pAura);
+#ifdef ENABLE_CPU_PROPAGATION
+//	Times the CPU propagation of the light held by a cascade for each slices-per-task setting (0 = adaptive)
+//	and writes the average milliseconds per propagation to pOutMs[configCount].
+void benchmarkCPUPropagation(ITaskManager* pTaskManager, Aura* pAura, uint32_t cascade, const uint32_t* pSlicesPerTask,
+                             uint32_t configCount, uint32_t iterations, float* pOutMs);
+#endif
 void applyLight(Cmd* pCmd, Renderer* pRenderer, Aura* pAura, const mat4& invVP, const vec3& camPos, Texture* normalRT, Texture* depthRT,
                 Texture* ambientOcclusionRT);
 void getLightApplyData(Aura* pAura, const mat4& invVP, const vec3& camPos, LightApplyData* data);
@@ -0,0 +1,271 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "AuraHalf.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HALF_F16C
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define HALF_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define HALF_TARGET(x)
+#else
+#define HALF_TARGET(x) __attribute__((target(x)))
+#endif
+
+namespace aura
+{
+static inline uint32_t asUint(float x)
+{
+    uint32_t u;
+    memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+static inline float asFloat(uint32_t u)
+{
+    float x;
+    memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+/************************************************************************/
+// Scalar
+/************************************************************************/
+//	half -> float bits = mantissa[offset[h >> 10] + (h & 0x3FF)] + exponent[h >> 10]
+//	Mantissa blocks: [0, 1024) denormals, [1024, 2048) normals, [2048, 3072) infinity and quiet NaNs.
+struct HalfToFloatTables
+{
+    uint32_t mMantissa[3072];
+    uint32_t mExponent[64];
+    uint16_t mOffset[64];
+
+    HalfToFloatTables()
+    {
+        mMantissa[0] = 0;
+        for (uint32_t i = 1; i < 1024; ++i)
+        {
+            //	Normalize the denormal
+            uint32_t m = i << 13;
+            uint32_t e = 0;
+            while ((m & 0x00800000) == 0)
+            {
+                e -= 0x00800000;
+                m <<= 1;
+            }
+            mMantissa[i] = (m & ~0x00800000) | (e + 0x38800000);
+        }
+        for (uint32_t i = 0; i < 1024; ++i)
+        {
+            mMantissa[1024 + i] = 0x38000000 + (i << 13);
+            mMantissa[2048 + i] = 0x38000000 + ((i << 13) | (i ? 0x00400000 : 0));
+        }
+
+        for (uint32_t i = 0; i < 32; ++i)
+        {
+            mExponent[i] = i << 23;
+            mExponent[32 + i] = 0x80000000 | (i << 23);
+            mOffset[i] = mOffset[32 + i] = 1024;
+        }
+        mExponent[0] = 0;
+        mExponent[32] = 0x80000000;
+        mExponent[31] = 0x47800000;
+        mExponent[63] = 0xC7800000;
+        mOffset[0] = mOffset[32] = 0;
+        mOffset[31] = mOffset[63] = 2048;
+    }
+};
+
+static const HalfToFloatTables& getHalfToFloatTables()
+{
+    static const HalfToFloatTables tables;
+    return tables;
+}
+
+static inline uint16_t floatToHalfBits(uint32_t f)
+{
+    const uint32_t sign = (f >> 16) & 0x8000;
+    f &= 0x7FFFFFFF;
+
+    //	Normal range: rebias the exponent and round to nearest even
+    const uint32_t normal = (f + ((uint32_t)(15 - 127) << 23) + 0xFFF + ((f >> 13) & 1)) >> 13;
+    //	Denormal range: adding 0.5 moves the mantissa into place and lets the FPU do the rounding
+    const uint32_t denormal = asUint(asFloat(f < 0x38800000 ? f : 0) + 0.5f) - 0x3F000000;
+    //	Overflow rounds to infinity, NaNs are quieted and keep the top of their payload
+    const uint32_t special = (f > 0x7F800000) ? (0x7E00 | ((f >> 13) & 0x3FF)) : 0x7C00;
+
+    const uint32_t h = (f >= 0x47800000) ? special : (f < 0x38800000) ? denormal : normal;
+    return (uint16_t)(h | sign);
+}
+
+static void convertHalfToFloatScalar(const half* pSrc, float* pDst, size_t count)
+{
+    const HalfToFloatTables& tables = getHalfToFloatTables();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint32_t h = pSrc[i].sh;
+        pDst[i] = asFloat(tables.mMantissa[tables.mOffset[h >> 10] + (h & 0x3FF)] + tables.mExponent[h >> 10]);
+    }
+}
+
+static void convertFloatToHalfScalar(const float* pSrc, half* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        pDst[i].sh = floatToHalfBits(asUint(pSrc[i]));
+}
+
+#if defined(HALF_F16C)
+/************************************************************************/
+// F16C: 8 values per iteration
+/************************************************************************/
+HALF_TARGET("avx,f16c")
+static void convertHalfToFloatF16C(const half* pSrc, float* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(pDst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(pSrc + i))));
+    convertHalfToFloatScalar(pSrc + i, pDst + i, count - i);
+}
+
+HALF_TARGET("avx,f16c")
+static void convertFloatToHalfF16C(const float* pSrc, half* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm256_cvtps_ph(_mm256_loadu_ps(pSrc + i), _MM_FROUND_TO_NEAREST_INT));
+    convertFloatToHalfScalar(pSrc + i, pDst + i, count - i);
+}
+
+static bool cpuSupportsF16C()
+{
+    unsigned int regs[4];
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    for (int i = 0; i < 4; ++i)
+        regs[i] = (unsigned int)info[i];
+#else
+    __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    const bool f16c = (regs[2] & (1u << 29)) != 0;
+    if (!osxsave || !avx || !f16c)
+        return false;
+
+    //	OS has to save YMM state on context switches
+#if defined(_MSC_VER)
+    return (_xgetbv(0) & 0x6) == 0x6;
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (eax & 0x6) == 0x6;
+#endif
+}
+#endif // HALF_F16C
+
+#if defined(HALF_NEON)
+/************************************************************************/
+// NEON: 4 values per iteration
+/************************************************************************/
+static void convertHalfToFloatNEON(const half* pSrc, float* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(pDst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(&pSrc[i].sh))));
+    convertHalfToFloatScalar(pSrc + i, pDst + i, count - i);
+}
+
+static void convertFloatToHalfNEON(const float* pSrc, half* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        vst1_u16(&pDst[i].sh, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(pSrc + i))));
+    convertFloatToHalfScalar(pSrc + i, pDst + i, count - i);
+}
+#endif // HALF_NEON
+
+/************************************************************************/
+// Dispatch
+/************************************************************************/
+static const HalfConversion gHalfConversions[HALF_CONVERSION_COUNT] = {
+    { "Table", convertHalfToFloatScalar, convertFloatToHalfScalar },
+#if defined(HALF_F16C)
+    { "F16C", convertHalfToFloatF16C, convertFloatToHalfF16C },
+#else
+    { "F16C", NULL, NULL },
+#endif
+#if defined(HALF_NEON)
+    { "NEON", convertHalfToFloatNEON, convertFloatToHalfNEON },
+#else
+    { "NEON", NULL, NULL },
+#endif
+};
+
+const HalfConversion& getHalfConversion(HalfConversionType type) { return gHalfConversions[type]; }
+
+bool isHalfConversionSupported(HalfConversionType type)
+{
+    switch (type)
+    {
+    case HALF_CONVERSION_TABLE:
+        return true;
+#if defined(HALF_F16C)
+    case HALF_CONVERSION_F16C:
+        return cpuSupportsF16C();
+#endif
+#if defined(HALF_NEON)
+    case HALF_CONVERSION_NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+static HalfConversionType findBestHalfConversion()
+{
+    //	Tails of accelerated conversions use the tables too
+    getHalfToFloatTables();
+
+    int best = HALF_CONVERSION_TABLE;
+    for (int i = HALF_CONVERSION_TABLE; i < HALF_CONVERSION_COUNT; ++i)
+    {
+        if (isHalfConversionSupported((HalfConversionType)i))
+            best = i;
+    }
+    return (HalfConversionType)best;
+}
+
+//	Initialized once, concurrent first calls wait for it
+static const HalfConversion& getBestHalfConversion()
+{
+    static const HalfConversion& conversion = getHalfConversion(findBestHalfConversion());
+    return conversion;
+}
+
+void convertHalfToFloat(const half* pSrc, float* pDst, size_t count) { getBestHalfConversion().halfToFloat(pSrc, pDst, count); }
+
+void convertFloatToHalf(const float* pSrc, half* pDst, size_t count) { getBestHalfConversion().floatToHalf(pSrc, pDst, count); }
+
+bool isHalfConversionAccelerated() { return &getBestHalfConversion() != &gHalfConversions[HALF_CONVERSION_TABLE]; }
+} // namespace aura
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#ifndef __AURAHALF_H_3C1F5B8E_7A2D_4E61_9B0C_5D84E2A6F913_INCLUDED__
+#define __AURAHALF_H_3C1F5B8E_7A2D_4E61_9B0C_5D84E2A6F913_INCLUDED__
+
+#include <stddef.h>
+
+#include "AuraVector.h"
+
+namespace aura
+{
+//	Bulk conversions between half and float buffers, meant for whole rows or slices of the LPV grids.
+//	F16C on x86 and NEON on ARM64 when available, table-driven scalar code otherwise. All paths return the same
+//	bits: floats round to nearest even, denormals are kept, NaNs keep their payload but always come back quiet.
+void convertHalfToFloat(const half* pSrc, float* pDst, size_t count);
+void convertFloatToHalf(const float* pSrc, half* pDst, size_t count);
+
+//	True if the conversions above run on conversion instructions instead of the scalar fallback
+bool isHalfConversionAccelerated();
+
+//	Every path on its own, the conversions above use the fastest one supported
+enum HalfConversionType
+{
+    HALF_CONVERSION_TABLE = 0, //	Scalar fallback, tables for half to float
+    HALF_CONVERSION_F16C,
+    HALF_CONVERSION_NEON,
+    HALF_CONVERSION_COUNT
+};
+
+typedef void (*HALFTOFLOATFUNC)(const half*, float*, size_t);
+typedef void (*FLOATTOHALFFUNC)(const float*, half*, size_t);
+
+struct HalfConversion
+{
+    const char*     pName;
+    HALFTOFLOATFUNC halfToFloat;
+    FLOATTOHALFFUNC floatToHalf;
+};
+
+//	Returns NULL functions for paths not compiled for this architecture.
+const HalfConversion& getHalfConversion(HalfConversionType type);
+bool                  isHalfConversionSupported(HalfConversionType type);
+} // namespace aura
+
+#endif //__AURAHALF_H_3C1F5B8E_7A2D_4E61_9B0C_5D84E2A6F913_INCLUDED__
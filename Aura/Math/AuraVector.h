@@ -96,25 +96,73 @@ struct vec2
     void operator/=(const vec2& v);
 };
 
-vec2 operator+(const vec2& u, const vec2& v);
-vec2 operator+(const vec2& v, const float s);
-vec2 operator+(const float s, const vec2& v);
+inline void vec2::operator+=(const float s)
+{
+    x += s;
+    y += s;
+}
+
+inline void vec2::operator+=(const vec2& v)
+{
+    x += v.x;
+    y += v.y;
+}
+
+inline void vec2::operator-=(const float s)
+{
+    x -= s;
+    y -= s;
+}
+
+inline void vec2::operator-=(const vec2& v)
+{
+    x -= v.x;
+    y -= v.y;
+}
+
+inline void vec2::operator*=(const float s)
+{
+    x *= s;
+    y *= s;
+}
+
+inline void vec2::operator*=(const vec2& v)
+{
+    x *= v.x;
+    y *= v.y;
+}
+
+inline void vec2::operator/=(const float s)
+{
+    x /= s;
+    y /= s;
+}
+
+inline void vec2::operator/=(const vec2& v)
+{
+    x /= v.x;
+    y /= v.y;
+}
+
+inline vec2 operator+(const vec2& u, const vec2& v) { return vec2(u.x + v.x, u.y + v.y); }
+inline vec2 operator+(const vec2& v, const float s) { return vec2(v.x + s, v.y + s); }
+inline vec2 operator+(const float s, const vec2& v) { return vec2(v.x + s, v.y + s); }
 
-vec2 operator-(const vec2& u, const vec2& v);
-vec2 operator-(const vec2& v, const float s);
-vec2 operator-(const float s, const vec2& v);
+inline vec2 operator-(const vec2& u, const vec2& v) { return vec2(u.x - v.x, u.y - v.y); }
+inline vec2 operator-(const vec2& v, const float s) { return vec2(v.x - s, v.y - s); }
+inline vec2 operator-(const float s, const vec2& v) { return vec2(v.x - s, v.y - s); }
 
-vec2 operator-(const vec2& v);
+inline vec2 operator-(const vec2& v) { return vec2(-v.x, -v.y); }
 
-vec2 operator*(const vec2& u, const vec2& v);
-vec2 operator*(const float s, const vec2& v);
-vec2 operator*(const vec2& v, const float s);
+inline vec2 operator*(const vec2& u, const vec2& v) { return vec2(u.x * v.x, u.y * v.y); }
+inline vec2 operator*(const float s, const vec2& v) { return vec2(v.x * s, v.y * s); }
+inline vec2 operator*(const vec2& v, const float s) { return vec2(v.x * s, v.y * s); }
 
-vec2 operator/(const vec2& u, const vec2& v);
-vec2 operator/(const vec2& v, const float s);
-vec2 operator/(const float s, const vec2& v);
+inline vec2 operator/(const vec2& u, const vec2& v) { return vec2(u.x / v.x, u.y / v.y); }
+inline vec2 operator/(const vec2& v, const float s) { return vec2(v.x / s, v.y / s); }
+inline vec2 operator/(const float s, const vec2& v) { return vec2(s / v.x, s / v.y); }
 
-bool operator==(const vec2& u, const vec2& v);
+inline bool operator==(const vec2& u, const vec2& v) { return (u.x == v.x && u.y == v.y); }
 
 /* --------------------------------------------------------------------------------- */
 
@@ -160,25 +208,81 @@ struct vec3
     void operator/=(const vec3& v);
 };
 
-vec3 operator+(const vec3& u, const vec3& v);
-vec3 operator+(const vec3& v, const float s);
-vec3 operator+(const float s, const vec3& v);
+inline void vec3::operator+=(const float s)
+{
+    x += s;
+    y += s;
+    z += s;
+}
+
+inline void vec3::operator+=(const vec3& v)
+{
+    x += v.x;
+    y += v.y;
+    z += v.z;
+}
+
+inline void vec3::operator-=(const float s)
+{
+    x -= s;
+    y -= s;
+    z -= s;
+}
+
+inline void vec3::operator-=(const vec3& v)
+{
+    x -= v.x;
+    y -= v.y;
+    z -= v.z;
+}
+
+inline void vec3::operator*=(const float s)
+{
+    x *= s;
+    y *= s;
+    z *= s;
+}
+
+inline void vec3::operator*=(const vec3& v)
+{
+    x *= v.x;
+    y *= v.y;
+    z *= v.z;
+}
+
+inline void vec3::operator/=(const float s)
+{
+    x /= s;
+    y /= s;
+    z /= s;
+}
+
+inline void vec3::operator/=(const vec3& v)
+{
+    x /= v.x;
+    y /= v.y;
+    z /= v.z;
+}
+
+inline vec3 operator+(const vec3& u, const vec3& v) { return vec3(u.x + v.x, u.y + v.y, u.z + v.z); }
+inline vec3 operator+(const vec3& v, const float s) { return vec3(v.x + s, v.y + s, v.z + s); }
+inline vec3 operator+(const float s, const vec3& v) { return vec3(v.x + s, v.y + s, v.z + s); }
 
-vec3 operator-(const vec3& u, const vec3& v);
-vec3 operator-(const vec3& v, const float s);
-vec3 operator-(const float s, const vec3& v);
+inline vec3 operator-(const vec3& u, const vec3& v) { return vec3(u.x - v.x, u.y - v.y, u.z - v.z); }
+inline vec3 operator-(const vec3& v, const float s) { return vec3(v.x - s, v.y - s, v.z - s); }
+inline vec3 operator-(const float s, const vec3& v) { return vec3(v.x - s, v.y - s, v.z - s); }
 
-vec3 operator-(const vec3& v);
+inline vec3 operator-(const vec3& v) { return vec3(-v.x, -v.y, -v.z); }
 
-vec3 operator*(const vec3& u, const vec3& v);
-vec3 operator*(const float s, const vec3& v);
-vec3 operator*(const vec3& v, const float s);
+inline vec3 operator*(const vec3& u, const vec3& v) { return vec3(u.x * v.x, u.y * v.y, u.z * v.z); }
+inline vec3 operator*(const float s, const vec3& v) { return vec3(v.x * s, v.y * s, v.z * s); }
+inline vec3 operator*(const vec3& v, const float s) { return vec3(v.x * s, v.y * s, v.z * s); }
 
-vec3 operator/(const vec3& u, const vec3& v);
-vec3 operator/(const vec3& v, const float s);
-vec3 operator/(const float s, const vec3& v);
+inline vec3 operator/(const vec3& u, const vec3& v) { return vec3(u.x / v.x, u.y / v.y, u.z / v.z); }
+inline vec3 operator/(const vec3& v, const float s) { return vec3(v.x / s, v.y / s, v.z / s); }
+inline vec3 operator/(const float s, const vec3& v) { return vec3(s / v.x, s / v.y, s / v.z); }
 
-bool operator==(const vec3& u, const vec3& v);
+inline bool operator==(const vec3& u, const vec3& v) { return (u.x == v.x && u.y == v.y && u.z == v.z); }
 
 /* --------------------------------------------------------------------------------- */
 
@@ -260,102 +364,282 @@ struct vec4
     void operator/=(const vec4& v);
 };
 
-vec4 operator+(const vec4& u, const vec4& v);
-vec4 operator+(const vec4& v, const float s);
-vec4 operator+(const float s, const vec4& v);
+inline void vec4::operator+=(const float s)
+{
+    x += s;
+    y += s;
+    z += s;
+    w += s;
+}
+
+inline void vec4::operator+=(const vec4& v)
+{
+    x += v.x;
+    y += v.y;
+    z += v.z;
+    w += v.w;
+}
+
+inline void vec4::operator-=(const float s)
+{
+    x -= s;
+    y -= s;
+    z -= s;
+    w -= s;
+}
+
+inline void vec4::operator-=(const vec4& v)
+{
+    x -= v.x;
+    y -= v.y;
+    z -= v.z;
+    w -= v.w;
+}
+
+inline void vec4::operator*=(const float s)
+{
+    x *= s;
+    y *= s;
+    z *= s;
+    w *= s;
+}
+
+inline void vec4::operator*=(const vec4& v)
+{
+    x *= v.x;
+    y *= v.y;
+    z *= v.z;
+    w *= v.w;
+}
+
+inline void vec4::operator/=(const float s)
+{
+    x /= s;
+    y /= s;
+    z /= s;
+    w /= s;
+}
+
+inline void vec4::operator/=(const vec4& v)
+{
+    x /= v.x;
+    y /= v.y;
+    z /= v.z;
+    w /= v.w;
+}
+
+inline vec4 operator+(const vec4& u, const vec4& v) { return vec4(u.x + v.x, u.y + v.y, u.z + v.z, u.w + v.w); }
+inline vec4 operator+(const vec4& v, const float s) { return vec4(v.x + s, v.y + s, v.z + s, v.w + s); }
+inline vec4 operator+(const float s, const vec4& v) { return vec4(v.x + s, v.y + s, v.z + s, v.w + s); }
 
-vec4 operator-(const vec4& u, const vec4& v);
-vec4 operator-(const vec4& v, const float s);
-vec4 operator-(const float s, const vec4& v);
+inline vec4 operator-(const vec4& u, const vec4& v) { return vec4(u.x - v.x, u.y - v.y, u.z - v.z, u.w - v.w); }
+inline vec4 operator-(const vec4& v, const float s) { return vec4(v.x - s, v.y - s, v.z - s, v.w - s); }
+inline vec4 operator-(const float s, const vec4& v) { return vec4(v.x - s, v.y - s, v.z - s, v.w - s); }
 
-vec4 operator-(const vec4& v);
+inline vec4 operator-(const vec4& v) { return vec4(-v.x, -v.y, -v.z, -v.w); }
 
-vec4 operator*(const vec4& u, const vec4& v);
-vec4 operator*(const float s, const vec4& v);
-vec4 operator*(const vec4& v, const float s);
+inline vec4 operator*(const vec4& u, const vec4& v) { return vec4(u.x * v.x, u.y * v.y, u.z * v.z, u.w * v.w); }
+inline vec4 operator*(const float s, const vec4& v) { return vec4(v.x * s, v.y * s, v.z * s, v.w * s); }
+inline vec4 operator*(const vec4& v, const float s) { return vec4(v.x * s, v.y * s, v.z * s, v.w * s); }
 
-vec4 operator/(const vec4& u, const vec4& v);
-vec4 operator/(const vec4& v, const float s);
-vec4 operator/(const float s, const vec4& v);
+inline vec4 operator/(const vec4& u, const vec4& v) { return vec4(u.x / v.x, u.y / v.y, u.z / v.z, u.w / v.w); }
+inline vec4 operator/(const vec4& v, const float s) { return vec4(v.x / s, v.y / s, v.z / s, v.w / s); }
+inline vec4 operator/(const float s, const vec4& v) { return vec4(s / v.x, s / v.y, s / v.z, s / v.w); }
 
-bool operator==(const vec4& u, const vec4& v);
+inline bool operator==(const vec4& u, const vec4& v) { return (u.x == v.x && u.y == v.y && u.z == v.z && u.w && v.w); }
 
 /* --------------------------------------------------------------------------------- */
 
-float dot(const vec2& u, const vec2& v);
-float dot(const vec3& u, const vec3& v);
-float dot(const vec4& u, const vec4& v);
-
-float lerp(const float u, const float v, const float x);
-vec2  lerp(const vec2& u, const vec2& v, const float x);
-vec3  lerp(const vec3& u, const vec3& v, const float x);
-vec4  lerp(const vec4& u, const vec4& v, const float x);
-vec2  lerp(const vec2& u, const vec2& v, const vec2& x);
-vec3  lerp(const vec3& u, const vec3& v, const vec3& x);
-vec4  lerp(const vec4& u, const vec4& v, const vec4& x);
-
-float cerp(const float u0, const float u1, const float u2, const float u3, float x);
-vec2  cerp(const vec2& u0, const vec2& u1, const vec2& u2, const vec2& u3, float x);
-vec3  cerp(const vec3& u0, const vec3& u1, const vec3& u2, const vec3& u3, float x);
-vec4  cerp(const vec4& u0, const vec4& u1, const vec4& u2, const vec4& u3, float x);
-
-float sign(const float v);
-vec2  sign(const vec2& v);
-vec3  sign(const vec3& v);
-vec4  sign(const vec4& v);
-
-float clamp(const float v, const float c0, const float c1);
-vec2  clamp(const vec2& v, const float c0, const float c1);
-vec2  clamp(const vec2& v, const vec2& c0, const vec2& c1);
-vec3  clamp(const vec3& v, const float c0, const float c1);
-vec3  clamp(const vec3& v, const vec3& c0, const vec3& c1);
-vec4  clamp(const vec4& v, const float c0, const float c1);
-vec4  clamp(const vec4& v, const vec4& c0, const vec4& c1);
-
-//	Igor: implement template specialization for min/max in cpp
+inline float dot(const vec2& u, const vec2& v) { return u.x * v.x + u.y * v.y; }
+inline float dot(const vec3& u, const vec3& v) { return u.x * v.x + u.y * v.y + u.z * v.z; }
+inline float dot(const vec4& u, const vec4& v) { return u.x * v.x + u.y * v.y + u.z * v.z + u.w * v.w; }
+
+inline float lerp(const float u, const float v, const float x) { return u + x * (v - u); }
+inline vec2 lerp(const vec2& u, const vec2& v, const float x) { return u + x * (v - u); }
+inline vec3 lerp(const vec3& u, const vec3& v, const float x) { return u + x * (v - u); }
+inline vec4 lerp(const vec4& u, const vec4& v, const float x) { return u + x * (v - u); }
+inline vec2 lerp(const vec2& u, const vec2& v, const vec2& x) { return u + x * (v - u); }
+inline vec3 lerp(const vec3& u, const vec3& v, const vec3& x) { return u + x * (v - u); }
+inline vec4 lerp(const vec4& u, const vec4& v, const vec4& x) { return u + x * (v - u); }
+
+inline float cerp(const float u0, const float u1, const float u2, const float u3, float x)
+{
+    float p = (u3 - u2) - (u0 - u1);
+    float q = (u0 - u1) - p;
+    float r = u2 - u0;
+    return x * (x * (x * p + q) + r) + u1;
+}
+
+inline vec2 cerp(const vec2& u0, const vec2& u1, const vec2& u2, const vec2& u3, float x)
+{
+    vec2 p = (u3 - u2) - (u0 - u1);
+    vec2 q = (u0 - u1) - p;
+    vec2 r = u2 - u0;
+    return x * (x * (x * p + q) + r) + u1;
+}
+
+inline vec3 cerp(const vec3& u0, const vec3& u1, const vec3& u2, const vec3& u3, float x)
+{
+    vec3 p = (u3 - u2) - (u0 - u1);
+    vec3 q = (u0 - u1) - p;
+    vec3 r = u2 - u0;
+    return x * (x * (x * p + q) + r) + u1;
+}
+
+inline vec4 cerp(const vec4& u0, const vec4& u1, const vec4& u2, const vec4& u3, float x)
+{
+    vec4 p = (u3 - u2) - (u0 - u1);
+    vec4 q = (u0 - u1) - p;
+    vec4 r = u2 - u0;
+    return x * (x * (x * p + q) + r) + u1;
+}
+
+inline float sign(const float v) { return (v > 0) ? 1.0f : (v < 0) ? -1.0f : 0.0f; }
+inline vec2 sign(const vec2& v) { return vec2(sign(v.x), sign(v.y)); }
+inline vec3 sign(const vec3& v) { return vec3(sign(v.x), sign(v.y), sign(v.z)); }
+inline vec4 sign(const vec4& v) { return vec4(sign(v.x), sign(v.y), sign(v.z), sign(v.w)); }
+
+inline float clamp(const float v, const float c0, const float c1) { return min(max(v, c0), c1); }
+inline vec2 clamp(const vec2& v, const float c0, const float c1) { return vec2(min(max(v.x, c0), c1), min(max(v.y, c0), c1)); }
+inline vec2 clamp(const vec2& v, const vec2& c0, const vec2& c1) { return vec2(min(max(v.x, c0.x), c1.x), min(max(v.y, c0.y), c1.y)); }
+inline vec3 clamp(const vec3& v, const float c0, const float c1)
+{
+    return vec3(min(max(v.x, c0), c1), min(max(v.y, c0), c1), min(max(v.z, c0), c1));
+}
+
+inline vec3 clamp(const vec3& v, const vec3& c0, const vec3& c1)
+{
+    return vec3(min(max(v.x, c0.x), c1.x), min(max(v.y, c0.y), c1.y), min(max(v.z, c0.z), c1.z));
+}
+
+inline vec4 clamp(const vec4& v, const float c0, const float c1)
+{
+    return vec4(min(max(v.x, c0), c1), min(max(v.y, c0), c1), min(max(v.z, c0), c1), min(max(v.z, c0), c1));
+}
+
+inline vec4 clamp(const vec4& v, const vec4& c0, const vec4& c1)
+{
+    return vec4(min(max(v.x, c0.x), c1.x), min(max(v.y, c0.y), c1.y), min(max(v.z, c0.z), c1.z), min(max(v.w, c0.w), c1.w));
+}
+
 // vec3  min(const vec3 &v1, const vec3 &v2);
 // vec3  max(const vec3 &v1, const vec3 &v2);
 template<>
-vec2 min(const vec2& a, const vec2& b);
+inline vec2 min(const vec2& a, const vec2& b)
+{
+    return vec2(min(a.x, b.x), min(a.y, b.y));
+}
 template<>
-vec2 max(const vec2& a, const vec2& b);
+inline vec2 max(const vec2& a, const vec2& b)
+{
+    return vec2(max(a.x, b.x), max(a.y, b.y));
+}
 template<>
-vec3 min(const vec3& a, const vec3& b);
+inline vec3 min(const vec3& a, const vec3& b)
+{
+    return vec3(min(a.x, b.x), min(a.y, b.y), min(a.z, b.z));
+}
 template<>
-vec3 max(const vec3& a, const vec3& b);
+inline vec3 max(const vec3& a, const vec3& b)
+{
+    return vec3(max(a.x, b.x), max(a.y, b.y), max(a.z, b.z));
+}
 template<>
-vec4 min(const vec4& a, const vec4& b);
+inline vec4 min(const vec4& a, const vec4& b)
+{
+    return vec4(min(a.x, b.x), min(a.y, b.y), min(a.z, b.z), min(a.w, b.w));
+}
 template<>
-vec4 max(const vec4& a, const vec4& b);
+inline vec4 max(const vec4& a, const vec4& b)
+{
+    return vec4(max(a.x, b.x), max(a.y, b.y), max(a.z, b.z), max(a.w, b.w));
+}
 
-float saturate(const float x);
+inline float saturate(const float x) { return clamp(x, 0, 1); }
 
-vec2 normalize(const vec2& v);
-vec3 normalize(const vec3& v);
-vec4 normalize(const vec4& v);
+inline vec2 normalize(const vec2& v)
+{
+    float invLen = 1.0f / sqrtf(v.x * v.x + v.y * v.y);
+    return v * invLen;
+}
 
-vec2 fastNormalize(const vec2& v);
-vec3 fastNormalize(const vec3& v);
-vec4 fastNormalize(const vec4& v);
+inline vec3 normalize(const vec3& v)
+{
+    float invLen = 1.0f / sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+    return v * invLen;
+}
 
-float length(const vec2& v);
-float length(const vec3& v);
-float length(const vec4& v);
+inline vec4 normalize(const vec4& v)
+{
+    float invLen = 1.0f / sqrtf(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
+    return v * invLen;
+}
 
-vec3 reflect(const vec3& v, const vec3& normal);
+inline vec2 fastNormalize(const vec2& v)
+{
+    float invLen = rsqrtf(v.x * v.x + v.y * v.y);
+    return v * invLen;
+}
+
+inline vec3 fastNormalize(const vec3& v)
+{
+    float invLen = rsqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+    return v * invLen;
+}
 
-float distance(const vec2& u, const vec2& v);
-float distance(const vec3& u, const vec3& v);
-float distance(const vec4& u, const vec4& v);
+inline vec4 fastNormalize(const vec4& v)
+{
+    float invLen = rsqrtf(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
+    return v * invLen;
+}
 
-float planeDistance(const vec3& normal, const float offset, const vec3& point);
-float planeDistance(const vec4& plane, const vec3& point);
+inline float length(const vec2& v) { return sqrtf(v.x * v.x + v.y * v.y); }
+inline float length(const vec3& v) { return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z); }
+inline float length(const vec4& v) { return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w); }
 
-float sCurve(const float t);
+inline vec3 reflect(const vec3& v, const vec3& normal)
+{
+    float n = dot(v, normal);
+    return v - 2 * n * normal;
+}
 
-vec3 cross(const vec3& u, const vec3& v);
+inline float distance(const vec2& u, const vec2& v)
+{
+    vec2 d = u - v;
+    return dot(d, d);
+}
 
-float lineProjection(const vec3& line0, const vec3& line1, const vec3& point);
+inline float distance(const vec3& u, const vec3& v)
+{
+    vec3 d = u - v;
+    return dot(d, d);
+}
+
+inline float distance(const vec4& u, const vec4& v)
+{
+    vec4 d = u - v;
+    return dot(d, d);
+}
+
+inline float planeDistance(const vec3& normal, const float offset, const vec3& point)
+{
+    return point.x * normal.x + point.y * normal.y + point.z * normal.z + offset;
+}
+
+inline float planeDistance(const vec4& plane, const vec3& point)
+{
+    return point.x * plane.x + point.y * plane.y + point.z * plane.z + plane.w;
+}
+
+inline float sCurve(const float t) { return t * t * (3 - 2 * t); }
+
+inline vec3 cross(const vec3& u, const vec3& v) { return vec3(u.y * v.z - v.y * u.z, u.z * v.x - u.x * v.z, u.x * v.y - u.y * v.x); }
+
+inline float lineProjection(const vec3& line0, const vec3& line1, const vec3& point)
+{
+    vec3 v = line1 - line0;
+    return dot(v, point - line0) / dot(v, v);
+}
 
 unsigned int toRGBA(const vec4& u);
 unsigned int toBGRA(const vec4& u);
@@ -384,17 +668,20 @@ struct mat2
     operator const float*() const { return (const float*)rows; }
 };
 
-mat2 operator+(const mat2& m, const mat2& n);
-mat2 operator-(const mat2& m, const mat2& n);
-mat2 operator-(const mat2& m);
+inline mat2 operator+(const mat2& m, const mat2& n) { return mat2(m.rows[0] + n.rows[0], m.rows[1] + n.rows[1]); }
+inline mat2 operator-(const mat2& m, const mat2& n) { return mat2(m.rows[0] - n.rows[0], m.rows[1] - n.rows[1]); }
+inline mat2 operator-(const mat2& m) { return mat2(-m.rows[0], -m.rows[1]); }
+
+#define rcDot2(r, c) (m.rows[r].x * n.rows[0][c] + m.rows[r].y * n.rows[1][c])
+inline mat2 operator*(const mat2& m, const mat2& n) { return mat2(rcDot2(0, 0), rcDot2(0, 1), rcDot2(1, 0), rcDot2(1, 1)); }
+#undef rcDot2
+inline vec2 operator*(const mat2& m, const vec2& v) { return vec2(dot(m.rows[0], v), dot(m.rows[1], v)); }
+inline mat2 operator*(const mat2& m, const float x) { return mat2(m.rows[0] * x, m.rows[1] * x); }
 
-mat2 operator*(const mat2& m, const mat2& n);
-vec2 operator*(const mat2& m, const vec2& v);
-mat2 operator*(const mat2& m, const float x);
+inline mat2 transpose(const mat2& m) { return mat2(m.rows[0].x, m.rows[1].x, m.rows[0].y, m.rows[1].y); }
+inline float det(const mat2& m) { return (m.rows[0].x * m.rows[1].y - m.rows[0].y * m.rows[1].x); }
 
-mat2  transpose(const mat2& m);
-float det(const mat2& m);
-mat2  operator!(const mat2& m);
+mat2 operator!(const mat2& m);
 
 /* --------------------------------------------------------------------------------- */
 
@@ -420,17 +707,34 @@ struct mat3
     operator const float*() const { return (const float*)rows; }
 };
 
-mat3 operator+(const mat3& m, const mat3& n);
-mat3 operator-(const mat3& m, const mat3& n);
-mat3 operator-(const mat3& m);
+inline mat3 operator+(const mat3& m, const mat3& n) { return mat3(m.rows[0] + n.rows[0], m.rows[1] + n.rows[1], m.rows[2] + n.rows[2]); }
+inline mat3 operator-(const mat3& m, const mat3& n) { return mat3(m.rows[0] - n.rows[0], m.rows[1] - n.rows[1], m.rows[2] - n.rows[2]); }
+inline mat3 operator-(const mat3& m) { return mat3(-m.rows[0], -m.rows[1], -m.rows[2]); }
+
+#define rcDot3(r, c) (m.rows[r].x * n.rows[0][c] + m.rows[r].y * n.rows[1][c] + m.rows[r].z * n.rows[2][c])
+inline mat3 operator*(const mat3& m, const mat3& n)
+{
+    return mat3(rcDot3(0, 0), rcDot3(0, 1), rcDot3(0, 2), rcDot3(1, 0), rcDot3(1, 1), rcDot3(1, 2), rcDot3(2, 0), rcDot3(2, 1),
+                rcDot3(2, 2));
+}
+#undef rcDot3
+
+inline vec3 operator*(const mat3& m, const vec3& v) { return vec3(dot(m.rows[0], v), dot(m.rows[1], v), dot(m.rows[2], v)); }
+inline mat3 operator*(const mat3& m, const float x) { return mat3(m.rows[0] * x, m.rows[1] * x, m.rows[2] * x); }
 
-mat3 operator*(const mat3& m, const mat3& n);
-vec3 operator*(const mat3& m, const vec3& v);
-mat3 operator*(const mat3& m, const float x);
+inline mat3 transpose(const mat3& m)
+{
+    return mat3(m.rows[0].x, m.rows[1].x, m.rows[2].x, m.rows[0].y, m.rows[1].y, m.rows[2].y, m.rows[0].z, m.rows[1].z, m.rows[2].z);
+}
+
+inline float det(const mat3& m)
+{
+    return m.rows[0].x * (m.rows[1].y * m.rows[2].z - m.rows[2].y * m.rows[1].z) -
+           m.rows[0].y * (m.rows[1].x * m.rows[2].z - m.rows[1].z * m.rows[2].x) +
+           m.rows[0].z * (m.rows[1].x * m.rows[2].y - m.rows[1].y * m.rows[2].x);
+}
 
-mat3  transpose(const mat3& m);
-float det(const mat3& m);
-mat3  operator!(const mat3& m);
+mat3 operator!(const mat3& m);
 
 /* --------------------------------------------------------------------------------- */
 
@@ -461,16 +765,52 @@ struct mat4
     void translate(const vec3& v);
 };
 
-mat4 operator+(const mat4& m, const mat4& n);
-mat4 operator-(const mat4& m, const mat4& n);
-mat4 operator-(const mat4& m);
+inline void mat4::translate(const vec3& v)
+{
+    rows[0].w += dot(rows[0].xyz(), v);
+    rows[1].w += dot(rows[1].xyz(), v);
+    rows[2].w += dot(rows[2].xyz(), v);
+    rows[3].w += dot(rows[3].xyz(), v);
+}
+
+inline mat4 operator+(const mat4& m, const mat4& n)
+{
+    return mat4(m.rows[0] + n.rows[0], m.rows[1] + n.rows[1], m.rows[2] + n.rows[2], m.rows[3] + n.rows[3]);
+}
 
-mat4 operator*(const mat4& m, const mat4& n);
-vec4 operator*(const mat4& m, const vec4& v);
-vec3 operator*(const mat4& m, const vec3& v);
-mat4 operator*(const mat4& m, const float x);
+inline mat4 operator-(const mat4& m, const mat4& n)
+{
+    return mat4(m.rows[0] - n.rows[0], m.rows[1] - n.rows[1], m.rows[2] - n.rows[2], m.rows[3] - n.rows[3]);
+}
+
+inline mat4 operator-(const mat4& m) { return mat4(-m.rows[0], -m.rows[1], -m.rows[2], -m.rows[3]); }
+
+#define rcDot4(r, c) (m.rows[r].x * n.rows[0][c] + m.rows[r].y * n.rows[1][c] + m.rows[r].z * n.rows[2][c] + m.rows[r].w * n.rows[3][c])
+inline mat4 operator*(const mat4& m, const mat4& n)
+{
+    return mat4(rcDot4(0, 0), rcDot4(0, 1), rcDot4(0, 2), rcDot4(0, 3), rcDot4(1, 0), rcDot4(1, 1), rcDot4(1, 2), rcDot4(1, 3),
+                rcDot4(2, 0), rcDot4(2, 1), rcDot4(2, 2), rcDot4(2, 3), rcDot4(3, 0), rcDot4(3, 1), rcDot4(3, 2), rcDot4(3, 3));
+}
+#undef rcDot4
+
+inline vec4 operator*(const mat4& m, const vec4& v)
+{
+    return vec4(dot(m.rows[0], v), dot(m.rows[1], v), dot(m.rows[2], v), dot(m.rows[3], v));
+}
+
+inline vec3 operator*(const mat4& m, const vec3& v)
+{
+    return vec3(dot(m.rows[0].xyz(), v), dot(m.rows[1].xyz(), v), dot(m.rows[2].xyz(), v));
+}
+
+inline mat4 operator*(const mat4& m, const float x) { return mat4(m.rows[0] * x, m.rows[1] * x, m.rows[2] * x, m.rows[3] * x); }
+
+inline mat4 transpose(const mat4& m)
+{
+    return mat4(m.rows[0].x, m.rows[1].x, m.rows[2].x, m.rows[3].x, m.rows[0].y, m.rows[1].y, m.rows[2].y, m.rows[3].y, m.rows[0].z,
+                m.rows[1].z, m.rows[2].z, m.rows[3].z, m.rows[0].w, m.rows[1].w, m.rows[2].w, m.rows[3].w);
+}
 
-mat4 transpose(const mat4& m);
 mat4 operator!(const mat4& m);
 
 /* --------------------------------------------------------------------------------- */
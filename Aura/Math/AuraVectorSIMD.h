@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#ifndef __AURAVECTORSIMD_H_8E2B4C71_19D3_4A5F_B6E0_3F7A9C1D52E8_INCLUDED__
+#define __AURAVECTORSIMD_H_8E2B4C71_19D3_4A5F_B6E0_3F7A9C1D52E8_INCLUDED__
+
+#include <stddef.h>
+
+#include "AuraVector.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AURA_SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define AURA_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace aura
+{
+//	16-byte aligned vec4 kept in a SSE or NEON register, plain floats on other targets.
+//	Lanes are computed in the same order as the vec4 operators, so results match them bit for bit.
+struct alignas(16) vec4a
+{
+#if defined(AURA_SIMD_SSE)
+    __m128 v;
+#elif defined(AURA_SIMD_NEON)
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+
+    vec4a() = default;
+#if defined(AURA_SIMD_SSE)
+    explicit vec4a(const __m128 r): v(r) {}
+    explicit vec4a(const float s): v(_mm_set1_ps(s)) {}
+    explicit vec4a(const vec4& u): v(_mm_loadu_ps(&u.x)) {}
+
+    operator vec4() const
+    {
+        vec4 u;
+        _mm_storeu_ps(&u.x, v);
+        return u;
+    }
+#elif defined(AURA_SIMD_NEON)
+    explicit vec4a(const float32x4_t r): v(r) {}
+    explicit vec4a(const float s): v(vdupq_n_f32(s)) {}
+    explicit vec4a(const vec4& u): v(vld1q_f32(&u.x)) {}
+
+    operator vec4() const
+    {
+        vec4 u;
+        vst1q_f32(&u.x, v);
+        return u;
+    }
+#else
+    explicit vec4a(const float s) { v[0] = v[1] = v[2] = v[3] = s; }
+    explicit vec4a(const vec4& u) { memcpy(v, &u.x, sizeof(v)); }
+
+    operator vec4() const { return vec4(v[0], v[1], v[2], v[3]); }
+#endif
+};
+
+#if defined(AURA_SIMD_SSE)
+inline vec4a operator+(const vec4a& u, const vec4a& v) { return vec4a(_mm_add_ps(u.v, v.v)); }
+inline vec4a operator-(const vec4a& u, const vec4a& v) { return vec4a(_mm_sub_ps(u.v, v.v)); }
+inline vec4a operator*(const vec4a& u, const vec4a& v) { return vec4a(_mm_mul_ps(u.v, v.v)); }
+inline vec4a operator*(const vec4a& v, const float s) { return vec4a(_mm_mul_ps(v.v, _mm_set1_ps(s))); }
+//	(u > v) ? u : v per lane like max(float, float), so NaNs in u give v
+inline vec4a max(const vec4a& u, const vec4a& v) { return vec4a(_mm_max_ps(u.v, v.v)); }
+
+inline float dot(const vec4a& u, const vec4a& v)
+{
+    alignas(16) float p[4];
+    _mm_store_ps(p, _mm_mul_ps(u.v, v.v));
+    return p[0] + p[1] + p[2] + p[3];
+}
+#elif defined(AURA_SIMD_NEON)
+inline vec4a operator+(const vec4a& u, const vec4a& v) { return vec4a(vaddq_f32(u.v, v.v)); }
+inline vec4a operator-(const vec4a& u, const vec4a& v) { return vec4a(vsubq_f32(u.v, v.v)); }
+inline vec4a operator*(const vec4a& u, const vec4a& v) { return vec4a(vmulq_f32(u.v, v.v)); }
+inline vec4a operator*(const vec4a& v, const float s) { return vec4a(vmulq_n_f32(v.v, s)); }
+//	vmaxq_f32 returns NaN for any NaN input, the select keeps the semantics of max(float, float)
+inline vec4a max(const vec4a& u, const vec4a& v) { return vec4a(vbslq_f32(vcgtq_f32(u.v, v.v), u.v, v.v)); }
+
+inline float dot(const vec4a& u, const vec4a& v)
+{
+    const float32x4_t p = vmulq_f32(u.v, v.v);
+    return vgetq_lane_f32(p, 0) + vgetq_lane_f32(p, 1) + vgetq_lane_f32(p, 2) + vgetq_lane_f32(p, 3);
+}
+#else
+inline vec4a operator+(const vec4a& u, const vec4a& v) { return vec4a(vec4(u) + vec4(v)); }
+inline vec4a operator-(const vec4a& u, const vec4a& v) { return vec4a(vec4(u) - vec4(v)); }
+inline vec4a operator*(const vec4a& u, const vec4a& v) { return vec4a(vec4(u) * vec4(v)); }
+inline vec4a operator*(const vec4a& v, const float s) { return vec4a(vec4(v) * s); }
+inline vec4a max(const vec4a& u, const vec4a& v) { return vec4a(max(vec4(u), vec4(v))); }
+inline float dot(const vec4a& u, const vec4a& v) { return dot(vec4(u), vec4(v)); }
+#endif
+
+//	pDst[i] = m * pSrc[i]. pDst may be pSrc.
+//	Every element is summed in the order of dot(), so the results equal the mat4 * vec4 operator.
+inline void transformVec4(const mat4& m, const vec4* pSrc, vec4* pDst, size_t count)
+{
+#if defined(AURA_SIMD_SSE) || defined(AURA_SIMD_NEON)
+    //	Columns of m, element k of the result is the sum of cols[c][k] * v[c]
+    const mat4  t = transpose(m);
+    const vec4a cols[4] = { vec4a(t.rows[0]), vec4a(t.rows[1]), vec4a(t.rows[2]), vec4a(t.rows[3]) };
+    for (size_t i = 0; i < count; ++i)
+    {
+        const vec4 v = pSrc[i];
+        pDst[i] = cols[0] * v.x + cols[1] * v.y + cols[2] * v.z + cols[3] * v.w;
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+        pDst[i] = m * pSrc[i];
+#endif
+}
+
+//	pDst[i] = m * pSrc[i]. pDst may be pSrc. Results equal the mat3 * vec3 operator.
+inline void transformVec3(const mat3& m, const vec3* pSrc, vec3* pDst, size_t count)
+{
+#if defined(AURA_SIMD_SSE) || defined(AURA_SIMD_NEON)
+    //	The fourth lane of the columns is padding
+    const mat3  t = transpose(m);
+    const vec4a cols[3] = { vec4a(vec4(t.rows[0], 0.0f)), vec4a(vec4(t.rows[1], 0.0f)), vec4a(vec4(t.rows[2], 0.0f)) };
+    for (size_t i = 0; i < count; ++i)
+    {
+        const vec3 v = pSrc[i];
+        const vec4 r = cols[0] * v.x + cols[1] * v.y + cols[2] * v.z;
+        pDst[i] = r.xyz();
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+        pDst[i] = m * pSrc[i];
+#endif
+}
+} // namespace aura
+
+#endif //__AURAVECTORSIMD_H_8E2B4C71_19D3_4A5F_B6E0_3F7A9C1D52E8_INCLUDED__
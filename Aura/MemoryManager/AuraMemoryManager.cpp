@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "../Interfaces/IAuraMemoryManager.h"
+
+#include <string.h>
+
+#ifdef ENABLE_DEFAULT_MEMORY_MANAGER
+#include <atomic>
+#include <mutex>
+#endif
+
+namespace aura
+{
+/************************************************************************/
+// Linear arena
+/************************************************************************/
+static size_t alignUp(size_t value, size_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+void initLinearArena(size_t capacity, LinearArena* pArena)
+{
+    memset(pArena, 0, sizeof(*pArena));
+    if (capacity == 0)
+        return;
+
+    pArena->mCapacity = alignUp(capacity, ARENA_ALIGNMENT);
+    pArena->pAllocation = aura::alloc(pArena->mCapacity + ARENA_ALIGNMENT - 1);
+    if (!pArena->pAllocation)
+    {
+        pArena->mCapacity = 0;
+        return;
+    }
+
+    pArena->pBase = (uint8_t*)alignUp((size_t)pArena->pAllocation, ARENA_ALIGNMENT);
+}
+
+void exitLinearArena(LinearArena* pArena)
+{
+    ASSERT(pArena->mLiveAllocations == 0);
+    if (pArena->pAllocation)
+        aura::dealloc(pArena->pAllocation);
+    memset(pArena, 0, sizeof(*pArena));
+}
+
+void* arenaAlloc(LinearArena* pArena, size_t size)
+{
+    const size_t alignedSize = alignUp(size, ARENA_ALIGNMENT);
+    if (!pArena->pBase || pArena->mOffset + alignedSize > pArena->mCapacity)
+        return NULL;
+
+    void* ptr = pArena->pBase + pArena->mOffset;
+    pArena->mOffset += alignedSize;
+    pArena->mPeakOffset = pArena->mOffset > pArena->mPeakOffset ? pArena->mOffset : pArena->mPeakOffset;
+    pArena->mLiveBytes += size;
+    ++pArena->mLiveAllocations;
+    return ptr;
+}
+
+void arenaDealloc(LinearArena* pArena, void* ptr, size_t size)
+{
+    ASSERT(arenaOwns(pArena, ptr) && pArena->mLiveAllocations > 0);
+    UNREF_PARAM(ptr);
+
+    pArena->mLiveBytes -= size;
+    //	Everything is free again, start over from the beginning
+    if (--pArena->mLiveAllocations == 0)
+        pArena->mOffset = 0;
+}
+
+bool arenaOwns(const LinearArena* pArena, const void* ptr)
+{
+    return pArena->pBase && (const uint8_t*)ptr >= pArena->pBase && (const uint8_t*)ptr < pArena->pBase + pArena->mCapacity;
+}
+
+void getLinearArenaStats(const LinearArena* pArena, MemoryStats* pStats)
+{
+    pStats->mLiveBytes = pArena->mLiveBytes;
+    pStats->mPeakBytes = pArena->mPeakOffset;
+    pStats->mReservedBytes = pArena->mCapacity;
+    pStats->mLiveAllocations = pArena->mLiveAllocations;
+    //	Space below the offset that was freed but can't be reused until the arena empties
+    pStats->mFragmentation = pArena->mOffset ? 1.0f - (float)pArena->mLiveBytes / (float)pArena->mOffset : 0.0f;
+}
+
+#ifdef ENABLE_DEFAULT_MEMORY_MANAGER
+/************************************************************************/
+// Default alloc / dealloc
+/************************************************************************/
+//	Every allocation is preceded by a header. Pool blocks are 16-byte aligned, heap blocks 64-byte aligned.
+struct AllocationHeader
+{
+    uint32_t mSizeClass;
+    uint32_t mSize;
+    void*    pRaw;
+};
+
+static_assert(sizeof(AllocationHeader) <= 16, "Pool blocks reserve 16 bytes for the header");
+
+static const uint32_t POOL_HEADER_SIZE = 16;
+static const uint32_t HEAP_HEADER_SIZE = 64;
+static const uint32_t HEAP_SIZE_CLASS = 0xFFFFFFFF;
+static const uint32_t POOL_CHUNK_SIZE = 64 * 1024;
+static const uint32_t POOL_SIZE_CLASSES[] = { 16, 32, 64, 128, 256 };
+static const uint32_t POOL_SIZE_CLASS_COUNT = sizeof(POOL_SIZE_CLASSES) / sizeof(POOL_SIZE_CLASSES[0]);
+
+struct FreeBlock
+{
+    FreeBlock* pNext;
+};
+
+//	Chunks are aligned to their size, so a block finds its chunk by masking its address.
+//	The chunk header takes the place of the first block header.
+struct PoolChunk
+{
+    PoolChunk* pNext;
+    uint32_t   mLiveBlocks;
+};
+
+static_assert(sizeof(PoolChunk) <= POOL_HEADER_SIZE, "Blocks start after the chunk header");
+
+struct Pool
+{
+    std::mutex mLock;
+    FreeBlock* pFreeList;
+    PoolChunk* pChunks;
+    size_t     mReservedBytes;
+};
+
+static Pool gPools[POOL_SIZE_CLASS_COUNT];
+
+static std::atomic<size_t>   gLiveBytes(0);
+static std::atomic<size_t>   gPeakBytes(0);
+static std::atomic<size_t>   gHeapReservedBytes(0);
+static std::atomic<uint32_t> gLiveAllocations(0);
+
+static void* allocSystem(size_t size, size_t alignment)
+{
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    void* ptr = NULL;
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : NULL;
+#endif
+}
+
+static void deallocSystem(void* ptr)
+{
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+static uint32_t getSizeClass(size_t size)
+{
+    for (uint32_t i = 0; i < POOL_SIZE_CLASS_COUNT; ++i)
+    {
+        if (size <= POOL_SIZE_CLASSES[i])
+            return i;
+    }
+    return HEAP_SIZE_CLASS;
+}
+
+static void trackAlloc(size_t size)
+{
+    ++gLiveAllocations;
+    const size_t liveBytes = gLiveBytes.fetch_add(size) + size;
+    size_t       peakBytes = gPeakBytes.load();
+    while (liveBytes > peakBytes && !gPeakBytes.compare_exchange_weak(peakBytes, liveBytes))
+    {
+    }
+}
+
+static PoolChunk* getPoolChunk(const void* pBlock) { return (PoolChunk*)((uintptr_t)pBlock & ~(uintptr_t)(POOL_CHUNK_SIZE - 1)); }
+
+//	Called with the pool locked
+static bool growPool(Pool* pPool, uint32_t blockSize)
+{
+    PoolChunk* pChunk = (PoolChunk*)allocSystem(POOL_CHUNK_SIZE, POOL_CHUNK_SIZE);
+    if (!pChunk)
+        return false;
+
+    pChunk->pNext = pPool->pChunks;
+    pChunk->mLiveBlocks = 0;
+    pPool->pChunks = pChunk;
+
+    //	Chunks stay with the pool until trimMemoryPools finds them empty
+    for (uint32_t offset = POOL_HEADER_SIZE; offset + blockSize <= POOL_CHUNK_SIZE; offset += blockSize)
+    {
+        FreeBlock* pBlock = (FreeBlock*)((uint8_t*)pChunk + offset);
+        pBlock->pNext = pPool->pFreeList;
+        pPool->pFreeList = pBlock;
+    }
+    pPool->mReservedBytes += POOL_CHUNK_SIZE;
+    return true;
+}
+
+void* alloc(size_t size)
+{
+    const uint32_t sizeClass = getSizeClass(size);
+    uint8_t*       pBlock = NULL;
+    uint32_t       headerSize = POOL_HEADER_SIZE;
+
+    if (sizeClass != HEAP_SIZE_CLASS)
+    {
+        Pool* pPool = &gPools[sizeClass];
+
+        std::lock_guard<std::mutex> lock(pPool->mLock);
+        if (pPool->pFreeList || growPool(pPool, POOL_HEADER_SIZE + POOL_SIZE_CLASSES[sizeClass]))
+        {
+            pBlock = (uint8_t*)pPool->pFreeList;
+            pPool->pFreeList = pPool->pFreeList->pNext;
+            ++getPoolChunk(pBlock)->mLiveBlocks;
+        }
+    }
+    else
+    {
+        ASSERT(size <= 0xFFFFFFFF);
+        headerSize = HEAP_HEADER_SIZE;
+        pBlock = (uint8_t*)allocSystem(HEAP_HEADER_SIZE + size, HEAP_HEADER_SIZE);
+        if (pBlock)
+            gHeapReservedBytes += HEAP_HEADER_SIZE + size;
+    }
+
+    if (!pBlock)
+        return NULL;
+
+    AllocationHeader* pHeader = (AllocationHeader*)(pBlock + headerSize) - 1;
+    pHeader->mSizeClass = sizeClass;
+    pHeader->mSize = (uint32_t)size;
+    pHeader->pRaw = pBlock;
+
+    trackAlloc(size);
+    return pBlock + headerSize;
+}
+
+void dealloc(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    AllocationHeader* pHeader = (AllocationHeader*)ptr - 1;
+    const uint32_t    size = pHeader->mSize;
+
+    --gLiveAllocations;
+    gLiveBytes -= size;
+
+    if (pHeader->mSizeClass == HEAP_SIZE_CLASS)
+    {
+        gHeapReservedBytes -= HEAP_HEADER_SIZE + size;
+        deallocSystem(pHeader->pRaw);
+        return;
+    }
+
+    ASSERT(pHeader->mSizeClass < POOL_SIZE_CLASS_COUNT);
+    Pool*      pPool = &gPools[pHeader->mSizeClass];
+    FreeBlock* pBlock = (FreeBlock*)pHeader->pRaw;
+
+    std::lock_guard<std::mutex> lock(pPool->mLock);
+    pBlock->pNext = pPool->pFreeList;
+    pPool->pFreeList = pBlock;
+    --getPoolChunk(pBlock)->mLiveBlocks;
+}
+
+void trimMemoryPools()
+{
+    for (uint32_t i = 0; i < POOL_SIZE_CLASS_COUNT; ++i)
+    {
+        Pool*                       pPool = &gPools[i];
+        std::lock_guard<std::mutex> lock(pPool->mLock);
+
+        //	Drop the free blocks of empty chunks, then the chunks themselves
+        FreeBlock** ppBlock = &pPool->pFreeList;
+        while (*ppBlock)
+        {
+            if (getPoolChunk(*ppBlock)->mLiveBlocks == 0)
+                *ppBlock = (*ppBlock)->pNext;
+            else
+                ppBlock = &(*ppBlock)->pNext;
+        }
+
+        PoolChunk** ppChunk = &pPool->pChunks;
+        while (*ppChunk)
+        {
+            PoolChunk* pChunk = *ppChunk;
+            if (pChunk->mLiveBlocks != 0)
+            {
+                ppChunk = &pChunk->pNext;
+                continue;
+            }
+
+            *ppChunk = pChunk->pNext;
+            pPool->mReservedBytes -= POOL_CHUNK_SIZE;
+            deallocSystem(pChunk);
+        }
+    }
+}
+
+void getMemoryStats(MemoryStats* pStats)
+{
+    size_t poolReservedBytes = 0;
+    for (uint32_t i = 0; i < POOL_SIZE_CLASS_COUNT; ++i)
+    {
+        std::lock_guard<std::mutex> lock(gPools[i].mLock);
+        poolReservedBytes += gPools[i].mReservedBytes;
+    }
+
+    pStats->mLiveBytes = gLiveBytes.load();
+    pStats->mPeakBytes = gPeakBytes.load();
+    pStats->mReservedBytes = poolReservedBytes + gHeapReservedBytes.load();
+    pStats->mLiveAllocations = gLiveAllocations.load();
+    //	Free pool blocks, rounding to size classes and headers
+    pStats->mFragmentation = pStats->mReservedBytes ? 1.0f - (float)pStats->mLiveBytes / (float)pStats->mReservedBytes : 0.0f;
+}
+#endif // ENABLE_DEFAULT_MEMORY_MANAGER
+} // namespace aura
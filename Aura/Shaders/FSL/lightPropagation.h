@@ -10,16 +10,21 @@
 #ifndef LIGHT_PROPAGATION_H
 #define LIGHT_PROPAGATION_H
 
+//	GridRes is the default cascade resolution. Cascades can pick any multiple of GridResGranularity
+//	between MinGridRes and MaxGridRes (16, 24, 32, 48, 64), shaders get it through their constants.
 #ifdef NO_FSL_DEFINITIONS
 static const uint  WorkGroupSize = 4;
 static const uint  GridRes = 32;
-static const float LPVtoOccludersOffset = 0.5f / GridRes;
+static const uint  MinGridRes = 16;
+static const uint  MaxGridRes = 64;
+static const uint  GridResGranularity = 8;
+
+inline bool isValidGridRes(uint gridRes) { return gridRes >= MinGridRes && gridRes <= MaxGridRes && gridRes % GridResGranularity == 0; }
 #endif
 
 #ifndef NO_FSL_DEFINITIONS
 STATIC const uint  WorkGroupSize = 4;
 STATIC const uint  GridRes = 32;
-STATIC const float LPVtoOccludersOffset = 0.5f / GridRes;
 #endif
 
 // Igor: If RSM size is static, use this instead of RSM params in shader
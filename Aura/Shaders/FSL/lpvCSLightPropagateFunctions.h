@@ -17,13 +17,7 @@
 #define THREAD_GROUP_Y_DIM 4
 #define THREAD_GROUP_Z_DIM 4
 
-//	TODO: Igor: this can be removed for release if 1
-//	TODO: Igor: Those multiplications can be moved elsewhere to reduce the number of multiplications, e.g.
-//	constants can be premultipled :)
-PUSH_CONSTANT(PropagationSetupRootConstant, b0)
-{
-	DATA(float, fPropagationScale, None);
-};
+#include "lpvPropagationRootConstant.h"
 
 #include "lpvSHMaths.h"
 
@@ -33,43 +27,43 @@ void FillLocalGrid(const uint3 groupThreadId, const uint3 dispatchThreadId, Samp
 {
 	// all threads grab a (not its own) voxel from global to local memory 
 	uint3 grabGlobalIndex = dispatchThreadId.xyz - u3(1);
-	Get(SHGrid)[groupThreadId.x][groupThreadId.y][groupThreadId.z] = SHSampleGrid(pointBorder, float3(grabGlobalIndex) / GridRes, i3(0));
+	Get(SHGrid)[groupThreadId.x][groupThreadId.y][groupThreadId.z] = SHSampleGrid(pointBorder, float3(grabGlobalIndex) / float(Get(uGridRes)), i3(0));
 
 	// sure i'm being brain dead and missing the easy way to fill the border of this volume without lots of if's...
 	if (groupThreadId.x == 0 || groupThreadId.x == 1) 
 	{
 		uint3 tmp = grabGlobalIndex + uint3(THREAD_GROUP_X_DIM, 0, 0);
-		Get(SHGrid)[groupThreadId.x + THREAD_GROUP_X_DIM][groupThreadId.y][groupThreadId.z] = SHSampleGrid(pointBorder, float3(tmp) / GridRes, i3(0));
+		Get(SHGrid)[groupThreadId.x + THREAD_GROUP_X_DIM][groupThreadId.y][groupThreadId.z] = SHSampleGrid(pointBorder, float3(tmp) / float(Get(uGridRes)), i3(0));
 	}
 	if (groupThreadId.y == 0 || groupThreadId.y == 1) 
 	{
 		uint3 tmp = grabGlobalIndex + uint3(0, THREAD_GROUP_Y_DIM, 0);
-		Get(SHGrid)[groupThreadId.x][groupThreadId.y + THREAD_GROUP_Y_DIM][groupThreadId.z] = SHSampleGrid(pointBorder, float3(tmp) / GridRes, i3(0));
+		Get(SHGrid)[groupThreadId.x][groupThreadId.y + THREAD_GROUP_Y_DIM][groupThreadId.z] = SHSampleGrid(pointBorder, float3(tmp) / float(Get(uGridRes)), i3(0));
 	}
 	if (groupThreadId.z == 0 || groupThreadId.z == 1) 
 	{
 		uint3 tmp = grabGlobalIndex + uint3(0, 0, THREAD_GROUP_Z_DIM);
-		Get(SHGrid)[groupThreadId.x][groupThreadId.y][groupThreadId.z + THREAD_GROUP_Z_DIM] = SHSampleGrid(pointBorder, float3(tmp) / GridRes, i3(0));
+		Get(SHGrid)[groupThreadId.x][groupThreadId.y][groupThreadId.z + THREAD_GROUP_Z_DIM] = SHSampleGrid(pointBorder, float3(tmp) / float(Get(uGridRes)), i3(0));
 	}
 	if ((groupThreadId.x == 0 || groupThreadId.x == 1) && (groupThreadId.y == 0 || groupThreadId.y == 1)) 
 	{
 		uint3 tmp = grabGlobalIndex + uint3(THREAD_GROUP_X_DIM, THREAD_GROUP_Y_DIM, 0);
-		Get(SHGrid)[groupThreadId.x + THREAD_GROUP_X_DIM][groupThreadId.y + THREAD_GROUP_Y_DIM][groupThreadId.z] = SHSampleGrid(pointBorder, float3(tmp) / GridRes, i3(0));
+		Get(SHGrid)[groupThreadId.x + THREAD_GROUP_X_DIM][groupThreadId.y + THREAD_GROUP_Y_DIM][groupThreadId.z] = SHSampleGrid(pointBorder, float3(tmp) / float(Get(uGridRes)), i3(0));
 	}
 	if ((groupThreadId.x == 0 || groupThreadId.x == 1) && (groupThreadId.z == 0 || groupThreadId.z == 1)) 
 	{
 		uint3 tmp = grabGlobalIndex + uint3(THREAD_GROUP_X_DIM, 0, THREAD_GROUP_Z_DIM);
-		Get(SHGrid)[groupThreadId.x + THREAD_GROUP_X_DIM][groupThreadId.y][groupThreadId.z + THREAD_GROUP_Z_DIM] = SHSampleGrid(pointBorder, float3(tmp) / GridRes, i3(0));
+		Get(SHGrid)[groupThreadId.x + THREAD_GROUP_X_DIM][groupThreadId.y][groupThreadId.z + THREAD_GROUP_Z_DIM] = SHSampleGrid(pointBorder, float3(tmp) / float(Get(uGridRes)), i3(0));
 	}
 	if ((groupThreadId.y == 0 || groupThreadId.y == 1) && (groupThreadId.z == 0 || groupThreadId.z == 1)) 
 	{
 		uint3 tmp = grabGlobalIndex + uint3(0, THREAD_GROUP_Y_DIM, THREAD_GROUP_Z_DIM);
-		Get(SHGrid)[groupThreadId.x][groupThreadId.y + THREAD_GROUP_Y_DIM][groupThreadId.z + THREAD_GROUP_Z_DIM] = SHSampleGrid(pointBorder, float3(tmp) / GridRes, i3(0));
+		Get(SHGrid)[groupThreadId.x][groupThreadId.y + THREAD_GROUP_Y_DIM][groupThreadId.z + THREAD_GROUP_Z_DIM] = SHSampleGrid(pointBorder, float3(tmp) / float(Get(uGridRes)), i3(0));
 	}
 	if ((groupThreadId.x == 0 || groupThreadId.x == 1) && (groupThreadId.y == 0 || groupThreadId.y == 1) && (groupThreadId.z == 0 || groupThreadId.z == 1)) 
 	{
 		uint3 tmp = grabGlobalIndex + uint3(THREAD_GROUP_X_DIM, THREAD_GROUP_Y_DIM, THREAD_GROUP_Z_DIM);
-		Get(SHGrid)[groupThreadId.x + THREAD_GROUP_X_DIM][groupThreadId.y + THREAD_GROUP_Y_DIM][groupThreadId.z + THREAD_GROUP_Z_DIM] = SHSampleGrid(pointBorder, float3(tmp) / GridRes, i3(0));
+		Get(SHGrid)[groupThreadId.x + THREAD_GROUP_X_DIM][groupThreadId.y + THREAD_GROUP_Y_DIM][groupThreadId.z + THREAD_GROUP_Z_DIM] = SHSampleGrid(pointBorder, float3(tmp) / float(Get(uGridRes)), i3(0));
 	}
 
 	// wait for all threads in the group to have filled local SH
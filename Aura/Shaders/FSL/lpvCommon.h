@@ -13,12 +13,13 @@
 #ifndef NO_FSL_DEFINITIONS
 #include "lightPropagation.h"
 
-float3 LPVtoOccluders(const float3 tc) { return tc + f3(LPVtoOccludersOffset); }
-float3 OccludersToLPV(const float3 tc) { return tc - f3(LPVtoOccludersOffset); }
+//	Offset is half a cell of the cascade resolution
+float3 LPVtoOccluders(const float3 tc, const float hpCellSize) { return tc + f3(hpCellSize); }
+float3 OccludersToLPV(const float3 tc, const float hpCellSize) { return tc - f3(hpCellSize); }
 
-float calculateBorderFadeout(float3 gridPos)
+float calculateBorderFadeout(float3 gridPos, float gridRes)
 {
-	float borderSize = 4.0f / GridRes;
+	float borderSize = 4.0f / gridRes;
 	float3 borderScale = smoothstep(1.0f, 1.0f - borderSize, gridPos);
 	borderScale *= smoothstep(0.0f, borderSize, gridPos);
 	float borderFactor = borderScale.x*borderScale.y*borderScale.z;
@@ -36,6 +37,7 @@ STRUCT(LightInjectionData)
 	DATA(float3,        camDir,               None);
 	DATA(float3,        smoothGridPosOffset,  None);
 	DATA(uint2,         RSMRes,               None);
+	DATA(uint,          gridRes,              None);
 };
 
 STRUCT(LightApplyCascadeData)
@@ -83,6 +85,7 @@ struct LightInjectionData
 	PAD(2);
 	//===================================
 	aura::uint2    RSMRes;
+	uint           gridRes;
 	//===================================
 };
 
@@ -125,6 +128,13 @@ struct VisualizationData
 	aura::float4x4 invView;
 	float          probeRadius;
 	float          lightScale;
+	uint           gridRes;
+};
+
+struct PropagationSetupRootConstant
+{
+	float fPropagationScale;
+	uint  uGridRes;
 };
 #endif
 
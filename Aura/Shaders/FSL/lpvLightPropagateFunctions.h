@@ -10,13 +10,7 @@
 #ifndef LPV_LIGHT_PROPAGATE_FUNCTIONS_H
 #define LPV_LIGHT_PROPAGATE_FUNCTIONS_H
 
-//	TODO: Igor: this can be removed for release if 1
-//	TODO: Igor: Those multiplications can be moved elsewhere to reduce the number of multiplications, e.g.
-//	constants can be premultipled :)
-PUSH_CONSTANT(PropagationSetupRootConstant, b0)
-{
-	DATA(float, fPropagationScale, None);
-};
+#include "lpvPropagationRootConstant.h"
 
 #include "lpvSHMaths.h"
 
@@ -106,8 +100,8 @@ SHSpectralCoeffs IVPropagateVirtualDir(const float3 texCoord,
 	if (useOcclusion || multipleReflections) \
 	{ \
 		float occlusion  = 1.0f; \
-		float hpCellSize = 0.5f / GridRes; \
-		SHCoeffs occluderCoeffs = SHSampleOccluder(Get(pointBorder), LPVtoOccluders(texCoord) + nOffset * hpCellSize, i3(0)); \
+		float hpCellSize = 0.5f / float(Get(uGridRes)); \
+		SHCoeffs occluderCoeffs = SHSampleOccluder(Get(pointBorder), LPVtoOccluders(texCoord, hpCellSize) + nOffset * hpCellSize, i3(0)); \
 \
 		if (useOcclusion) \
 		{ \
@@ -121,7 +115,7 @@ SHSpectralCoeffs IVPropagateVirtualDir(const float3 texCoord,
 		FLATTEN \
 		if (multipleReflections) \
 		{ \
-			SHCoeffs occluderReflectorCoeffs = SHSampleOccluder(Get(pointBorder), LPVtoOccluders(texCoord) + 1.5f * nOffset * hpCellSize, i3(0)); \
+			SHCoeffs occluderReflectorCoeffs = SHSampleOccluder(Get(pointBorder), LPVtoOccluders(texCoord, hpCellSize) + 1.5f * nOffset * hpCellSize, i3(0)); \
 			float3 sourceLuminance = max(SHEvaluateFunction(nOffset, selfSpectralCoeffs), f3(0.0f)); \
 			float  sourceOcclusion = saturate(1.0f - SHEvaluateFunction_float4(-nOffset, occluderCoeffs)); \
 			float  reflectedLuminance = max(SHEvaluateFunction_float4(-nOffset, occluderReflectorCoeffs), 0.0f); \
@@ -205,8 +199,8 @@ void IVPropagateDirN(inout(SHSpectralCoeffs) pixelCoeffs,
 	if (useOcclusion || multipleReflections)
 	{
 		float occlusion  = 1.0f;
-		float hpCellSize = 0.5f / GridRes;
-		SHCoeffs occluderCoeffs = SHSampleOccluder(Get(pointBorder), LPVtoOccluders(texCoord) + nOffset * hpCellSize, i3(0));
+		float hpCellSize = 0.5f / float(Get(uGridRes));
+		SHCoeffs occluderCoeffs = SHSampleOccluder(Get(pointBorder), LPVtoOccluders(texCoord, hpCellSize) + nOffset * hpCellSize, i3(0));
 
 		if (useOcclusion)
 		{
@@ -220,7 +214,7 @@ void IVPropagateDirN(inout(SHSpectralCoeffs) pixelCoeffs,
 		FLATTEN
 		if (multipleReflections)
 		{
-			SHCoeffs occluderReflectorCoeffs = SHSampleOccluder(Get(pointBorder), LPVtoOccluders(texCoord) + 1.5f * nOffset * hpCellSize, i3(0));
+			SHCoeffs occluderReflectorCoeffs = SHSampleOccluder(Get(pointBorder), LPVtoOccluders(texCoord, hpCellSize) + 1.5f * nOffset * hpCellSize, i3(0));
 			float3 sourceLuminance    = max(SHEvaluateFunction(nOffset, selfSpectralCoeffs), f3(0.0f));
 			float  sourceOcclusion    = saturate(1.0f - SHEvaluateFunction_float4(-nOffset, occluderCoeffs));
 			float  reflectedLuminance = max(SHEvaluateFunction_float4(-nOffset, occluderReflectorCoeffs), 0.0f);
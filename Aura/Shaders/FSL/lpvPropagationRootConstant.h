@@ -0,0 +1,23 @@
+/*
+* Copyright (c) 2017-2024 The Forge Interactive Inc.
+*
+* This is a part of Aura.
+* This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge.
+* You can not use this code for commercial purposes.
+*
+*/
+
+#ifndef LPV_PROPAGATION_ROOT_CONSTANT_H
+#define LPV_PROPAGATION_ROOT_CONSTANT_H
+
+//	Shared by the propagation and copy passes. Vertex and pixel stages have to declare the same layout.
+//	TODO: Igor: this can be removed for release if 1
+//	TODO: Igor: Those multiplications can be moved elsewhere to reduce the number of multiplications, e.g.
+//	constants can be premultipled :)
+PUSH_CONSTANT(PropagationSetupRootConstant, b0)
+{
+	DATA(float, fPropagationScale, None);
+	DATA(uint,  uGridRes,          None); // Resolution of the cascade being propagated
+};
+
+#endif // LPV_PROPAGATION_ROOT_CONSTANT_H
@@ -19,6 +19,7 @@ CBUFFER(uniforms, UPDATE_FREQ_NONE, b0, binding = 0)
 	DATA(f4x4,  invView,      None);
 	DATA(float, probeRadius,  None);
 	DATA(float, lightScale,   None);
+	DATA(uint,  gridRes,      None);
 };
 
 RES(SamplerState, linearBorder, UPDATE_FREQ_NONE, s0, binding = 1);
@@ -0,0 +1,515 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "../Interfaces/IAuraTaskManager.h"
+
+#ifdef ENABLE_DEFAULT_TASK_MANAGER
+
+#include <atomic>
+#include <new>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "../Interfaces/IAuraMemoryManager.h"
+
+namespace aura
+{
+static const uint32_t TASK_SET_SLOT_BITS = 12;
+static const uint32_t MAX_TASK_SETS = 1u << TASK_SET_SLOT_BITS;
+static const uint32_t TASK_SET_SLOT_MASK = MAX_TASK_SETS - 1;
+static const uint32_t TASK_SET_GENERATION_COUNT = (0xFFFFFFFFu >> TASK_SET_SLOT_BITS); // the all-ones generation would produce ITASKSETHANDLE_INVALID
+static const uint32_t MAX_DEPENDENCY_LINKS = 2 * MAX_TASK_SETS;
+static const uint32_t TASK_QUEUE_CAPACITY = 4096;
+static const uint32_t MAX_TASK_WORKERS = 64;
+static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+struct TaskItem
+{
+    uint32_t mSlot;
+    uint32_t mIndex;
+};
+
+//	The owner pushes and pops at the bottom, thieves take the oldest item from the top.
+struct TaskQueue
+{
+    pthread_mutex_t mLock;
+    uint32_t        mTop;
+    uint32_t        mBottom;
+    TaskItem        mItems[TASK_QUEUE_CAPACITY];
+
+    bool push(const TaskItem& item)
+    {
+        pthread_mutex_lock(&mLock);
+        const bool hasSpace = mBottom - mTop < TASK_QUEUE_CAPACITY;
+        if (hasSpace)
+            mItems[mBottom++ % TASK_QUEUE_CAPACITY] = item;
+        pthread_mutex_unlock(&mLock);
+        return hasSpace;
+    }
+
+    bool pop(TaskItem* pItem)
+    {
+        pthread_mutex_lock(&mLock);
+        const bool hasItems = mBottom != mTop;
+        if (hasItems)
+            *pItem = mItems[--mBottom % TASK_QUEUE_CAPACITY];
+        pthread_mutex_unlock(&mLock);
+        return hasItems;
+    }
+
+    bool steal(TaskItem* pItem)
+    {
+        pthread_mutex_lock(&mLock);
+        const bool hasItems = mBottom != mTop;
+        if (hasItems)
+            *pItem = mItems[mTop++ % TASK_QUEUE_CAPACITY];
+        pthread_mutex_unlock(&mLock);
+        return hasItems;
+    }
+};
+
+struct TaskSet
+{
+    ITASKSETFUNC          pFunc;
+    void*                 pArg;
+    const char*           pName;
+    uint32_t              mCount;
+    std::atomic<uint32_t> mRemaining;   //	Subtasks that haven't finished yet
+    std::atomic<uint32_t> mPendingDeps; //	Unfinished dependencies, +1 while the set is being created
+    std::atomic<bool>     mDone;
+    //	Written under mGraphLock, isTaskDone reads them without it
+    std::atomic<uint32_t> mGeneration;
+    std::atomic<bool>     mInUse;
+    //	Protected by mGraphLock
+    bool                  mReleased;
+    uint32_t              mFirstDependent;
+    uint32_t              mNextFree;
+};
+
+struct DependencyLink
+{
+    uint32_t mSlot;
+    uint32_t mNext;
+};
+
+class DefaultTaskManager;
+
+struct WorkerThreadArgs
+{
+    DefaultTaskManager* pManager;
+    uint32_t            mIndex;
+};
+
+static thread_local DefaultTaskManager* tlsTaskManager = NULL;
+static thread_local uint32_t            tlsWorkerIndex = 0;
+
+class DefaultTaskManager: public ITaskManager
+{
+public:
+    bool init(uint32_t workerCount);
+    void exit();
+
+    bool createTaskSet(uint32_t group, ITASKSETFUNC pFunc, void* pArg, uint32_t uTaskCount, ITASKSETHANDLE* pDepends, uint32_t nDepends,
+                       const char* setName, ITASKSETHANDLE* pOutHandle) override;
+    void releaseTask(ITASKSETHANDLE hTaskSet) override;
+    void releaseTasks(ITASKSETHANDLE* pHTaskSets, uint32_t nSets) override;
+    void waitForTaskSet(ITASKSETHANDLE hTaskSet) override;
+    bool isTaskDone(ITASKSETHANDLE hTaskSet) override;
+    void waitAll() override;
+    uint32_t getThreadCount() override { return mWorkerCount + 1; }
+
+private:
+    static void* workerThreadFunc(void* pData);
+
+    uint32_t getCallerQueue() const { return (tlsTaskManager == this) ? tlsWorkerIndex : mWorkerCount; }
+    TaskSet* getTaskSet(ITASKSETHANDLE hTaskSet);
+
+    void makeReady(uint32_t slot);
+    void completeTaskSet(uint32_t slot);
+    void freeSlot(uint32_t slot);
+    void runItem(const TaskItem& item, uint32_t context);
+    bool tryRunOne(uint32_t queueIndex);
+    void helpOrYield(uint32_t queueIndex);
+
+    uint32_t         mWorkerCount;
+    pthread_t        mThreads[MAX_TASK_WORKERS];
+    WorkerThreadArgs mWorkerArgs[MAX_TASK_WORKERS];
+    //	One queue per worker plus a shared one for threads outside of the pool
+    TaskQueue* pQueues;
+
+    pthread_mutex_t mGraphLock;
+    TaskSet*        pTaskSets;
+    uint32_t        mFirstFreeSet;
+    DependencyLink* pLinks;
+    uint32_t        mFirstFreeLink;
+
+    pthread_mutex_t       mSleepLock;
+    pthread_cond_t        mSleepCond;
+    std::atomic<uint32_t> mQueuedItems;
+    std::atomic<uint32_t> mOutstandingSets;
+    std::atomic<bool>     mQuit;
+};
+
+bool DefaultTaskManager::init(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        const long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+        workerCount = cpuCount > 1 ? (uint32_t)(cpuCount - 1) : 1;
+    }
+    mWorkerCount = workerCount < MAX_TASK_WORKERS ? workerCount : MAX_TASK_WORKERS;
+
+    pthread_mutex_init(&mGraphLock, NULL);
+    pthread_mutex_init(&mSleepLock, NULL);
+    pthread_cond_init(&mSleepCond, NULL);
+    mQueuedItems.store(0);
+    mOutstandingSets.store(0);
+    mQuit.store(false);
+
+    pQueues = (TaskQueue*)aura::alloc((mWorkerCount + 1) * sizeof(TaskQueue));
+    for (uint32_t i = 0; i < mWorkerCount + 1; ++i)
+    {
+        pthread_mutex_init(&pQueues[i].mLock, NULL);
+        pQueues[i].mTop = 0;
+        pQueues[i].mBottom = 0;
+    }
+
+    pTaskSets = (TaskSet*)aura::alloc(MAX_TASK_SETS * sizeof(TaskSet));
+    for (uint32_t i = 0; i < MAX_TASK_SETS; ++i)
+    {
+        TaskSet* pSet = new (&pTaskSets[i]) TaskSet();
+        pSet->mGeneration.store(0);
+        pSet->mInUse.store(false);
+        pSet->mNextFree = (i + 1 < MAX_TASK_SETS) ? i + 1 : INVALID_INDEX;
+    }
+    mFirstFreeSet = 0;
+
+    pLinks = (DependencyLink*)aura::alloc(MAX_DEPENDENCY_LINKS * sizeof(DependencyLink));
+    for (uint32_t i = 0; i < MAX_DEPENDENCY_LINKS; ++i)
+        pLinks[i].mNext = (i + 1 < MAX_DEPENDENCY_LINKS) ? i + 1 : INVALID_INDEX;
+    mFirstFreeLink = 0;
+
+    for (uint32_t i = 0; i < mWorkerCount; ++i)
+    {
+        mWorkerArgs[i] = { this, i };
+        if (pthread_create(&mThreads[i], NULL, workerThreadFunc, &mWorkerArgs[i]) != 0)
+        {
+            mWorkerCount = i;
+            break;
+        }
+    }
+
+    return mWorkerCount > 0;
+}
+
+void DefaultTaskManager::exit()
+{
+    waitAll();
+
+    pthread_mutex_lock(&mSleepLock);
+    mQuit.store(true);
+    pthread_cond_broadcast(&mSleepCond);
+    pthread_mutex_unlock(&mSleepLock);
+
+    for (uint32_t i = 0; i < mWorkerCount; ++i)
+        pthread_join(mThreads[i], NULL);
+
+    for (uint32_t i = 0; i < MAX_TASK_SETS; ++i)
+        pTaskSets[i].~TaskSet();
+    aura::dealloc(pTaskSets);
+    aura::dealloc(pLinks);
+
+    for (uint32_t i = 0; i < mWorkerCount + 1; ++i)
+        pthread_mutex_destroy(&pQueues[i].mLock);
+    aura::dealloc(pQueues);
+
+    pthread_cond_destroy(&mSleepCond);
+    pthread_mutex_destroy(&mSleepLock);
+    pthread_mutex_destroy(&mGraphLock);
+}
+
+void* DefaultTaskManager::workerThreadFunc(void* pData)
+{
+    const WorkerThreadArgs* pArgs = (const WorkerThreadArgs*)pData;
+    DefaultTaskManager*     pManager = pArgs->pManager;
+
+    //	The index of the worker is its queue and the context it passes to tasks
+    tlsTaskManager = pManager;
+    tlsWorkerIndex = pArgs->mIndex;
+
+    while (!pManager->mQuit.load(std::memory_order_acquire))
+    {
+        if (pManager->tryRunOne(tlsWorkerIndex))
+            continue;
+
+        pthread_mutex_lock(&pManager->mSleepLock);
+        while (pManager->mQueuedItems.load(std::memory_order_acquire) == 0 && !pManager->mQuit.load(std::memory_order_acquire))
+            pthread_cond_wait(&pManager->mSleepCond, &pManager->mSleepLock);
+        pthread_mutex_unlock(&pManager->mSleepLock);
+    }
+
+    return NULL;
+}
+
+TaskSet* DefaultTaskManager::getTaskSet(ITASKSETHANDLE hTaskSet)
+{
+    if (hTaskSet == ITASKSETHANDLE_INVALID)
+        return NULL;
+
+    TaskSet* pSet = &pTaskSets[hTaskSet & TASK_SET_SLOT_MASK];
+    return (pSet->mGeneration.load() == (hTaskSet >> TASK_SET_SLOT_BITS)) ? pSet : NULL;
+}
+
+bool DefaultTaskManager::createTaskSet(uint32_t group, ITASKSETFUNC pFunc, void* pArg, uint32_t uTaskCount, ITASKSETHANDLE* pDepends,
+                                       uint32_t nDepends, const char* setName, ITASKSETHANDLE* pOutHandle)
+{
+    UNREF_PARAM(group);
+
+    pthread_mutex_lock(&mGraphLock);
+    const uint32_t slot = mFirstFreeSet;
+    if (slot == INVALID_INDEX)
+    {
+        pthread_mutex_unlock(&mGraphLock);
+        if (pOutHandle)
+            *pOutHandle = ITASKSETHANDLE_INVALID;
+        return false;
+    }
+
+    TaskSet* pSet = &pTaskSets[slot];
+    mFirstFreeSet = pSet->mNextFree;
+
+    pSet->pFunc = pFunc;
+    pSet->pArg = pArg;
+    pSet->pName = setName;
+    pSet->mCount = uTaskCount;
+    pSet->mRemaining.store(uTaskCount, std::memory_order_relaxed);
+    pSet->mPendingDeps.store(1, std::memory_order_relaxed);
+    pSet->mDone.store(false, std::memory_order_relaxed);
+    pSet->mInUse.store(true);
+    pSet->mReleased = false;
+    pSet->mFirstDependent = INVALID_INDEX;
+
+    //	Released or finished dependencies are already satisfied
+    for (uint32_t i = 0; i < nDepends; ++i)
+    {
+        TaskSet* pDependency = getTaskSet(pDepends[i]);
+        if (!pDependency || !pDependency->mInUse.load() || pDependency->mDone.load(std::memory_order_acquire))
+            continue;
+
+        const uint32_t link = mFirstFreeLink;
+        ASSERT(link != INVALID_INDEX);
+        if (link == INVALID_INDEX)
+        {
+            //	Out of links, fall back to waiting for the dependency below
+            pthread_mutex_unlock(&mGraphLock);
+            waitForTaskSet(pDepends[i]);
+            pthread_mutex_lock(&mGraphLock);
+            continue;
+        }
+
+        mFirstFreeLink = pLinks[link].mNext;
+        pLinks[link].mSlot = slot;
+        pLinks[link].mNext = pDependency->mFirstDependent;
+        pDependency->mFirstDependent = link;
+        pSet->mPendingDeps.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const ITASKSETHANDLE handle = (pSet->mGeneration.load() << TASK_SET_SLOT_BITS) | slot;
+    pthread_mutex_unlock(&mGraphLock);
+
+    mOutstandingSets.fetch_add(1, std::memory_order_acq_rel);
+
+    if (pOutHandle)
+        *pOutHandle = handle;
+
+    if (pSet->mPendingDeps.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        makeReady(slot);
+
+    return true;
+}
+
+void DefaultTaskManager::makeReady(uint32_t slot)
+{
+    TaskSet* pSet = &pTaskSets[slot];
+    if (pSet->mCount == 0)
+    {
+        completeTaskSet(slot);
+        return;
+    }
+
+    const uint32_t queueIndex = getCallerQueue();
+    mQueuedItems.fetch_add(pSet->mCount, std::memory_order_acq_rel);
+
+    for (uint32_t i = 0; i < pSet->mCount; ++i)
+    {
+        const TaskItem item = { slot, i };
+        bool           queued = false;
+        for (uint32_t q = 0; q < mWorkerCount + 1 && !queued; ++q)
+            queued = pQueues[(queueIndex + q) % (mWorkerCount + 1)].push(item);
+
+        //	Every queue is full. No locks are held here, so run the item right away.
+        if (!queued)
+        {
+            mQueuedItems.fetch_sub(1, std::memory_order_acq_rel);
+            runItem(item, queueIndex);
+        }
+    }
+
+    pthread_mutex_lock(&mSleepLock);
+    pthread_cond_broadcast(&mSleepCond);
+    pthread_mutex_unlock(&mSleepLock);
+}
+
+void DefaultTaskManager::completeTaskSet(uint32_t slot)
+{
+    TaskSet* pSet = &pTaskSets[slot];
+
+    pthread_mutex_lock(&mGraphLock);
+    pSet->mDone.store(true, std::memory_order_release);
+    const uint32_t firstDependent = pSet->mFirstDependent;
+    pSet->mFirstDependent = INVALID_INDEX;
+    if (pSet->mReleased)
+        freeSlot(slot);
+    pthread_mutex_unlock(&mGraphLock);
+
+    //	The detached dependency list is owned by this thread now
+    uint32_t lastLink = INVALID_INDEX;
+    for (uint32_t link = firstDependent; link != INVALID_INDEX; link = pLinks[link].mNext)
+    {
+        TaskSet* pDependent = &pTaskSets[pLinks[link].mSlot];
+        if (pDependent->mPendingDeps.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            makeReady(pLinks[link].mSlot);
+        lastLink = link;
+    }
+
+    if (lastLink != INVALID_INDEX)
+    {
+        pthread_mutex_lock(&mGraphLock);
+        pLinks[lastLink].mNext = mFirstFreeLink;
+        mFirstFreeLink = firstDependent;
+        pthread_mutex_unlock(&mGraphLock);
+    }
+
+    mOutstandingSets.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+//	Called with mGraphLock held
+void DefaultTaskManager::freeSlot(uint32_t slot)
+{
+    TaskSet* pSet = &pTaskSets[slot];
+    pSet->mInUse.store(false);
+    pSet->mGeneration.store((pSet->mGeneration.load() + 1) % TASK_SET_GENERATION_COUNT);
+    pSet->mNextFree = mFirstFreeSet;
+    mFirstFreeSet = slot;
+}
+
+void DefaultTaskManager::runItem(const TaskItem& item, uint32_t context)
+{
+    TaskSet* pSet = &pTaskSets[item.mSlot];
+    pSet->pFunc(pSet->pArg, (int32_t)context, item.mIndex, pSet->mCount);
+
+    if (pSet->mRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        completeTaskSet(item.mSlot);
+}
+
+bool DefaultTaskManager::tryRunOne(uint32_t queueIndex)
+{
+    const uint32_t queueCount = mWorkerCount + 1;
+    TaskItem       item;
+
+    //	Own work first (most recent, cache-hot), then the oldest work of everybody else
+    bool found = pQueues[queueIndex].pop(&item);
+    for (uint32_t q = 1; q < queueCount && !found; ++q)
+        found = pQueues[(queueIndex + q) % queueCount].steal(&item);
+
+    if (!found)
+        return false;
+
+    mQueuedItems.fetch_sub(1, std::memory_order_acq_rel);
+    runItem(item, queueIndex);
+    return true;
+}
+
+void DefaultTaskManager::helpOrYield(uint32_t queueIndex)
+{
+    if (!tryRunOne(queueIndex))
+        sched_yield();
+}
+
+void DefaultTaskManager::releaseTask(ITASKSETHANDLE hTaskSet)
+{
+    pthread_mutex_lock(&mGraphLock);
+    TaskSet* pSet = getTaskSet(hTaskSet);
+    if (pSet && pSet->mInUse.load() && !pSet->mReleased)
+    {
+        pSet->mReleased = true;
+        //	Sets released before they finish are recycled by completeTaskSet
+        if (pSet->mDone.load(std::memory_order_acquire))
+            freeSlot(hTaskSet & TASK_SET_SLOT_MASK);
+    }
+    pthread_mutex_unlock(&mGraphLock);
+}
+
+void DefaultTaskManager::releaseTasks(ITASKSETHANDLE* pHTaskSets, uint32_t nSets)
+{
+    for (uint32_t i = 0; i < nSets; ++i)
+        releaseTask(pHTaskSets[i]);
+}
+
+bool DefaultTaskManager::isTaskDone(ITASKSETHANDLE hTaskSet)
+{
+    //	A recycled slot means the set finished and was released
+    TaskSet* pSet = getTaskSet(hTaskSet);
+    if (!pSet || !pSet->mInUse.load() || pSet->mDone.load(std::memory_order_acquire))
+        return true;
+
+    //	Without mGraphLock the slot can be recycled after the generation check, mInUse and mDone may belong to the next set
+    return !getTaskSet(hTaskSet);
+}
+
+void DefaultTaskManager::waitForTaskSet(ITASKSETHANDLE hTaskSet)
+{
+    const uint32_t queueIndex = getCallerQueue();
+    while (!isTaskDone(hTaskSet))
+        helpOrYield(queueIndex);
+}
+
+void DefaultTaskManager::waitAll()
+{
+    const uint32_t queueIndex = getCallerQueue();
+    while (mOutstandingSets.load(std::memory_order_acquire) != 0)
+        helpOrYield(queueIndex);
+}
+
+void initDefaultTaskManager(uint32_t workerCount, ITaskManager** ppTaskManager)
+{
+    DefaultTaskManager* pManager = new (aura::alloc(sizeof(DefaultTaskManager))) DefaultTaskManager();
+    if (!pManager->init(workerCount))
+    {
+        pManager->exit();
+        pManager->~DefaultTaskManager();
+        aura::dealloc(pManager);
+        pManager = NULL;
+    }
+
+    *ppTaskManager = pManager;
+}
+
+void removeDefaultTaskManager(ITaskManager* pTaskManager)
+{
+    DefaultTaskManager* pManager = (DefaultTaskManager*)pTaskManager;
+    pManager->exit();
+    pManager->~DefaultTaskManager();
+    aura::dealloc(pManager);
+}
+} // namespace aura
+
+#endif // ENABLE_DEFAULT_TASK_MANAGER
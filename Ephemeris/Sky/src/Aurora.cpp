@@ -9,3 +9,249 @@
  */
 
 #include "Aurora.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
+
+#include "../../src/ParallelFor.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
+
+// Work per parallelFor task. Batches smaller than this are relaxed on the calling thread without waking any helper.
+#define AURORA_CONSTRAINTS_PER_TASK 2048
+#define AURORA_PARTICLES_PER_TASK   8192
+// A particle's used colors are tracked in a 64 bit mask
+#define AURORA_MAX_COLORS           64
+
+struct AuroraSolverTask
+{
+    AuroraSolver* pSolver;
+    uint32_t      begin;
+    uint32_t      end;
+    float         deltaTime;
+};
+
+static int compareConstraints(const void* pLhs, const void* pRhs)
+{
+    const AuroraSolverConstraint* lhs = (const AuroraSolverConstraint*)pLhs;
+    const AuroraSolverConstraint* rhs = (const AuroraSolverConstraint*)pRhs;
+    const uint32_t                lhsFirst = min(lhs->p1, lhs->p2);
+    const uint32_t                rhsFirst = min(rhs->p1, rhs->p2);
+    return lhsFirst < rhsFirst ? -1 : (lhsFirst > rhsFirst ? 1 : 0);
+}
+
+void AuroraSolver::Init(const Aurora& aurora, uint32_t solverThreadCount)
+{
+    Exit();
+
+    threadCount = solverThreadCount;
+    particleCount = (uint32_t)arrlenu(aurora.particles);
+    constraintCount = (uint32_t)arrlenu(aurora.constraints);
+
+    // One block for all particle streams
+    float* particleData = (float*)tf_calloc((size_t)particleCount * 11, sizeof(float));
+    float* streams[11];
+    for (uint32_t i = 0; i < 11; ++i)
+        streams[i] = particleData + (size_t)i * particleCount;
+    positionX = streams[0];
+    positionY = streams[1];
+    positionZ = streams[2];
+    prevPositionX = streams[3];
+    prevPositionY = streams[4];
+    prevPositionZ = streams[5];
+    accelerationX = streams[6];
+    accelerationY = streams[7];
+    accelerationZ = streams[8];
+    mass = streams[9];
+    movable = streams[10];
+
+    for (uint32_t i = 0; i < particleCount; ++i)
+    {
+        const AuroraParticle& particle = aurora.particles[i];
+        positionX[i] = particle.position.getX();
+        positionY[i] = particle.position.getY();
+        positionZ[i] = particle.position.getZ();
+        prevPositionX[i] = particle.prevPosition.getX();
+        prevPositionY[i] = particle.prevPosition.getY();
+        prevPositionZ[i] = particle.prevPosition.getZ();
+        accelerationX[i] = particle.acceleration.getX();
+        accelerationY[i] = particle.acceleration.getY();
+        accelerationZ[i] = particle.acceleration.getZ();
+        mass[i] = particle.mass;
+        movable[i] = particle.IsMovable ? 1.0f : 0.0f;
+    }
+
+    // Greedy coloring in constraint order: every constraint takes the first color neither of its particles uses yet
+    uint64_t* usedColors = (uint64_t*)tf_calloc(particleCount ? particleCount : 1, sizeof(uint64_t));
+    uint8_t*  constraintColors = (uint8_t*)tf_malloc(constraintCount ? constraintCount : 1);
+    uint32_t  colorSizes[AURORA_MAX_COLORS] = {};
+    for (uint32_t i = 0; i < constraintCount; ++i)
+    {
+        uint32_t p1 = (uint32_t)(aurora.constraints[i].p1 - aurora.particles);
+        uint32_t p2 = (uint32_t)(aurora.constraints[i].p2 - aurora.particles);
+        ASSERT(p1 < particleCount && p2 < particleCount);
+
+        uint64_t used = usedColors[p1] | usedColors[p2];
+        uint32_t color = 0;
+        while (used & (1ull << color))
+            ++color;
+        ASSERT(color < AURORA_MAX_COLORS);
+
+        usedColors[p1] |= 1ull << color;
+        usedColors[p2] |= 1ull << color;
+        constraintColors[i] = (uint8_t)color;
+        colorCount = max(colorCount, color + 1);
+        ++colorSizes[color];
+    }
+
+    colorOffsets = (uint32_t*)tf_malloc((colorCount + 1) * sizeof(uint32_t));
+    colorOffsets[0] = 0;
+    for (uint32_t color = 0; color < colorCount; ++color)
+        colorOffsets[color + 1] = colorOffsets[color] + colorSizes[color];
+
+    constraints = (AuroraSolverConstraint*)tf_malloc((constraintCount ? constraintCount : 1) * sizeof(AuroraSolverConstraint));
+    uint32_t nextInColor[AURORA_MAX_COLORS];
+    memcpy(nextInColor, colorOffsets, colorCount * sizeof(uint32_t));
+    for (uint32_t i = 0; i < constraintCount; ++i)
+    {
+        AuroraSolverConstraint& constraint = constraints[nextInColor[constraintColors[i]]++];
+        constraint.p1 = (uint32_t)(aurora.constraints[i].p1 - aurora.particles);
+        constraint.p2 = (uint32_t)(aurora.constraints[i].p2 - aurora.particles);
+        constraint.restDistance = aurora.constraints[i].getRestDistance();
+    }
+
+    // Constraints of one color don't share particles, so their order doesn't change the result. Walking them in particle order
+    // keeps the SoA streams cache friendly, Aurora::Init emits its grid constraints column by column.
+    for (uint32_t color = 0; color < colorCount; ++color)
+        qsort(constraints + colorOffsets[color], colorSizes[color], sizeof(AuroraSolverConstraint), compareConstraints);
+
+    tf_free(constraintColors);
+    tf_free(usedColors);
+}
+
+void AuroraSolver::Exit()
+{
+    tf_free(positionX);
+    tf_free(constraints);
+    tf_free(colorOffsets);
+    positionX = positionY = positionZ = NULL;
+    prevPositionX = prevPositionY = prevPositionZ = NULL;
+    accelerationX = accelerationY = accelerationZ = NULL;
+    mass = movable = NULL;
+    constraints = NULL;
+    colorOffsets = NULL;
+    particleCount = constraintCount = colorCount = 0;
+}
+
+void AuroraSolver::addForce(const vec3& direction)
+{
+    const float x = direction.getX();
+    const float y = direction.getY();
+    const float z = direction.getZ();
+    for (uint32_t i = 0; i < particleCount; ++i)
+    {
+        accelerationX[i] += x / mass[i];
+        accelerationY[i] += y / mass[i];
+        accelerationZ[i] += z / mass[i];
+    }
+}
+
+// Aurora::windForce applies the direction to every particle, the per triangle version is disabled there as well
+void AuroraSolver::windForce(const vec3& direction) { addForce(direction); }
+
+static void taskRelaxConstraints(void* pUserData, uint32_t taskIndex)
+{
+    const AuroraSolverTask* pTask = (const AuroraSolverTask*)pUserData;
+    AuroraSolver*           pSolver = pTask->pSolver;
+
+    const uint32_t begin = pTask->begin + taskIndex * AURORA_CONSTRAINTS_PER_TASK;
+    const uint32_t end = min(begin + AURORA_CONSTRAINTS_PER_TASK, pTask->end);
+
+    float* px = pSolver->positionX;
+    float* py = pSolver->positionY;
+    float* pz = pSolver->positionZ;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        const AuroraSolverConstraint& constraint = pSolver->constraints[i];
+        const uint32_t                p1 = constraint.p1;
+        const uint32_t                p2 = constraint.p2;
+
+        // Same correction as AuroraConstraint::satisfyConstraint
+        const float gapX = px[p2] - px[p1];
+        const float gapY = py[p2] - py[p1];
+        const float gapZ = pz[p2] - pz[p1];
+        const float currentDistance = sqrtf(gapX * gapX + gapY * gapY + gapZ * gapZ);
+        const float scale = 1.0f - constraint.restDistance / currentDistance;
+        const float correctionX = gapX * scale * 0.5f;
+        const float correctionY = gapY * scale * 0.5f;
+        const float correctionZ = gapZ * scale * 0.5f;
+
+        if (pSolver->movable[p1] != 0.0f)
+        {
+            px[p1] += correctionX;
+            py[p1] += correctionY;
+            pz[p1] += correctionZ;
+        }
+        if (pSolver->movable[p2] != 0.0f)
+        {
+            px[p2] -= correctionX;
+            py[p2] -= correctionY;
+            pz[p2] -= correctionZ;
+        }
+    }
+}
+
+static void taskIntegrateParticles(void* pUserData, uint32_t taskIndex)
+{
+    const AuroraSolverTask* pTask = (const AuroraSolverTask*)pUserData;
+    AuroraSolver*           pSolver = pTask->pSolver;
+
+    const uint32_t begin = taskIndex * AURORA_PARTICLES_PER_TASK;
+    const uint32_t end = min(begin + AURORA_PARTICLES_PER_TASK, pSolver->particleCount);
+    const float    deltaTime = pTask->deltaTime;
+    const float    keep = 1.0f - DAMPING;
+
+    float* const streams[3][3] = {
+        { pSolver->positionX, pSolver->prevPositionX, pSolver->accelerationX },
+        { pSolver->positionY, pSolver->prevPositionY, pSolver->accelerationY },
+        { pSolver->positionZ, pSolver->prevPositionZ, pSolver->accelerationZ },
+    };
+    const float* movable = pSolver->movable;
+
+    // Verlet step of AuroraParticle::update, one branch free loop per axis so it vectorizes
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        float* position = streams[axis][0];
+        float* prevPosition = streams[axis][1];
+        float* acceleration = streams[axis][2];
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const float current = position[i];
+            const float next = current + (current - prevPosition[i]) * keep + acceleration[i] * deltaTime;
+            const bool  isMovable = movable[i] != 0.0f;
+            position[i] = isMovable ? next : current;
+            prevPosition[i] = isMovable ? current : prevPosition[i];
+            acceleration[i] = 0.0f;
+        }
+    }
+}
+
+void AuroraSolver::update(float deltaTime)
+{
+    AuroraSolverTask task = {};
+    task.pSolver = this;
+    task.deltaTime = deltaTime;
+
+    for (uint32_t i = 0; i < CONSTRAINT_ITERATIONS; i++)
+    {
+        for (uint32_t color = 0; color < colorCount; ++color)
+        {
+            task.begin = colorOffsets[color];
+            task.end = colorOffsets[color + 1];
+            const uint32_t taskCount = (task.end - task.begin + AURORA_CONSTRAINTS_PER_TASK - 1) / AURORA_CONSTRAINTS_PER_TASK;
+            parallelFor(taskRelaxConstraints, &task, taskCount, threadCount);
+        }
+    }
+
+    const uint32_t taskCount = (particleCount + AURORA_PARTICLES_PER_TASK - 1) / AURORA_PARTICLES_PER_TASK;
+    parallelFor(taskIntegrateParticles, &task, taskCount, threadCount);
+}
@@ -88,6 +88,8 @@ public:
         rest_distance = length(gap);
     }
 
+    float getRestDistance() const { return rest_distance; }
+
     /* This is one of the important methods, where a single constraint between two particles p1 and p2 is solved
     the method is called by Cloth.time_step() many times per frame*/
     void satisfyConstraint()
@@ -254,3 +256,47 @@ public:
     AuroraParticleStbDsArray   particles = NULL;   // all particles that are part of this cloth
     AuroraConstraintStbDsArray constraints = NULL; // alle constraints between particles as part of this cloth
 };
+
+struct AuroraSolverConstraint
+{
+    uint32_t p1;
+    uint32_t p2;
+    float    restDistance;
+};
+
+/* CPU backend for the same simulation as Aurora. Particles are stored as SoA and the constraints are split into batches (colors)
+in which no two constraints share a particle, so every batch can be relaxed in parallel. Within a batch constraints keep their
+particle order, the end state only differs from Aurora::update by the order constraints are relaxed in.*/
+class AuroraSolver
+{
+public:
+    // Takes over the particles and constraints of a legacy aurora. threadCount 0 uses every core, 1 stays on the calling thread.
+    void Init(const Aurora& aurora, uint32_t solverThreadCount = 1);
+    void Exit();
+
+    void addForce(const vec3& direction);
+    void windForce(const vec3& direction);
+    void update(float deltaTime);
+
+    vec3 getPosition(uint32_t index) const { return vec3(positionX[index], positionY[index], positionZ[index]); }
+
+    uint32_t particleCount = 0;
+    uint32_t threadCount = 1;
+
+    float* positionX = NULL;
+    float* positionY = NULL;
+    float* positionZ = NULL;
+    float* prevPositionX = NULL;
+    float* prevPositionY = NULL;
+    float* prevPositionZ = NULL;
+    float* accelerationX = NULL;
+    float* accelerationY = NULL;
+    float* accelerationZ = NULL;
+    float* mass = NULL;
+    float* movable = NULL; // 1.0f or 0.0f so the integration doesn't branch
+
+    uint32_t                constraintCount = 0;
+    AuroraSolverConstraint* constraints = NULL; // sorted by color, then by particle
+    uint32_t                colorCount = 0;
+    uint32_t*               colorOffsets = NULL; // colorCount + 1 entries into constraints
+};
@@ -10,8 +10,15 @@
 
 #include "Ephemeris.h"
 
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
+
 namespace confetti
 {
+static const double TWO_PI_D = 6.283185307179586;
+
+//	The series grow by up to ~230000 radians per century, reduce before going to float
+static double wrapAngle(double angle) { return angle - TWO_PI_D * floor(angle / TWO_PI_D); }
+
 //	TODO: C: vheck all signs here
 
 mat4 rotateX(const float angle)
@@ -53,7 +60,7 @@ void Ephemeris::Update(const Location& location, const LocalTime& localTime)
     Ry = rotateY(((float)location.getLatitude() - PI / 2.0f));
     //	TODO: B: check: Igor: changed this to make sun rotate correct side
     // Rz = rotateZ(LSTM);
-    Rz = rotateZ((float)-m_LSTM);
+    Rz = rotateZ((float)-wrapAngle(m_LSTM));
     Rx = rotateX((float)e);
     m_EquatorialToHorizon = Ry * Rz * m_Precession;
     m_EclipticToHorizon = Ry * Rz * m_Precession * Rx;
@@ -74,7 +81,7 @@ void Ephemeris::UpdateSunPosition()
     double M = 6.24 + 628.302 * m_TimeAtomic;
 
     m_sunEclipticLongitude =
-        (float)(4.895048 + 628.331951 * m_TimeAtomic + (0.033417 - 0.000084 * m_TimeAtomic) * sin(M) + 0.000351 * sin(2.0 * M));
+        (float)wrapAngle(4.895048 + 628.331951 * m_TimeAtomic + (0.033417 - 0.000084 * m_TimeAtomic) * sin(M) + 0.000351 * sin(2.0 * M));
 
     double latitude = 0;
     double geocentricDistance = 1.000140 - (0.016708 - 0.000042 * m_TimeAtomic) * cos(M) - 0.000141 * cos(2.0 * M); // AU's
@@ -166,7 +173,7 @@ void Ephemeris::UpdateMoonPosition()
 
     m_moonHorizon = toEngine(v3ToF3(EclipticToHorizon * f3Tov3(vEcliptical)));
 
-    float moonPhaseAngle = (float)longitude - m_sunEclipticLongitude;
+    float moonPhaseAngle = (float)wrapAngle(longitude) - m_sunEclipticLongitude;
     m_SunLocalToMoon.y = 0;                    // sin(latitude);
     m_SunLocalToMoon.x = -cos(moonPhaseAngle); //*cos(latitude);
     m_SunLocalToMoon.z = sin(moonPhaseAngle);  //*cos(latitude);
@@ -182,4 +189,236 @@ void Ephemeris::UpdateMoonPosition()
     moonDistance = (moonHoriz - Vector3(0, 0, 1)).Length() * 6378.137;
     */
 }
+
+//	Samples evaluated per pass over the SoA scratch of UpdateBatch
+#define EPHEMERIS_BATCH_SIZE 64
+//	One hour in centuries. Precession moves by less than 1e-8 radians in that time.
+#define EPHEMERIS_PRECESSION_REUSE_CENTURIES (1.0 / (24.0 * 36525.0))
+
+static inline double batchSin(double x) { return sin(x); }
+static inline double batchCos(double x) { return cos(x); }
+static inline float  batchSin(float x) { return sinf(x); }
+static inline float  batchCos(float x) { return cosf(x); }
+
+//	Row major 3x3 in the precision of the batch
+template<typename Real> struct BatchMatrix
+{
+    Real m[3][3];
+};
+
+template<typename Real> static BatchMatrix<Real> batchMul(const BatchMatrix<Real>& a, const BatchMatrix<Real>& b)
+{
+    BatchMatrix<Real> r;
+    for (int row = 0; row < 3; ++row)
+        for (int col = 0; col < 3; ++col)
+            r.m[row][col] = a.m[row][0] * b.m[0][col] + a.m[row][1] * b.m[1][col] + a.m[row][2] * b.m[2][col];
+    return r;
+}
+
+//	Same rotations as rotateX/Y/Z
+template<typename Real> static BatchMatrix<Real> batchRotateX(double angle)
+{
+    Real              c = (Real)cos(angle), s = (Real)sin(angle);
+    BatchMatrix<Real> r = { { { 1, 0, 0 }, { 0, c, -s }, { 0, s, c } } };
+    return r;
+}
+
+template<typename Real> static BatchMatrix<Real> batchRotateY(double angle)
+{
+    Real              c = (Real)cos(angle), s = (Real)sin(angle);
+    BatchMatrix<Real> r = { { { c, 0, -s }, { 0, 1, 0 }, { s, 0, c } } };
+    return r;
+}
+
+template<typename Real> static BatchMatrix<Real> batchRotateZ(double angle)
+{
+    Real              c = (Real)cos(angle), s = (Real)sin(angle);
+    BatchMatrix<Real> r = { { { c, -s, 0 }, { s, c, 0 }, { 0, 0, 1 } } };
+    return r;
+}
+
+//	Latitude rotation with the row swizzle of toEngine(mat4&) applied
+template<typename Real> static BatchMatrix<Real> batchLocationToEngine(const Location& location)
+{
+    BatchMatrix<Real> ry = batchRotateY<Real>(location.getLatitude() - TWO_PI_D / 4.0);
+    BatchMatrix<Real> r;
+    for (int col = 0; col < 3; ++col)
+    {
+        r.m[0][col] = ry.m[1][col];
+        r.m[1][col] = ry.m[2][col];
+        r.m[2][col] = -ry.m[0][col];
+    }
+    return r;
+}
+
+//	Ecliptic to horizon is locationToEngine * rotateZ(-LSTM) * precession * rotateX(obliquity).
+//	Only the middle rotation changes from sample to sample.
+template<typename Real>
+static float3 batchEclipticToHorizon(const BatchMatrix<Real>& locationToEngine, Real sinLSTM, Real cosLSTM,
+                                     const BatchMatrix<Real>& precessedEcliptic, Real x, Real y, Real z)
+{
+    const Real(*b)[3] = precessedEcliptic.m;
+    Real px = b[0][0] * x + b[0][1] * y + b[0][2] * z;
+    Real py = b[1][0] * x + b[1][1] * y + b[1][2] * z;
+    Real pz = b[2][0] * x + b[2][1] * y + b[2][2] * z;
+
+    Real rx = cosLSTM * px + sinLSTM * py;
+    Real ry = cosLSTM * py - sinLSTM * px;
+
+    const Real(*a)[3] = locationToEngine.m;
+    return float3((float)(a[0][0] * rx + a[0][1] * ry + a[0][2] * pz), (float)(a[1][0] * rx + a[1][1] * ry + a[1][2] * pz),
+                  (float)(a[2][0] * rx + a[2][1] * ry + a[2][2] * pz));
+}
+
+template<typename Real> static void updateBatch(const EphemerisBatchDesc& desc, const EphemerisBatchOutput& output)
+{
+    ASSERT(desc.pLocalTimes && desc.pLocations);
+    ASSERT(desc.mLocationCount == 1 || desc.mLocationCount == desc.mCount);
+
+    BatchMatrix<Real> locationToEngine = batchLocationToEngine<Real>(desc.pLocations[0]);
+    BatchMatrix<Real> precessedEcliptic = {};
+    double            precessionTime = 0.0;
+    bool              precessionValid = false;
+
+    //	Per sample inputs, matrices and series terms, SoA so the series loops vectorize
+    BatchMatrix<Real> precession[EPHEMERIS_BATCH_SIZE];
+    Real              T[EPHEMERIS_BATCH_SIZE];
+    Real              lstm[EPHEMERIS_BATCH_SIZE], sunM[EPHEMERIS_BATCH_SIZE], sunL[EPHEMERIS_BATCH_SIZE];
+    Real              lp[EPHEMERIS_BATCH_SIZE], m[EPHEMERIS_BATCH_SIZE], f[EPHEMERIS_BATCH_SIZE], mp[EPHEMERIS_BATCH_SIZE],
+        d[EPHEMERIS_BATCH_SIZE];
+    Real sinLSTM[EPHEMERIS_BATCH_SIZE], cosLSTM[EPHEMERIS_BATCH_SIZE], sinSunM[EPHEMERIS_BATCH_SIZE], cosSunM[EPHEMERIS_BATCH_SIZE];
+    Real sinM[EPHEMERIS_BATCH_SIZE], cosM[EPHEMERIS_BATCH_SIZE], sinF[EPHEMERIS_BATCH_SIZE], cosF[EPHEMERIS_BATCH_SIZE];
+    Real sinMP[EPHEMERIS_BATCH_SIZE], cosMP[EPHEMERIS_BATCH_SIZE], sinD[EPHEMERIS_BATCH_SIZE], cosD[EPHEMERIS_BATCH_SIZE];
+    Real sunDistance[EPHEMERIS_BATCH_SIZE], moonLongitude[EPHEMERIS_BATCH_SIZE], moonLatitude[EPHEMERIS_BATCH_SIZE],
+        moonDistance[EPHEMERIS_BATCH_SIZE];
+    Real sinSunL[EPHEMERIS_BATCH_SIZE], cosSunL[EPHEMERIS_BATCH_SIZE], sinMoonLon[EPHEMERIS_BATCH_SIZE], cosMoonLon[EPHEMERIS_BATCH_SIZE],
+        sinMoonLat[EPHEMERIS_BATCH_SIZE], cosMoonLat[EPHEMERIS_BATCH_SIZE];
+
+    for (uint32_t begin = 0; begin < desc.mCount; begin += EPHEMERIS_BATCH_SIZE)
+    {
+        const uint32_t count = min((uint32_t)EPHEMERIS_BATCH_SIZE, desc.mCount - begin);
+
+        //	Times and the slowly varying terms. Angles are reduced in double before anything goes to Real.
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const LocalTime& localTime = desc.pLocalTimes[begin + i];
+            const Location&  location = desc.pLocations[desc.mLocationCount == 1 ? 0 : begin + i];
+            double           timeGMT = localTime.getJ200Centuries(false);
+            double           t = localTime.getJ200Centuries(true);
+
+            if (!precessionValid || fabs(t - precessionTime) > EPHEMERIS_PRECESSION_REUSE_CENTURIES)
+            {
+                BatchMatrix<Real> ry = batchRotateY<Real>(-0.00972 * t);
+                BatchMatrix<Real> rz = batchRotateZ<Real>(0.01118 * t);
+                precessedEcliptic = batchMul(batchMul(batchMul(rz, ry), rz), batchRotateX<Real>(0.409093 - 0.000227 * t));
+                precessionTime = t;
+                precessionValid = true;
+            }
+            precession[i] = precessedEcliptic;
+
+            T[i] = (Real)t;
+            lstm[i] = (Real)wrapAngle(4.894961 + 230121.675315 * timeGMT + location.getLongitude());
+            sunM[i] = (Real)wrapAngle(6.24 + 628.302 * t);
+            sunL[i] = (Real)wrapAngle(4.895048 + 628.331951 * t);
+            lp[i] = (Real)wrapAngle(3.8104 + 8399.7091 * t);
+            m[i] = (Real)wrapAngle(6.2300 + 628.3019 * t);
+            f[i] = (Real)wrapAngle(1.6280 + 8433.4663 * t);
+            mp[i] = (Real)wrapAngle(2.3554 + 8328.6911 * t);
+            d[i] = (Real)wrapAngle(5.1985 + 7771.3772 * t);
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            sinLSTM[i] = batchSin(lstm[i]);
+            cosLSTM[i] = batchCos(lstm[i]);
+            sinSunM[i] = batchSin(sunM[i]);
+            cosSunM[i] = batchCos(sunM[i]);
+            sinM[i] = batchSin(m[i]);
+            cosM[i] = batchCos(m[i]);
+            sinF[i] = batchSin(f[i]);
+            cosF[i] = batchCos(f[i]);
+            sinMP[i] = batchSin(mp[i]);
+            cosMP[i] = batchCos(mp[i]);
+            sinD[i] = batchSin(d[i]);
+            cosD[i] = batchCos(d[i]);
+        }
+
+        //	The series of UpdateSunPosition and UpdateMoonPosition, every harmonic expanded from the four base angles
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const Real t = T[i];
+            const Real sM = sinSunM[i], cM = cosSunM[i];
+            const Real sin2SunM = 2 * sM * cM;
+            const Real cos2SunM = 1 - 2 * sM * sM;
+
+            sunL[i] += (Real)(0.033417 - 0.000084 * t) * sM + (Real)0.000351 * sin2SunM;
+            sunDistance[i] = (Real)1.000140 - (Real)(0.016708 - 0.000042 * t) * cM - (Real)0.000141 * cos2SunM;
+
+            const Real sm = sinM[i], cm = cosM[i];
+            const Real sf = sinF[i], cf = cosF[i];
+            const Real sp = sinMP[i], cp = cosMP[i];
+            const Real s2d = 2 * sinD[i] * cosD[i], c2d = 1 - 2 * sinD[i] * sinD[i];
+            const Real s2p = 2 * sp * cp, c2p = 1 - 2 * sp * sp;
+            const Real s2f = 2 * sf * cf;
+            const Real sinMPlusMP = sm * cp + cm * sp, cosMPlusMP = cm * cp - sm * sp;
+            const Real sinMPPlusF = sp * cf + cp * sf, cosMPPlusF = cp * cf - sp * sf;
+            const Real sinFMinusMP = sf * cp - cf * sp, cosFMinusMP = cf * cp + sf * sp;
+
+            moonLongitude[i] = lp[i] + (Real)0.1098 * sp + (Real)0.0222 * (s2d * cp - c2d * sp) + (Real)0.0115 * s2d + (Real)0.0037 * s2p -
+                               (Real)0.0032 * sm - (Real)0.0020 * s2f + (Real)0.0010 * (s2d * c2p - c2d * s2p) +
+                               (Real)0.0010 * (s2d * cosMPlusMP - c2d * sinMPlusMP) + (Real)0.0009 * (s2d * cp + c2d * sp) +
+                               (Real)0.0008 * (s2d * cm - c2d * sm) + (Real)0.0007 * (sp * cm - cp * sm) - (Real)0.0006 * sinD[i] -
+                               (Real)0.0005 * sinMPlusMP;
+
+            moonLatitude[i] = (Real)0.0895 * sf + (Real)0.0049 * sinMPPlusF + (Real)0.0048 * (sp * cf - cp * sf) +
+                              (Real)0.0030 * (s2d * cf - c2d * sf) + (Real)0.0010 * (s2d * cosFMinusMP + c2d * sinFMinusMP) +
+                              (Real)0.0008 * (s2d * cosMPPlusF - c2d * sinMPPlusF) + (Real)0.0006 * (s2d * cf + c2d * sf);
+
+            Real pip = (Real)0.016593 + (Real)0.000904 * cp + (Real)0.000166 * (c2d * cp + s2d * sp) + (Real)0.000137 * c2d +
+                       (Real)0.000049 * c2p + (Real)0.000015 * (c2d * cp - s2d * sp) + (Real)0.000009 * (c2d * cm + s2d * sm);
+            moonDistance[i] = 1 / pip; // earth radii
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            sinSunL[i] = batchSin(sunL[i]);
+            cosSunL[i] = batchCos(sunL[i]);
+            sinMoonLon[i] = batchSin(moonLongitude[i]);
+            cosMoonLon[i] = batchCos(moonLongitude[i]);
+            sinMoonLat[i] = batchSin(moonLatitude[i]);
+            cosMoonLat[i] = batchCos(moonLatitude[i]);
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (desc.mLocationCount != 1)
+                locationToEngine = batchLocationToEngine<Real>(desc.pLocations[begin + i]);
+
+            //	toCartesian negates the latitude
+            if (output.pSunDirections)
+                output.pSunDirections[begin + i] = batchEclipticToHorizon(locationToEngine, sinLSTM[i], cosLSTM[i], precession[i],
+                                                                          sunDistance[i] * cosSunL[i], sunDistance[i] * sinSunL[i],
+                                                                          (Real)0);
+            if (output.pMoonDirections)
+                output.pMoonDirections[begin + i] = batchEclipticToHorizon(
+                    locationToEngine, sinLSTM[i], cosLSTM[i], precession[i], moonDistance[i] * cosMoonLon[i] * cosMoonLat[i],
+                    moonDistance[i] * sinMoonLon[i] * cosMoonLat[i], -moonDistance[i] * sinMoonLat[i]);
+            if (output.pSunLocalToMoonDirections)
+            {
+                //	Moon phase angle is moonLongitude - sunL
+                Real cosPhase = cosMoonLon[i] * cosSunL[i] + sinMoonLon[i] * sinSunL[i];
+                Real sinPhase = sinMoonLon[i] * cosSunL[i] - cosMoonLon[i] * sinSunL[i];
+                output.pSunLocalToMoonDirections[begin + i] = float3((float)-cosPhase, 0.0f, (float)sinPhase);
+            }
+        }
+    }
+}
+
+void Ephemeris::UpdateBatch(const EphemerisBatchDesc& desc, const EphemerisBatchOutput& output)
+{
+    if (desc.mPrecision == EPHEMERIS_PRECISION_FLOAT)
+        updateBatch<float>(desc, output);
+    else
+        updateBatch<double>(desc, output);
+}
 } // namespace confetti
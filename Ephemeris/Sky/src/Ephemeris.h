@@ -21,11 +21,41 @@ namespace confetti
 class Location;
 class LocalTime;
 
+enum EphemerisPrecision
+{
+    //	Series and transforms in double, matches Ephemeris::Update
+    EPHEMERIS_PRECISION_DOUBLE,
+    //	Angles are reduced to [0, 2PI) in double, everything after that is float. Directions stay within ~1e-5 radians.
+    EPHEMERIS_PRECISION_FLOAT,
+};
+
+struct EphemerisBatchDesc
+{
+    const LocalTime* pLocalTimes;
+    //	Either one location per time or a single one shared by all of them
+    const Location*    pLocations;
+    uint32_t           mCount;
+    uint32_t           mLocationCount;
+    EphemerisPrecision mPrecision;
+};
+
+//	Any of the arrays can be NULL, the others receive mCount directions each
+struct EphemerisBatchOutput
+{
+    float3* pSunDirections;
+    float3* pMoonDirections;
+    float3* pSunLocalToMoonDirections;
+};
+
 class Ephemeris
 {
 public:
     void Update(const Location& location, const LocalTime& localTime);
 
+    //	Sun and moon directions for many instants at once, e.g. to precompute lighting timelines.
+    //	Precession is only recomputed when the time moves by more than an hour, so sorted times are cheapest.
+    static void UpdateBatch(const EphemerisBatchDesc& desc, const EphemerisBatchOutput& output);
+
     const float3& getSunDirection() const { return m_sunHorizon; }
     const float3& getMoonDirection() const { return m_moonHorizon; }
     const float3& getSunLocalToMoonDirection() const { return m_SunLocalToMoon; }
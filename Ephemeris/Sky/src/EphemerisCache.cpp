@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "EphemerisCache.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../The-Forge/Common_3/Utilities/ThirdParty/OpenSource/Nothings/stb_ds.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
+
+namespace confetti
+{
+#define EPHEMERIS_CACHE_MAGIC   0x43485045 // 'EPHC'
+#define EPHEMERIS_CACHE_VERSION 1
+
+static const double SECONDS_PER_CENTURY = 36525.0 * 24.0 * 60.0 * 60.0;
+
+//	Step of the 5 point stencil used for the tangents. Short enough for the truncation error,
+//	long enough that the float rounding of Update doesn't dominate once scaled by hour long intervals.
+static const double TANGENT_STEP_SECONDS = 600.0;
+
+//	Every interval is checked at these points against half of the allowed error
+static const double intervalCheckPoints[3] = { 0.25, 0.5, 0.75 };
+
+struct EphemerisCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    double   beginCenturies;
+    double   latitude;
+    double   longitude;
+    double   durationSeconds;
+    double   maxAngularError;
+    double   maxStepSeconds;
+    double   minStepSeconds;
+    uint32_t nodeCount;
+    uint32_t reserved;
+};
+
+EphemerisCacheDesc getDefaultEphemerisCacheDesc(const Location& location, const LocalTime& begin, double durationSeconds)
+{
+    EphemerisCacheDesc desc = {};
+    desc.mLocation = location;
+    desc.mBegin = begin;
+    desc.mDurationSeconds = durationSeconds;
+    //	About 1% of the sun disk
+    desc.mMaxAngularError = 1e-4;
+    desc.mMaxStepSeconds = 6.0 * 60.0 * 60.0;
+    desc.mMinStepSeconds = 60.0;
+    return desc;
+}
+
+static void sampleEphemeris(const EphemerisCacheDesc& desc, double seconds, float3* pOutValues)
+{
+    LocalTime localTime = desc.mBegin;
+    localTime.setLocalSeconds(desc.mBegin.getLocalSeconds() + seconds);
+
+    Ephemeris ephemeris;
+    ephemeris.Update(desc.mLocation, localTime);
+    pOutValues[0] = ephemeris.getSunDirection();
+    pOutValues[1] = ephemeris.getMoonDirection();
+    pOutValues[2] = ephemeris.getSunLocalToMoonDirection();
+}
+
+static EphemerisCacheNode createNode(const EphemerisCacheDesc& desc, double seconds)
+{
+    EphemerisCacheNode node = {};
+    node.mSeconds = seconds;
+    sampleEphemeris(desc, seconds, node.mValues);
+
+    static const double stencilOffsets[4] = { -2.0, -1.0, 1.0, 2.0 };
+    static const double stencilWeights[4] = { 1.0, -8.0, 8.0, -1.0 };
+
+    double tangents[EPHEMERIS_CACHE_CHANNEL_COUNT][3] = {};
+    for (uint32_t s = 0; s < 4; ++s)
+    {
+        float3 values[EPHEMERIS_CACHE_CHANNEL_COUNT];
+        sampleEphemeris(desc, seconds + stencilOffsets[s] * TANGENT_STEP_SECONDS, values);
+        for (uint32_t c = 0; c < EPHEMERIS_CACHE_CHANNEL_COUNT; ++c)
+        {
+            tangents[c][0] += stencilWeights[s] * values[c].x;
+            tangents[c][1] += stencilWeights[s] * values[c].y;
+            tangents[c][2] += stencilWeights[s] * values[c].z;
+        }
+    }
+
+    const double scale = 1.0 / (12.0 * TANGENT_STEP_SECONDS);
+    for (uint32_t c = 0; c < EPHEMERIS_CACHE_CHANNEL_COUNT; ++c)
+        node.mTangents[c] = float3((float)(tangents[c][0] * scale), (float)(tangents[c][1] * scale), (float)(tangents[c][2] * scale));
+    return node;
+}
+
+static float3 hermite(const float3& p0, const float3& m0, const float3& p1, const float3& m1, double h, double u)
+{
+    const double u2 = u * u;
+    const double u3 = u2 * u;
+    const double h00 = 2.0 * u3 - 3.0 * u2 + 1.0;
+    const double h10 = (u3 - 2.0 * u2 + u) * h;
+    const double h01 = -2.0 * u3 + 3.0 * u2;
+    const double h11 = (u3 - u2) * h;
+
+    return float3((float)(h00 * p0.x + h10 * m0.x + h01 * p1.x + h11 * m1.x), (float)(h00 * p0.y + h10 * m0.y + h01 * p1.y + h11 * m1.y),
+                  (float)(h00 * p0.z + h10 * m0.z + h01 * p1.z + h11 * m1.z));
+}
+
+static void interpolateNodes(const EphemerisCacheNode& a, const EphemerisCacheNode& b, double seconds, float3* pOutValues)
+{
+    const double h = b.mSeconds - a.mSeconds;
+    const double u = h > 0.0 ? (seconds - a.mSeconds) / h : 0.0;
+    for (uint32_t c = 0; c < EPHEMERIS_CACHE_CHANNEL_COUNT; ++c)
+        pOutValues[c] = hermite(a.mValues[c], a.mTangents[c], b.mValues[c], b.mTangents[c], h, u);
+}
+
+static double angleBetween(const float3& a, const float3& b)
+{
+    const double cx = (double)a.y * b.z - (double)a.z * b.y;
+    const double cy = (double)a.z * b.x - (double)a.x * b.z;
+    const double cz = (double)a.x * b.y - (double)a.y * b.x;
+    const double dot = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+    return atan2(sqrt(cx * cx + cy * cy + cz * cz), dot);
+}
+
+static bool isIntervalWithinError(const EphemerisCacheDesc& desc, const EphemerisCacheNode& a, const EphemerisCacheNode& b)
+{
+    for (uint32_t i = 0; i < sizeof(intervalCheckPoints) / sizeof(intervalCheckPoints[0]); ++i)
+    {
+        const double seconds = a.mSeconds + (b.mSeconds - a.mSeconds) * intervalCheckPoints[i];
+
+        float3 exact[EPHEMERIS_CACHE_CHANNEL_COUNT];
+        float3 interpolated[EPHEMERIS_CACHE_CHANNEL_COUNT];
+        sampleEphemeris(desc, seconds, exact);
+        interpolateNodes(a, b, seconds, interpolated);
+
+        for (uint32_t c = 0; c < EPHEMERIS_CACHE_CHANNEL_COUNT; ++c)
+        {
+            if (angleBetween(exact[c], interpolated[c]) > 0.5 * desc.mMaxAngularError)
+                return false;
+        }
+    }
+    return true;
+}
+
+void EphemerisCache::Init(const EphemerisCacheDesc& desc)
+{
+    ASSERT(desc.mDurationSeconds >= 0.0);
+    ASSERT(desc.mMinStepSeconds > 0.0 && desc.mMinStepSeconds <= desc.mMaxStepSeconds);
+
+    Exit();
+    m_desc = desc;
+    m_beginCenturies = desc.mBegin.getJ200Centuries(false);
+
+    //	Walk forward, halving the step until the interval is accurate enough and growing it again afterwards
+    arrpush(m_pNodes, createNode(desc, 0.0));
+    double step = desc.mMaxStepSeconds;
+    while (m_pNodes[arrlen(m_pNodes) - 1].mSeconds < desc.mDurationSeconds)
+    {
+        const EphemerisCacheNode last = m_pNodes[arrlen(m_pNodes) - 1];
+
+        step = fmin(step, desc.mDurationSeconds - last.mSeconds);
+        EphemerisCacheNode next = createNode(desc, last.mSeconds + step);
+        while (step > desc.mMinStepSeconds && !isIntervalWithinError(desc, last, next))
+        {
+            step = fmax(step * 0.5, desc.mMinStepSeconds);
+            next = createNode(desc, last.mSeconds + step);
+        }
+
+        arrpush(m_pNodes, next);
+        step = fmin(step * 2.0, desc.mMaxStepSeconds);
+    }
+
+    m_nodeCount = (uint32_t)arrlen(m_pNodes);
+}
+
+void EphemerisCache::Exit()
+{
+    arrfree(m_pNodes);
+    m_nodeCount = 0;
+}
+
+static void getEphemerisCacheHeader(const EphemerisCacheDesc& desc, uint32_t nodeCount, EphemerisCacheHeader* pHeader)
+{
+    memset(pHeader, 0, sizeof(*pHeader));
+    pHeader->magic = EPHEMERIS_CACHE_MAGIC;
+    pHeader->version = EPHEMERIS_CACHE_VERSION;
+    pHeader->beginCenturies = desc.mBegin.getJ200Centuries(false);
+    pHeader->latitude = desc.mLocation.getLatitude();
+    pHeader->longitude = desc.mLocation.getLongitude();
+    pHeader->durationSeconds = desc.mDurationSeconds;
+    pHeader->maxAngularError = desc.mMaxAngularError;
+    pHeader->maxStepSeconds = desc.mMaxStepSeconds;
+    pHeader->minStepSeconds = desc.mMinStepSeconds;
+    pHeader->nodeCount = nodeCount;
+}
+
+bool EphemerisCache::Load(ResourceDirectory resourceDir, const char* fileName, const EphemerisCacheDesc& desc)
+{
+    FileStream fh = {};
+    if (!fsOpenStreamFromPath(resourceDir, fileName, FM_READ, &fh))
+        return false;
+
+    EphemerisCacheHeader header = {};
+    EphemerisCacheHeader expected = {};
+    bool                 valid = fsReadFromStream(&fh, &header, sizeof(header)) == sizeof(header);
+    getEphemerisCacheHeader(desc, header.nodeCount, &expected);
+    valid = valid && header.nodeCount > 0 && memcmp(&header, &expected, sizeof(header)) == 0;
+
+    const size_t nodesSize = (size_t)header.nodeCount * sizeof(EphemerisCacheNode);
+    valid = valid && (size_t)fsGetStreamFileSize(&fh) == sizeof(header) + nodesSize;
+    if (!valid)
+    {
+        LOGF(LogLevel::eINFO, "Ephemeris cache %s is out of date", fileName);
+        fsCloseStream(&fh);
+        return false;
+    }
+
+    Exit();
+    arrsetlen(m_pNodes, header.nodeCount);
+    valid = fsReadFromStream(&fh, m_pNodes, nodesSize) == nodesSize;
+    fsCloseStream(&fh);
+
+    if (!valid)
+    {
+        LOGF(LogLevel::eWARNING, "Failed to read ephemeris cache %s", fileName);
+        Exit();
+        return false;
+    }
+
+    m_desc = desc;
+    m_beginCenturies = header.beginCenturies;
+    m_nodeCount = header.nodeCount;
+    return true;
+}
+
+bool EphemerisCache::Save(ResourceDirectory resourceDir, const char* fileName) const
+{
+    ASSERT(m_nodeCount > 0);
+
+    FileStream fh = {};
+    if (!fsOpenStreamFromPath(resourceDir, fileName, FM_WRITE, &fh))
+    {
+        LOGF(LogLevel::eWARNING, "Failed to write ephemeris cache %s", fileName);
+        return false;
+    }
+
+    EphemerisCacheHeader header;
+    getEphemerisCacheHeader(m_desc, m_nodeCount, &header);
+
+    const size_t nodesSize = (size_t)m_nodeCount * sizeof(EphemerisCacheNode);
+    bool         written = fsWriteToStream(&fh, &header, sizeof(header)) == sizeof(header);
+    written = written && fsWriteToStream(&fh, m_pNodes, nodesSize) == nodesSize;
+    fsCloseStream(&fh);
+
+    if (!written)
+        LOGF(LogLevel::eWARNING, "Failed to write ephemeris cache %s", fileName);
+    return written;
+}
+
+void EphemerisCache::Lookup(const LocalTime& localTime, float3* pOutSunDirection, float3* pOutMoonDirection,
+                            float3* pOutSunLocalToMoon) const
+{
+    const double seconds = (localTime.getJ200Centuries(false) - m_beginCenturies) * SECONDS_PER_CENTURY;
+    Lookup(seconds, pOutSunDirection, pOutMoonDirection, pOutSunLocalToMoon);
+}
+
+void EphemerisCache::Lookup(double secondsFromBegin, float3* pOutSunDirection, float3* pOutMoonDirection, float3* pOutSunLocalToMoon) const
+{
+    ASSERT(m_nodeCount > 0);
+
+    //	Last node at or before the requested time
+    uint32_t first = 0;
+    uint32_t count = m_nodeCount;
+    while (count > 1)
+    {
+        const uint32_t half = count / 2;
+        if (m_pNodes[first + half].mSeconds <= secondsFromBegin)
+            first += half;
+        count -= half;
+    }
+
+    float3 values[EPHEMERIS_CACHE_CHANNEL_COUNT];
+    if (first + 1 < m_nodeCount)
+    {
+        const EphemerisCacheNode& a = m_pNodes[first];
+        const EphemerisCacheNode& b = m_pNodes[first + 1];
+        interpolateNodes(a, b, fmin(fmax(secondsFromBegin, a.mSeconds), b.mSeconds), values);
+    }
+    else
+    {
+        memcpy(values, m_pNodes[first].mValues, sizeof(values));
+    }
+
+    if (pOutSunDirection)
+        *pOutSunDirection = values[0];
+    if (pOutMoonDirection)
+        *pOutMoonDirection = values[1];
+    if (pOutSunLocalToMoon)
+        *pOutSunLocalToMoon = values[2];
+}
+} // namespace confetti
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IFileSystem.h"
+
+#include "Ephemeris.h"
+
+namespace confetti
+{
+//	Sun, moon and sun local to moon directions
+#define EPHEMERIS_CACHE_CHANNEL_COUNT 3
+
+struct EphemerisCacheDesc
+{
+    Location  mLocation;
+    LocalTime mBegin;
+    double    mDurationSeconds;
+    //	Largest angle between a looked up direction and the one of Ephemeris::Update, radians.
+    //	Update returns floats, bounds below ~1e-6 only refine down to mMinStepSeconds.
+    double    mMaxAngularError;
+    //	Bounds of the adaptive time grid
+    double    mMaxStepSeconds;
+    double    mMinStepSeconds;
+};
+
+EphemerisCacheDesc getDefaultEphemerisCacheDesc(const Location& location, const LocalTime& begin, double durationSeconds);
+
+struct EphemerisCacheNode
+{
+    double mSeconds;
+    float3 mValues[EPHEMERIS_CACHE_CHANNEL_COUNT];
+    //	Derivatives per second
+    float3 mTangents[EPHEMERIS_CACHE_CHANNEL_COUNT];
+};
+
+//	Directions sampled on a time grid that is refined until cubic Hermite interpolation stays within mMaxAngularError.
+class EphemerisCache
+{
+public:
+    void Init(const EphemerisCacheDesc& desc);
+    void Exit();
+
+    //	Load fails when the file was built for a different desc
+    bool Load(ResourceDirectory resourceDir, const char* fileName, const EphemerisCacheDesc& desc);
+    bool Save(ResourceDirectory resourceDir, const char* fileName) const;
+
+    //	Times outside of the cached range are clamped to it. Any output can be NULL.
+    void Lookup(const LocalTime& localTime, float3* pOutSunDirection, float3* pOutMoonDirection, float3* pOutSunLocalToMoon) const;
+    void Lookup(double secondsFromBegin, float3* pOutSunDirection, float3* pOutMoonDirection, float3* pOutSunLocalToMoon) const;
+
+    uint32_t getNodeCount() const { return m_nodeCount; }
+
+private:
+    EphemerisCacheDesc  m_desc = {};
+    double              m_beginCenturies = 0.0;
+    EphemerisCacheNode* m_pNodes = NULL;
+    uint32_t            m_nodeCount = 0;
+};
+} // namespace confetti
@@ -11,6 +11,11 @@
 #include "Icosahedron.h"
 
 #include "../../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../The-Forge/Common_3/Utilities/Math/MathTypes.h"
+
+#include "../../src/ParallelFor.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
 
 static const float icosahedronA = 0.85065080835204f;   // sqrt(2.0f / (5.0f - sqrt(5.0f)))
 static const float icosahedronB = 0.5257311121191336f; // sqrt(2.0f / (5.0f + sqrt(5.0f)))
@@ -30,104 +35,270 @@ static const uint32_t icosahedronIndices[icosahedronTriangleCount * 3] = {
     3, 4, 9,  3, 2, 4, 3, 6, 2, 3, 8,  6, 3, 9,  8,  4, 5, 9, 2, 11, 4,  6,  10, 2,  8,  7, 6, 9, 1, 8,
 };
 
-struct EdgeNode
+// Faces subdivided by one parallelFor task
+#define ICOSPHERE_FACES_PER_TASK 2048
+
+// Every level has 4x the faces of the previous one: F = 20 * 4^n, E = 30 * 4^n, V = V_prev + E_prev = 10 * 4^n + 2
+static uint32_t getIcosphereFaceCount(uint32_t subdivisions) { return icosahedronTriangleCount << (2 * subdivisions); }
+static uint32_t getIcosphereEdgeCount(uint32_t subdivisions) { return 30u << (2 * subdivisions); }
+
+uint32_t getIcosphereVertexCount(uint32_t subdivisions) { return (10u << (2 * subdivisions)) + 2; }
+uint32_t getIcosphereIndexCount(uint32_t subdivisions) { return getIcosphereFaceCount(subdivisions) * 3; }
+
+// Edges are numbered in the order a scan over the faces first touches them, which is also the order the midpoints are appended in.
+// The face corner (face * 3 + corner) of that first touch owns the edge and is the only one that writes its midpoint.
+struct IcosphereEdge
+{
+    uint32_t v0;
+    uint32_t v1;
+    uint32_t owner;
+};
+
+// Split of face (t0, t1, t2) with midpoints m0 = (t0, t1), m1 = (t1, t2), m2 = (t2, t0) into
+// (t0, m0, m2), (m0, t1, m1), (m0, m1, m2), (m2, m1, t2). Each child edge is either one half of a parent edge
+// (corner * 2 + 0 for the half at the edge start, corner * 2 + 1 for the half at its end) or one of the three inner edges (6 + n).
+static const uint8_t childEdgeSources[12] = { 0, 6, 5, 1, 2, 7, 7, 8, 6, 8, 3, 4 };
+
+struct IcosphereLevel
 {
-    uint64_t key;
-    uint32_t value;
+    const uint32_t*      pIndices;
+    const uint32_t*      pFaceEdges;
+    const IcosphereEdge* pEdges;
+    const uint32_t*      pNewEdgeStart;
+    uint32_t             faceCount;
+    uint32_t             vertexCount;
+
+    VertexF3*      pVertices;
+    uint32_t*      pNewIndices;
+    // Only written when another level follows
+    uint32_t*      pNewFaceEdges;
+    IcosphereEdge* pNewEdges;
+    uint32_t*      pHalfEdges;
 };
 
-typedef EdgeNode* EdgeMapStbDs;
+static bool isEdgeOwner(const IcosphereLevel* pLevel, uint32_t face, uint32_t corner)
+{
+    return pLevel->pEdges[pLevel->pFaceEdges[face * 3 + corner]].owner == face * 3 + corner;
+}
+
+// Index of the half of parent edge e that touches vertex v into pHalfEdges
+static uint32_t getHalfEdgeSlot(const IcosphereEdge* pEdge, uint32_t edge, uint32_t v) { return edge * 2 + (pEdge->v0 == v ? 0 : 1); }
 
-static uint32_t insertOrGetMidpoint(EdgeMapStbDs* midPointMap, VertexStbDsArray* vertices, uint32_t lIndex, uint32_t rIndex)
+static void subdivideFaces(void* pUserData, uint32_t taskIndex)
 {
-    ASSERT(midPointMap);
-    ASSERT(vertices && *vertices);
+    IcosphereLevel* pLevel = (IcosphereLevel*)pUserData;
+
+    uint32_t faceBegin = taskIndex * ICOSPHERE_FACES_PER_TASK;
+    uint32_t faceEnd = min(faceBegin + ICOSPHERE_FACES_PER_TASK, pLevel->faceCount);
+
+    for (uint32_t face = faceBegin; face < faceEnd; ++face)
+    {
+        const uint32_t* t = pLevel->pIndices + face * 3;
+        const uint32_t* e = pLevel->pFaceEdges + face * 3;
+
+        uint32_t m[3];
+        bool     owned[3];
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+            m[corner] = pLevel->vertexCount + e[corner];
+            owned[corner] = isEdgeOwner(pLevel, face, corner);
+            if (!owned[corner])
+                continue;
+
+            const VertexF3& a = pLevel->pVertices[t[corner]];
+            const VertexF3& b = pLevel->pVertices[t[(corner + 1) % 3]];
 
-    uint64_t li = lIndex;
-    uint64_t ri = rIndex;
+            VertexF3 c{ {
+                (a.pos[0] + b.pos[0]) / 2,
+                (a.pos[1] + b.pos[1]) / 2,
+                (a.pos[2] + b.pos[2]) / 2,
+            } };
+            pLevel->pVertices[m[corner]] = c;
+        }
 
-    if (lIndex > rIndex)
-        ri <<= 32;
-    else
-        li <<= 32;
+        uint32_t* ind = pLevel->pNewIndices + face * 12;
 
-    uint64_t key = ri | li;
+        *(ind++) = t[0]; //-V769
+        *(ind++) = m[0];
+        *(ind++) = m[2];
+        *(ind++) = m[0];
+        *(ind++) = t[1];
+        *(ind++) = m[1];
+        *(ind++) = m[0];
+        *(ind++) = m[1];
+        *(ind++) = m[2];
+        *(ind++) = m[2];
+        *(ind++) = m[1];
+        *(ind++) = t[2];
 
-    EdgeNode* point = hmgetp_null(*midPointMap, key);
-    if (point)
-        return point->value;
+        if (!pLevel->pNewFaceEdges)
+            continue;
 
-    VertexF3& a = (*vertices)[lIndex]; //-V595
-    VertexF3& b = (*vertices)[rIndex]; //-V595
+        // Number the child edges first touched by this face in scan order. Halves of edges owned by an earlier face are filled by
+        // linkSharedHalfEdges once every face has numbered its own.
+        const uint32_t* childIndices = pLevel->pNewIndices + face * 12;
+        uint32_t        sourceEdges[9];
+        memset(sourceEdges, 0xFF, sizeof(sourceEdges));
+        uint32_t nextEdge = pLevel->pNewEdgeStart[face];
+        for (uint32_t childCorner = 0; childCorner < 12; ++childCorner)
+        {
+            uint32_t source = childEdgeSources[childCorner];
+            bool     isHalf = source < 6;
+            if (isHalf && !owned[source / 2])
+                continue;
 
-    VertexF3 c{ {
-        (a.pos[0] + b.pos[0]) / 2,
-        (a.pos[1] + b.pos[1]) / 2,
-        (a.pos[2] + b.pos[2]) / 2,
-    } };
+            if (sourceEdges[source] == UINT32_MAX)
+            {
+                IcosphereEdge* pEdge = &pLevel->pNewEdges[nextEdge];
+                pEdge->v0 = childIndices[childCorner];
+                pEdge->v1 = childIndices[childCorner - childCorner % 3 + (childCorner + 1) % 3];
+                pEdge->owner = face * 12 + childCorner;
+                sourceEdges[source] = nextEdge++;
 
-    uint32_t index = (uint32_t)arrlen(*vertices);
-    hmput(*midPointMap, key, index);
-    arrpush(*vertices, c);
-    return index;
+                if (isHalf)
+                {
+                    uint32_t corner = source / 2;
+                    uint32_t v = t[(corner + (source & 1)) % 3];
+                    pLevel->pHalfEdges[getHalfEdgeSlot(&pLevel->pEdges[e[corner]], e[corner], v)] = sourceEdges[source];
+                }
+            }
+            pLevel->pNewFaceEdges[face * 12 + childCorner] = sourceEdges[source];
+        }
+    }
 }
 
-static void Subdivide(VertexStbDsArray* outVertices, IndexStbDsArray* outIndices)
+static void linkSharedHalfEdges(void* pUserData, uint32_t taskIndex)
 {
-    EdgeMapStbDs midPointMap = NULL;
-
-    uint32_t* oldIndices = *outIndices;
+    IcosphereLevel* pLevel = (IcosphereLevel*)pUserData;
 
-    uint32_t        numTriangles = (uint32_t)arrlen(*outIndices) / 3;
-    IndexStbDsArray newIndices = NULL;
-    arrsetlen(newIndices, numTriangles * 12);
-    ASSERT(newIndices);
+    uint32_t faceBegin = taskIndex * ICOSPHERE_FACES_PER_TASK;
+    uint32_t faceEnd = min(faceBegin + ICOSPHERE_FACES_PER_TASK, pLevel->faceCount);
 
-    for (uint32_t i = 0; i < numTriangles; ++i)
+    for (uint32_t face = faceBegin; face < faceEnd; ++face)
     {
-        uint32_t t0 = oldIndices[i * 3 + 0];
-        uint32_t t1 = oldIndices[i * 3 + 1];
-        uint32_t t2 = oldIndices[i * 3 + 2];
-
-        uint32_t m0 = insertOrGetMidpoint(&midPointMap, outVertices, t0, t1);
-        uint32_t m1 = insertOrGetMidpoint(&midPointMap, outVertices, t1, t2);
-        uint32_t m2 = insertOrGetMidpoint(&midPointMap, outVertices, t2, t0);
-
-        uint32_t* ind = newIndices + i * 12;
-
-        *(ind++) = t0; //-V769
-        *(ind++) = m0;
-        *(ind++) = m2;
-        *(ind++) = m0;
-        *(ind++) = t1;
-        *(ind++) = m1;
-        *(ind++) = m0;
-        *(ind++) = m1;
-        *(ind++) = m2;
-        *(ind++) = m2;
-        *(ind++) = m1;
-        *(ind++) = t2;
+        const uint32_t* t = pLevel->pIndices + face * 3;
+        const uint32_t* e = pLevel->pFaceEdges + face * 3;
+
+        for (uint32_t childCorner = 0; childCorner < 12; ++childCorner)
+        {
+            uint32_t source = childEdgeSources[childCorner];
+            if (source >= 6 || isEdgeOwner(pLevel, face, source / 2))
+                continue;
+
+            uint32_t corner = source / 2;
+            uint32_t v = t[(corner + (source & 1)) % 3];
+            pLevel->pNewFaceEdges[face * 12 + childCorner] =
+                pLevel->pHalfEdges[getHalfEdgeSlot(&pLevel->pEdges[e[corner]], e[corner], v)];
+        }
     }
+}
+
+// Edges of the base icosahedron in scan order
+static void initIcosahedronEdges(IcosphereEdge* pEdges, uint32_t* pFaceEdges)
+{
+    uint32_t edgeCount = 0;
+    for (uint32_t faceCorner = 0; faceCorner < icosahedronTriangleCount * 3; ++faceCorner)
+    {
+        uint32_t v0 = icosahedronIndices[faceCorner];
+        uint32_t v1 = icosahedronIndices[faceCorner - faceCorner % 3 + (faceCorner + 1) % 3];
+
+        uint32_t edge = 0;
+        while (edge < edgeCount && !((pEdges[edge].v0 == v0 && pEdges[edge].v1 == v1) || (pEdges[edge].v0 == v1 && pEdges[edge].v1 == v0)))
+            ++edge;
 
-    hmfree(midPointMap);
-    arrfree(*outIndices);
-    *outIndices = newIndices;
+        if (edge == edgeCount)
+        {
+            pEdges[edgeCount].v0 = v0;
+            pEdges[edgeCount].v1 = v1;
+            pEdges[edgeCount].owner = faceCorner;
+            ++edgeCount;
+        }
+        pFaceEdges[faceCorner] = edge;
+    }
+    ASSERT(edgeCount == getIcosphereEdgeCount(0));
 }
 
-void CreateIcosphere(uint32_t subdivisions, VertexStbDsArray* outVertices, IndexStbDsArray* outIndices)
+void CreateIcosphere(uint32_t subdivisions, VertexStbDsArray* outVertices, IndexStbDsArray* outIndices, uint32_t threadCount)
 {
+    ASSERT(subdivisions <= ICOSPHERE_MAX_SUBDIVISIONS);
+
     VertexStbDsArray vertices = NULL;
     IndexStbDsArray  indices = NULL;
-    arrsetlen(vertices, icosahedronVertexCount);
-    arrsetlen(indices, icosahedronTriangleCount * 3);
+    arrsetlen(vertices, getIcosphereVertexCount(subdivisions));
+    arrsetlen(indices, getIcosphereIndexCount(subdivisions));
+    ASSERT(vertices && indices);
     memcpy((VertexF3*)vertices, icosahedronVertices, icosahedronVertexCount * sizeof(*vertices));
-    memcpy(indices, icosahedronIndices, icosahedronTriangleCount * 3 * sizeof(*indices));
 
-    for (uint32_t i = 0; i < subdivisions; ++i)
+    if (subdivisions == 0)
     {
-        Subdivide(&vertices, &indices);
+        memcpy(indices, icosahedronIndices, icosahedronTriangleCount * 3 * sizeof(*indices));
+        *outVertices = vertices;
+        *outIndices = indices;
+        return;
     }
 
+    // Intermediate levels ping-pong between two sets of buffers sized for the level before the last one.
+    // The last level writes straight into the output indices and doesn't need its edges.
+    uint32_t       maxFaceCount = getIcosphereFaceCount(subdivisions - 1);
+    uint32_t       maxEdgeCount = getIcosphereEdgeCount(subdivisions - 1);
+    uint32_t*      pScratchIndices[2] = { (uint32_t*)tf_malloc(maxFaceCount * 3 * sizeof(uint32_t)),
+                                     (uint32_t*)tf_malloc(maxFaceCount * 3 * sizeof(uint32_t)) };
+    uint32_t*      pFaceEdges[2] = { (uint32_t*)tf_malloc(maxFaceCount * 3 * sizeof(uint32_t)),
+                                (uint32_t*)tf_malloc(maxFaceCount * 3 * sizeof(uint32_t)) };
+    IcosphereEdge* pEdges[2] = { (IcosphereEdge*)tf_malloc(maxEdgeCount * sizeof(IcosphereEdge)),
+                                 (IcosphereEdge*)tf_malloc(maxEdgeCount * sizeof(IcosphereEdge)) };
+    uint32_t*      pNewEdgeStart = (uint32_t*)tf_malloc(maxFaceCount * sizeof(uint32_t));
+    uint32_t*      pHalfEdges = (uint32_t*)tf_malloc(maxEdgeCount * 2 * sizeof(uint32_t));
+
+    initIcosahedronEdges(pEdges[0], pFaceEdges[0]);
+
+    for (uint32_t level = 0; level < subdivisions; ++level)
+    {
+        bool isLastLevel = level + 1 == subdivisions;
+
+        IcosphereLevel data = {};
+        data.pIndices = level == 0 ? icosahedronIndices : pScratchIndices[(level - 1) & 1];
+        data.pFaceEdges = pFaceEdges[level & 1];
+        data.pEdges = pEdges[level & 1];
+        data.pNewEdgeStart = pNewEdgeStart;
+        data.faceCount = getIcosphereFaceCount(level);
+        data.vertexCount = getIcosphereVertexCount(level);
+        data.pVertices = vertices;
+        data.pNewIndices = isLastLevel ? indices : pScratchIndices[level & 1];
+
+        if (!isLastLevel)
+        {
+            data.pNewFaceEdges = pFaceEdges[(level + 1) & 1];
+            data.pNewEdges = pEdges[(level + 1) & 1];
+            data.pHalfEdges = pHalfEdges;
+
+            // Every face adds its three inner edges and both halves of the edges it owns
+            uint32_t newEdgeCount = 0;
+            for (uint32_t face = 0; face < data.faceCount; ++face)
+            {
+                pNewEdgeStart[face] = newEdgeCount;
+                newEdgeCount += 3;
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                    newEdgeCount += isEdgeOwner(&data, face, corner) ? 2 : 0;
+            }
+            ASSERT(newEdgeCount == getIcosphereEdgeCount(level + 1));
+        }
+
+        uint32_t taskCount = (data.faceCount + ICOSPHERE_FACES_PER_TASK - 1) / ICOSPHERE_FACES_PER_TASK;
+        parallelFor(subdivideFaces, &data, taskCount, threadCount);
+        if (!isLastLevel)
+            parallelFor(linkSharedHalfEdges, &data, taskCount, threadCount);
+    }
+
+    tf_free(pScratchIndices[0]);
+    tf_free(pScratchIndices[1]);
+    tf_free(pFaceEdges[0]);
+    tf_free(pFaceEdges[1]);
+    tf_free(pEdges[0]);
+    tf_free(pEdges[1]);
+    tf_free(pNewEdgeStart);
+    tf_free(pHalfEdges);
+
     *outVertices = vertices;
     *outIndices = indices;
 }
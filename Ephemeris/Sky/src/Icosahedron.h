@@ -19,4 +19,11 @@ struct VertexF3
 typedef VertexF3* VertexStbDsArray;
 typedef uint32_t* IndexStbDsArray;
 
-void CreateIcosphere(uint32_t subdivisions, VertexStbDsArray* outVertices, IndexStbDsArray* outIndices);
+// Vertex, edge and index counts of deeper levels overflow 32 bits
+#define ICOSPHERE_MAX_SUBDIVISIONS 13
+
+uint32_t getIcosphereVertexCount(uint32_t subdivisions);
+uint32_t getIcosphereIndexCount(uint32_t subdivisions);
+
+// Faces of a level are split in parallel, threadCount 0 uses every CPU core. The result doesn't depend on the thread count.
+void CreateIcosphere(uint32_t subdivisions, VertexStbDsArray* outVertices, IndexStbDsArray* outIndices, uint32_t threadCount = 0);
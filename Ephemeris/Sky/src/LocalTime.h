@@ -28,6 +28,8 @@ public:
     void setLocalHours(int localHours) { m_localHours = localHours; }
     void setLocalMinutes(int localMinutes) { m_localMinutes = localMinutes; }
     void setLocalSeconds(double localSeconds) { m_localSeconds = localSeconds; }
+    //	Seconds aren't wrapped into minutes, any offset can be added here
+    double getLocalSeconds() const { return m_localSeconds; }
 
     void setGMTOffset(int GMTOffset) { m_GMTOffset = GMTOffset; }
 
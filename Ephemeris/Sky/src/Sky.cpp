@@ -63,6 +63,10 @@ static float StarDensity = 10.0f;
 static float StarDistribution = 20000000.0f;
 static float ParticleSize = 100000.0f;
 
+// Nebula and stars only depend on the values above and the seed, the cache is regenerated whenever one of them changes
+static uint32_t    StarSeed = 1;
+static const char* pSpaceCacheName = "EphemerisSpace.cache";
+
 float4 NebulaHighColor = unpackR8G8B8A8_SRGB(0x412C1D78);
 float4 NebulaMidColor = unpackR8G8B8A8_SRGB(0x041D22FF);
 float4 NebulaLowColor = unpackR8G8B8A8_SRGB(0x040315FF);
@@ -203,131 +207,31 @@ float noise(const vec3& x)
                 f.getZ());
 }
 
-float3 ColorTemperatureToRGB(float temperatureInKelvins)
-{
-    float3 retColor;
-
-    temperatureInKelvins = clamp(temperatureInKelvins, 1000.0f, 40000.0f) / 100.0f;
-
-    if (temperatureInKelvins <= 66.0f)
-    {
-        retColor.x = 1.0f;
-        retColor.y = clamp(0.39008157876901960784f * log(temperatureInKelvins) - 0.63184144378862745098f, 0.0f, 1.0f);
-    }
-    else
-    {
-        float t = temperatureInKelvins - 60.0f;
-        retColor.x = clamp(1.29293618606274509804f * pow(t, -0.1332047592f), 0.0f, 1.0f);
-        retColor.y = clamp(1.12989086089529411765f * pow(t, -0.0755148492f), 0.0f, 1.0f);
-    }
-
-    if (temperatureInKelvins > 66.0f)
-        retColor.z = 1.0f;
-    else if (temperatureInKelvins <= 19.0f)
-        retColor.z = 0.0f;
-    else
-        retColor.z = clamp(0.54320678911019607843f * log(temperatureInKelvins - 10.0f) - 1.19625408914f, 0.0f, 1.0f);
-
-    return retColor;
-}
-
 // Generates an array of vertices and normals for a sphere
 void Sky::GenerateIcosahedron(float** ppPoints, VertexStbDsArray& vertices, IndexStbDsArray& indices, int numberOfDivisions, float radius)
 {
     UNREF_PARAM(radius);
     CreateIcosphere(numberOfDivisions, &vertices, &indices);
 
-    int numVertex = (int)arrlen(vertices);
+    uint32_t numVertex = (uint32_t)arrlen(vertices);
 
     float3* pPoints = (float3*)tf_malloc(numVertex * (sizeof(float3) * 3));
 
-    uint32_t vertexCounter = 0;
-
-    const float* position = vertices->pos;
-
-    float minVal = 10.0f;
-    float maxVal = -10.0f;
-
-    for (int i = 0; i < numVertex; ++i)
+    SpaceGeneratorDesc spaceDesc = {};
+    spaceDesc.mSeed = StarSeed;
+    spaceDesc.mSpaceScale = SpaceScale;
+    spaceDesc.mPlanetRadius = PLANET_RADIUS;
+    spaceDesc.mNebulaScale = NebulaScale;
+    spaceDesc.mStarDensity = StarDensity;
+    spaceDesc.mStarDistribution = StarDistribution;
+    spaceDesc.mStarIntensity = StarIntensity;
+    spaceDesc.mParticleSize = ParticleSize;
+
+    if (!loadSpaceCache(RD_PIPELINE_CACHE, pSpaceCacheName, &spaceDesc, numVertex, pPoints, &gParticleSystem.particleDataSet))
     {
-        vec3 tempPosition = vec3(position[i * 3], position[i * 3 + 1], position[i * 3 + 2]);
-        pPoints[vertexCounter] = v3ToF3(tempPosition) * SpaceScale;
-        pPoints[vertexCounter].setY(pPoints[vertexCounter].getY() - PLANET_RADIUS);
-        vertexCounter++;
-        vec3 normalizedPosition = normalize(tempPosition);
-        pPoints[vertexCounter++] = v3ToF3(normalizedPosition);
-
-        vec3 normalizedPosition01 = normalizedPosition + vec3(1.0f, 1.0f, 1.0f);
-        normalizedPosition01 *= 0.5f;        // normalized to [0,1]
-        normalizedPosition01 *= NebulaScale; // scale it
-
-        float NoiseValue01 =
-            noiseGenerator.perlinNoise3D(normalizedPosition01.getX(), normalizedPosition01.getY(), normalizedPosition01.getZ());
-
-        maxVal = max(maxVal, NoiseValue01);
-        minVal = min(minVal, NoiseValue01);
-
-        vec3 normalizedPosition02 =
-            vec3(normalizedPosition.getX(), -normalizedPosition.getY(), normalizedPosition.getZ()) + vec3(1.0f, 1.0f, 1.0f);
-        normalizedPosition02 *= 0.5f;        // normalized to [0,1]
-        normalizedPosition02 *= NebulaScale; // scale it
-
-        float NoiseValue02 =
-            noiseGenerator.perlinNoise3D(normalizedPosition02.getX(), normalizedPosition02.getY(), normalizedPosition02.getZ());
-
-        maxVal = max(maxVal, NoiseValue02);
-        minVal = min(minVal, NoiseValue02);
-
-        vec3 normalizedPosition03 =
-            vec3(-normalizedPosition.getX(), normalizedPosition.getY(), -normalizedPosition.getZ()) + vec3(1.0f, 1.0f, 1.0f);
-        normalizedPosition03 *= 0.5f;        // normalized to [0,1]
-        normalizedPosition03 *= NebulaScale; // scale it
-
-        float NoiseValue03 =
-            noiseGenerator.perlinNoise3D(normalizedPosition03.getX(), normalizedPosition03.getY(), normalizedPosition03.getZ());
-
-        maxVal = max(maxVal, NoiseValue03);
-        minVal = min(minVal, NoiseValue03);
-
-        pPoints[vertexCounter++] = float3(NoiseValue01, NoiseValue02, NoiseValue03);
-    }
-
-    float len = maxVal - minVal;
-
-    for (int i = 0; i < numVertex; ++i)
-    {
-        // Nebula Density
-        int index = i * 3 + 2;
-        pPoints[index] = (pPoints[index] - float3(minVal, minVal, minVal)) / len;
-
-        float Density = (pPoints[index].getX() + pPoints[index].getY() + pPoints[index].getZ()) / 3.0f;
-        Density = pow(Density, 1.5f);
-        int maxStar = (int)(StarDensity * Density);
-        for (int j = 0; j < maxStar; j++)
-        {
-            vec3 Positions = f3Tov3(pPoints[index - 1]) * SpaceScale;
-            Positions += (vec3((float)rand() / (float)RAND_MAX, (float)rand() / (float)RAND_MAX, (float)rand() / (float)RAND_MAX) * 2.0f -
-                          vec3(1.0f, 1.0f, 1.0f)) *
-                         StarDistribution;
-            Positions = normalize(Positions) * SpaceScale;
-            Positions.setY(Positions.getY() - PLANET_RADIUS);
-
-            float temperature = ((float)rand() / (float)RAND_MAX) * 30000.0f + 3700.0f;
-            vec3  StarColor = f3Tov3(ColorTemperatureToRGB(temperature));
-            vec4  Colors = vec4(StarColor, (((float)rand() / (float)RAND_MAX * 0.9f) + 0.1f) * StarIntensity);
-
-            float starSize = (((float)rand() / (float)RAND_MAX * 1.1f) + 0.5f);
-            starSize *= starSize;
-
-            vec4 Info = vec4(temperature, starSize * ParticleSize, (float)rand() / (float)RAND_MAX, (float)rand() / (float)RAND_MAX);
-
-            ParticleData tempParticleData;
-            tempParticleData.ParticlePositions = vec4(Positions, 1.0f);
-            tempParticleData.ParticleColors = Colors;
-            tempParticleData.ParticleInfo = Info;
-
-            arrpush(gParticleSystem.particleDataSet, tempParticleData);
-        }
+        generateSpace(&spaceDesc, vertices, numVertex, pPoints, &gParticleSystem.particleDataSet);
+        saveSpaceCache(RD_PIPELINE_CACHE, pSpaceCacheName, &spaceDesc, numVertex, pPoints, gParticleSystem.particleDataSet,
+                       (uint32_t)arrlenu(gParticleSystem.particleDataSet));
     }
 
     (*ppPoints) = (float*)pPoints;
@@ -1215,3 +1119,5 @@ Buffer* Sky::GetParticleVertexBuffer() { return gParticleSystem.pParticleVertexB
 Buffer* Sky::GetParticleInstanceBuffer() { return gParticleSystem.pParticleInstanceBuffer; }
 
 uint32_t Sky::GetParticleCount() { return (uint32_t)arrlen(gParticleSystem.particleDataSet); }
+
+const ParticleData* Sky::GetParticleData() { return gParticleSystem.particleDataSet; }
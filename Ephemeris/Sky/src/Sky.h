@@ -15,19 +15,9 @@
 #include "../../../../The-Forge/Common_3/Application/Interfaces/IProfiler.h"
 #include "../../../../The-Forge/Common_3/Graphics/Interfaces/IGraphics.h"
 
-#include "../../src/Perlin.h"
-
 #include "Icosahedron.h"
 #include "SkyCommon.h"
-
-typedef struct ParticleData
-{
-    vec4 ParticlePositions;
-    vec4 ParticleColors;
-    vec4 ParticleInfo; // x: temperature, y: particle size, z: blink time seed,
-} ParticleData;
-
-typedef ParticleData* ParticleStbDsArray;
+#include "SpaceGenerator.h"
 
 typedef struct ParticleSystem
 {
@@ -68,9 +58,10 @@ public:
     void   GenerateIcosahedron(float** ppPoints, VertexStbDsArray& vertices, IndexStbDsArray& indices, int numberOfDivisions,
                                float radius = 1.0f);
 
-    Buffer*  GetParticleVertexBuffer();
-    Buffer*  GetParticleInstanceBuffer();
-    uint32_t GetParticleCount();
+    Buffer*             GetParticleVertexBuffer();
+    Buffer*             GetParticleInstanceBuffer();
+    uint32_t            GetParticleCount();
+    const ParticleData* GetParticleData();
 
     uint gFrameIndex = 0;
 
@@ -105,8 +96,6 @@ public:
 
     Buffer* pTransmittanceBuffer = NULL;
 
-    Perlin noiseGenerator;
-
     ProfileToken gGpuProfileToken = {};
 
     ParticleSystem gParticleSystem = {};
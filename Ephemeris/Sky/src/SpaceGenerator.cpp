@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "SpaceGenerator.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
+
+#include "../../src/Noise.h"
+#include "../../src/ParallelFor.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
+
+#define SPACE_CACHE_MAGIC   0x43415053 // "SPAC"
+// Bump whenever generateSpace changes its output
+#define SPACE_CACHE_VERSION 1
+
+static const uint32_t SPACE_VERTICES_PER_TASK = 1024;
+
+struct SpaceCacheHeader
+{
+    uint32_t           magic;
+    uint32_t           version;
+    uint32_t           vertexCount;
+    uint32_t           starCount;
+    SpaceGeneratorDesc desc; // mThreadCount is always 0
+};
+
+struct SpaceGeneratorContext
+{
+    const SpaceGeneratorDesc* pDesc;
+    const VertexF3*           pVertices;
+    uint32_t                  vertexCount;
+    float3*                   pPoints;
+    NoiseFBM                  nebulaNoise;
+    // Three mirrored nebula lookups per vertex, lookup n of vertex i is at n * vertexCount + i
+    float*                    pNoiseX;
+    float*                    pNoiseY;
+    float*                    pNoiseZ;
+    float*                    pNoiseValues;
+    float                     minVal;
+    float                     maxVal;
+    // vertexCount + 1 entries, the stars of vertex i are [pStarOffsets[i], pStarOffsets[i + 1])
+    uint32_t*                 pStarOffsets;
+    ParticleData*             pStars;
+};
+
+// splitmix64, every vertex gets its own stream so the stars don't depend on how vertices are split across threads
+struct SpaceRandom
+{
+    uint64_t state;
+
+    SpaceRandom(uint32_t seed, uint32_t vertexIndex): state(((uint64_t)seed << 32) | vertexIndex) { next(); }
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1]
+    float nextFloat() { return (float)(next() >> 40) * (1.0f / 16777215.0f); }
+};
+
+float3 ColorTemperatureToRGB(float temperatureInKelvins)
+{
+    float3 retColor;
+
+    temperatureInKelvins = clamp(temperatureInKelvins, 1000.0f, 40000.0f) / 100.0f;
+
+    if (temperatureInKelvins <= 66.0f)
+    {
+        retColor.x = 1.0f;
+        retColor.y = clamp(0.39008157876901960784f * log(temperatureInKelvins) - 0.63184144378862745098f, 0.0f, 1.0f);
+    }
+    else
+    {
+        float t = temperatureInKelvins - 60.0f;
+        retColor.x = clamp(1.29293618606274509804f * pow(t, -0.1332047592f), 0.0f, 1.0f);
+        retColor.y = clamp(1.12989086089529411765f * pow(t, -0.0755148492f), 0.0f, 1.0f);
+    }
+
+    if (temperatureInKelvins > 66.0f)
+        retColor.z = 1.0f;
+    else if (temperatureInKelvins <= 19.0f)
+        retColor.z = 0.0f;
+    else
+        retColor.z = clamp(0.54320678911019607843f * log(temperatureInKelvins - 10.0f) - 1.19625408914f, 0.0f, 1.0f);
+
+    return retColor;
+}
+
+static void taskGenerateNebula(void* pUserData, uint32_t taskIndex)
+{
+    SpaceGeneratorContext*    pContext = (SpaceGeneratorContext*)pUserData;
+    const SpaceGeneratorDesc* pDesc = pContext->pDesc;
+    const uint32_t            vertexCount = pContext->vertexCount;
+    const uint32_t            begin = taskIndex * SPACE_VERTICES_PER_TASK;
+    const uint32_t            end = min(begin + SPACE_VERTICES_PER_TASK, vertexCount);
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        const float* position = pContext->pVertices[i].pos;
+        vec3         tempPosition = vec3(position[0], position[1], position[2]);
+        float3*      pVertexPoints = &pContext->pPoints[i * 3];
+        pVertexPoints[0] = v3ToF3(tempPosition) * pDesc->mSpaceScale;
+        pVertexPoints[0].setY(pVertexPoints[0].getY() - pDesc->mPlanetRadius);
+        vec3 normalizedPosition = normalize(tempPosition);
+        pVertexPoints[1] = v3ToF3(normalizedPosition);
+
+        const vec3 mirroredPositions[3] = {
+            normalizedPosition,
+            vec3(normalizedPosition.getX(), -normalizedPosition.getY(), normalizedPosition.getZ()),
+            vec3(-normalizedPosition.getX(), normalizedPosition.getY(), -normalizedPosition.getZ()),
+        };
+        for (uint32_t n = 0; n < 3; ++n)
+        {
+            vec3 noisePosition = mirroredPositions[n] + vec3(1.0f, 1.0f, 1.0f);
+            noisePosition *= 0.5f;                // normalized to [0,1]
+            noisePosition *= pDesc->mNebulaScale; // scale it
+
+            const uint32_t noiseIndex = n * vertexCount + i;
+            pContext->pNoiseX[noiseIndex] = noisePosition.getX();
+            pContext->pNoiseY[noiseIndex] = noisePosition.getY();
+            pContext->pNoiseZ[noiseIndex] = noisePosition.getZ();
+        }
+    }
+
+    for (uint32_t n = 0; n < 3; ++n)
+    {
+        const uint32_t first = n * vertexCount + begin;
+        evaluateNoiseFBM3D(&pContext->nebulaNoise, pContext->pNoiseX + first, pContext->pNoiseY + first, pContext->pNoiseZ + first,
+                           pContext->pNoiseValues + first, end - begin);
+    }
+}
+
+static void taskCountStars(void* pUserData, uint32_t taskIndex)
+{
+    SpaceGeneratorContext* pContext = (SpaceGeneratorContext*)pUserData;
+    const uint32_t         vertexCount = pContext->vertexCount;
+    const uint32_t         begin = taskIndex * SPACE_VERTICES_PER_TASK;
+    const uint32_t         end = min(begin + SPACE_VERTICES_PER_TASK, vertexCount);
+    const float            minVal = pContext->minVal;
+    const float            len = pContext->maxVal - minVal;
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        // Nebula Density
+        const float* pNoise = pContext->pNoiseValues;
+        const vec3   nebula = (vec3(pNoise[i], pNoise[vertexCount + i], pNoise[2 * vertexCount + i]) - vec3(minVal, minVal, minVal)) / len;
+        pContext->pPoints[i * 3 + 2] = v3ToF3(nebula);
+
+        float Density = (nebula.getX() + nebula.getY() + nebula.getZ()) / 3.0f;
+        Density = pow(Density, 1.5f);
+        // Turned into offsets once every vertex is counted
+        pContext->pStarOffsets[i + 1] = (uint32_t)(int)(pContext->pDesc->mStarDensity * Density);
+    }
+}
+
+static void taskGenerateStars(void* pUserData, uint32_t taskIndex)
+{
+    SpaceGeneratorContext*    pContext = (SpaceGeneratorContext*)pUserData;
+    const SpaceGeneratorDesc* pDesc = pContext->pDesc;
+    const uint32_t            begin = taskIndex * SPACE_VERTICES_PER_TASK;
+    const uint32_t            end = min(begin + SPACE_VERTICES_PER_TASK, pContext->vertexCount);
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        SpaceRandom    random(pDesc->mSeed, i);
+        const vec3     normal = f3Tov3(pContext->pPoints[i * 3 + 1]);
+        ParticleData*  pStar = pContext->pStars + pContext->pStarOffsets[i];
+        ParticleData*  pStarEnd = pContext->pStars + pContext->pStarOffsets[i + 1];
+        for (; pStar != pStarEnd; ++pStar)
+        {
+            const float rx = random.nextFloat();
+            const float ry = random.nextFloat();
+            const float rz = random.nextFloat();
+            vec3        Positions = normal * pDesc->mSpaceScale;
+            Positions += (vec3(rx, ry, rz) * 2.0f - vec3(1.0f, 1.0f, 1.0f)) * pDesc->mStarDistribution;
+            Positions = normalize(Positions) * pDesc->mSpaceScale;
+            Positions.setY(Positions.getY() - pDesc->mPlanetRadius);
+
+            float temperature = random.nextFloat() * 30000.0f + 3700.0f;
+            vec3  StarColor = f3Tov3(ColorTemperatureToRGB(temperature));
+            vec4  Colors = vec4(StarColor, ((random.nextFloat() * 0.9f) + 0.1f) * pDesc->mStarIntensity);
+
+            float starSize = ((random.nextFloat() * 1.1f) + 0.5f);
+            starSize *= starSize;
+
+            const float blinkSeed0 = random.nextFloat();
+            const float blinkSeed1 = random.nextFloat();
+            vec4        Info = vec4(temperature, starSize * pDesc->mParticleSize, blinkSeed0, blinkSeed1);
+
+            pStar->ParticlePositions = vec4(Positions, 1.0f);
+            pStar->ParticleColors = Colors;
+            pStar->ParticleInfo = Info;
+        }
+    }
+}
+
+void generateSpace(const SpaceGeneratorDesc* pDesc, const VertexF3* pVertices, uint32_t vertexCount, float3* pOutPoints,
+                   ParticleStbDsArray* pOutStars)
+{
+    SpaceGeneratorContext context = {};
+    context.pDesc = pDesc;
+    context.pVertices = pVertices;
+    context.vertexCount = vertexCount;
+    context.pPoints = pOutPoints;
+
+    // Same values as Perlin::perlinNoise3D
+    NoiseFBMDesc nebulaNoiseDesc;
+    getLegacyPerlinNoiseFBMDesc3D(&nebulaNoiseDesc);
+    initNoiseFBM(&nebulaNoiseDesc, &context.nebulaNoise);
+
+    const uint32_t noiseCount = vertexCount * 3;
+    context.pNoiseX = (float*)tf_malloc(noiseCount * 4 * sizeof(float));
+    context.pNoiseY = context.pNoiseX + noiseCount;
+    context.pNoiseZ = context.pNoiseY + noiseCount;
+    context.pNoiseValues = context.pNoiseZ + noiseCount;
+    context.pStarOffsets = (uint32_t*)tf_malloc((vertexCount + 1) * sizeof(uint32_t));
+
+    const uint32_t taskCount = (vertexCount + SPACE_VERTICES_PER_TASK - 1) / SPACE_VERTICES_PER_TASK;
+    parallelFor(taskGenerateNebula, &context, taskCount, pDesc->mThreadCount);
+
+    context.minVal = 10.0f;
+    context.maxVal = -10.0f;
+    for (uint32_t i = 0; i < noiseCount; ++i)
+    {
+        context.maxVal = max(context.maxVal, context.pNoiseValues[i]);
+        context.minVal = min(context.minVal, context.pNoiseValues[i]);
+    }
+
+    parallelFor(taskCountStars, &context, taskCount, pDesc->mThreadCount);
+
+    context.pStarOffsets[0] = 0;
+    for (uint32_t i = 0; i < vertexCount; ++i)
+        context.pStarOffsets[i + 1] += context.pStarOffsets[i];
+
+    // All stars are written in place, no reallocation while generating
+    const size_t firstStar = arrlenu(*pOutStars);
+    arrsetlen(*pOutStars, firstStar + context.pStarOffsets[vertexCount]);
+    context.pStars = *pOutStars + firstStar;
+
+    parallelFor(taskGenerateStars, &context, taskCount, pDesc->mThreadCount);
+
+    tf_free(context.pStarOffsets);
+    tf_free(context.pNoiseX);
+}
+
+static void getSpaceCacheHeader(const SpaceGeneratorDesc* pDesc, uint32_t vertexCount, uint32_t starCount, SpaceCacheHeader* pHeader)
+{
+    memset(pHeader, 0, sizeof(*pHeader));
+    pHeader->magic = SPACE_CACHE_MAGIC;
+    pHeader->version = SPACE_CACHE_VERSION;
+    pHeader->vertexCount = vertexCount;
+    pHeader->starCount = starCount;
+    pHeader->desc = *pDesc;
+    pHeader->desc.mThreadCount = 0;
+}
+
+bool loadSpaceCache(ResourceDirectory resourceDir, const char* fileName, const SpaceGeneratorDesc* pDesc, uint32_t vertexCount,
+                    float3* pOutPoints, ParticleStbDsArray* pOutStars)
+{
+    FileStream fh = {};
+    if (!fsOpenStreamFromPath(resourceDir, fileName, FM_READ, &fh))
+        return false;
+
+    SpaceCacheHeader header = {};
+    SpaceCacheHeader expected = {};
+    bool             valid = fsReadFromStream(&fh, &header, sizeof(header)) == sizeof(header);
+    getSpaceCacheHeader(pDesc, vertexCount, header.starCount, &expected);
+    valid = valid && memcmp(&header, &expected, sizeof(header)) == 0;
+
+    const size_t pointsSize = (size_t)vertexCount * 3 * sizeof(float3);
+    const size_t starsSize = (size_t)header.starCount * sizeof(ParticleData);
+    valid = valid && (size_t)fsGetStreamFileSize(&fh) == sizeof(header) + pointsSize + starsSize;
+    if (!valid)
+    {
+        LOGF(LogLevel::eINFO, "Space cache %s is out of date, regenerating nebula and stars", fileName);
+        fsCloseStream(&fh);
+        return false;
+    }
+
+    const size_t firstStar = arrlenu(*pOutStars);
+    arrsetlen(*pOutStars, firstStar + header.starCount);
+    valid = fsReadFromStream(&fh, pOutPoints, pointsSize) == pointsSize;
+    valid = valid && fsReadFromStream(&fh, *pOutStars + firstStar, starsSize) == starsSize;
+    fsCloseStream(&fh);
+
+    if (!valid)
+    {
+        LOGF(LogLevel::eWARNING, "Failed to read space cache %s", fileName);
+        arrsetlen(*pOutStars, firstStar);
+    }
+    return valid;
+}
+
+bool saveSpaceCache(ResourceDirectory resourceDir, const char* fileName, const SpaceGeneratorDesc* pDesc, uint32_t vertexCount,
+                    const float3* pPoints, const ParticleData* pStars, uint32_t starCount)
+{
+    FileStream fh = {};
+    if (!fsOpenStreamFromPath(resourceDir, fileName, FM_WRITE, &fh))
+    {
+        LOGF(LogLevel::eWARNING, "Failed to write space cache %s", fileName);
+        return false;
+    }
+
+    SpaceCacheHeader header;
+    getSpaceCacheHeader(pDesc, vertexCount, starCount, &header);
+
+    const size_t pointsSize = (size_t)vertexCount * 3 * sizeof(float3);
+    const size_t starsSize = (size_t)starCount * sizeof(ParticleData);
+    bool         written = fsWriteToStream(&fh, &header, sizeof(header)) == sizeof(header);
+    written = written && fsWriteToStream(&fh, pPoints, pointsSize) == pointsSize;
+    written = written && fsWriteToStream(&fh, pStars, starsSize) == starsSize;
+    fsCloseStream(&fh);
+
+    if (!written)
+        LOGF(LogLevel::eWARNING, "Failed to write space cache %s", fileName);
+    return written;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IFileSystem.h"
+#include "../../../../The-Forge/Common_3/Utilities/Math/MathTypes.h"
+
+#include "Icosahedron.h"
+
+typedef struct ParticleData
+{
+    vec4 ParticlePositions;
+    vec4 ParticleColors;
+    vec4 ParticleInfo; // x: temperature, y: particle size, z: blink time seed,
+} ParticleData;
+
+typedef ParticleData* ParticleStbDsArray;
+
+// Everything the nebula and the stars depend on. Identical descs generate identical data.
+struct SpaceGeneratorDesc
+{
+    uint32_t mSeed;
+    float    mSpaceScale;
+    float    mPlanetRadius;
+    float    mNebulaScale;
+    float    mStarDensity;
+    float    mStarDistribution;
+    float    mStarIntensity;
+    float    mParticleSize;
+    // 0 uses every CPU core, 1 generates on the calling thread. Doesn't change the output.
+    uint32_t mThreadCount;
+};
+
+// Writes position, normal and nebula density of every sphere vertex to pOutPoints (3 float3 per vertex)
+// and appends the stars to pOutStars. Stars of a vertex come from a random stream seeded by mSeed and the vertex index.
+void generateSpace(const SpaceGeneratorDesc* pDesc, const VertexF3* pVertices, uint32_t vertexCount, float3* pOutPoints,
+                   ParticleStbDsArray* pOutStars);
+
+// Cache of generateSpace results. Loading fails when the file was written for a different desc or vertex count.
+bool loadSpaceCache(ResourceDirectory resourceDir, const char* fileName, const SpaceGeneratorDesc* pDesc, uint32_t vertexCount,
+                    float3* pOutPoints, ParticleStbDsArray* pOutStars);
+bool saveSpaceCache(ResourceDirectory resourceDir, const char* fileName, const SpaceGeneratorDesc* pDesc, uint32_t vertexCount,
+                    const float3* pPoints, const ParticleData* pStars, uint32_t starCount);
+
+float3 ColorTemperatureToRGB(float temperatureInKelvins);
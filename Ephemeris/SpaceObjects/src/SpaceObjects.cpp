@@ -16,6 +16,8 @@
 
 #include "../../src/AppSettings.h"
 
+#include "StarField.h"
+
 #include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
 
 #define USING_MILKYWAY 0
@@ -53,6 +55,13 @@ uint32_t MilkyWayIndexCount = 0;
 
 Buffer* pStarUniformBuffer[SpaceObjects::gDataBufferCount] = { NULL };
 Buffer* pSunUniformBuffer[SpaceObjects::gDataBufferCount] = { NULL };
+// Visible stars of the frame, compacted from gStarField
+Buffer* pStarInstanceBuffer[SpaceObjects::gDataBufferCount] = { NULL };
+
+static StarField gStarField = {};
+static bool      gStarCulling = true;
+// Fraction of the brightest star's brightness below which stars are skipped
+static float     gStarMinBrightness = 0.0f;
 
 static float g_ElapsedTime = 0.0f;
 
@@ -416,6 +425,28 @@ bool SpaceObjects::Init(Renderer* const renderer, PipelineCache* pCache)
         addResource(&sunUniformDesc, &token);
     }
 
+    if (pStarData)
+    {
+        StarFieldDesc starFieldDesc = {};
+        starFieldDesc.pStars = pStarData;
+        starFieldDesc.mStarCount = StarDataCount;
+        starFieldDesc.mCenter = vec3(0.0f, -PLANET_RADIUS, 0.0f);
+        initStarField(&starFieldDesc, &gStarField);
+
+        BufferLoadDesc starInstanceDesc = {};
+        starInstanceDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
+        starInstanceDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+        starInstanceDesc.mDesc.mSize = (uint64_t)max(StarDataCount, 1u) * sizeof(ParticleData);
+        starInstanceDesc.mDesc.mFlags = BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT;
+        starInstanceDesc.pData = NULL;
+
+        for (uint i = 0; i < gDataBufferCount; i++)
+        {
+            starInstanceDesc.ppBuffer = &pStarInstanceBuffer[i];
+            addResource(&starInstanceDesc, &token);
+        }
+    }
+
     ///////////////////////////////////////////////////////////////////
     // UI
     ///////////////////////////////////////////////////////////////////
@@ -428,6 +459,17 @@ bool SpaceObjects::Init(Renderer* const renderer, PipelineCache* pCache)
     UIComponentDesc.mStartSize = vec2(300.0f / dpiScale[0], 250.0f / dpiScale[1]);
     uiCreateComponent("Space Objects", &UIComponentDesc, &pGuiWindow);
 
+    CheckboxWidget starCulling;
+    starCulling.pData = &gStarCulling;
+    luaRegisterWidget(uiCreateComponentWidget(pGuiWindow, "Cull Stars", &starCulling, WIDGET_TYPE_CHECKBOX));
+
+    SliderFloatWidget starMinBrightness;
+    starMinBrightness.pData = &gStarMinBrightness;
+    starMinBrightness.mMin = 0.0f;
+    starMinBrightness.mMax = 1.0f;
+    starMinBrightness.mStep = 0.001f;
+    luaRegisterWidget(uiCreateComponentWidget(pGuiWindow, "Star LOD Brightness", &starMinBrightness, WIDGET_TYPE_SLIDER_FLOAT));
+
     waitForToken(&token);
 
     return true;
@@ -463,7 +505,11 @@ void SpaceObjects::Exit()
     {
         removeResource(pSunUniformBuffer[i]);
         removeResource(pStarUniformBuffer[i]);
+        if (pStarInstanceBuffer[i])
+            removeResource(pStarInstanceBuffer[i]);
+        pStarInstanceBuffer[i] = NULL;
     }
+    exitStarField(&gStarField);
     removeResource(pMoonTexture);
 
     removeResource(pGlobalTriangularVertexBuffer);
@@ -618,13 +664,31 @@ void SpaceObjects::Draw(Cmd* cmd)
         cmdBindDescriptorSet(cmd, 0, pStarDescriptorSet[0]);
         cmdBindDescriptorSet(cmd, gFrameIndex, pStarDescriptorSet[1]);
 
+        Buffer*  pInstanceBuffer = pParticleInstanceBuffer;
+        uint32_t instanceCount = ParticleCount;
 #if !defined(ORBIS)
+        // ORBIS reads the stars through starInstanceBuffer of the static descriptor set, it always draws all of them
+        if (gStarCulling && pStarInstanceBuffer[gFrameIndex])
+        {
+            StarFieldCullDesc cullDesc = {};
+            cullDesc.mRotMat = starData.RotMat;
+            cullDesc.mViewProjMat = starData.ViewProjMat;
+            cullDesc.mMinBrightness = gStarMinBrightness;
+
+            BufferUpdateDesc starInstanceUpdateDesc = { pStarInstanceBuffer[gFrameIndex] };
+            beginUpdateResource(&starInstanceUpdateDesc);
+            instanceCount = cullStarField(&gStarField, &cullDesc, (ParticleData*)starInstanceUpdateDesc.pMappedData);
+            endUpdateResource(&starInstanceUpdateDesc);
+            pInstanceBuffer = pStarInstanceBuffer[gFrameIndex];
+        }
+
         const uint32_t strides[] = { ParticleInstanceStride };
-        Buffer*        particleVertexBuffers[] = { pParticleInstanceBuffer };
+        Buffer*        particleVertexBuffers[] = { pInstanceBuffer };
         cmdBindVertexBuffer(cmd, 1, particleVertexBuffers, strides, NULL);
 #endif
 
-        cmdDrawInstanced(cmd, 4, 0, ParticleCount, 0);
+        if (instanceCount)
+            cmdDrawInstanced(cmd, 4, 0, instanceCount, 0);
 
         cmdEndGpuTimestampQuery(cmd, gGpuProfileToken);
     }
@@ -1122,3 +1186,9 @@ void SpaceObjects::InitializeWithLoad(RenderTarget* InDepthRenderTarget, RenderT
     ParticleVertexStride = ParticleVertexStrideParam;
     ParticleInstanceStride = ParticleInstanceStrideParam;
 }
+
+void SpaceObjects::InitializeStarField(const ParticleData* pStars, uint32_t starCount)
+{
+    pStarData = pStars;
+    StarDataCount = starCount;
+}
@@ -20,6 +20,8 @@
 #include "../../../../The-Forge/Common_3/Application/Interfaces/IUI.h"
 #include "../../../../The-Forge/Common_3/Graphics/Interfaces/IGraphics.h"
 
+struct ParticleData;
+
 class SpaceObjects: public IMiddleware
 {
 public:
@@ -45,6 +47,8 @@ public:
     void InitializeWithLoad(RenderTarget* InDepthRenderTarget, RenderTarget* InLinearDepthRenderTarget, Texture* SavePrevTexture,
                             Buffer* ParticleVertexBuffer, Buffer* ParticleInstanceBuffer, uint32_t ParticleCountParam,
                             uint32_t ParticleVertexStride, uint32_t ParticleInstanceStride);
+    // CPU copy of the stars in ParticleInstanceBuffer. Set before Init to cull the starfield every frame, it has to outlive Init.
+    void InitializeStarField(const ParticleData* pStars, uint32_t starCount);
     bool Load(int32_t width, int32_t height);
 
     // void GenerateRing(eastl::vector<float> &vertices, eastl::vector<uint32_t> &indices, uint32_t WidthDividor, uint32_t HeightDividor,
@@ -88,6 +92,9 @@ public:
     uint32_t ParticleVertexStride = 0;
     uint32_t ParticleInstanceStride = 0;
 
+    const ParticleData* pStarData = NULL;
+    uint32_t            StarDataCount = 0;
+
     mat4 SpaceProjectionMatrix;
 
     float  Azimuth = 0.0f;
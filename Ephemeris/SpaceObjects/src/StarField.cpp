@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "StarField.h"
+
+#include "../../src/ParallelFor.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
+
+static const uint32_t STAR_FIELD_DEFAULT_BIN_RESOLUTION = 16;
+static const uint32_t STARS_PER_TASK = 16384;
+static const uint32_t BINS_PER_TASK = 64;
+// A star quad is offset by up to its size along the camera right and up vectors
+static const float    STAR_QUAD_EXTENT = 1.41421356f;
+
+struct StarSortKey
+{
+    float    brightness;
+    uint32_t index;
+};
+
+struct StarFieldContext
+{
+    const StarFieldDesc* pDesc;
+    StarField*           pField;
+    uint32_t             binResolution;
+    uint32_t*            pStarBins;
+    StarSortKey*         pSortKeys;
+};
+
+static uint32_t getStarBin(const vec3& direction, uint32_t resolution)
+{
+    const float x = direction.getX();
+    const float y = direction.getY();
+    const float z = direction.getZ();
+    const float ax = fabsf(x);
+    const float ay = fabsf(y);
+    const float az = fabsf(z);
+
+    uint32_t face;
+    float    u, v, majorAxis;
+    if (ax >= ay && ax >= az)
+    {
+        face = x >= 0.0f ? 0 : 1;
+        majorAxis = ax;
+        u = z;
+        v = y;
+    }
+    else if (ay >= az)
+    {
+        face = y >= 0.0f ? 2 : 3;
+        majorAxis = ay;
+        u = x;
+        v = z;
+    }
+    else
+    {
+        face = z >= 0.0f ? 4 : 5;
+        majorAxis = az;
+        u = x;
+        v = y;
+    }
+
+    if (majorAxis <= 0.0f)
+        return 0;
+
+    const uint32_t cellU = min((uint32_t)((u / majorAxis * 0.5f + 0.5f) * (float)resolution), resolution - 1);
+    const uint32_t cellV = min((uint32_t)((v / majorAxis * 0.5f + 0.5f) * (float)resolution), resolution - 1);
+    return (face * resolution + cellV) * resolution + cellU;
+}
+
+static void taskBinStars(void* pUserData, uint32_t taskIndex)
+{
+    StarFieldContext*    pContext = (StarFieldContext*)pUserData;
+    const StarFieldDesc* pDesc = pContext->pDesc;
+    const uint32_t       begin = taskIndex * STARS_PER_TASK;
+    const uint32_t       end = min(begin + STARS_PER_TASK, pDesc->mStarCount);
+
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        const vec3 direction = pDesc->pStars[i].ParticlePositions.getXYZ() - pDesc->mCenter;
+        pContext->pStarBins[i] = getStarBin(direction, pContext->binResolution);
+    }
+}
+
+// Brightest first, stars of the same brightness keep their generation order so the output doesn't depend on the sort
+static int compareStarSortKeys(const void* pLeft, const void* pRight)
+{
+    const StarSortKey* pA = (const StarSortKey*)pLeft;
+    const StarSortKey* pB = (const StarSortKey*)pRight;
+    if (pA->brightness != pB->brightness)
+        return pA->brightness > pB->brightness ? -1 : 1;
+    return pA->index < pB->index ? -1 : (pA->index > pB->index ? 1 : 0);
+}
+
+static void taskSortBins(void* pUserData, uint32_t taskIndex)
+{
+    StarFieldContext*    pContext = (StarFieldContext*)pUserData;
+    const StarFieldDesc* pDesc = pContext->pDesc;
+    StarField*           pField = pContext->pField;
+    const uint32_t       begin = taskIndex * BINS_PER_TASK;
+    const uint32_t       end = min(begin + BINS_PER_TASK, pField->mBinCount);
+
+    for (uint32_t bin = begin; bin < end; ++bin)
+    {
+        const uint32_t first = pField->pBinOffsets[bin];
+        const uint32_t count = pField->pBinOffsets[bin + 1] - first;
+        if (!count)
+        {
+            pField->pBinBounds[bin] = vec4(0.0f, 0.0f, 0.0f, -1.0f);
+            continue;
+        }
+
+        StarSortKey* pKeys = pContext->pSortKeys + first;
+        qsort(pKeys, count, sizeof(StarSortKey), compareStarSortKeys);
+
+        vec3 boundsMin = pDesc->pStars[pKeys[0].index].ParticlePositions.getXYZ();
+        vec3 boundsMax = boundsMin;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const ParticleData* pStar = &pDesc->pStars[pKeys[i].index];
+            pField->pStars[first + i] = *pStar;
+            pField->pBrightness[first + i] = pKeys[i].brightness;
+            boundsMin = minPerElem(boundsMin, pStar->ParticlePositions.getXYZ());
+            boundsMax = maxPerElem(boundsMax, pStar->ParticlePositions.getXYZ());
+        }
+
+        const vec3 center = (boundsMin + boundsMax) * 0.5f;
+        float      radius = 0.0f;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const ParticleData* pStar = &pField->pStars[first + i];
+            radius = fmaxf(radius, length(pStar->ParticlePositions.getXYZ() - center) + pStar->ParticleInfo.getY() * STAR_QUAD_EXTENT);
+        }
+        // Keeps whole bins conservative against the rounding of the per star test
+        pField->pBinBounds[bin] = vec4(center, radius * 1.0001f + 1.0f);
+    }
+}
+
+void initStarField(const StarFieldDesc* pDesc, StarField* pOutField)
+{
+    const uint32_t binResolution = pDesc->mBinResolution ? pDesc->mBinResolution : STAR_FIELD_DEFAULT_BIN_RESOLUTION;
+    const uint32_t starCount = pDesc->mStarCount;
+
+    *pOutField = {};
+    pOutField->mStarCount = starCount;
+    pOutField->mBinCount = 6 * binResolution * binResolution;
+    pOutField->pStars = (ParticleData*)tf_malloc(max(starCount, 1u) * sizeof(ParticleData));
+    pOutField->pBrightness = (float*)tf_malloc(max(starCount, 1u) * sizeof(float));
+    pOutField->pBinOffsets = (uint32_t*)tf_calloc(pOutField->mBinCount + 1, sizeof(uint32_t));
+    pOutField->pBinBounds = (vec4*)tf_malloc(pOutField->mBinCount * sizeof(vec4));
+
+    StarFieldContext context = {};
+    context.pDesc = pDesc;
+    context.pField = pOutField;
+    context.binResolution = binResolution;
+    context.pStarBins = (uint32_t*)tf_malloc(max(starCount, 1u) * sizeof(uint32_t));
+    context.pSortKeys = (StarSortKey*)tf_malloc(max(starCount, 1u) * sizeof(StarSortKey));
+
+    parallelFor(taskBinStars, &context, (starCount + STARS_PER_TASK - 1) / STARS_PER_TASK, pDesc->mThreadCount);
+
+    // Counting sort into the bins, stars of a bin stay in generation order until the bins are sorted by brightness
+    for (uint32_t i = 0; i < starCount; ++i)
+    {
+        ++pOutField->pBinOffsets[context.pStarBins[i] + 1];
+        pOutField->mMaxBrightness = fmaxf(pOutField->mMaxBrightness, getStarBrightness(&pDesc->pStars[i]));
+    }
+    for (uint32_t bin = 0; bin < pOutField->mBinCount; ++bin)
+        pOutField->pBinOffsets[bin + 1] += pOutField->pBinOffsets[bin];
+
+    uint32_t* pBinCursors = (uint32_t*)tf_malloc(pOutField->mBinCount * sizeof(uint32_t));
+    memcpy(pBinCursors, pOutField->pBinOffsets, pOutField->mBinCount * sizeof(uint32_t));
+    for (uint32_t i = 0; i < starCount; ++i)
+    {
+        StarSortKey* pKey = &context.pSortKeys[pBinCursors[context.pStarBins[i]]++];
+        pKey->brightness = getStarBrightness(&pDesc->pStars[i]);
+        pKey->index = i;
+    }
+    tf_free(pBinCursors);
+
+    parallelFor(taskSortBins, &context, (pOutField->mBinCount + BINS_PER_TASK - 1) / BINS_PER_TASK, pDesc->mThreadCount);
+
+    tf_free(context.pSortKeys);
+    tf_free(context.pStarBins);
+}
+
+void exitStarField(StarField* pField)
+{
+    tf_free(pField->pStars);
+    tf_free(pField->pBrightness);
+    tf_free(pField->pBinOffsets);
+    tf_free(pField->pBinBounds);
+    *pField = {};
+}
+
+void getStarFieldFrustum(const StarFieldCullDesc* pDesc, StarFieldFrustum* pOutFrustum)
+{
+    // Planes of the combined matrix are in star space. RotMat is rigid, so distances to them are the same as in world space.
+    const mat4 starToClip = pDesc->mViewProjMat * pDesc->mRotMat;
+    const vec4 rowX = starToClip.getRow(0);
+    const vec4 rowY = starToClip.getRow(1);
+    const vec4 rowW = starToClip.getRow(3);
+
+    pOutFrustum->mPlanes[0] = rowW + rowX;
+    pOutFrustum->mPlanes[1] = rowW - rowX;
+    pOutFrustum->mPlanes[2] = rowW + rowY;
+    pOutFrustum->mPlanes[3] = rowW - rowY;
+    for (uint32_t i = 0; i < 4; ++i)
+        pOutFrustum->mPlanes[i] /= length(pOutFrustum->mPlanes[i].getXYZ());
+}
+
+static inline float getPlaneDistance(const vec4& plane, const vec3& point) { return dot(plane.getXYZ(), point) + plane.getW(); }
+
+bool isStarInFrustum(const StarFieldFrustum* pFrustum, const ParticleData* pStar)
+{
+    const vec3  position = pStar->ParticlePositions.getXYZ();
+    const float radius = pStar->ParticleInfo.getY() * STAR_QUAD_EXTENT;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        if (getPlaneDistance(pFrustum->mPlanes[i], position) < -radius)
+            return false;
+    }
+    return true;
+}
+
+uint32_t cullStarField(const StarField* pField, const StarFieldCullDesc* pDesc, ParticleData* pOutStars)
+{
+    StarFieldFrustum frustum;
+    getStarFieldFrustum(pDesc, &frustum);
+
+    const float minBrightness = pDesc->mMinBrightness * pField->mMaxBrightness;
+    uint32_t    visibleCount = 0;
+    for (uint32_t bin = 0; bin < pField->mBinCount; ++bin)
+    {
+        const uint32_t first = pField->pBinOffsets[bin];
+        uint32_t       last = pField->pBinOffsets[bin + 1];
+
+        // Stars are sorted brightest first, find the first one below the cutoff
+        uint32_t low = first;
+        while (low < last)
+        {
+            const uint32_t middle = low + (last - low) / 2;
+            if (pField->pBrightness[middle] >= minBrightness)
+                low = middle + 1;
+            else
+                last = middle;
+        }
+        if (first == last)
+            continue;
+
+        const vec4& bounds = pField->pBinBounds[bin];
+        bool        inside = true;
+        bool        outside = false;
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const float distance = getPlaneDistance(frustum.mPlanes[i], bounds.getXYZ());
+            outside = outside || distance < -bounds.getW();
+            inside = inside && distance >= bounds.getW();
+        }
+        if (outside)
+            continue;
+
+        if (inside)
+        {
+            memcpy(pOutStars + visibleCount, pField->pStars + first, (last - first) * sizeof(ParticleData));
+            visibleCount += last - first;
+            continue;
+        }
+
+        for (uint32_t i = first; i < last; ++i)
+        {
+            if (isStarInFrustum(&frustum, &pField->pStars[i]))
+                pOutStars[visibleCount++] = pField->pStars[i];
+        }
+    }
+
+    return visibleCount;
+}
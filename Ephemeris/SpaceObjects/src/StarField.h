@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include "../../Sky/src/SpaceGenerator.h"
+
+// Stars binned by their direction on a cube map around the star sphere, so the starfield can be culled bin by bin every frame.
+// Inside a bin the stars are sorted from brightest to dimmest, a brightness cutoff keeps a prefix of every bin.
+struct StarField
+{
+    // Stars reordered by bin
+    ParticleData* pStars;
+    // Brightness of every star in pStars, see getStarBrightness
+    float*        pBrightness;
+    // mBinCount + 1 entries, the stars of bin i are [pBinOffsets[i], pBinOffsets[i + 1])
+    uint32_t*     pBinOffsets;
+    // Bounding sphere of every bin including the star sizes, center in xyz and radius in w
+    vec4*         pBinBounds;
+    uint32_t      mStarCount;
+    uint32_t      mBinCount;
+    float         mMaxBrightness;
+};
+
+struct StarFieldDesc
+{
+    const ParticleData* pStars;
+    uint32_t            mStarCount;
+    // Center of the star sphere, stars are binned by their direction from it
+    vec3                mCenter;
+    // Bins along the edge of every cube face, 0 uses 16
+    uint32_t            mBinResolution;
+    // 0 uses every CPU core, 1 builds on the calling thread. Doesn't change the output.
+    uint32_t            mThreadCount;
+};
+
+struct StarFieldCullDesc
+{
+    // RotMat and ViewProjMat of the StarUniform in Star.vert
+    mat4  mRotMat;
+    mat4  mViewProjMat;
+    // Stars with a brightness below mMinBrightness * StarField::mMaxBrightness are dropped, 0 keeps all of them
+    float mMinBrightness;
+};
+
+// Side planes of the view frustum in the space of ParticleData::ParticlePositions, normalized.
+// Near and far are left out, the star sphere lies between SPACE_NEAR and SPACE_FAR.
+struct StarFieldFrustum
+{
+    vec4 mPlanes[4];
+};
+
+void initStarField(const StarFieldDesc* pDesc, StarField* pOutField);
+void exitStarField(StarField* pField);
+
+// Intensity times size of the star quad
+static inline float getStarBrightness(const ParticleData* pStar) { return pStar->ParticleColors.getW() * pStar->ParticleInfo.getY(); }
+
+void getStarFieldFrustum(const StarFieldCullDesc* pDesc, StarFieldFrustum* pOutFrustum);
+// True when the quad of the star can touch the frustum, the same test cullStarField runs on every star of a partially visible bin
+bool isStarInFrustum(const StarFieldFrustum* pFrustum, const ParticleData* pStar);
+
+// Writes the visible stars that pass the brightness cutoff to pOutStars, which has room for mStarCount stars, and returns their count
+uint32_t cullStarField(const StarField* pField, const StarFieldCullDesc* pDesc, ParticleData* pOutStars);
@@ -15,9 +15,34 @@
 #include "../../../../The-Forge/Common_3/Utilities/Interfaces/IFileSystem.h"
 #include "../../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
 
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define PREFETCH_READ(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#elif defined(__GNUC__) || defined(__clang__)
+#define PREFETCH_READ(p) __builtin_prefetch(p)
+#else
+#define PREFETCH_READ(p)
+#endif
+
+HeightData::HeightData(const char* fileName, HeightDataFormat format):
+    colCount(0), rowCount(0), colOffset(1356), rowOffset(924), levels(0), patchSize(128), data(nullptr), tiledStream(), tiles(nullptr),
+    tilesCopy(nullptr), tileShift(0), tileMask(0), tileColCount(0)
+{
+    if (format == HEIGHT_DATA_TILED)
+        loadTiled(fileName);
+    else
+        loadRaw(fileName);
+
+    if (!isLoaded())
+        return;
+
+    levels = 1;
+    while ((patchSize << (levels - 1)) < (int)colCount || (patchSize << (levels - 1)) < (int)rowCount)
+        levels++;
+}
+
 // Creates data source from the specified raw data file
-HeightData::HeightData(const char* fileName):
-    colCount(0), rowCount(0), colOffset(1356), rowOffset(924), levels(0), patchSize(128), data(nullptr)
+void HeightData::loadRaw(const char* fileName)
 {
     // open file
     FileStream modelFile0FH = {};
@@ -56,10 +81,6 @@ HeightData::HeightData(const char* fileName):
         rowCount *= 2;
     }
 
-    levels = 1;
-    while ((patchSize << (levels - 1)) < (int)colCount || (patchSize << (levels - 1)) < (int)rowCount)
-        levels++;
-
     colCount++;
     rowCount++;
 
@@ -82,7 +103,125 @@ HeightData::HeightData(const char* fileName):
     tf_free(heightMap);
 }
 
-HeightData::~HeightData(void) { tf_free(data); }
+void HeightData::loadTiled(const char* fileName)
+{
+    if (!fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ, &tiledStream))
+    {
+        LOGF(LogLevel::eINFO, "Tiled height map not found: %s\n", fileName);
+        return;
+    }
+
+    TiledHeightDataHeader header = {};
+    const size_t          fileSize = (size_t)fsGetStreamFileSize(&tiledStream);
+    bool                  valid = fileSize >= sizeof(header) && fsReadFromStream(&tiledStream, &header, sizeof(header)) == sizeof(header);
+    valid = valid && header.magic == TILED_HEIGHT_DATA_MAGIC && header.version == TILED_HEIGHT_DATA_VERSION;
+    valid = valid && header.tileSize && !(header.tileSize & (header.tileSize - 1));
+    valid = valid && header.tileColCount * header.tileSize >= header.colCount && header.tileRowCount * header.tileSize >= header.rowCount;
+
+    const size_t tileDataSize = (size_t)header.tileColCount * header.tileRowCount * header.tileSize * header.tileSize * sizeof(float);
+    valid = valid && fileSize >= sizeof(header) + tileDataSize;
+    if (!valid)
+    {
+        LOGF(LogLevel::eERROR, "Invalid tiled height map: %s\n", fileName);
+        fsCloseStream(&tiledStream);
+        return;
+    }
+
+    // The mapping stays valid while the stream is open, pages are faulted in as tiles get sampled
+    size_t      mappedSize = 0;
+    const void* pMapped = NULL;
+    if (fsStreamMemoryMap(&tiledStream, &mappedSize, &pMapped) && pMapped && mappedSize >= sizeof(header) + tileDataSize)
+    {
+        tiles = (const float*)((const uint8_t*)pMapped + sizeof(header));
+    }
+    else
+    {
+        // Streams that can't be mapped (e.g. inside archives) are read up front
+        tilesCopy = tf_malloc(tileDataSize);
+        if (fsReadFromStream(&tiledStream, tilesCopy, tileDataSize) != tileDataSize)
+        {
+            LOGF(LogLevel::eERROR, "Failed to read tiled height map: %s\n", fileName);
+            tf_free(tilesCopy);
+            tilesCopy = nullptr;
+            fsCloseStream(&tiledStream);
+            return;
+        }
+        fsCloseStream(&tiledStream);
+        tiles = (const float*)tilesCopy;
+    }
+
+    colCount = header.colCount;
+    rowCount = header.rowCount;
+    tileColCount = header.tileColCount;
+    tileMask = header.tileSize - 1;
+    tileShift = 0;
+    while ((1u << tileShift) < header.tileSize)
+        ++tileShift;
+}
+
+HeightData::~HeightData(void)
+{
+    tf_free(data);
+
+    if (tilesCopy)
+        tf_free(tilesCopy);
+    else if (tiles)
+        fsCloseStream(&tiledStream);
+}
+
+bool HeightData::saveTiled(ResourceDirectory resourceDir, const char* fileName, uint32_t tileSize) const
+{
+    if (!isLoaded() || !tileSize || (tileSize & (tileSize - 1)))
+        return false;
+
+    FileStream fh = {};
+    if (!fsOpenStreamFromPath(resourceDir, fileName, FM_WRITE, &fh))
+    {
+        LOGF(LogLevel::eERROR, "Could not create tiled height map: %s\n", fileName);
+        return false;
+    }
+
+    TiledHeightDataHeader header = {};
+    header.magic = TILED_HEIGHT_DATA_MAGIC;
+    header.version = TILED_HEIGHT_DATA_VERSION;
+    header.colCount = colCount;
+    header.rowCount = rowCount;
+    header.tileSize = tileSize;
+    header.tileColCount = (colCount + tileSize - 1) / tileSize;
+    header.tileRowCount = (rowCount + tileSize - 1) / tileSize;
+
+    bool   success = fsWriteToStream(&fh, &header, sizeof(header)) == sizeof(header);
+    float* tile = (float*)tf_malloc(sizeof(float) * tileSize * tileSize);
+    for (uint32_t tileRow = 0; success && tileRow < header.tileRowCount; ++tileRow)
+    {
+        for (uint32_t tileCol = 0; success && tileCol < header.tileColCount; ++tileCol)
+        {
+            for (uint32_t r = 0; r < tileSize; ++r)
+            {
+                for (uint32_t c = 0; c < tileSize; ++c)
+                {
+                    const uint32_t col = tileCol * tileSize + c;
+                    const uint32_t row = tileRow * tileSize + r;
+                    tile[c + r * tileSize] = (col < colCount && row < rowCount) ? *getSampleAddress(col, row) : 0.0f;
+                }
+            }
+            const size_t tileBytes = sizeof(float) * tileSize * tileSize;
+            success = fsWriteToStream(&fh, tile, tileBytes) == tileBytes;
+        }
+    }
+    tf_free(tile);
+    fsCloseStream(&fh);
+
+    if (!success)
+        LOGF(LogLevel::eERROR, "Failed to write tiled height map: %s\n", fileName);
+    return success;
+}
+
+bool HeightData::convertToTiled(const char* rawFileName, ResourceDirectory resourceDir, const char* tiledFileName, uint32_t tileSize)
+{
+    HeightData rawData(rawFileName, HEIGHT_DATA_RAW);
+    return rawData.saveTiled(resourceDir, tiledFileName, tileSize);
+}
 
 int mirrorCoord(int coord, int dim)
 {
@@ -96,11 +235,11 @@ int mirrorCoord(int coord, int dim)
     return coord;
 }
 
-float HeightData::getInterpolatedHeight(float col, float row, int step) const
+void HeightData::getHeightTaps(float col, float row, int step, HeightTaps* pTaps) const
 {
-    int    row0 = ((int)floorf(row) / step) * step;
-    int    col0 = ((int)floorf(col) / step) * step;
-    float2 weights = float2((col - (float)col0) / (float)step, (row - (float)row0) / (float)step);
+    int row0 = ((int)floorf(row) / step) * step;
+    int col0 = ((int)floorf(col) / step) * step;
+    pTaps->weights = float2((col - (float)col0) / (float)step, (row - (float)row0) / (float)step);
     col0 += colOffset;
     row0 += rowOffset;
 
@@ -112,13 +251,49 @@ float HeightData::getInterpolatedHeight(float col, float row, int step) const
     row0 = mirrorCoord(row0, rowCount);
     row1 = mirrorCoord(row1, rowCount);
 
-    float H00 = data[col0 + row0 * colCount];
-    float H10 = data[col1 + row0 * colCount];
-    float H01 = data[col0 + row1 * colCount];
-    float H11 = data[col1 + row1 * colCount];
+    pTaps->H00 = getSampleAddress(col0, row0);
+    pTaps->H10 = getSampleAddress(col1, row0);
+    pTaps->H01 = getSampleAddress(col0, row1);
+    pTaps->H11 = getSampleAddress(col1, row1);
+}
+
+static inline float interpolateHeight(const HeightData::HeightTaps& taps)
+{
+    const float2& weights = taps.weights;
     // float interpolatedHeight = (H00 * (1 - weights.mX) + H10 * weights.mX) * (1 - weights.mY) +    (H01 * (1 - weights.mX) + H11 *
     // weights.mX) * weights.mY;
-    float interpolatedHeight =
-        (H00 * (1 - weights.x) + H10 * weights.x) * (1 - weights.y) + (H01 * (1 - weights.x) + H11 * weights.x) * weights.y;
+    float interpolatedHeight = (*taps.H00 * (1 - weights.x) + *taps.H10 * weights.x) * (1 - weights.y) +
+                               (*taps.H01 * (1 - weights.x) + *taps.H11 * weights.x) * weights.y;
     return interpolatedHeight;
 }
+
+float HeightData::getInterpolatedHeight(float col, float row, int step) const
+{
+    HeightTaps taps;
+    getHeightTaps(col, row, step, &taps);
+    return interpolateHeight(taps);
+}
+
+void HeightData::getInterpolatedHeights(const float2* pCoords, float* pOutHeights, uint32_t count, int step) const
+{
+    static const uint32_t BATCH_SIZE = 32;
+    HeightTaps            taps[BATCH_SIZE];
+
+    for (uint32_t batchStart = 0; batchStart < count; batchStart += BATCH_SIZE)
+    {
+        const uint32_t batchCount = min(BATCH_SIZE, count - batchStart);
+
+        // Resolve and prefetch the whole batch first so the loads of different samples overlap
+        for (uint32_t i = 0; i < batchCount; ++i)
+        {
+            getHeightTaps(pCoords[batchStart + i].x, pCoords[batchStart + i].y, step, &taps[i]);
+            PREFETCH_READ(taps[i].H00);
+            PREFETCH_READ(taps[i].H10);
+            PREFETCH_READ(taps[i].H01);
+            PREFETCH_READ(taps[i].H11);
+        }
+
+        for (uint32_t i = 0; i < batchCount; ++i)
+            pOutHeights[batchStart + i] = interpolateHeight(taps[i]);
+    }
+}
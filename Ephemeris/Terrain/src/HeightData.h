@@ -10,22 +10,93 @@
 
 #pragma once
 
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IFileSystem.h"
 #include "../../../../The-Forge/Common_3/Utilities/Math/MathTypes.h"
 
+// Tiled height map file: this header followed by tileColCount * tileRowCount tiles of tileSize * tileSize floats.
+// Tiles are stored row by row, samples inside a tile too. The grid is already padded to 2^n+1 samples,
+// tiles on the right and bottom edge are padded with zeros.
+struct TiledHeightDataHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t colCount;
+    uint32_t rowCount;
+    uint32_t tileSize;
+    uint32_t tileColCount;
+    uint32_t tileRowCount;
+    uint32_t reserved;
+};
+
+static const uint32_t TILED_HEIGHT_DATA_MAGIC = 0x31544448; // "HDT1"
+static const uint32_t TILED_HEIGHT_DATA_VERSION = 1;
+static const uint32_t TILED_HEIGHT_DATA_DEFAULT_TILE_SIZE = 64;
+
+enum HeightDataFormat
+{
+    // Square raw float heights, loaded and padded in memory
+    HEIGHT_DATA_RAW = 0,
+    // TiledHeightDataHeader file, memory-mapped so tiles are only paged in once they are sampled
+    HEIGHT_DATA_TILED,
+};
+
 class HeightData
 {
 public:
-    HeightData(const char* fileName);
+    HeightData(const char* fileName, HeightDataFormat format = HEIGHT_DATA_RAW);
     virtual ~HeightData(void);
 
+    bool isLoaded() const { return data != nullptr || tiles != nullptr; }
+
     float getInterpolatedHeight(float col, float row, int step = 1) const;
+    // Same results as getInterpolatedHeight for every coordinate. Samples are gathered in batches
+    // whose cache lines are prefetched before they are interpolated.
+    void  getInterpolatedHeights(const float2* pCoords, float* pOutHeights, uint32_t count, int step = 1) const;
+
+    // Writes the padded grid as a tiled height map. tileSize has to be a power of two.
+    bool saveTiled(ResourceDirectory resourceDir, const char* fileName, uint32_t tileSize = TILED_HEIGHT_DATA_DEFAULT_TILE_SIZE) const;
+    // Converts a raw height map from RD_TEXTURES into a tiled one
+    static bool convertToTiled(const char* rawFileName, ResourceDirectory resourceDir, const char* tiledFileName,
+                               uint32_t tileSize = TILED_HEIGHT_DATA_DEFAULT_TILE_SIZE);
 
     unsigned int colCount, rowCount;
     int          colOffset, rowOffset;
 
+    // The four samples around a coordinate and the bilinear weights between them
+    struct HeightTaps
+    {
+        const float* H00;
+        const float* H10;
+        const float* H01;
+        const float* H11;
+        float2       weights;
+    };
+
 private:
+    void loadRaw(const char* fileName);
+    void loadTiled(const char* fileName);
+    void getHeightTaps(float col, float row, int step, HeightTaps* pTaps) const;
+
+    // Address of a sample inside the padded grid
+    const float* getSampleAddress(int col, int row) const
+    {
+        if (data)
+            return data + col + row * colCount;
+
+        const float* tile = tiles + (((size_t)(row >> tileShift) * tileColCount + (uint32_t)(col >> tileShift)) << (2 * tileShift));
+        return tile + ((row & tileMask) << tileShift) + (col & tileMask);
+    }
+
     int levels;
     int patchSize;
 
     float* data;
+
+    // Tiled backend
+    FileStream   tiledStream;
+    const float* tiles;
+    void*        tilesCopy; // Only used when the stream can't be memory-mapped
+    uint32_t     tileShift;
+    uint32_t     tileMask;
+    uint32_t     tileColCount;
 };
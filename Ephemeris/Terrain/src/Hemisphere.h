@@ -13,6 +13,8 @@
 // asimp importer
 #include "../../../../The-Forge/Common_3/Resources/ResourceLoader/Interfaces/IResourceLoader.h"
 
+#include "../../src/ParallelFor.h"
+
 #include "HeightData.h"
 #include "Visibility.h"
 
@@ -31,12 +33,15 @@ struct TerrainVertex
     TerrainVertex(): wsPos(0, 0, 0), maskUV(0, 0) {}
 };
 
+// All segments of a hemisphere share one index buffer, each one draws indexCount indices from firstIndex.
+// Segments start at even indices and are joined by degenerate triangles, so adjacent segments can be drawn as one range.
 struct MeshSegment
 {
     Buffer*            indexBuffer;
+    uint32_t           firstIndex;
     uint32_t           indexCount;
     TerrainBoundingBox boundingBox;
-    MeshSegment(): indexBuffer(NULL), indexCount(0) {}
+    MeshSegment(): indexBuffer(NULL), firstIndex(0), indexCount(0) {}
 };
 
 enum TriangulationOrder
@@ -46,13 +51,21 @@ enum TriangulationOrder
     ORDER_01_TO_10
 };
 
+// Exact number of indices buildTriangleStrip writes
+static inline uint32_t getTriangleStripIndexCount(uint32_t colCount, uint32_t rowCount, TriangulationOrder triangleType)
+{
+    ASSERT(rowCount >= 2);
+    return (triangleType == ORDER_01_TO_10 ? 1 : 0) + 2 * (rowCount - 1) * colCount + 2 * (rowCount - 2);
+}
+
+// outIndices has to hold getTriangleStripIndexCount indices
 static inline void buildTriangleStrip(TriangulationOrder triangulationOrder, uint32_t startIndex, uint32_t colStart, uint32_t rowStart,
                                       uint32_t colCount, uint32_t rowCount, TriangulationOrder triangleType, uint32_t pitch,
-                                      uint32_t* outIndexCount, uint32_t** outIndices)
+                                      uint32_t* outIndexCount, uint32_t* outIndices)
 {
-    uint32_t  maxPossibleIndexCount = 3 + 4 * (rowCount - 1) * colCount;
     uint32_t  indexCount = 0;
-    uint32_t* indices = (uint32_t*)tf_malloc(4 * maxPossibleIndexCount);
+    uint32_t* indices = outIndices;
+    *outIndexCount = 0;
 
     // ASSERT(triangleType == ORDER_00_TO_11 || triangleType == ORDER_01_TO_10);
     uint32_t iFirstTerrainVertex = startIndex + colStart + (rowStart + (triangleType == ORDER_00_TO_11 ? 1 : 0)) * pitch;
@@ -110,16 +123,22 @@ static inline void buildTriangleStrip(TriangulationOrder triangulationOrder, uin
         }
     }
 
+    ASSERT(indexCount == getTriangleStripIndexCount(colCount, rowCount, triangleType));
     *outIndexCount = indexCount;
-    *outIndices = indices;
 }
 
+// Vertex generation and strip building run on worker threads. All indices are packed into a single
+// index buffer that is uploaded with one token wait.
+// Segments are grouped into 12 rays, the segments of every ring at the same position around the ring, and ordered from the inner
+// ring outwards inside a ray. A view from the center of the hemisphere sees a few contiguous ranges of them. outSegmentNodes is a
+// hierarchy of boxes over them, the root has a child per ray and the rays a child per segment, see cullTerrainSegments.
 class HemisphereBuilder
 {
 public:
     void build(Renderer* a_renderer, HeightData* a_heightMap, const float a_planetRadius, float a_sampleScale, float a_samplingStep,
                uint32_t a_ringCount, uint32_t a_gridDimension, uint32_t* outVertexCount, TerrainVertex** outVertices,
-               uint32_t* outMeshSegmentCount, MeshSegment** outMeshSegments)
+               uint32_t* outMeshSegmentCount, MeshSegment** outMeshSegments, Buffer** outIndexBuffer, uint32_t* outSegmentNodeCount,
+               TerrainSegmentNode** outSegmentNodes)
     {
         ASSERT(a_ringCount);
 
@@ -130,164 +149,312 @@ public:
         sampleScale = a_sampleScale;
         planetRadius = a_planetRadius;
         gridDimension = a_gridDimension;
+        ringCount = a_ringCount;
 
-        uint32_t       vertexCount = a_ringCount * gridDimension * gridDimension + a_ringCount * gridDimension * gridDimension;
-        TerrainVertex* vertices = (TerrainVertex*)tf_malloc(sizeof(TerrainVertex) * vertexCount);
-
-        uint32_t     meshSegmentCount = 4 + (a_ringCount - 1) * 12;
-        MeshSegment* meshSegments = (MeshSegment*)tf_malloc(sizeof(MeshSegment) * meshSegmentCount);
+        uint32_t vertexCount = a_ringCount * gridDimension * gridDimension + a_ringCount * gridDimension * gridDimension;
+        vertices = (TerrainVertex*)tf_malloc(sizeof(TerrainVertex) * vertexCount);
+        firstGridStart = a_ringCount * gridDimension * gridDimension;
 
-        MeshSegment* segment = meshSegments;
+        meshSegmentCount = 4 + (a_ringCount - 1) * 12;
+        meshSegments = (MeshSegment*)tf_malloc(sizeof(MeshSegment) * meshSegmentCount);
+        segmentDescs = (SegmentDesc*)tf_malloc(sizeof(SegmentDesc) * meshSegmentCount);
 
-        // Build mesh rings
-        uint32_t currGridStart = a_ringCount * gridDimension * gridDimension;
+        // Lay out the segments of every ring in order around the ring, then group them by ray, see getSegmentIndex
+        uint32_t currGridStart = firstGridStart;
         for (uint32_t currRing = 0; currRing < a_ringCount; ++currRing)
         {
-            float gridScale = 1.f / (float)(1 << (a_ringCount - 1 - currRing));
-
-            // Configure vertices
-
-            // Fill TerrainVertex buffer
-            for (uint32_t row = 0; row < gridDimension; ++row)
-            {
-                for (uint32_t col = 0; col < gridDimension; ++col)
-                {
-                    vertices[currGridStart + col + row * gridDimension] = createTerrainVertex(col, row, gridScale);
-                }
-            }
-
-            // Aligns vertices on the outer boundary
-            if (currRing < a_ringCount - 1)
-            {
-                for (uint32_t i = 1; i < gridDimension - 1; i += 2)
-                {
-                    // Top & bottom boundaries
-                    for (uint32_t row = 0; row < gridDimension; row += gridDimension - 1)
-                    {
-                        float3& v0 = vertices[currGridStart + i - 1 + row * gridDimension].wsPos;
-                        float3& v1 = vertices[currGridStart + i + row * gridDimension].wsPos;
-                        float3& v2 = vertices[currGridStart + i + 1 + row * gridDimension].wsPos;
-                        v1 = v3ToF3((f3Tov3(v0) + f3Tov3(v2)) * 0.5f); //    (v0 + v2) * 0.5f;
-                    }
-
-                    // Left & right boundaries
-                    for (uint32_t col = 0; col < gridDimension; col += gridDimension - 1)
-                    {
-                        float3& v0 = vertices[currGridStart + col + (i - 1) * gridDimension].wsPos;
-                        float3& v1 = vertices[currGridStart + col + i * gridDimension].wsPos;
-                        float3& v2 = vertices[currGridStart + col + (i + 1) * gridDimension].wsPos;
-                        v1 = v3ToF3((f3Tov3(v0) + f3Tov3(v2)) * 0.5f); //    (v0 + v2) * 0.5f;
-                    }
-                }
-            }
-
-            // Configure indices
-
             uint32_t gridMiddle = (gridDimension - 1) / 2;
             uint32_t gridQuarter = (gridDimension - 1) / 4;
 
-            gridPitch = gridDimension;
-            gridStart = currGridStart;
-            // Generate indices for the current ring
+            SegmentDesc  ringSegments[12];
+            SegmentDesc* segment = ringSegments;
+
             if (currRing == 0)
             {
-                *(segment++) = buildMeshSegment(0, 0, gridMiddle + 1, gridMiddle + 1, ORDER_00_TO_11, vertices);
-                *(segment++) = buildMeshSegment(gridMiddle, 0, gridMiddle + 1, gridMiddle + 1, ORDER_01_TO_10, vertices);
-                *(segment++) = buildMeshSegment(0, gridMiddle, gridMiddle + 1, gridMiddle + 1, ORDER_01_TO_10, vertices);
-                *(segment++) = buildMeshSegment(gridMiddle, gridMiddle, gridMiddle + 1, gridMiddle + 1, ORDER_00_TO_11, vertices);
+                *(segment++) = { currGridStart, 0, 0, gridMiddle + 1, gridMiddle + 1, ORDER_00_TO_11 };
+                *(segment++) = { currGridStart, gridMiddle, 0, gridMiddle + 1, gridMiddle + 1, ORDER_01_TO_10 };
+                *(segment++) = { currGridStart, gridMiddle, gridMiddle, gridMiddle + 1, gridMiddle + 1, ORDER_00_TO_11 };
+                *(segment++) = { currGridStart, 0, gridMiddle, gridMiddle + 1, gridMiddle + 1, ORDER_01_TO_10 };
             }
             else
             {
-                *(segment++) = buildMeshSegment(0, 0, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11, vertices);
-                *(segment++) = buildMeshSegment(gridQuarter, 0, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11, vertices);
+                // Top row
+                *(segment++) = { currGridStart, 0, 0, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11 };
+                *(segment++) = { currGridStart, gridQuarter, 0, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11 };
+                *(segment++) = { currGridStart, gridMiddle, 0, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10 };
+                *(segment++) = { currGridStart, gridQuarter * 3, 0, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10 };
+
+                // Right column
+                *(segment++) = { currGridStart, gridQuarter * 3, gridQuarter, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10 };
+                *(segment++) = { currGridStart, gridQuarter * 3, gridMiddle, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11 };
+
+                // Bottom row, right to left
+                *(segment++) = { currGridStart, gridQuarter * 3, gridQuarter * 3, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11 };
+                *(segment++) = { currGridStart, gridMiddle, gridQuarter * 3, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11 };
+                *(segment++) = { currGridStart, gridQuarter, gridQuarter * 3, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10 };
+                *(segment++) = { currGridStart, 0, gridQuarter * 3, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10 };
+
+                // Left column, bottom to top
+                *(segment++) = { currGridStart, 0, gridMiddle, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10 };
+                *(segment++) = { currGridStart, 0, gridQuarter, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11 };
+            }
+
+            for (uint32_t i = 0; i < (uint32_t)(segment - ringSegments); ++i)
+                segmentDescs[getSegmentIndex(currRing, i)] = ringSegments[i];
 
-                *(segment++) = buildMeshSegment(gridMiddle, 0, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10, vertices);
-                *(segment++) = buildMeshSegment(gridQuarter * 3, 0, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10, vertices);
+            currGridStart += gridDimension * gridDimension;
+        }
 
-                *(segment++) = buildMeshSegment(0, gridQuarter, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11, vertices);
-                *(segment++) = buildMeshSegment(0, gridMiddle, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10, vertices);
+        uint32_t totalIndexCount = 0;
+        for (uint32_t i = 0; i < meshSegmentCount; ++i)
+        {
+            // Room for the degenerate join with the previous segment. An even start keeps the winding of the strip when the
+            // segment is drawn together with the previous ones.
+            if (i)
+                totalIndexCount = (totalIndexCount + SEGMENT_JOIN_INDEX_COUNT + 1) & ~1u;
+
+            meshSegments[i] = MeshSegment();
+            meshSegments[i].firstIndex = totalIndexCount;
+            meshSegments[i].indexCount =
+                getTriangleStripIndexCount(segmentDescs[i].colCount, segmentDescs[i].rowCount, segmentDescs[i].quadTriangType);
+            totalIndexCount += meshSegments[i].indexCount;
+        }
+        indices = (uint32_t*)tf_malloc(sizeof(uint32_t) * totalIndexCount);
 
-                *(segment++) = buildMeshSegment(gridQuarter * 3, gridQuarter, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10, vertices);
-                *(segment++) = buildMeshSegment(gridQuarter * 3, gridMiddle, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11, vertices);
+        // Fill TerrainVertex buffer
+        rowChunkCount = (gridDimension + VERTEX_ROWS_PER_TASK - 1) / VERTEX_ROWS_PER_TASK;
+        parallelFor(taskCreateVertices, this, a_ringCount * rowChunkCount);
 
-                *(segment++) = buildMeshSegment(0, gridQuarter * 3, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10, vertices);
-                *(segment++) = buildMeshSegment(gridQuarter, gridQuarter * 3, gridQuarter + 1, gridQuarter + 1, ORDER_01_TO_10, vertices);
+        // Aligns vertices on the outer boundary
+        for (uint32_t currRing = 0; currRing < a_ringCount - 1; ++currRing)
+            alignRingBoundary(firstGridStart + currRing * gridDimension * gridDimension);
 
-                *(segment++) = buildMeshSegment(gridMiddle, gridQuarter * 3, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11, vertices);
-                *(segment++) =
-                    buildMeshSegment(gridQuarter * 3, gridQuarter * 3, gridQuarter + 1, gridQuarter + 1, ORDER_00_TO_11, vertices);
-            }
+        // Configure indices
+        parallelFor(taskBuildMeshSegment, this, meshSegmentCount);
 
-            currGridStart += gridDimension * gridDimension;
+        // Repeat the last index of a segment and then the first one of the next segment until the start of the next segment
+        for (uint32_t i = 1; i < meshSegmentCount; ++i)
+        {
+            const uint32_t joinStart = meshSegments[i - 1].firstIndex + meshSegments[i - 1].indexCount;
+            indices[joinStart] = indices[joinStart - 1];
+            for (uint32_t index = joinStart + 1; index < meshSegments[i].firstIndex; ++index)
+                indices[index] = indices[meshSegments[i].firstIndex];
         }
 
-        ASSERT(segment == meshSegments + meshSegmentCount);
+        buildSegmentNodes();
+
+        SyncToken indexToken = {};
+        Buffer*   indexBuffer = NULL;
+        // mesh.indexBuffer = renderer->addIndexBuffer(mesh.indexCount, sizeof(uint32_t), STATIC, &indices.front());
+        BufferLoadDesc zoneIbDesc = {};
+        zoneIbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDEX_BUFFER;
+        zoneIbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+        zoneIbDesc.mDesc.mSize = (uint64_t)totalIndexCount * sizeof(uint32_t);
+        zoneIbDesc.pData = indices;
+        zoneIbDesc.ppBuffer = &indexBuffer;
+        addResource(&zoneIbDesc, &indexToken);
+        waitForToken(&indexToken);
+
+        for (uint32_t i = 0; i < meshSegmentCount; ++i)
+            meshSegments[i].indexBuffer = indexBuffer;
+
+        tf_free(indices);
+        tf_free(segmentDescs);
+        indices = NULL;
+        segmentDescs = NULL;
 
         *outVertexCount = vertexCount;
         *outVertices = vertices;
 
         *outMeshSegmentCount = meshSegmentCount;
         *outMeshSegments = meshSegments;
+
+        *outIndexBuffer = indexBuffer;
+
+        *outSegmentNodeCount = segmentNodeCount;
+        *outSegmentNodes = segmentNodes;
     }
 
 private:
-    uint32_t    gridPitch = 0;
-    uint32_t    gridStart = 0;
-    Renderer*   renderer = nullptr;
-    HeightData* heightmap = nullptr;
-    float       sampleScale = 0.0f, samplingStep = 0.0f, planetRadius = 0.0f;
-    uint32_t    gridDimension = 0;
-
-    MeshSegment buildMeshSegment(uint32_t colStart, uint32_t rowStart, uint32_t colCount, uint32_t rowCount,
-                                 enum TriangulationOrder quadTriangType, const TerrainVertex* vertices)
+    struct SegmentDesc
     {
-        MeshSegment mesh;
+        uint32_t           gridStart;
+        uint32_t           colStart;
+        uint32_t           rowStart;
+        uint32_t           colCount;
+        uint32_t           rowCount;
+        TriangulationOrder quadTriangType;
+    };
+
+    static const uint32_t VERTEX_ROWS_PER_TASK = 16;
+    static const uint32_t VERTEX_HEIGHT_BATCH = 64;
+    // Last index of the previous segment and first index of the next one
+    static const uint32_t SEGMENT_JOIN_INDEX_COUNT = 2;
+
+    Renderer*      renderer = nullptr;
+    HeightData*    heightmap = nullptr;
+    float          sampleScale = 0.0f, samplingStep = 0.0f, planetRadius = 0.0f;
+    uint32_t       gridDimension = 0;
+    uint32_t       ringCount = 0;
+    uint32_t       firstGridStart = 0;
+    uint32_t       rowChunkCount = 0;
+    TerrainVertex* vertices = nullptr;
+    uint32_t*      indices = nullptr;
+    uint32_t       meshSegmentCount = 0;
+    MeshSegment*   meshSegments = nullptr;
+    SegmentDesc*   segmentDescs = nullptr;
+
+    uint32_t            segmentNodeCount = 0;
+    TerrainSegmentNode* segmentNodes = nullptr;
+
+    static void taskCreateVertices(void* pUserData, uint32_t taskIndex)
+    {
+        HemisphereBuilder* pBuilder = (HemisphereBuilder*)pUserData;
 
-        uint32_t* indices;
-        buildTriangleStrip(ORDER_UNDEFINED, gridStart, colStart, rowStart, colCount, rowCount, quadTriangType, gridPitch, &mesh.indexCount,
-                           &indices);
+        const uint32_t gridDimension = pBuilder->gridDimension;
+        const uint32_t currRing = taskIndex / pBuilder->rowChunkCount;
+        const uint32_t rowBegin = (taskIndex % pBuilder->rowChunkCount) * VERTEX_ROWS_PER_TASK;
+        const uint32_t rowEnd = min(rowBegin + VERTEX_ROWS_PER_TASK, gridDimension);
+        const uint32_t currGridStart = pBuilder->firstGridStart + currRing * gridDimension * gridDimension;
+        const float    gridScale = 1.f / (float)(1 << (pBuilder->ringCount - 1 - currRing));
 
-        SyncToken      token = {};
-        // mesh.indexBuffer = renderer->addIndexBuffer(mesh.indexCount, sizeof(uint32_t), STATIC, &indices.front());
-        BufferLoadDesc zoneIbDesc = {};
-        zoneIbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDEX_BUFFER;
-        zoneIbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
-        zoneIbDesc.mDesc.mSize = (uint64_t)(mesh.indexCount * sizeof(uint32_t));
-        zoneIbDesc.pData = indices;
-        zoneIbDesc.ppBuffer = &mesh.indexBuffer;
-        addResource(&zoneIbDesc, &token);
-        waitForToken(&token);
+        float2 heightCoords[VERTEX_HEIGHT_BATCH];
+        float  heights[VERTEX_HEIGHT_BATCH];
 
-        auto& bounds = mesh.boundingBox;
-        bounds.max = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-        bounds.min = float3(FLT_MAX, FLT_MAX, FLT_MAX);
+        for (uint32_t row = rowBegin; row < rowEnd; ++row)
+        {
+            TerrainVertex* rowVertices = pBuilder->vertices + currGridStart + row * gridDimension;
+            // Heights of a batch of vertices are sampled together
+            for (uint32_t batchStart = 0; batchStart < gridDimension; batchStart += VERTEX_HEIGHT_BATCH)
+            {
+                const uint32_t batchCount = min(VERTEX_HEIGHT_BATCH, gridDimension - batchStart);
+                for (uint32_t i = 0; i < batchCount; ++i)
+                {
+                    rowVertices[batchStart + i] = pBuilder->createTerrainVertex(batchStart + i, row, gridScale);
+                    const float3& posWs = rowVertices[batchStart + i].wsPos;
+                    heightCoords[i] = float2(posWs.x / pBuilder->samplingStep, posWs.z / pBuilder->samplingStep);
+                }
+
+                pBuilder->heightmap->getInterpolatedHeights(heightCoords, heights, batchCount);
+
+                for (uint32_t i = 0; i < batchCount; ++i)
+                    pBuilder->applyTerrainVertexHeight(rowVertices[batchStart + i], heightCoords[i], heights[i]);
+            }
+        }
+    }
+
+    static void taskBuildMeshSegment(void* pUserData, uint32_t segmentIndex)
+    {
+        HemisphereBuilder* pBuilder = (HemisphereBuilder*)pUserData;
+
+        pBuilder->buildMeshSegment(pBuilder->segmentDescs[segmentIndex], &pBuilder->meshSegments[segmentIndex]);
+    }
+
+    // Every ring but ring 0 has 12 segments around it, ray i holds segment i of these rings. Ring 0 has 4 segments, one per quarter,
+    // which start the rays of the 4 corner segments.
+    static const uint32_t SEGMENT_RAY_COUNT = 12;
+
+    uint32_t getRayFirstSegment(uint32_t ray) const { return ray * (ringCount - 1) + (ray + 2) / 3; }
+    uint32_t getSegmentIndex(uint32_t ring, uint32_t ringSegment) const
+    {
+        if (ring == 0)
+            return getRayFirstSegment(ringSegment * 3);
+        return getRayFirstSegment(ringSegment) + (ringSegment % 3 == 0 ? 1 : 0) + ring - 1;
+    }
+
+    static void growBoundingBox(TerrainBoundingBox& bounds, const TerrainBoundingBox& other)
+    {
+        bounds.min = float3(min(bounds.min.x, other.min.x), min(bounds.min.y, other.min.y), min(bounds.min.z, other.min.z));
+        bounds.max = float3(max(bounds.max.x, other.max.x), max(bounds.max.y, other.max.y), max(bounds.max.z, other.max.z));
+    }
+
+    // Root, then the rays, then a leaf per segment. Deeper trees over the rings of a ray visit fewer nodes but cost more, the rays
+    // pointing at the camera straddle the frustum planes down to single segments anyway.
+    void buildSegmentNodes()
+    {
+        segmentNodeCount = 1 + SEGMENT_RAY_COUNT + meshSegmentCount;
+        segmentNodes = (TerrainSegmentNode*)tf_malloc(sizeof(TerrainSegmentNode) * segmentNodeCount);
+
+        TerrainSegmentNode& root = segmentNodes[0];
+        root = { meshSegments[0].boundingBox, 0, meshSegmentCount, 1, SEGMENT_RAY_COUNT };
+
+        for (uint32_t ray = 0; ray < SEGMENT_RAY_COUNT; ++ray)
+        {
+            const uint32_t firstSegment = getRayFirstSegment(ray);
+            const uint32_t segmentCount = (ray + 1 < SEGMENT_RAY_COUNT ? getRayFirstSegment(ray + 1) : meshSegmentCount) - firstSegment;
 
-        for (uint32_t i = 0; i < mesh.indexCount; ++i)
+            TerrainSegmentNode& rayNode = segmentNodes[1 + ray];
+            rayNode = { meshSegments[firstSegment].boundingBox, firstSegment, segmentCount, 1 + SEGMENT_RAY_COUNT + firstSegment,
+                        segmentCount };
+            for (uint32_t i = firstSegment; i < firstSegment + segmentCount; ++i)
+            {
+                segmentNodes[rayNode.firstChild + i - firstSegment] = { meshSegments[i].boundingBox, i, 1, 0, 0 };
+                growBoundingBox(rayNode.boundingBox, meshSegments[i].boundingBox);
+            }
+            growBoundingBox(root.boundingBox, rayNode.boundingBox);
+        }
+    }
+
+    void alignRingBoundary(uint32_t currGridStart)
+    {
+        for (uint32_t i = 1; i < gridDimension - 1; i += 2)
         {
-            const auto& vert = vertices[indices[i]].wsPos;
-            bounds.min.x = min(bounds.min.x, vert.x);
-            bounds.min.y = min(bounds.min.y, vert.y);
-            bounds.min.z = min(bounds.min.z, vert.z);
-
-            bounds.max.x = max(bounds.max.x, vert.x);
-            bounds.max.y = max(bounds.max.y, vert.y);
-            bounds.max.z = max(bounds.max.z, vert.z);
+            // Top & bottom boundaries
+            for (uint32_t row = 0; row < gridDimension; row += gridDimension - 1)
+            {
+                float3& v0 = vertices[currGridStart + i - 1 + row * gridDimension].wsPos;
+                float3& v1 = vertices[currGridStart + i + row * gridDimension].wsPos;
+                float3& v2 = vertices[currGridStart + i + 1 + row * gridDimension].wsPos;
+                v1 = v3ToF3((f3Tov3(v0) + f3Tov3(v2)) * 0.5f); //    (v0 + v2) * 0.5f;
+            }
+
+            // Left & right boundaries
+            for (uint32_t col = 0; col < gridDimension; col += gridDimension - 1)
+            {
+                float3& v0 = vertices[currGridStart + col + (i - 1) * gridDimension].wsPos;
+                float3& v1 = vertices[currGridStart + col + i * gridDimension].wsPos;
+                float3& v2 = vertices[currGridStart + col + (i + 1) * gridDimension].wsPos;
+                v1 = v3ToF3((f3Tov3(v0) + f3Tov3(v2)) * 0.5f); //    (v0 + v2) * 0.5f;
+            }
         }
+    }
 
-        tf_free(indices);
+    void buildMeshSegment(const SegmentDesc& desc, MeshSegment* mesh)
+    {
+        uint32_t indexCount = 0;
+        buildTriangleStrip(ORDER_UNDEFINED, desc.gridStart, desc.colStart, desc.rowStart, desc.colCount, desc.rowCount, desc.quadTriangType,
+                           gridDimension, &indexCount, indices + mesh->firstIndex);
+        ASSERT(indexCount == mesh->indexCount);
+
+        // The strip references every vertex of the segment rectangle, walk the rows instead of the indices
+        auto& bounds = mesh->boundingBox;
+        bounds.max = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        bounds.min = float3(FLT_MAX, FLT_MAX, FLT_MAX);
 
-        return mesh;
+        for (uint32_t row = desc.rowStart; row < desc.rowStart + desc.rowCount; ++row)
+        {
+            const TerrainVertex* rowVertices = vertices + desc.gridStart + row * gridDimension;
+            for (uint32_t col = desc.colStart; col < desc.colStart + desc.colCount; ++col)
+            {
+                const auto& vert = rowVertices[col].wsPos;
+                bounds.min.x = min(bounds.min.x, vert.x);
+                bounds.min.y = min(bounds.min.y, vert.y);
+                bounds.min.z = min(bounds.min.z, vert.z);
+
+                bounds.max.x = max(bounds.max.x, vert.x);
+                bounds.max.y = max(bounds.max.y, vert.y);
+                bounds.max.z = max(bounds.max.z, vert.z);
+            }
+        }
     }
 
-    void computeTerrainVertexHeight(TerrainVertex& TerrainVertex)
+    // heightCoord is the height map coordinate of the vertex, displacement the height sampled there
+    void applyTerrainVertexHeight(TerrainVertex& TerrainVertex, const float2& heightCoord, float displacement) const
     {
         float3& posWs = TerrainVertex.wsPos;
 
-        float col = posWs.x / samplingStep;
-        float row = posWs.z / samplingStep;
-        float displacement = heightmap->getInterpolatedHeight(col, row);
-        TerrainVertex.maskUV.x = (col + (float)heightmap->colOffset + 0.5f) / (float)heightmap->colCount;
-        TerrainVertex.maskUV.y = (row + (float)heightmap->rowOffset + 0.5f) / (float)heightmap->rowCount;
+        TerrainVertex.maskUV.x = (heightCoord.x + (float)heightmap->colOffset + 0.5f) / (float)heightmap->colCount;
+        TerrainVertex.maskUV.y = (heightCoord.y + (float)heightmap->rowOffset + 0.5f) / (float)heightmap->rowCount;
 
         float3 sphereNormal;
         sphereNormal = v3ToF3(normalize(f3Tov3(posWs)));
@@ -296,9 +463,12 @@ private:
         displacement = displacement * displacement * displacement;
         displacement *= 1.5f;
         posWs = v3ToF3(f3Tov3(posWs) + f3Tov3(sphereNormal) * displacement * sampleScale * MaxMountainHeight);
+
+        posWs.y -= planetRadius;
     }
 
-    TerrainVertex createTerrainVertex(uint32_t col, uint32_t row, float gridScale)
+    // Vertex on the undisplaced sphere, before applyTerrainVertexHeight
+    TerrainVertex createTerrainVertex(uint32_t col, uint32_t row, float gridScale) const
     {
         TerrainVertex currVert;
         auto&         pos = currVert.wsPos;
@@ -324,10 +494,6 @@ private:
 
         pos = v3ToF3(f3Tov3(pos) * planetRadius);
 
-        computeTerrainVertexHeight(currVert);
-
-        pos.y -= planetRadius;
-
         return currVert;
     }
 };
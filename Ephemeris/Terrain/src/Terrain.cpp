@@ -65,69 +65,22 @@ struct LightingTerrainUniformBuffer
     float4 LightColor;
 };
 
-#if !USE_PROCEDUAL_TERRAIN
-static bool boxIntersects(TerrainFrustum& frustum, TerrainBoundingBox& box)
+#if USE_PROCEDUAL_TERRAIN
+// The vertex buffer of a zone, see TerrainZoneSetDesc
+static void addZoneResource(void* pUserData, TerrainZone* pZone)
 {
-    Plane*   planes = frustum.CPlanes.planes;
-    Plane*   currPlane;
-    Vector3* currNormal;
-    Vector3  maxPoint;
-
-    for (int planeIdx = 0; planeIdx < 6; planeIdx++)
-    {
-        currPlane = planes + planeIdx;
-        currNormal = &currPlane->normal;
-
-        maxPoint.setX((currNormal->getX() > 0) ? box.max.x : box.min.x);
-        maxPoint.setY((currNormal->getY() > 0) ? box.max.y : box.min.y);
-        maxPoint.setZ((currNormal->getZ() > 0) ? box.max.z : box.min.z);
-
-        float dMax = dot(maxPoint, *currNormal) + currPlane->distance;
-
-        if (dMax < 0)
-            return false;
-    }
-    return true;
+    Buffer*        pZoneVertexBuffer = NULL;
+    BufferLoadDesc zoneVbDesc = {};
+    zoneVbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
+    zoneVbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+    zoneVbDesc.mDesc.mSize = (uint64_t)GRID_SIZE * GRID_SIZE * TERRAIN_ZONE_VERTEX_FLOATS * sizeof(float);
+    zoneVbDesc.pData = pZone->pData->pPosAndUVs;
+    zoneVbDesc.ppBuffer = &pZoneVertexBuffer;
+    addResource(&zoneVbDesc, NULL);
+    pZone->pResource = pZoneVertexBuffer;
 }
 
-static void getFrustumFromMatrix(const mat4& matrix, TerrainFrustum& frustum)
-{
-    // Left clipping plane
-    frustum.iPlanes.left.normal.setX(matrix[0][3] + matrix[0][0]);
-    frustum.iPlanes.left.normal.setY(matrix[1][3] + matrix[1][0]);
-    frustum.iPlanes.left.normal.setZ(matrix[2][3] + matrix[2][0]);
-    frustum.iPlanes.left.distance = matrix[3][3] + matrix[3][0];
-
-    // Right clipping plane
-    frustum.iPlanes.right.normal.setX(matrix[0][3] - matrix[0][0]);
-    frustum.iPlanes.right.normal.setY(matrix[1][3] - matrix[1][0]);
-    frustum.iPlanes.right.normal.setZ(matrix[2][3] - matrix[2][0]);
-    frustum.iPlanes.right.distance = matrix[3][3] - matrix[3][0];
-
-    // Top clipping plane
-    frustum.iPlanes.top.normal.setX(matrix[0][3] - matrix[0][1]);
-    frustum.iPlanes.top.normal.setY(matrix[1][3] - matrix[1][1]);
-    frustum.iPlanes.top.normal.setZ(matrix[2][3] - matrix[2][1]);
-    frustum.iPlanes.top.distance = matrix[3][3] - matrix[3][1];
-
-    // Bottom clipping plane
-    frustum.iPlanes.bottom.normal.setX(matrix[0][3] + matrix[0][1]);
-    frustum.iPlanes.bottom.normal.setY(matrix[1][3] + matrix[1][1]);
-    frustum.iPlanes.bottom.normal.setZ(matrix[2][3] + matrix[2][1]);
-    frustum.iPlanes.bottom.distance = matrix[3][3] + matrix[3][1];
-
-    // Near clipping plane
-    frustum.iPlanes.front.normal.setX(matrix[0][2]);
-    frustum.iPlanes.front.normal.setY(matrix[1][2]);
-    frustum.iPlanes.front.normal.setZ(matrix[2][2]);
-    frustum.iPlanes.front.distance = matrix[3][2];
-
-    // Far clipping plane
-    frustum.iPlanes.back.normal.setX(matrix[0][3] - matrix[0][2]);
-    frustum.iPlanes.back.normal.setY(matrix[1][3] - matrix[1][2]);
-    frustum.iPlanes.back.normal.setZ(matrix[2][3] - matrix[2][2]);
-    frustum.iPlanes.back.distance = matrix[3][3] - matrix[3][2];
-}
+static void removeZoneResource(void* pUserData, TerrainZone* pZone) { removeResource((Buffer*)pZone->pResource); }
 #endif
 
 bool Terrain::Init(Renderer* renderer, PipelineCache* pCache)
@@ -183,6 +136,21 @@ bool Terrain::Init(Renderer* renderer, PipelineCache* pCache)
     zoneIbDesc.pData = indexBuffer.data();
     zoneIbDesc.ppBuffer = &pGlobalZoneIndexBuffer;
     addResource(&zoneIbDesc, &token);
+
+    TerrainZoneStreamerDesc zoneStreamerDesc = {};
+    zoneStreamerDesc.mGridSize = GRID_SIZE;
+    zoneStreamerDesc.mScale = OVERALLSCALE;
+    zoneStreamerDesc.mNoiseOffset = (float)TILE_CENTER;
+    initTerrainZoneStreamer(&zoneStreamerDesc, &zoneStreamer);
+
+    TerrainZoneSetDesc zoneSetDesc = {};
+    zoneSetDesc.mZoneSize = GRID_SIZE * OVERALLSCALE;
+    zoneSetDesc.mPrefetchRadius = ZONE_PREFETCH_RADIUS;
+    zoneSetDesc.mResidentBudget = ZONE_RESIDENT_BUDGET;
+    zoneSetDesc.mFramesInFlight = gDataBufferCount;
+    zoneSetDesc.pAddResource = addZoneResource;
+    zoneSetDesc.pRemoveResource = removeZoneResource;
+    initTerrainZoneSet(&zoneSetDesc, &zoneSet);
 #endif
 
     float screenQuadPoints[] = {
@@ -249,16 +217,9 @@ void Terrain::Exit()
     removeSampler(pRenderer, pNearestClampSampler);
 
 #if USE_PROCEDUAL_TERRAIN
+    exitTerrainZoneStreamer(&zoneStreamer);
+    exitTerrainZoneSet(&zoneSet);
     removeResource(pGlobalZoneIndexBuffer);
-
-    for (ZoneMap::iterator iter = gZoneMap.begin(); iter != gZoneMap.end(); ++iter)
-    {
-        Zone* zone = iter->second;
-        removeResource(zone->pZoneVertexBuffer);
-        tf_free(zone);
-    }
-
-    gZoneMap.clear();
 #endif
 
     removeResource(pGlobalVertexBuffer);
@@ -272,10 +233,8 @@ void Terrain::Exit()
 
     removeResource(pVolumetricCloudsShadowBuffer);
 
-    for (size_t i = 0; i < meshSegmentCount; i++)
-    {
-        removeResource(meshSegments[i].indexBuffer);
-    }
+    removeResource(pMeshSegmentIndexBuffer);
+    pMeshSegmentIndexBuffer = NULL;
 
     removeResource(pTerrainNormalTexture);
     removeResource(pTerrainMaskTexture);
@@ -294,6 +253,11 @@ void Terrain::Exit()
     tf_free(meshSegments);
     meshSegments = NULL;
     meshSegmentCount = 0;
+    tf_free(segmentNodes);
+    tf_free(visibleSegmentRuns);
+    segmentNodes = NULL;
+    visibleSegmentRuns = NULL;
+    segmentNodeCount = 0;
 }
 
 void Terrain::GenerateTerrainFromHeightmap(float radius)
@@ -303,20 +267,35 @@ void Terrain::GenerateTerrainFromHeightmap(float radius)
     tf_free(meshSegments);
     meshSegments = NULL;
     meshSegmentCount = 0;
-
-    HeightData dataSource("Terrain/HeightMap.r32");
+    tf_free(segmentNodes);
+    tf_free(visibleSegmentRuns);
+    segmentNodes = NULL;
+    visibleSegmentRuns = NULL;
+    segmentNodeCount = 0;
+
+    // Prefer the memory-mapped tiled height map, see HeightData::convertToTiled
+    HeightData* dataSource = tf_new(HeightData, "Terrain/HeightMap.hdt", HEIGHT_DATA_TILED);
+    if (!dataSource->isLoaded())
+    {
+        tf_delete(dataSource);
+        dataSource = tf_new(HeightData, "Terrain/HeightMap.r32", HEIGHT_DATA_RAW);
+    }
 
     TerrainVertex* vertices;
     {
         HemisphereBuilder hemisphereBuilder;
-        hemisphereBuilder.build(pRenderer, &dataSource, radius, 1.0f, 64, 15,
+        hemisphereBuilder.build(pRenderer, dataSource, radius, 1.0f, 64, 15,
 #ifdef _DEBUG
                                 33,
 #else
                                 513,
 #endif
-                                &TerrainPathVertexCount, &vertices, &meshSegmentCount, &meshSegments);
+                                &TerrainPathVertexCount, &vertices, &meshSegmentCount, &meshSegments, &pMeshSegmentIndexBuffer,
+                                &segmentNodeCount, &segmentNodes);
     }
+    visibleSegmentRuns = (TerrainSegmentRun*)tf_malloc(sizeof(TerrainSegmentRun) * meshSegmentCount);
+
+    tf_delete(dataSource);
 
     SyncToken token = {};
 
@@ -796,15 +775,16 @@ void Terrain::Draw(Cmd* cmd)
 
         cmdBindDescriptorSet(cmd, gFrameIndex, pTerrainDescriptorSet[1]);
 
-        for (ZoneMap::iterator iter = gZoneMap.begin(); iter != gZoneMap.end(); ++iter)
+        for (uint32_t i = 0; i < zoneSet.mZoneCount; ++i)
         {
-            Zone* zone = iter->second;
+            TerrainZone* zone = &zoneSet.pZones[i];
 
-            if (zone->visible)
+            if (zone->mVisible && zone->mResident)
             {
-                const uint32_t stride = sizeof(float) * 5;
-                cmdBindVertexBuffer(cmd, 1, &zone->pZoneVertexBuffer, &stride, NULL);
-                cmdBindIndexBuffer(cmd, zone->pZoneIndexBuffer, INDEX_TYPE_UINT32, 0);
+                const uint32_t stride = sizeof(float) * TERRAIN_ZONE_VERTEX_FLOATS;
+                Buffer*        pZoneVertexBuffer = (Buffer*)zone->pResource;
+                cmdBindVertexBuffer(cmd, 1, &pZoneVertexBuffer, &stride, NULL);
+                cmdBindIndexBuffer(cmd, pGlobalZoneIndexBuffer, INDEX_TYPE_UINT32, 0);
                 cmdDrawIndexed(cmd, (uint32_t)indexBuffer.size(), 0, 0);
             }
         }
@@ -861,13 +841,17 @@ void Terrain::Draw(Cmd* cmd)
         cmdBindDescriptorSet(cmd, gFrameIndex, pTerrainDescriptorSet[1]);
 
         // render depth image
-        for (uint32_t i = 0; i < meshSegmentCount; ++i)
+        cmdBindIndexBuffer(cmd, pMeshSegmentIndexBuffer, INDEX_TYPE_UINT32, 0);
+        // Segments behind the planet are hidden by the terrain in front of them
+        TerrainHorizon terrainHorizon;
+        getTerrainHorizon(pCameraController->getViewPosition(), vec3(0.0f, -PLANET_RADIUS, 0.0f), PLANET_RADIUS, terrainHorizon);
+        const uint32_t visibleRunCount = cullTerrainSegments(segmentNodes, terrainFrustum, &terrainHorizon, visibleSegmentRuns);
+        for (uint32_t i = 0; i < visibleRunCount; ++i)
         {
-            MeshSegment* mesh = meshSegments + i;
-            if (!boxIntersects(terrainFrustum, mesh->boundingBox) /*&& !shadowPass*/)
-                continue;
-            cmdBindIndexBuffer(cmd, mesh->indexBuffer, INDEX_TYPE_UINT32, 0);
-            cmdDrawIndexed(cmd, (uint32_t)mesh->indexCount, 0, 0);
+            // Adjacent segments are joined by degenerate triangles in the index buffer
+            const MeshSegment* first = meshSegments + visibleSegmentRuns[i].firstSegment;
+            const MeshSegment* last = first + visibleSegmentRuns[i].segmentCount - 1;
+            cmdDrawIndexed(cmd, last->firstIndex + last->indexCount - first->firstIndex, first->firstIndex, 0);
         }
 
         cmdBindRenderTargets(cmd, NULL);
@@ -954,94 +938,12 @@ void Terrain::Update(float deltaTime)
     }
 
 #if USE_PROCEDUAL_TERRAIN
-    for (ZoneMap::iterator iter = gZoneMap.begin(); iter != gZoneMap.end(); ++iter)
-    {
-        Zone* zone = iter->second;
-        zone->visible = false;
-    }
-
     vec3 cameraPos = pCameraController->getViewPosition();
-
-    uint32_t MinX = (uint32_t)(floor((cameraPos.getX() / (GRID_SIZE * OVERALLSCALE)) - 0.5f) + TILE_CENTER);
-    uint32_t MaxX = (uint32_t)(floor((cameraPos.getX() / (GRID_SIZE * OVERALLSCALE)) + 0.5f) + TILE_CENTER);
-
-    uint32_t MinZ = (uint32_t)(floor((cameraPos.getZ() / (GRID_SIZE * OVERALLSCALE)) - 0.5f) + TILE_CENTER);
-    uint32_t MaxZ = (uint32_t)(floor((cameraPos.getZ() / (GRID_SIZE * OVERALLSCALE)) + 0.5f) + TILE_CENTER);
-
-    for (uint32_t Z = MinZ; Z <= MaxZ; Z++)
-    {
-        for (uint32_t X = MinX; X <= MaxX; X++)
-        {
-            uint32_t z = Z;
-            uint32_t x = X;
-            while (z > 0)
-            {
-                z /= 10;
-                x *= 10;
-            }
-
-            eastl::unordered_map<uint32_t, Zone*>::iterator iterator = gZoneMap.find(x + Z);
-
-            // if there is no zone
-            if (iterator == gZoneMap.end())
-            {
-                // create it
-                Zone* newZone = tf_placement_new<Zone>(tf_calloc(1, sizeof(Zone)));
-
-                int32_t XInit = (X - TILE_CENTER) * GRID_SIZE;
-                int32_t ZInit = (Z - TILE_CENTER) * GRID_SIZE;
-
-                float gap = (float)GRID_SIZE / (float)(GRID_SIZE - 1);
-
-                float i = (float)XInit;
-
-                for (int X_index = 0; X_index < GRID_SIZE; X_index++)
-                {
-                    float j = (float)ZInit;
-
-                    for (int Z_index = 0; Z_index < GRID_SIZE; Z_index++)
-                    {
-                        newZone->PosAndUVs.push_back((float)i * OVERALLSCALE);
-                        newZone->PosAndUVs.push_back(noiseGenerator.perlinNoise2D((float)(i + (float)TILE_CENTER) * 0.125f,
-                                                                                  (float)(j + (float)TILE_CENTER) * 0.125f) *
-                                                     OVERALLSCALE);
-                        newZone->PosAndUVs.push_back((float)j * OVERALLSCALE);
-
-                        newZone->PosAndUVs.push_back((float)(j - ZInit) / GRID_SIZE);
-                        newZone->PosAndUVs.push_back((float)(i - XInit) / GRID_SIZE);
-
-                        j += gap;
-                    }
-
-                    i += gap;
-                }
-
-                newZone->X = X;
-                newZone->Z = Z;
-                newZone->visible = true;
-
-                uint64_t       zoneDataSize = GRID_SIZE * GRID_SIZE * sizeof(float) * 5;
-                BufferLoadDesc zoneVbDesc = {};
-                zoneVbDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
-                zoneVbDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
-                zoneVbDesc.mDesc.mSize = zoneDataSize;
-                zoneVbDesc.pData = newZone->PosAndUVs.data();
-                zoneVbDesc.ppBuffer = &newZone->pZoneVertexBuffer;
-                addResource(&zoneVbDesc, NULL);
-
-                newZone->pZoneIndexBuffer = pGlobalZoneIndexBuffer;
-
-                gZoneMap.insert(eastl::pair<uint32_t, Zone*>(newZone->GetKey(), newZone));
-            }
-            else
-            {
-                iterator->second->visible = true;
-            }
-        }
-    }
+    updateTerrainZones(&zoneSet, &zoneStreamer, cameraPos.getX(), cameraPos.getZ());
 #endif
 }
 
+
 void Terrain::InitializeWithLoad(RenderTarget* InDepthRenderTarget) { pDepthBuffer = InDepthRenderTarget; }
 
 void Terrain::Initialize(ICameraController* InCameraController, ProfileToken InGraphicsGpuProfiler)
@@ -26,43 +26,15 @@
 
 #define USE_PROCEDUAL_TERRAIN 0
 #if USE_PROCEDUAL_TERRAIN
-#include "../../../../The-Forge/Common_3/Utilities/ThirdParty/OpenSource/EASTL/unordered_map.h"
 #include "../../../../The-Forge/Common_3/Utilities/ThirdParty/OpenSource/EASTL/vector.h"
 
-struct Zone
-{
-    bool     visible;
-    uint32_t X;
-    uint32_t Z;
-
-    // vec3 positions[GRID_SIZE][GRID_SIZE];
-    eastl::vector<float> PosAndUVs;
-
-    Buffer* pZoneVertexBuffer = NULL;
-    Buffer* pZoneIndexBuffer = NULL;
-
-    uint32_t GetKey()
-    {
-        uint32_t z = Z;
-        uint32_t x = X;
-        while (z > 0)
-        {
-            z /= 10;
-            x *= 10;
-        }
-
-        return (x + Z);
-    }
-
-    Zone()
-    {
-        visible = false;
-        X = TILE_CENTER;
-        Z = TILE_CENTER;
-    }
-};
+#include "TerrainZoneStreamer.h"
 
-typedef eastl::unordered_map<uint32_t, Zone*> ZoneMap;
+// Zones around the camera that are generated ahead of being visible
+#define ZONE_PREFETCH_RADIUS 1
+// Resident zones kept for when the camera comes back, least recently used ones are evicted first.
+// Has to hold the (2 + 2 * ZONE_PREFETCH_RADIUS)^2 zones around the camera.
+#define ZONE_RESIDENT_BUDGET 32
 #endif
 
 struct VolumetricCloudsShadowCB
@@ -128,8 +100,9 @@ public:
     ProfileToken gGpuProfileToken = {};
 
 #if USE_PROCEDUAL_TERRAIN
-    ZoneMap                 gZoneMap;
     eastl::vector<uint32_t> indexBuffer;
+    TerrainZoneStreamer     zoneStreamer;
+    TerrainZoneSet          zoneSet;
 #endif
 
     Buffer* pGlobalZoneIndexBuffer = NULL;
@@ -137,6 +110,12 @@ public:
 
     uint32_t     meshSegmentCount = 0;
     MeshSegment* meshSegments = NULL;
+    // Indices of all mesh segments
+    Buffer*      pMeshSegmentIndexBuffer = NULL;
+    // Hierarchy over meshSegments and room for the visible runs of a frame
+    uint32_t            segmentNodeCount = 0;
+    TerrainSegmentNode* segmentNodes = NULL;
+    TerrainSegmentRun*  visibleSegmentRuns = NULL;
 
     Buffer* pGlobalTriangularVertexBuffer = NULL;
 
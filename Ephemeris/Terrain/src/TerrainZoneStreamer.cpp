@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "TerrainZoneStreamer.h"
+
+#include "../../src/Perlin.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
+
+static void siftDownTerrainZoneRequest(TerrainZoneRequest* pHeap, uint32_t count, uint32_t index)
+{
+    const TerrainZoneRequest request = pHeap[index];
+    for (uint32_t child = index * 2 + 1; child < count; child = index * 2 + 1)
+    {
+        if (child + 1 < count && pHeap[child + 1].mPriority < pHeap[child].mPriority)
+            ++child;
+        if (request.mPriority <= pHeap[child].mPriority)
+            break;
+        pHeap[index] = pHeap[child];
+        index = child;
+    }
+    pHeap[index] = request;
+}
+
+// Only the render thread walks the list, and it is also the only one removing zones from it
+static bool isTerrainZoneFinished(TerrainZoneStreamer* pStreamer, uint64_t key)
+{
+    for (TerrainZoneData* pZone = (TerrainZoneData*)tfrg_atomicptr_load_acquire(&pStreamer->mFinished); pZone; pZone = pZone->pNext)
+    {
+        if (getTerrainZoneKey(pZone->mX, pZone->mZ) == key)
+            return true;
+    }
+    return false;
+}
+
+static void terrainZoneWorkerThread(void* pData)
+{
+    TerrainZoneWorker*             pWorker = (TerrainZoneWorker*)pData;
+    TerrainZoneStreamer*           pStreamer = pWorker->pStreamer;
+    const TerrainZoneStreamerDesc* pDesc = &pStreamer->mDesc;
+    const uint64_t                 vertexCount = (uint64_t)pDesc->mGridSize * pDesc->mGridSize;
+
+    for (;;)
+    {
+        acquireMutex(&pStreamer->mMutex);
+        while (!pStreamer->mQuit && !pStreamer->mRequestCount)
+            waitConditionVariable(&pStreamer->mWakeUp, &pStreamer->mMutex, TIMEOUT_INFINITE);
+        if (pStreamer->mQuit)
+        {
+            releaseMutex(&pStreamer->mMutex);
+            break;
+        }
+
+        const TerrainZoneRequest request = pStreamer->pRequests[0];
+        pStreamer->pRequests[0] = pStreamer->pRequests[--pStreamer->mRequestCount];
+        siftDownTerrainZoneRequest(pStreamer->pRequests, pStreamer->mRequestCount, 0);
+        pStreamer->mKeysInFlight[pWorker->mIndex] = getTerrainZoneKey(request.mX, request.mZ);
+        pStreamer->mBusy[pWorker->mIndex] = true;
+        releaseMutex(&pStreamer->mMutex);
+
+        TerrainZoneData* pZone = (TerrainZoneData*)tf_calloc(1, sizeof(TerrainZoneData));
+        pZone->mX = request.mX;
+        pZone->mZ = request.mZ;
+        pZone->pPosAndUVs = (float*)tf_malloc(vertexCount * TERRAIN_ZONE_VERTEX_FLOATS * sizeof(float));
+        generateTerrainZone(pDesc, request.mX, request.mZ, pZone->pPosAndUVs);
+
+        // Pushed before the zone leaves the in flight keys, so requestTerrainZones always sees it in one of them
+        uintptr_t head;
+        do
+        {
+            head = tfrg_atomicptr_load_relaxed(&pStreamer->mFinished);
+            pZone->pNext = (TerrainZoneData*)head;
+            tfrg_memorybarrier_release();
+        } while (tfrg_atomicptr_cas_relaxed(&pStreamer->mFinished, head, (uintptr_t)pZone) != head);
+
+        acquireMutex(&pStreamer->mMutex);
+        pStreamer->mBusy[pWorker->mIndex] = false;
+        releaseMutex(&pStreamer->mMutex);
+    }
+}
+
+void initTerrainZoneStreamer(const TerrainZoneStreamerDesc* pDesc, TerrainZoneStreamer* pStreamer)
+{
+    ASSERT(pDesc->mGridSize > 1);
+
+    *pStreamer = {};
+    pStreamer->mDesc = *pDesc;
+
+    uint32_t threadCount = pDesc->mThreadCount;
+    if (threadCount == 0)
+        threadCount = (uint32_t)getNumCPUCores() - 1;
+    threadCount = threadCount < TERRAIN_ZONE_MAX_THREADS ? threadCount : TERRAIN_ZONE_MAX_THREADS;
+    pStreamer->mThreadCount = threadCount > 1 ? threadCount : 1;
+
+    initMutex(&pStreamer->mMutex);
+    initConditionVariable(&pStreamer->mWakeUp);
+
+    for (uint32_t i = 0; i < pStreamer->mThreadCount; ++i)
+    {
+        TerrainZoneWorker* pWorker = &pStreamer->mWorkers[i];
+        pWorker->pStreamer = pStreamer;
+        pWorker->mIndex = i;
+
+        ThreadDesc threadDesc = {};
+        threadDesc.pFunc = terrainZoneWorkerThread;
+        threadDesc.pData = pWorker;
+        initThread(&threadDesc, &pWorker->mThread);
+    }
+}
+
+void exitTerrainZoneStreamer(TerrainZoneStreamer* pStreamer)
+{
+    acquireMutex(&pStreamer->mMutex);
+    pStreamer->mQuit = true;
+    wakeAllConditionVariable(&pStreamer->mWakeUp);
+    releaseMutex(&pStreamer->mMutex);
+
+    for (uint32_t i = 0; i < pStreamer->mThreadCount; ++i)
+        joinThread(pStreamer->mWorkers[i].mThread);
+
+    for (TerrainZoneData* pZone = popFinishedTerrainZones(pStreamer); pZone;)
+    {
+        TerrainZoneData* pNext = pZone->pNext;
+        freeTerrainZoneData(pZone);
+        pZone = pNext;
+    }
+
+    exitConditionVariable(&pStreamer->mWakeUp);
+    exitMutex(&pStreamer->mMutex);
+    tf_free(pStreamer->pRequests);
+    *pStreamer = {};
+}
+
+void requestTerrainZones(TerrainZoneStreamer* pStreamer, const TerrainZoneRequest* pRequests, uint32_t requestCount)
+{
+    acquireMutex(&pStreamer->mMutex);
+
+    if (requestCount > pStreamer->mRequestCapacity)
+    {
+        pStreamer->mRequestCapacity = requestCount;
+        pStreamer->pRequests = (TerrainZoneRequest*)tf_realloc(pStreamer->pRequests, requestCount * sizeof(TerrainZoneRequest));
+    }
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < requestCount; ++i)
+    {
+        const uint64_t key = getTerrainZoneKey(pRequests[i].mX, pRequests[i].mZ);
+        bool           skip = false;
+        for (uint32_t t = 0; t < pStreamer->mThreadCount && !skip; ++t)
+            skip = pStreamer->mBusy[t] && pStreamer->mKeysInFlight[t] == key;
+        if (!skip && !isTerrainZoneFinished(pStreamer, key))
+            pStreamer->pRequests[count++] = pRequests[i];
+    }
+
+    pStreamer->mRequestCount = count;
+    for (uint32_t i = count / 2; i-- > 0;)
+        siftDownTerrainZoneRequest(pStreamer->pRequests, count, i);
+
+    if (count)
+        wakeAllConditionVariable(&pStreamer->mWakeUp);
+    releaseMutex(&pStreamer->mMutex);
+}
+
+TerrainZoneData* popFinishedTerrainZones(TerrainZoneStreamer* pStreamer)
+{
+    // Taking the whole list at once means a zone can't be popped and pushed again in between, so there is no ABA problem
+    uintptr_t head;
+    do
+    {
+        head = tfrg_atomicptr_load_relaxed(&pStreamer->mFinished);
+    } while (head && tfrg_atomicptr_cas_relaxed(&pStreamer->mFinished, head, 0) != head);
+    tfrg_memorybarrier_acquire();
+    return (TerrainZoneData*)head;
+}
+
+void freeTerrainZoneData(TerrainZoneData* pZone)
+{
+    tf_free(pZone->pPosAndUVs);
+    tf_free(pZone);
+}
+
+void generateTerrainZone(const TerrainZoneStreamerDesc* pDesc, int32_t x, int32_t z, float* pOutPosAndUVs)
+{
+    const uint32_t gridSize = pDesc->mGridSize;
+    const int32_t  xInit = x * (int32_t)gridSize;
+    const int32_t  zInit = z * (int32_t)gridSize;
+    const float    gap = (float)gridSize / (float)(gridSize - 1);
+
+    float* pVertex = pOutPosAndUVs;
+    float  i = (float)xInit;
+    for (uint32_t xIndex = 0; xIndex < gridSize; ++xIndex)
+    {
+        float j = (float)zInit;
+        for (uint32_t zIndex = 0; zIndex < gridSize; ++zIndex)
+        {
+            pVertex[0] = i * pDesc->mScale;
+            pVertex[1] = Perlin::perlinNoise2D((i + pDesc->mNoiseOffset) * 0.125f, (j + pDesc->mNoiseOffset) * 0.125f) * pDesc->mScale;
+            pVertex[2] = j * pDesc->mScale;
+            pVertex[3] = (j - (float)zInit) / (float)gridSize;
+            pVertex[4] = (i - (float)xInit) / (float)gridSize;
+            pVertex += TERRAIN_ZONE_VERTEX_FLOATS;
+
+            j += gap;
+        }
+        i += gap;
+    }
+}
+
+static TerrainZone* findTerrainZone(TerrainZoneSet* pSet, int32_t x, int32_t z)
+{
+    for (uint32_t i = 0; i < pSet->mZoneCount; ++i)
+    {
+        if (pSet->pZones[i].mX == x && pSet->pZones[i].mZ == z)
+            return &pSet->pZones[i];
+    }
+    return NULL;
+}
+
+static void removeTerrainZone(TerrainZoneSet* pSet, uint32_t index)
+{
+    TerrainZone* pZone = &pSet->pZones[index];
+    if (pZone->mResident)
+    {
+        pSet->mDesc.pRemoveResource(pSet->mDesc.pUserData, pZone);
+        freeTerrainZoneData(pZone->pData);
+        --pSet->mResidentCount;
+    }
+    pSet->pZones[index] = pSet->pZones[--pSet->mZoneCount];
+}
+
+void initTerrainZoneSet(const TerrainZoneSetDesc* pDesc, TerrainZoneSet* pSet)
+{
+    ASSERT(pDesc->mZoneSize > 0.0f && pDesc->mPrefetchRadius >= 0);
+    ASSERT(pDesc->pAddResource && pDesc->pRemoveResource);
+
+    *pSet = {};
+    pSet->mDesc = *pDesc;
+
+    // Every zone around the camera can be missing at once
+    const uint32_t areaSize = 2 + 2 * (uint32_t)pDesc->mPrefetchRadius;
+    ASSERT(pDesc->mResidentBudget >= areaSize * areaSize);
+    pSet->mRequestCapacity = areaSize * areaSize;
+    pSet->pRequests = (TerrainZoneRequest*)tf_malloc(pSet->mRequestCapacity * sizeof(TerrainZoneRequest));
+}
+
+void exitTerrainZoneSet(TerrainZoneSet* pSet)
+{
+    while (pSet->mZoneCount)
+        removeTerrainZone(pSet, pSet->mZoneCount - 1);
+    tf_free(pSet->pZones);
+    tf_free(pSet->pRequests);
+    *pSet = {};
+}
+
+void updateTerrainZones(TerrainZoneSet* pSet, TerrainZoneStreamer* pStreamer, float cameraX, float cameraZ)
+{
+    const TerrainZoneSetDesc* pDesc = &pSet->mDesc;
+    const uint64_t            frame = ++pSet->mFrame;
+
+    const float movedX = cameraX - pSet->mLastCameraX;
+    const float movedZ = cameraZ - pSet->mLastCameraZ;
+    const float moved = sqrtf(movedX * movedX + movedZ * movedZ);
+    if (moved > 1e-3f)
+    {
+        pSet->mTravelX = movedX / moved;
+        pSet->mTravelZ = movedZ / moved;
+    }
+    pSet->mLastCameraX = cameraX;
+    pSet->mLastCameraZ = cameraZ;
+
+    // Zones the streamer finished become resident, the ones that were dropped in the meantime are thrown away
+    for (TerrainZoneData* pData = popFinishedTerrainZones(pStreamer); pData;)
+    {
+        TerrainZoneData* pNext = pData->pNext;
+        TerrainZone*     pZone = findTerrainZone(pSet, pData->mX, pData->mZ);
+        if (!pZone || pZone->mResident)
+        {
+            freeTerrainZoneData(pData);
+            ++pSet->mDroppedCount;
+        }
+        else
+        {
+            pZone->pData = pData;
+            pZone->mResident = true;
+            ++pSet->mResidentCount;
+            pDesc->pAddResource(pDesc->pUserData, pZone);
+        }
+        pData = pNext;
+    }
+
+    // The 2x2 zones closest to the camera are drawn, the ring of mPrefetchRadius around them is generated ahead of time
+    const int32_t minX = (int32_t)floorf(cameraX / pDesc->mZoneSize - 0.5f);
+    const int32_t minZ = (int32_t)floorf(cameraZ / pDesc->mZoneSize - 0.5f);
+    const int32_t radius = pDesc->mPrefetchRadius;
+
+    for (uint32_t i = 0; i < pSet->mZoneCount; ++i)
+        pSet->pZones[i].mVisible = false;
+
+    uint32_t requestCount = 0;
+    for (int32_t z = minZ - radius; z <= minZ + 1 + radius; ++z)
+    {
+        for (int32_t x = minX - radius; x <= minX + 1 + radius; ++x)
+        {
+            TerrainZone* pZone = findTerrainZone(pSet, x, z);
+            if (!pZone)
+            {
+                if (pSet->mZoneCount == pSet->mZoneCapacity)
+                {
+                    pSet->mZoneCapacity = pSet->mZoneCapacity ? pSet->mZoneCapacity * 2 : pDesc->mResidentBudget;
+                    pSet->pZones = (TerrainZone*)tf_realloc(pSet->pZones, pSet->mZoneCapacity * sizeof(TerrainZone));
+                }
+                pZone = &pSet->pZones[pSet->mZoneCount++];
+                *pZone = {};
+                pZone->mX = x;
+                pZone->mZ = z;
+            }
+
+            pZone->mVisible = x >= minX && x <= minX + 1 && z >= minZ && z <= minZ + 1;
+            pZone->mLastUsedFrame = frame;
+
+            if (!pZone->mResident)
+            {
+                TerrainZoneRequest* pRequest = &pSet->pRequests[requestCount++];
+                pRequest->mX = x;
+                pRequest->mZ = z;
+                const float         offsetX = ((float)x + 0.5f) * pDesc->mZoneSize - cameraX;
+                const float         offsetZ = ((float)z + 0.5f) * pDesc->mZoneSize - cameraZ;
+                pRequest->mPriority = getTerrainZonePriority(offsetX, offsetZ, pSet->mTravelX, pSet->mTravelZ);
+            }
+        }
+    }
+
+    // Zones that left the area before they were generated are forgotten, their requests are dropped below
+    for (uint32_t i = pSet->mZoneCount; i-- > 0;)
+    {
+        if (!pSet->pZones[i].mResident && pSet->pZones[i].mLastUsedFrame != frame)
+            removeTerrainZone(pSet, i);
+    }
+
+    // Least recently used first. The GPU can still read the resources of a zone drawn during the frames in flight.
+    while (pSet->mResidentCount > pDesc->mResidentBudget)
+    {
+        uint32_t evict = pSet->mZoneCount;
+        for (uint32_t i = 0; i < pSet->mZoneCount; ++i)
+        {
+            const TerrainZone& zone = pSet->pZones[i];
+            if (zone.mResident && zone.mLastUsedFrame + pDesc->mFramesInFlight < frame &&
+                (evict == pSet->mZoneCount || zone.mLastUsedFrame < pSet->pZones[evict].mLastUsedFrame))
+                evict = i;
+        }
+        if (evict == pSet->mZoneCount)
+            break;
+        removeTerrainZone(pSet, evict);
+    }
+
+    requestTerrainZones(pStreamer, pSet->pRequests, requestCount);
+}
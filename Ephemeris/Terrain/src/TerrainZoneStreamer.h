@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include <math.h>
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IThread.h"
+#include "../../../../The-Forge/Common_3/Utilities/Threading/Atomics.h"
+
+// Generates the vertices of procedural terrain zones on worker threads, nearest zones in the direction of travel first.
+// The render thread only hands out requests and takes finished zones, it never waits for a zone to be generated.
+
+#define TERRAIN_ZONE_MAX_THREADS 4
+// Floats per zone vertex: position followed by uv
+#define TERRAIN_ZONE_VERTEX_FLOATS 5
+
+// Zone (x, z) covers [x, x + 1) * gridSize * scale along the world x axis and the same along z
+static inline uint64_t getTerrainZoneKey(int32_t x, int32_t z) { return ((uint64_t)(uint32_t)z << 32) | (uint64_t)(uint32_t)x; }
+
+struct TerrainZoneRequest
+{
+    int32_t mX;
+    int32_t mZ;
+    // Lower is generated first, see getTerrainZonePriority
+    float   mPriority;
+};
+
+// Vertices of a zone, handed from the workers to the render thread
+struct TerrainZoneData
+{
+    // Next finished zone, see popFinishedTerrainZones
+    TerrainZoneData* pNext;
+    int32_t          mX;
+    int32_t          mZ;
+    // gridSize * gridSize vertices of TERRAIN_ZONE_VERTEX_FLOATS
+    float*           pPosAndUVs;
+};
+
+struct TerrainZoneStreamerDesc
+{
+    // Vertices along the edge of a zone
+    uint32_t mGridSize;
+    // World units per grid cell and height of the noise
+    float    mScale;
+    // Added to the grid coordinates before sampling the noise
+    float    mNoiseOffset;
+    // 0 uses every CPU core but the render thread, up to TERRAIN_ZONE_MAX_THREADS
+    uint32_t mThreadCount;
+};
+
+struct TerrainZoneStreamer;
+
+struct TerrainZoneWorker
+{
+    TerrainZoneStreamer* pStreamer;
+    uint32_t             mIndex;
+    ThreadHandle         mThread;
+};
+
+struct TerrainZoneStreamer
+{
+    TerrainZoneStreamerDesc mDesc;
+    uint32_t                mThreadCount;
+    TerrainZoneWorker       mWorkers[TERRAIN_ZONE_MAX_THREADS];
+
+    // Guards the request heap, the zones in flight and mQuit
+    Mutex                   mMutex;
+    ConditionVariable       mWakeUp;
+    // Binary min heap on mPriority
+    TerrainZoneRequest*     pRequests;
+    uint32_t                mRequestCount;
+    uint32_t                mRequestCapacity;
+    // Key of the zone every worker is generating, valid when mBusy is set
+    uint64_t                mKeysInFlight[TERRAIN_ZONE_MAX_THREADS];
+    bool                    mBusy[TERRAIN_ZONE_MAX_THREADS];
+    bool                    mQuit;
+
+    // Lock free list of finished zones, pushed by the workers and emptied by the render thread
+    tfrg_atomicptr_t        mFinished;
+};
+
+void initTerrainZoneStreamer(const TerrainZoneStreamerDesc* pDesc, TerrainZoneStreamer* pStreamer);
+// Stops the workers after the zones they are generating and frees every zone that was not taken
+void exitTerrainZoneStreamer(TerrainZoneStreamer* pStreamer);
+
+// Lower for zones closer to the camera, zones ahead along the normalized travel direction win over zones as far behind it.
+// The offset is from the camera to the zone center in world units.
+static inline float getTerrainZonePriority(float offsetX, float offsetZ, float travelX, float travelZ)
+{
+    return sqrtf(offsetX * offsetX + offsetZ * offsetZ) - 0.5f * (offsetX * travelX + offsetZ * travelZ);
+}
+
+// Replaces the pending requests, so zones that are not requested anymore are dropped before they are generated.
+// Zones that are being generated or finished but not taken yet are skipped. Only locks against the workers taking a request.
+void requestTerrainZones(TerrainZoneStreamer* pStreamer, const TerrainZoneRequest* pRequests, uint32_t requestCount);
+
+// Takes every zone finished since the last call, linked through pNext. Lock free, call from one thread only.
+TerrainZoneData* popFinishedTerrainZones(TerrainZoneStreamer* pStreamer);
+void             freeTerrainZoneData(TerrainZoneData* pZone);
+
+// The vertices the workers write for zone (x, z), pOutPosAndUVs has room for gridSize * gridSize vertices
+void generateTerrainZone(const TerrainZoneStreamerDesc* pDesc, int32_t x, int32_t z, float* pOutPosAndUVs);
+
+// Zones around the camera on the render thread: which ones are drawn, which ones to request from the streamer and which resident
+// ones to evict. Renderer free, resources of a zone are created and removed through the callbacks.
+
+// Zones move around pZones as others are forgotten, keep pData or pResource rather than the address of a zone.
+
+struct TerrainZone
+{
+    // Zone coordinates, see getTerrainZoneKey
+    int32_t          mX;
+    int32_t          mZ;
+    // One of the zones closest to the camera, see updateTerrainZones
+    bool             mVisible;
+    // Set once the vertices came back from the streamer
+    bool             mResident;
+    // Last frame the zone was around the camera
+    uint64_t         mLastUsedFrame;
+    // Vertices of a resident zone
+    TerrainZoneData* pData;
+    // Renderer resources of a resident zone, the vertex buffer in Terrain
+    void*            pResource;
+};
+
+typedef void (*TerrainZoneFunc)(void* pUserData, TerrainZone* pZone);
+
+struct TerrainZoneSetDesc
+{
+    // World units along the edge of a zone
+    float           mZoneSize;
+    // Zones generated ahead of being visible around the 2x2 visible ones
+    int32_t         mPrefetchRadius;
+    // Resident zones kept for when the camera comes back, has to hold the (2 + 2 * mPrefetchRadius)^2 zones around the camera
+    uint32_t        mResidentBudget;
+    // Frames the GPU can still read the resources of a zone after it was drawn, those zones are not evicted
+    uint32_t        mFramesInFlight;
+    // Called when the vertices of a zone arrive and before a resident zone is evicted
+    TerrainZoneFunc pAddResource;
+    TerrainZoneFunc pRemoveResource;
+    void*           pUserData;
+};
+
+struct TerrainZoneSet
+{
+    TerrainZoneSetDesc  mDesc;
+    TerrainZone*        pZones;
+    uint32_t            mZoneCount;
+    uint32_t            mZoneCapacity;
+    uint32_t            mResidentCount;
+    TerrainZoneRequest* pRequests;
+    uint32_t            mRequestCapacity;
+    uint64_t            mFrame;
+    float               mLastCameraX;
+    float               mLastCameraZ;
+    // Normalized direction the camera last moved in on the ground plane
+    float               mTravelX;
+    float               mTravelZ;
+    // Finished zones that left the area before they arrived, they are freed without becoming resident
+    uint32_t            mDroppedCount;
+};
+
+void initTerrainZoneSet(const TerrainZoneSetDesc* pDesc, TerrainZoneSet* pSet);
+// Removes the resources of every resident zone
+void exitTerrainZoneSet(TerrainZoneSet* pSet);
+
+// Once per frame: takes the zones the streamer finished, requests the missing ones around the camera and evicts the least
+// recently used resident zones over the budget. Never waits for a zone to be generated.
+void updateTerrainZones(TerrainZoneSet* pSet, TerrainZoneStreamer* pStreamer, float cameraX, float cameraZ);
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "Visibility.h"
+
+static const uint32_t FRUSTUM_PLANE_COUNT = 6;
+static const uint32_t ALL_PLANES_INSIDE = (1u << FRUSTUM_PLANE_COUNT) - 1;
+// Relative margin on the squared horizon distance, covers the rounding of the dot products at planet scale
+static const float    HORIZON_EPSILON = 1e-3f;
+
+bool boxIntersects(const TerrainFrustum& frustum, const TerrainBoundingBox& box)
+{
+    const Plane*   planes = frustum.CPlanes.planes;
+    const Plane*   currPlane;
+    const Vector3* currNormal;
+    Vector3        maxPoint;
+
+    for (int planeIdx = 0; planeIdx < 6; planeIdx++)
+    {
+        currPlane = planes + planeIdx;
+        currNormal = &currPlane->normal;
+
+        maxPoint.setX((currNormal->getX() > 0) ? box.max.x : box.min.x);
+        maxPoint.setY((currNormal->getY() > 0) ? box.max.y : box.min.y);
+        maxPoint.setZ((currNormal->getZ() > 0) ? box.max.z : box.min.z);
+
+        float dMax = dot(maxPoint, *currNormal) + currPlane->distance;
+
+        if (dMax < 0)
+            return false;
+    }
+    return true;
+}
+
+void getFrustumFromMatrix(const mat4& matrix, TerrainFrustum& frustum)
+{
+    // Left clipping plane
+    frustum.iPlanes.left.normal.setX(matrix[0][3] + matrix[0][0]);
+    frustum.iPlanes.left.normal.setY(matrix[1][3] + matrix[1][0]);
+    frustum.iPlanes.left.normal.setZ(matrix[2][3] + matrix[2][0]);
+    frustum.iPlanes.left.distance = matrix[3][3] + matrix[3][0];
+
+    // Right clipping plane
+    frustum.iPlanes.right.normal.setX(matrix[0][3] - matrix[0][0]);
+    frustum.iPlanes.right.normal.setY(matrix[1][3] - matrix[1][0]);
+    frustum.iPlanes.right.normal.setZ(matrix[2][3] - matrix[2][0]);
+    frustum.iPlanes.right.distance = matrix[3][3] - matrix[3][0];
+
+    // Top clipping plane
+    frustum.iPlanes.top.normal.setX(matrix[0][3] - matrix[0][1]);
+    frustum.iPlanes.top.normal.setY(matrix[1][3] - matrix[1][1]);
+    frustum.iPlanes.top.normal.setZ(matrix[2][3] - matrix[2][1]);
+    frustum.iPlanes.top.distance = matrix[3][3] - matrix[3][1];
+
+    // Bottom clipping plane
+    frustum.iPlanes.bottom.normal.setX(matrix[0][3] + matrix[0][1]);
+    frustum.iPlanes.bottom.normal.setY(matrix[1][3] + matrix[1][1]);
+    frustum.iPlanes.bottom.normal.setZ(matrix[2][3] + matrix[2][1]);
+    frustum.iPlanes.bottom.distance = matrix[3][3] + matrix[3][1];
+
+    // Near clipping plane
+    frustum.iPlanes.front.normal.setX(matrix[0][2]);
+    frustum.iPlanes.front.normal.setY(matrix[1][2]);
+    frustum.iPlanes.front.normal.setZ(matrix[2][2]);
+    frustum.iPlanes.front.distance = matrix[3][2];
+
+    // Far clipping plane
+    frustum.iPlanes.back.normal.setX(matrix[0][3] - matrix[0][2]);
+    frustum.iPlanes.back.normal.setY(matrix[1][3] - matrix[1][2]);
+    frustum.iPlanes.back.normal.setZ(matrix[2][3] - matrix[2][2]);
+    frustum.iPlanes.back.distance = matrix[3][3] - matrix[3][2];
+}
+
+void getTerrainHorizon(const vec3& cameraPos, const vec3& planetCenter, float planetRadius, TerrainHorizon& horizon)
+{
+    horizon.cameraPos = cameraPos;
+    horizon.centerToCamera = cameraPos - planetCenter;
+
+    const float horizonDistanceSq = lengthSqr(horizon.centerToCamera) - planetRadius * planetRadius;
+    horizon.horizonDistanceSq = horizonDistanceSq * (1.0f + HORIZON_EPSILON);
+    horizon.enabled = horizonDistanceSq > 0.0f && cameraPos.getY() >= planetCenter.getY();
+}
+
+enum HorizonTest
+{
+    HORIZON_VISIBLE = 0,
+    HORIZON_CROSSING,
+    HORIZON_HIDDEN,
+};
+
+// With V the camera relative to the planet center, a point P is behind the horizon plane when dot(V, camera - P) exceeds the squared
+// horizon distance, and inside the cone when dot(V, camera - P)^2 exceeds it times |camera - P|^2. Both regions are convex, so a box is
+// hidden when all of its corners are. Like the p-vertex test of the frustum, the corners with the largest and smallest dot product
+// tell whether the box is entirely behind or in front of the horizon plane.
+static HorizonTest testBoxHorizon(const TerrainHorizon& horizon, const TerrainBoundingBox& box)
+{
+    const vec3& v = horizon.centerToCamera;
+    const vec3  toMin = horizon.cameraPos - f3Tov3(box.min);
+    const vec3  toMax = horizon.cameraPos - f3Tov3(box.max);
+
+    // Corners the furthest behind and in front of the horizon plane
+    const vec3 lowest((v.getX() > 0) ? toMin.getX() : toMax.getX(), (v.getY() > 0) ? toMin.getY() : toMax.getY(),
+                      (v.getZ() > 0) ? toMin.getZ() : toMax.getZ());
+    const vec3 highest((v.getX() > 0) ? toMax.getX() : toMin.getX(), (v.getY() > 0) ? toMax.getY() : toMin.getY(),
+                       (v.getZ() > 0) ? toMax.getZ() : toMin.getZ());
+    if (dot(v, lowest) <= horizon.horizonDistanceSq)
+        return HORIZON_VISIBLE;
+    if (dot(v, highest) <= horizon.horizonDistanceSq)
+        return HORIZON_CROSSING;
+
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const vec3  toCamera((corner & 1) ? toMax.getX() : toMin.getX(), (corner & 2) ? toMax.getY() : toMin.getY(),
+                            (corner & 4) ? toMax.getZ() : toMin.getZ());
+        const float projection = dot(v, toCamera);
+        if (projection * projection <= horizon.horizonDistanceSq * lengthSqr(toCamera))
+            return HORIZON_CROSSING;
+    }
+    return HORIZON_HIDDEN;
+}
+
+bool isBoxBelowHorizon(const TerrainHorizon& horizon, const TerrainBoundingBox& box)
+{
+    return horizon.enabled && testBoxHorizon(horizon, box) == HORIZON_HIDDEN;
+}
+
+struct TerrainCullContext
+{
+    const TerrainSegmentNode* nodes;
+    const TerrainFrustum*     frustum;
+    const TerrainHorizon*     horizon;
+    TerrainSegmentRun*        runs;
+    uint32_t                  runCount;
+};
+
+static void addVisibleSegments(TerrainCullContext& context, uint32_t firstSegment, uint32_t segmentCount)
+{
+    if (context.runCount)
+    {
+        TerrainSegmentRun& lastRun = context.runs[context.runCount - 1];
+        if (lastRun.firstSegment + lastRun.segmentCount == firstSegment)
+        {
+            lastRun.segmentCount += segmentCount;
+            return;
+        }
+    }
+
+    context.runs[context.runCount++] = { firstSegment, segmentCount };
+}
+
+// insideMask has a bit for every frustum plane the parent is entirely inside of, children don't test these planes again.
+// testHorizon turns false below nodes that are entirely in front of the horizon plane.
+static void cullTerrainNode(TerrainCullContext& context, uint32_t nodeIndex, uint32_t insideMask, bool testHorizon)
+{
+    const TerrainSegmentNode& node = context.nodes[nodeIndex];
+    const TerrainBoundingBox& box = node.boundingBox;
+    const Plane*              planes = context.frustum->CPlanes.planes;
+
+    for (uint32_t planeIdx = 0; planeIdx < FRUSTUM_PLANE_COUNT; ++planeIdx)
+    {
+        if (insideMask & (1u << planeIdx))
+            continue;
+
+        const Vector3& normal = planes[planeIdx].normal;
+        const Vector3  maxPoint((normal.getX() > 0) ? box.max.x : box.min.x, (normal.getY() > 0) ? box.max.y : box.min.y,
+                               (normal.getZ() > 0) ? box.max.z : box.min.z);
+        if (dot(maxPoint, normal) + planes[planeIdx].distance < 0)
+            return;
+
+        const Vector3 minPoint((normal.getX() > 0) ? box.min.x : box.max.x, (normal.getY() > 0) ? box.min.y : box.max.y,
+                               (normal.getZ() > 0) ? box.min.z : box.max.z);
+        if (dot(minPoint, normal) + planes[planeIdx].distance >= 0)
+            insideMask |= 1u << planeIdx;
+    }
+
+    if (testHorizon)
+    {
+        const HorizonTest horizonTest = testBoxHorizon(*context.horizon, box);
+        if (horizonTest == HORIZON_HIDDEN)
+            return;
+        testHorizon = horizonTest == HORIZON_CROSSING;
+    }
+
+    if (!node.childCount || (insideMask == ALL_PLANES_INSIDE && !testHorizon))
+    {
+        addVisibleSegments(context, node.firstSegment, node.segmentCount);
+        return;
+    }
+
+    for (uint32_t child = 0; child < node.childCount; ++child)
+        cullTerrainNode(context, node.firstChild + child, insideMask, testHorizon);
+}
+
+uint32_t cullTerrainSegments(const TerrainSegmentNode* nodes, const TerrainFrustum& frustum, const TerrainHorizon* horizon,
+                             TerrainSegmentRun* outRuns)
+{
+    TerrainCullContext context = { nodes, &frustum, horizon, outRuns, 0 };
+    cullTerrainNode(context, 0, 0, horizon && horizon->enabled);
+    return context.runCount;
+}
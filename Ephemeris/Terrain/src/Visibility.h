@@ -42,3 +42,49 @@ struct TerrainFrustum
         Planes          CPlanes;
     };
 };
+
+// Node of the bounding volume hierarchy over the mesh segments of a hemisphere. A node covers a contiguous range of segments, so the
+// segments of a node that is entirely visible are drawn with one range of the packed index buffer.
+struct TerrainSegmentNode
+{
+    TerrainBoundingBox boundingBox;
+    uint32_t           firstSegment;
+    uint32_t           segmentCount;
+    // Children are the childCount nodes from firstChild, leaves have none and a single segment
+    uint32_t           firstChild;
+    uint32_t           childCount;
+};
+
+// Visible segments [firstSegment, firstSegment + segmentCount)
+struct TerrainSegmentRun
+{
+    uint32_t firstSegment;
+    uint32_t segmentCount;
+};
+
+// Horizon of the planet sphere seen from the camera. Points inside the cone from the camera around the sphere and behind the plane of
+// the horizon circle are hidden by the sphere.
+struct TerrainHorizon
+{
+    vec3  cameraPos;
+    // Camera position relative to the planet center
+    vec3  centerToCamera;
+    // Squared distance from the camera to the horizon circle, slightly enlarged to stay conservative with float precision
+    float horizonDistanceSq;
+    bool  enabled;
+};
+
+void getFrustumFromMatrix(const mat4& matrix, TerrainFrustum& frustum);
+bool boxIntersects(const TerrainFrustum& frustum, const TerrainBoundingBox& box);
+
+// planetRadius must not exceed the lowest point of the terrain. Horizon culling is disabled when the camera is inside the sphere or
+// below planetCenter.y, the terrain hemisphere doesn't cover the lower half of the planet that could be seen from there.
+void getTerrainHorizon(const vec3& cameraPos, const vec3& planetCenter, float planetRadius, TerrainHorizon& horizon);
+// True when the sphere hides the whole box
+bool isBoxBelowHorizon(const TerrainHorizon& horizon, const TerrainBoundingBox& box);
+
+// Walks the hierarchy from the root and writes the visible segments in increasing order to outRuns, adjacent segments merged into one
+// run. outRuns needs room for a run per segment. The result matches testing every segment with boxIntersects and, when horizon isn't
+// NULL, isBoxBelowHorizon. Returns the run count.
+uint32_t cullTerrainSegments(const TerrainSegmentNode* nodes, const TerrainFrustum& frustum, const TerrainHorizon* horizon,
+                             TerrainSegmentRun* outRuns);
@@ -0,0 +1,535 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "CloudNoiseLoader.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
+
+#include "../../src/ParallelFor.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
+
+#define DDS_MAGIC               0x20534444 // "DDS "
+#define DDS_HEADER_SIZE         128        // Magic and DDS_HEADER
+#define DDS_PIXEL_FORMAT_RGB    0x40
+#define DDS_PIXEL_FORMAT_FOURCC 0x4
+#define DDS_MIP_MAP_COUNT       0x20000
+
+#define KTX_HEADER_SIZE       64
+#define KTX_ENDIANNESS        0x04030201
+#define KTX_GL_UNSIGNED_BYTE  0x1401
+#define KTX_GL_RGBA           0x1908
+#define KTX_GL_BGRA           0x80E1
+
+static const uint8_t KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// Mips of an uncompressed 8 bit texture and the byte of every RGBA channel inside a texel
+struct CloudNoiseSlice
+{
+    // Top mip, the next one follows after levelHeaderSize bytes
+    const uint8_t* pTexels;
+    uint32_t       width;
+    uint32_t       height;
+    uint32_t       mipCount;
+    uint32_t       levelHeaderSize;
+    // 4 means the channel isn't stored and reads as 1.0 like it does on the GPU
+    uint32_t       channelBytes[CLOUD_NOISE_CHANNEL_COUNT];
+};
+
+struct CloudNoiseSliceContext
+{
+    const char*       sliceNameFormat;
+    CloudNoiseVolume* pVolume;
+    uint16_t          unormToHalf[256];
+    tfrg_atomic32_t   failedSlices;
+};
+
+struct CloudNoiseMipContext
+{
+    const uint16_t* pSrc;
+    uint16_t*       pDst;
+    uint32_t        dstSize;
+};
+
+static inline uint32_t readUInt32(const uint8_t* pData)
+{
+    uint32_t value;
+    memcpy(&value, pData, sizeof(value));
+    return value;
+}
+
+// Round to nearest even like the GPU does when it stores to a half texture
+static uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7FFFFFFF;
+    const uint32_t exponent = magnitude >> 23;
+
+    if (magnitude > 0x7F800000)
+        return (uint16_t)(sign | 0x7E00);
+    if (exponent >= 143)
+        return (uint16_t)(sign | 0x7C00);
+
+    if (exponent < 113)
+    {
+        // Denormal half, the rounding may carry into the smallest normal
+        if (exponent < 102)
+            return sign;
+        const uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+        const uint32_t shift = 126 - exponent;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        uint32_t       result = mantissa >> shift;
+        result += (remainder > halfway || (remainder == halfway && (result & 1))) ? 1 : 0;
+        return (uint16_t)(sign | result);
+    }
+
+    const uint32_t remainder = magnitude & 0x1FFF;
+    uint32_t       result = (magnitude - (112u << 23)) >> 13;
+    result += (remainder > 0x1000 || (remainder == 0x1000 && (result & 1))) ? 1 : 0;
+    return (uint16_t)(sign | result);
+}
+
+float cloudNoiseHalfToFloat(uint16_t value)
+{
+    const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0x1F)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else
+    {
+        // Denormals are exact in float
+        const float denormal = (float)mantissa * (1.0f / 16777216.0f);
+        memcpy(&bits, &denormal, sizeof(bits));
+        bits |= sign;
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+static bool getChannelByte(uint32_t mask, uint32_t* pOutByte)
+{
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        if (mask == (0xFFu << (i * 8)))
+        {
+            *pOutByte = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseDDSSlice(const uint8_t* pData, size_t size, CloudNoiseSlice* pSlice)
+{
+    if (size < DDS_HEADER_SIZE || readUInt32(pData) != DDS_MAGIC)
+        return false;
+
+    // DDS_PIXELFORMAT starts at 76 bytes into the file
+    const uint32_t pixelFormatFlags = readUInt32(pData + 80);
+    const uint32_t bitCount = readUInt32(pData + 88);
+    if (!(pixelFormatFlags & DDS_PIXEL_FORMAT_RGB) || (pixelFormatFlags & DDS_PIXEL_FORMAT_FOURCC) || bitCount != 32)
+        return false;
+
+    const uint32_t alphaMask = readUInt32(pData + 104);
+    pSlice->channelBytes[3] = 4;
+    if (!getChannelByte(readUInt32(pData + 92), &pSlice->channelBytes[0]) ||
+        !getChannelByte(readUInt32(pData + 96), &pSlice->channelBytes[1]) ||
+        !getChannelByte(readUInt32(pData + 100), &pSlice->channelBytes[2]) ||
+        (alphaMask && !getChannelByte(alphaMask, &pSlice->channelBytes[3])))
+        return false;
+
+    pSlice->height = readUInt32(pData + 12);
+    pSlice->width = readUInt32(pData + 16);
+    pSlice->mipCount = (readUInt32(pData + 8) & DDS_MIP_MAP_COUNT) ? readUInt32(pData + 28) : 1;
+    pSlice->mipCount = pSlice->mipCount ? pSlice->mipCount : 1;
+    pSlice->levelHeaderSize = 0;
+    pSlice->pTexels = pData + DDS_HEADER_SIZE;
+    return size >= DDS_HEADER_SIZE + (size_t)pSlice->width * pSlice->height * 4;
+}
+
+static bool parseKTXSlice(const uint8_t* pData, size_t size, CloudNoiseSlice* pSlice)
+{
+    if (size < KTX_HEADER_SIZE || memcmp(pData, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 ||
+        readUInt32(pData + 12) != KTX_ENDIANNESS || readUInt32(pData + 16) != KTX_GL_UNSIGNED_BYTE)
+        return false;
+
+    const uint32_t glFormat = readUInt32(pData + 24);
+    if (glFormat == KTX_GL_RGBA)
+    {
+        const uint32_t rgba[CLOUD_NOISE_CHANNEL_COUNT] = { 0, 1, 2, 3 };
+        memcpy(pSlice->channelBytes, rgba, sizeof(rgba));
+    }
+    else if (glFormat == KTX_GL_BGRA)
+    {
+        const uint32_t bgra[CLOUD_NOISE_CHANNEL_COUNT] = { 2, 1, 0, 3 };
+        memcpy(pSlice->channelBytes, bgra, sizeof(bgra));
+    }
+    else
+    {
+        return false;
+    }
+
+    pSlice->width = readUInt32(pData + 36);
+    pSlice->height = readUInt32(pData + 40);
+    pSlice->mipCount = readUInt32(pData + 56) ? readUInt32(pData + 56) : 1;
+    // Every level starts with its size, RGBA8 rows never need padding
+    pSlice->levelHeaderSize = sizeof(uint32_t);
+    // The first image size follows the key/value data
+    const size_t imageOffset = (size_t)KTX_HEADER_SIZE + readUInt32(pData + 60) + sizeof(uint32_t);
+    pSlice->pTexels = pData + imageOffset;
+    return size >= imageOffset + (size_t)pSlice->width * pSlice->height * 4;
+}
+
+// Reads a whole texture from RD_TEXTURES and finds its mips
+static uint8_t* readCloudNoiseTexture(const char* fileName, CloudNoiseSlice* pSlice, size_t* pOutSize)
+{
+    FileStream fh = {};
+    if (!fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_READ, &fh))
+    {
+        LOGF(LogLevel::eWARNING, "Cloud noise texture %s not found", fileName);
+        return NULL;
+    }
+
+    const size_t size = (size_t)fsGetStreamFileSize(&fh);
+    uint8_t*     pData = (uint8_t*)tf_malloc(size);
+    bool         valid = fsReadFromStream(&fh, pData, size) == size;
+    fsCloseStream(&fh);
+
+    valid = valid && (parseDDSSlice(pData, size, pSlice) || parseKTXSlice(pData, size, pSlice));
+    if (!valid)
+    {
+        LOGF(LogLevel::eWARNING, "Cloud noise texture %s isn't an uncompressed RGBA8 texture", fileName);
+        tf_free(pData);
+        return NULL;
+    }
+    *pOutSize = size;
+    return pData;
+}
+
+static bool decodeCloudNoiseSlice(CloudNoiseSliceContext* pContext, uint32_t z)
+{
+    char fileName[FS_MAX_PATH] = {};
+    snprintf(fileName, sizeof(fileName), pContext->sliceNameFormat, z);
+
+    const uint32_t  dimension = pContext->pVolume->mDimension;
+    CloudNoiseSlice slice = {};
+    size_t          size = 0;
+    uint8_t*        pData = readCloudNoiseTexture(fileName, &slice, &size);
+    if (!pData)
+        return false;
+
+    if (slice.width != dimension || slice.height != dimension)
+    {
+        LOGF(LogLevel::eWARNING, "Cloud noise slice %s isn't %ux%u", fileName, dimension, dimension);
+        tf_free(pData);
+        return false;
+    }
+
+    // The slice is written straight into its place in the top mip
+    const uint32_t texelCount = dimension * dimension;
+    uint16_t*      pDst = pContext->pVolume->pVoxels + (uint64_t)z * texelCount * CLOUD_NOISE_CHANNEL_COUNT;
+    for (uint32_t i = 0; i < texelCount; ++i)
+    {
+        const uint8_t* pTexel = slice.pTexels + i * 4;
+        for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+        {
+            const uint32_t byteIndex = slice.channelBytes[c];
+            pDst[i * CLOUD_NOISE_CHANNEL_COUNT + c] = pContext->unormToHalf[byteIndex < 4 ? pTexel[byteIndex] : 255];
+        }
+    }
+
+    tf_free(pData);
+    return true;
+}
+
+static void decodeCloudNoiseSliceTask(void* pUserData, uint32_t z)
+{
+    CloudNoiseSliceContext* pContext = (CloudNoiseSliceContext*)pUserData;
+    if (!decodeCloudNoiseSlice(pContext, z))
+        tfrg_atomic32_add_relaxed(&pContext->failedSlices, 1);
+}
+
+// One slice of a mip, same sum order as Gen3DtexMipmap
+static void buildCloudNoiseMipTask(void* pUserData, uint32_t z)
+{
+    const CloudNoiseMipContext* pContext = (const CloudNoiseMipContext*)pUserData;
+    const uint32_t              dstSize = pContext->dstSize;
+    const uint32_t              srcSize = dstSize * 2;
+
+    for (uint32_t y = 0; y < dstSize; ++y)
+    {
+        for (uint32_t x = 0; x < dstSize; ++x)
+        {
+            float result[CLOUD_NOISE_CHANNEL_COUNT] = {};
+            for (uint32_t dx = 0; dx < 2; ++dx)
+            {
+                for (uint32_t dy = 0; dy < 2; ++dy)
+                {
+                    for (uint32_t dz = 0; dz < 2; ++dz)
+                    {
+                        const uint64_t  srcVoxel = ((uint64_t)(z * 2 + dz) * srcSize + (y * 2 + dy)) * srcSize + (x * 2 + dx);
+                        const uint16_t* pSrc = pContext->pSrc + srcVoxel * CLOUD_NOISE_CHANNEL_COUNT;
+                        for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+                            result[c] += cloudNoiseHalfToFloat(pSrc[c]);
+                    }
+                }
+            }
+
+            uint16_t* pDst = pContext->pDst + (((uint64_t)z * dstSize + y) * dstSize + x) * CLOUD_NOISE_CHANNEL_COUNT;
+            for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+                pDst[c] = floatToHalf(result[c] / (2 * 2 * 2));
+        }
+    }
+}
+
+uint64_t getCloudNoiseMipOffset(uint32_t dimension, uint32_t mip)
+{
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < mip; ++i)
+    {
+        const uint64_t size = dimension >> i;
+        offset += size * size * size * CLOUD_NOISE_CHANNEL_COUNT;
+    }
+    return offset;
+}
+
+uint32_t getCloudNoiseMipCount(uint32_t dimension)
+{
+    uint32_t mipCount = 1;
+    while ((dimension >> mipCount) != 0)
+        ++mipCount;
+    return mipCount;
+}
+
+static void initCloudNoiseVolume(uint32_t dimension, CloudNoiseVolume* pVolume)
+{
+    pVolume->mDimension = dimension;
+    pVolume->mMipCount = getCloudNoiseMipCount(dimension);
+    pVolume->pVoxels = (uint16_t*)tf_malloc(getCloudNoiseMipOffset(dimension, pVolume->mMipCount) * sizeof(uint16_t));
+}
+
+void exitCloudNoiseVolume(CloudNoiseVolume* pVolume)
+{
+    tf_free(pVolume->pVoxels);
+    *pVolume = {};
+}
+
+bool loadCloudNoiseImage(const char* fileName, CloudNoiseImage* pOutImage)
+{
+    CloudNoiseSlice slice = {};
+    size_t          size = 0;
+    uint8_t*        pData = readCloudNoiseTexture(fileName, &slice, &size);
+    if (!pData)
+        return false;
+
+    pOutImage->mWidth = slice.width;
+    pOutImage->mHeight = slice.height;
+    pOutImage->mMipCount = slice.mipCount;
+
+    // Only the mips stored in the file are used, like on the GPU
+    const uint64_t texelCount = getCloudNoiseImageMipOffset(pOutImage, slice.mipCount) / CLOUD_NOISE_CHANNEL_COUNT;
+    if ((size_t)(slice.pTexels - pData) + texelCount * 4 + (slice.mipCount - 1) * slice.levelHeaderSize > size)
+    {
+        LOGF(LogLevel::eWARNING, "Cloud noise texture %s is missing mips", fileName);
+        tf_free(pData);
+        *pOutImage = {};
+        return false;
+    }
+
+    pOutImage->pTexels = (float*)tf_malloc(texelCount * CLOUD_NOISE_CHANNEL_COUNT * sizeof(float));
+    const uint8_t* pLevel = slice.pTexels;
+    float*         pDst = pOutImage->pTexels;
+    for (uint32_t mip = 0; mip < slice.mipCount; ++mip)
+    {
+        const uint32_t levelTexelCount = getCloudNoiseImageMipSize(slice.width, mip) * getCloudNoiseImageMipSize(slice.height, mip);
+        for (uint32_t i = 0; i < levelTexelCount; ++i, pDst += CLOUD_NOISE_CHANNEL_COUNT)
+        {
+            for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+                pDst[c] = slice.channelBytes[c] < 4 ? (float)pLevel[i * 4 + slice.channelBytes[c]] / 255.0f : 1.0f;
+        }
+        pLevel += levelTexelCount * 4 + slice.levelHeaderSize;
+    }
+
+    tf_free(pData);
+    return true;
+}
+
+void exitCloudNoiseImage(CloudNoiseImage* pImage)
+{
+    tf_free(pImage->pTexels);
+    *pImage = {};
+}
+
+uint64_t getCloudNoiseImageMipOffset(const CloudNoiseImage* pImage, uint32_t mip)
+{
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < mip; ++i)
+        offset += (uint64_t)getCloudNoiseImageMipSize(pImage->mWidth, i) * getCloudNoiseImageMipSize(pImage->mHeight, i);
+    return offset * CLOUD_NOISE_CHANNEL_COUNT;
+}
+
+bool loadCloudNoiseSlices(const char* sliceNameFormat, uint32_t dimension, uint32_t threadCount, CloudNoiseVolume* pOutVolume)
+{
+    ASSERT(dimension && !(dimension & (dimension - 1)));
+    initCloudNoiseVolume(dimension, pOutVolume);
+
+    CloudNoiseSliceContext sliceContext = {};
+    sliceContext.sliceNameFormat = sliceNameFormat;
+    sliceContext.pVolume = pOutVolume;
+    for (uint32_t i = 0; i < 256; ++i)
+        sliceContext.unormToHalf[i] = floatToHalf((float)i / 255.0f);
+    parallelFor(decodeCloudNoiseSliceTask, &sliceContext, dimension, threadCount);
+
+    if (tfrg_atomic32_load_relaxed(&sliceContext.failedSlices))
+    {
+        exitCloudNoiseVolume(pOutVolume);
+        return false;
+    }
+
+    for (uint32_t mip = 1; mip < pOutVolume->mMipCount; ++mip)
+    {
+        CloudNoiseMipContext mipContext = {};
+        mipContext.pSrc = pOutVolume->pVoxels + getCloudNoiseMipOffset(dimension, mip - 1);
+        mipContext.pDst = pOutVolume->pVoxels + getCloudNoiseMipOffset(dimension, mip);
+        mipContext.dstSize = dimension >> mip;
+        parallelFor(buildCloudNoiseMipTask, &mipContext, mipContext.dstSize, threadCount);
+    }
+
+    return true;
+}
+
+static void getCloudNoiseFileHeader(uint32_t dimension, CloudNoiseFileHeader* pHeader)
+{
+    memset(pHeader, 0, sizeof(*pHeader));
+    pHeader->magic = CLOUD_NOISE_FILE_MAGIC;
+    pHeader->version = CLOUD_NOISE_FILE_VERSION;
+    pHeader->dimension = dimension;
+    pHeader->mipCount = getCloudNoiseMipCount(dimension);
+}
+
+bool loadPackedCloudNoise(ResourceDirectory resourceDir, const char* fileName, uint32_t dimension, CloudNoiseVolume* pOutVolume)
+{
+    FileStream fh = {};
+    if (!fsOpenStreamFromPath(resourceDir, fileName, FM_READ, &fh))
+        return false;
+
+    CloudNoiseFileHeader header = {};
+    CloudNoiseFileHeader expected = {};
+    bool                 valid = fsReadFromStream(&fh, &header, sizeof(header)) == sizeof(header);
+    getCloudNoiseFileHeader(dimension, &expected);
+    valid = valid && memcmp(&header, &expected, sizeof(header)) == 0;
+
+    const size_t voxelsSize = (size_t)getCloudNoiseMipOffset(dimension, expected.mipCount) * sizeof(uint16_t);
+    valid = valid && (size_t)fsGetStreamFileSize(&fh) == sizeof(header) + voxelsSize;
+    if (!valid)
+    {
+        LOGF(LogLevel::eINFO, "Packed cloud noise %s is out of date, loading the slices", fileName);
+        fsCloseStream(&fh);
+        return false;
+    }
+
+    initCloudNoiseVolume(dimension, pOutVolume);
+    valid = fsReadFromStream(&fh, pOutVolume->pVoxels, voxelsSize) == voxelsSize;
+    fsCloseStream(&fh);
+
+    if (!valid)
+    {
+        LOGF(LogLevel::eWARNING, "Failed to read packed cloud noise %s", fileName);
+        exitCloudNoiseVolume(pOutVolume);
+    }
+    return valid;
+}
+
+bool savePackedCloudNoise(ResourceDirectory resourceDir, const char* fileName, const CloudNoiseVolume* pVolume)
+{
+    FileStream fh = {};
+    if (!fsOpenStreamFromPath(resourceDir, fileName, FM_WRITE, &fh))
+    {
+        LOGF(LogLevel::eWARNING, "Could not create packed cloud noise %s", fileName);
+        return false;
+    }
+
+    CloudNoiseFileHeader header = {};
+    getCloudNoiseFileHeader(pVolume->mDimension, &header);
+
+    const size_t voxelsSize = (size_t)getCloudNoiseMipOffset(pVolume->mDimension, pVolume->mMipCount) * sizeof(uint16_t);
+    bool         written = fsWriteToStream(&fh, &header, sizeof(header)) == sizeof(header);
+    written = written && fsWriteToStream(&fh, pVolume->pVoxels, voxelsSize) == voxelsSize;
+    fsCloseStream(&fh);
+
+    if (!written)
+        LOGF(LogLevel::eWARNING, "Failed to write packed cloud noise %s", fileName);
+    return written;
+}
+
+bool convertCloudNoiseSlices(const char* sliceNameFormat, uint32_t dimension, ResourceDirectory resourceDir, const char* packedFileName)
+{
+    CloudNoiseVolume volume = {};
+    if (!loadCloudNoiseSlices(sliceNameFormat, dimension, 0, &volume))
+        return false;
+
+    const bool saved = savePackedCloudNoise(resourceDir, packedFileName, &volume);
+    exitCloudNoiseVolume(&volume);
+    return saved;
+}
+
+bool loadCloudNoise(const CloudNoiseDesc* pDesc, CloudNoiseVolume* pOutVolume)
+{
+    if (loadPackedCloudNoise(RD_TEXTURES, pDesc->pPackedFileName, pDesc->mDimension, pOutVolume) ||
+        loadPackedCloudNoise(RD_PIPELINE_CACHE, pDesc->pCacheFileName, pDesc->mDimension, pOutVolume))
+        return true;
+
+    if (!loadCloudNoiseSlices(pDesc->pSliceNameFormat, pDesc->mDimension, pDesc->mThreadCount, pOutVolume))
+        return false;
+
+    savePackedCloudNoise(RD_PIPELINE_CACHE, pDesc->pCacheFileName, pOutVolume);
+    return true;
+}
+
+static void loadCloudNoiseThread(void* pData)
+{
+    CloudNoiseLoad* pLoad = (CloudNoiseLoad*)pData;
+    pLoad->mSucceeded = true;
+    for (uint32_t i = 0; i < pLoad->mCount && pLoad->mSucceeded; ++i)
+        pLoad->mSucceeded = loadCloudNoise(&pLoad->pDescs[i], &pLoad->pVolumes[i]);
+}
+
+void beginLoadCloudNoise(CloudNoiseLoad* pLoad)
+{
+    ThreadDesc threadDesc = {};
+    threadDesc.pFunc = loadCloudNoiseThread;
+    threadDesc.pData = pLoad;
+    initThread(&threadDesc, &pLoad->mThread);
+}
+
+bool waitLoadCloudNoise(CloudNoiseLoad* pLoad)
+{
+    joinThread(pLoad->mThread);
+    if (!pLoad->mSucceeded)
+    {
+        for (uint32_t i = 0; i < pLoad->mCount; ++i)
+            exitCloudNoiseVolume(&pLoad->pVolumes[i]);
+    }
+    return pLoad->mSucceeded;
+}
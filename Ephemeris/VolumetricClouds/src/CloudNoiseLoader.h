@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IFileSystem.h"
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IThread.h"
+
+// Packed cloud noise file: this header followed by every mip of the volume, largest first.
+// Voxels are RGBA16F like the GPU texture, x runs fastest, then y, then z.
+struct CloudNoiseFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dimension;
+    uint32_t mipCount;
+};
+
+static const uint32_t CLOUD_NOISE_FILE_MAGIC = 0x314E4443; // "CDN1"
+// Bump whenever the voxels or their mips are computed differently
+static const uint32_t CLOUD_NOISE_FILE_VERSION = 1;
+static const uint32_t CLOUD_NOISE_CHANNEL_COUNT = 4;
+
+// A cubic cloud noise volume with its full mip chain, as uploaded to the R16G16B16A16_SFLOAT 3D texture
+struct CloudNoiseVolume
+{
+    uint32_t  mDimension;
+    uint32_t  mMipCount;
+    // Every mip back to back, CLOUD_NOISE_CHANNEL_COUNT halfs per voxel
+    uint16_t* pVoxels;
+};
+
+// A 2D texture like the weather map or the curl noise with the mips stored in its file
+struct CloudNoiseImage
+{
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mMipCount;
+    // Every mip back to back, CLOUD_NOISE_CHANNEL_COUNT floats per texel
+    float*   pTexels;
+};
+
+// Where the voxels of a volume come from, see loadCloudNoise
+struct CloudNoiseDesc
+{
+    // Packed file shipped in RD_TEXTURES, see convertCloudNoiseSlices
+    const char* pPackedFileName;
+    // Packed file in RD_PIPELINE_CACHE, written the first time the volume is assembled from its slices
+    const char* pCacheFileName;
+    // printf format of the RGBA8 slice textures in RD_TEXTURES, formatted with the slice index
+    const char* pSliceNameFormat;
+    uint32_t    mDimension;
+    // Threads decoding slices and building mips. 0 uses every CPU core, 1 the loading thread. Doesn't change the output.
+    uint32_t    mThreadCount;
+};
+
+// Number of halfs in front of a mip inside CloudNoiseVolume::pVoxels and the packed file
+uint64_t getCloudNoiseMipOffset(uint32_t dimension, uint32_t mip);
+uint32_t getCloudNoiseMipCount(uint32_t dimension);
+
+void exitCloudNoiseVolume(CloudNoiseVolume* pVolume);
+
+float cloudNoiseHalfToFloat(uint16_t value);
+
+static inline uint32_t getCloudNoiseImageMipSize(uint32_t size, uint32_t mip) { return (size >> mip) ? (size >> mip) : 1; }
+// Number of floats in front of a mip inside CloudNoiseImage::pTexels
+uint64_t getCloudNoiseImageMipOffset(const CloudNoiseImage* pImage, uint32_t mip);
+
+// Decodes every mip of an uncompressed RGBA8 DDS or KTX texture in RD_TEXTURES, e.g. for the CPU ray-marcher
+bool loadCloudNoiseImage(const char* fileName, CloudNoiseImage* pOutImage);
+void exitCloudNoiseImage(CloudNoiseImage* pImage);
+
+// Decodes the uncompressed DDS or KTX slices in parallel straight into the top mip and averages 2x2x2 voxels into every
+// smaller mip, giving the same voxels as the GenHigh/LowTopFreq3Dtex and Gen3DtexMipmap shaders.
+bool loadCloudNoiseSlices(const char* sliceNameFormat, uint32_t dimension, uint32_t threadCount, CloudNoiseVolume* pOutVolume);
+
+// Reads the whole packed volume with a single read. Fails when the file was written for a different dimension or version.
+bool loadPackedCloudNoise(ResourceDirectory resourceDir, const char* fileName, uint32_t dimension, CloudNoiseVolume* pOutVolume);
+bool savePackedCloudNoise(ResourceDirectory resourceDir, const char* fileName, const CloudNoiseVolume* pVolume);
+
+// Converts the slices of a volume into a packed file, e.g. to ship it in RD_TEXTURES next to the slices
+bool convertCloudNoiseSlices(const char* sliceNameFormat, uint32_t dimension, ResourceDirectory resourceDir, const char* packedFileName);
+
+// Prefers the packed files and falls back to the slices. Volumes assembled from slices are cached
+// so the next start only needs one read per volume.
+bool loadCloudNoise(const CloudNoiseDesc* pDesc, CloudNoiseVolume* pOutVolume);
+
+// Runs loadCloudNoise for several zeroed volumes on a background thread while the caller creates its other resources
+struct CloudNoiseLoad
+{
+    const CloudNoiseDesc* pDescs;
+    CloudNoiseVolume*     pVolumes;
+    uint32_t              mCount;
+    bool                  mSucceeded;
+    ThreadHandle          mThread;
+};
+
+void beginLoadCloudNoise(CloudNoiseLoad* pLoad);
+// Returns false and frees the volumes when any of them failed to load
+bool waitLoadCloudNoise(CloudNoiseLoad* pLoad);
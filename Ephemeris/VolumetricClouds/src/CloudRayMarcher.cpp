@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "CloudRayMarcher.h"
+
+#include "../../src/ParallelFor.h"
+
+#include "../../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
+
+// Same constants as VolumetricCloudsCommon.h
+#define TRANSMITTANCE_SAMPLE_STEP_COUNT 5
+#define DEFAULT_MAX_DISTANCE            200000.0f
+#define ONE_OVER_FOURPI                 0.07957747154594767f
+#define LOW_FREQ_LOD                    1.0f
+#define HIGH_FREQ_LOD                   0.0f
+#define CURL_NOISE_LOD                  1.0f
+
+static const uint32_t CLOUD_RAY_MARCHER_DEFAULT_TILE_SIZE = 16;
+
+// Offsets of the light samples. The shader normalizes the first one although it is zero, here it adds nothing to the light direction.
+static const float gLightSampleOffsets[TRANSMITTANCE_SAMPLE_STEP_COUNT][3] = {
+    { 0.0f, 0.0f, 0.0f },
+    { 0.612305f, -0.187500f, 0.28125f },
+    { 0.648437f, 0.026367f, -0.792969f },
+    { -0.636719f, 0.449219f, -0.539062f },
+    { -0.808594f, 0.748047f, 0.456055f },
+};
+
+struct CloudRayMarcherContext
+{
+    const CloudRayMarcherDesc* pDesc;
+    CloudRayMarcherOutput*     pOutput;
+    const VolumetricCloudsCB*  pCB;
+    const DataPerLayer*        pLayer;
+    // Every half value as float, noise volumes are stored as halfs
+    float*                     pHalfToFloat;
+    uint32_t                   width;
+    uint32_t                   height;
+    uint32_t                   tileSize;
+    uint32_t                   tileCountX;
+    uint32_t                   minSampleCount;
+    uint32_t                   maxSampleCount;
+
+    // Constants of every ray, see GetDensity
+    vec3  earthCenter;
+    vec3  lightDirection;
+    vec3  lightSampleDirections[TRANSMITTANCE_SAMPLE_STEP_COUNT];
+    vec4  windWithVelocity;
+    vec3  biasedCloudPos;
+    vec3  cloudTopOffsetWithWindDir;
+    float detailShapeTilingDivCloudSize;
+    float weatherRotationCos;
+    float weatherRotationSin;
+};
+
+static inline float saturate(float value) { return fminf(fmaxf(value, 0.0f), 1.0f); }
+static inline float lerpf(float a, float b, float t) { return a + (b - a) * t; }
+static inline float fracf(float value) { return value - floorf(value); }
+
+static inline float remapClamped(float value, float originalMin, float originalMax, float newMin, float newMax)
+{
+    return newMin + saturate((value - originalMin) / (originalMax - originalMin)) * (newMax - newMin);
+}
+
+static inline int32_t wrapTexel(int32_t texel, int32_t size)
+{
+    texel %= size;
+    return texel < 0 ? texel + size : texel;
+}
+
+static void sampleImageMip(const CloudNoiseImage* pImage, uint32_t mip, float u, float v, float* pOut)
+{
+    const int32_t width = (int32_t)getCloudNoiseImageMipSize(pImage->mWidth, mip);
+    const int32_t height = (int32_t)getCloudNoiseImageMipSize(pImage->mHeight, mip);
+    const float*  pTexels = pImage->pTexels + getCloudNoiseImageMipOffset(pImage, mip);
+
+    const float   x = u * (float)width - 0.5f;
+    const float   y = v * (float)height - 0.5f;
+    const float   fx = x - floorf(x);
+    const float   fy = y - floorf(y);
+    const int32_t x0 = wrapTexel((int32_t)floorf(x), width);
+    const int32_t y0 = wrapTexel((int32_t)floorf(y), height);
+    const int32_t x1 = wrapTexel(x0 + 1, width);
+    const int32_t y1 = wrapTexel(y0 + 1, height);
+
+    const float* p00 = pTexels + (y0 * width + x0) * CLOUD_NOISE_CHANNEL_COUNT;
+    const float* p10 = pTexels + (y0 * width + x1) * CLOUD_NOISE_CHANNEL_COUNT;
+    const float* p01 = pTexels + (y1 * width + x0) * CLOUD_NOISE_CHANNEL_COUNT;
+    const float* p11 = pTexels + (y1 * width + x1) * CLOUD_NOISE_CHANNEL_COUNT;
+    for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+        pOut[c] = lerpf(lerpf(p00[c], p10[c], fx), lerpf(p01[c], p11[c], fx), fy);
+}
+
+static void sampleVolumeMip(const CloudRayMarcherContext* pContext, const CloudNoiseVolume* pVolume, uint32_t mip, const vec3& uvw,
+                            float* pOut)
+{
+    const int32_t   size = (int32_t)(pVolume->mDimension >> mip);
+    const uint16_t* pVoxels = pVolume->pVoxels + getCloudNoiseMipOffset(pVolume->mDimension, mip);
+    const float*    pHalfToFloat = pContext->pHalfToFloat;
+
+    const float coords[3] = { uvw.getX() * (float)size - 0.5f, uvw.getY() * (float)size - 0.5f, uvw.getZ() * (float)size - 0.5f };
+    int32_t     texels[3][2];
+    float       weights[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        weights[i] = coords[i] - floorf(coords[i]);
+        texels[i][0] = wrapTexel((int32_t)floorf(coords[i]), size);
+        texels[i][1] = wrapTexel(texels[i][0] + 1, size);
+    }
+
+    float result[CLOUD_NOISE_CHANNEL_COUNT] = {};
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const uint32_t dx = corner & 1;
+        const uint32_t dy = (corner >> 1) & 1;
+        const uint32_t dz = corner >> 2;
+        const float    weight = (dx ? weights[0] : 1.0f - weights[0]) * (dy ? weights[1] : 1.0f - weights[1]) *
+                             (dz ? weights[2] : 1.0f - weights[2]);
+
+        const uint64_t  voxel = ((uint64_t)texels[2][dz] * size + texels[1][dy]) * size + texels[0][dx];
+        const uint16_t* pVoxel = pVoxels + voxel * CLOUD_NOISE_CHANNEL_COUNT;
+        for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+            result[c] += weight * pHalfToFloat[pVoxel[c]];
+    }
+    memcpy(pOut, result, sizeof(result));
+}
+
+// SampleLvlTex3D with a linear mip filter
+static void sampleVolume(const CloudRayMarcherContext* pContext, const CloudNoiseVolume* pVolume, const vec3& uvw, float lod, float* pOut)
+{
+    lod = fminf(fmaxf(lod, 0.0f), (float)(pVolume->mMipCount - 1));
+    const uint32_t mip = (uint32_t)lod;
+    const float    mipWeight = lod - (float)mip;
+
+    sampleVolumeMip(pContext, pVolume, mip, uvw, pOut);
+    if (mipWeight > 0.0f)
+    {
+        float next[CLOUD_NOISE_CHANNEL_COUNT];
+        sampleVolumeMip(pContext, pVolume, mip + 1, uvw, next);
+        for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+            pOut[c] = lerpf(pOut[c], next[c], mipWeight);
+    }
+}
+
+static void sampleImage(const CloudNoiseImage* pImage, float u, float v, float lod, float* pOut)
+{
+    lod = fminf(fmaxf(lod, 0.0f), (float)(pImage->mMipCount - 1));
+    const uint32_t mip = (uint32_t)lod;
+    const float    mipWeight = lod - (float)mip;
+
+    sampleImageMip(pImage, mip, u, v, pOut);
+    if (mipWeight > 0.0f)
+    {
+        float next[CLOUD_NOISE_CHANNEL_COUNT];
+        sampleImageMip(pImage, mip + 1, u, v, next);
+        for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+            pOut[c] = lerpf(pOut[c], next[c], mipWeight);
+    }
+}
+
+static bool traceSphere(const vec3& origin, const vec3& dir, const vec3& center, float radius2, float* pT1, float* pT2)
+{
+    *pT1 = 0.0f;
+    *pT2 = 0.0f;
+
+    const vec3  p = origin - center;
+    const float b = dot(p, dir);
+    const float c = dot(p, p) - radius2;
+    const float f = b * b - c;
+    if (f >= 0.0f)
+    {
+        const float sqrtF = sqrtf(f);
+        *pT1 = -b - sqrtF;
+        *pT2 = -b + sqrtF;
+    }
+
+    return *pT1 > 0.0f || *pT2 > 0.0f;
+}
+
+static bool getRayMarchStart(const CloudRayMarcherContext* pContext, const vec3& origin, const vec3& dir, vec3* pStart)
+{
+    float ot1, ot2, it1, it2;
+    if (!traceSphere(origin, dir, pContext->earthCenter, pContext->pLayer->EarthRadiusAddCloudsLayerEnd2, &ot1, &ot2))
+        return false;
+
+    if (traceSphere(origin, dir, pContext->earthCenter, pContext->pLayer->EarthRadiusAddCloudsLayerStart2, &it1, &it2))
+    {
+        const float branchFactor = saturate(floorf(it1 + 1.0f));
+        *pStart = origin + lerpf(fmaxf(it2, 0.0f), fmaxf(ot1, 0.0f), branchFactor) * dir;
+    }
+    else
+    {
+        *pStart = origin + fmaxf(ot1, 0.0f) * dir;
+    }
+    return true;
+}
+
+static inline vec3 getProjectedShellPoint(const CloudRayMarcherContext* pContext, float shellRadius, const vec3& pt)
+{
+    return shellRadius * normalize(pt - pContext->earthCenter) + pContext->earthCenter;
+}
+
+static float getDensityHeightGradient(float relativeHeight, float cloudType)
+{
+    const float stratusBottom = 1.0f - powf(1.0f - remapClamped(relativeHeight, 0.08f, 0.28f, 0.0f, 1.0f), 1.4f);
+    const float stratusTop = 1.0f - powf(1.0f - remapClamped(relativeHeight, 0.42f, 0.62f, 1.0f, 0.0f), 1.4f);
+    const float stratus = fmaxf(0.0f, stratusBottom * stratusTop);
+
+    const float stratocumulusBottom = 1.0f - powf(1.0f - remapClamped(relativeHeight, 0.18f, 0.41f, 0.0f, 1.0f), 2.0f);
+    const float stratocumulusTop = 1.0f - powf(1.0f - remapClamped(relativeHeight, 0.65f, 0.98f, 1.0f, 0.0f), 2.0f);
+    const float stratocumulus = fmaxf(0.0f, stratocumulusBottom * stratocumulusTop);
+
+    return lerpf(stratus, stratocumulus, saturate(cloudType * cloudType * 2.0f));
+}
+
+// SampleDensity of the shader
+static float sampleDensity(const CloudRayMarcherContext* pContext, vec3 worldPos, float lod, float heightFraction, const vec3& currentProj,
+                           bool cheap)
+{
+    const DataPerLayer*            pLayer = pContext->pLayer;
+    const CloudRayMarcherTextures* pTextures = pContext->pDesc->pTextures;
+    const vec4&                    wind = pContext->windWithVelocity;
+
+    // Unwind position only for the weather data
+    const vec3 unwindWorldPos = worldPos;
+    worldPos += heightFraction * pContext->cloudTopOffsetWithWindDir;
+    worldPos += pContext->biasedCloudPos;
+
+    const float weatherU = (unwindWorldPos.getX() + wind.getX() + pLayer->WeatherTextureOffsetX) / pLayer->WeatherTextureSize -
+                           pLayer->RotationPivotOffsetX;
+    const float weatherV = (unwindWorldPos.getZ() + wind.getY() + pLayer->WeatherTextureOffsetZ) / pLayer->WeatherTextureSize -
+                           pLayer->RotationPivotOffsetZ;
+    float       weatherData[CLOUD_NOISE_CHANNEL_COUNT];
+    sampleImage(pTextures->pWeatherMap,
+                weatherU * pContext->weatherRotationCos - weatherV * pContext->weatherRotationSin + pLayer->RotationPivotOffsetX,
+                weatherU * pContext->weatherRotationSin + weatherV * pContext->weatherRotationCos + pLayer->RotationPivotOffsetZ, 0.0f,
+                weatherData);
+
+    const vec3 worldPosDivCloudSize = worldPos / pLayer->CloudSize;
+
+    // Density of the base cloud
+    float lowFreqNoises[CLOUD_NOISE_CHANNEL_COUNT];
+    sampleVolume(pContext, pTextures->pLowFrequencyNoise, worldPosDivCloudSize * pLayer->BaseShapeTiling, lod, lowFreqNoises);
+    const float lowFreqFBm = (lowFreqNoises[1] * 0.625f) + (lowFreqNoises[2] * 0.25f) + (lowFreqNoises[3] * 0.125f);
+
+    float baseCloud = remapClamped(lowFreqNoises[0], lowFreqFBm - 1.0f, 1.0f, 0.0f, 1.0f);
+    baseCloud = saturate(baseCloud + pLayer->CloudCoverage);
+    baseCloud *= getDensityHeightGradient(heightFraction, saturate(weatherData[1] + pLayer->CloudType));
+
+    float cloudCoverage = saturate(weatherData[2]);
+    cloudCoverage = powf(cloudCoverage, remapClamped(heightFraction, 0.2f, 0.8f, 1.0f, lerpf(1.0f, 0.5f, pLayer->AnvilBias)));
+
+    const float baseCloudCoverage = remapClamped(baseCloud, cloudCoverage, 1.0f, 0.0f, 1.0f) * cloudCoverage;
+    if (cheap)
+        return baseCloudCoverage;
+
+    float curlNoise[CLOUD_NOISE_CHANNEL_COUNT];
+    sampleImage(pTextures->pCurlNoise, worldPosDivCloudSize.getX() * pLayer->CurlTextureTiling,
+                worldPosDivCloudSize.getZ() * pLayer->CurlTextureTiling, CURL_NOISE_LOD, curlNoise);
+
+    const float curlScale = (1.0f - heightFraction) * pLayer->CurlStrenth;
+    worldPos.setX(worldPos.getX() + curlNoise[0] * curlScale);
+    worldPos.setZ(worldPos.getZ() + curlNoise[1] * curlScale);
+    worldPos.setY(worldPos.getY() - pLayer->RisingVaporUpDirection *
+                                        ((pContext->pCB->TimeAndScreenSize.getX() * pLayer->RisingVaporIntensity) /
+                                         (pLayer->CloudSize * 0.0657f * pLayer->RisingVaporScale)));
+
+    const vec3 uvw = (worldPos + vec3(wind.getZ(), 0.0f, wind.getW())) * pContext->detailShapeTilingDivCloudSize;
+    float      highFreqNoises[CLOUD_NOISE_CHANNEL_COUNT];
+    sampleVolume(pContext, pTextures->pHighFrequencyNoise, uvw, HIGH_FREQ_LOD, highFreqNoises);
+    const float highFreqFBm = (highFreqNoises[0] * 0.625f) + (highFreqNoises[1] * 0.25f) + (highFreqNoises[2] * 0.125f);
+
+    const float heightFractionNew = saturate(length(worldPos - currentProj) / pLayer->LayerThickness);
+    const float heightFreqNoiseModifier = lerpf(highFreqFBm, 1.0f - highFreqFBm, saturate(heightFractionNew * 10.0f));
+
+    return remapClamped(baseCloudCoverage, heightFreqNoiseModifier * pLayer->DetailStrenth, 1.0f, 0.0f, 1.0f);
+}
+
+static inline float henyeyGreenstein(float g, float cosTheta)
+{
+    const float g2 = g * g;
+    return ONE_OVER_FOURPI * (1.0f - g2) / powf(fabsf(1.0f + g2 - 2.0f * g * cosTheta), 1.5f);
+}
+
+// SampleEnergy and GetLightEnergy of the shader
+static float sampleEnergy(const CloudRayMarcherContext* pContext, const vec3& rayPos, float heightFraction, float density, float cosTheta)
+{
+    const VolumetricCloudsCB* pCB = pContext->pCB;
+    const DataPerLayer*       pLayer = pContext->pLayer;
+    const float               stepSize = pCB->lightDirection.getW();
+
+    float totalSample = 0.0f;
+    float mipmapOffset = LOW_FREQ_LOD;
+    float step = 0.5f;
+    for (uint32_t i = 0; i < TRANSMITTANCE_SAMPLE_STEP_COUNT; ++i)
+    {
+        const vec3  samplePoint = rayPos + (step * stepSize) * pContext->lightSampleDirections[i];
+        const vec3  currentProj = getProjectedShellPoint(pContext, pLayer->EarthRadiusAddCloudsLayerStart, samplePoint);
+        const float sampleHeightFraction = saturate(length(samplePoint - currentProj) / pLayer->LayerThickness);
+
+        totalSample += sampleDensity(pContext, samplePoint, mipmapOffset, sampleHeightFraction, currentProj, false);
+
+        // Increase the mipmap offset to gain performance
+        mipmapOffset += 0.5f;
+        step += 1.0f;
+    }
+
+    float       hg = fmaxf(henyeyGreenstein(pCB->Eccentricity, cosTheta),
+                     saturate(henyeyGreenstein(0.99f - pCB->SilverliningSpread, cosTheta))) *
+               pCB->SilverliningIntensity;
+    const float dl = totalSample * pLayer->Precipitation;
+    hg /= fmaxf(dl, 0.05f);
+
+    // Attenuation (Beer's Law)
+    const float primaryAttenuation = expf(-dl);
+    const float secondaryAttenuation = expf(-dl * 0.25f) * 0.7f;
+    const float attenuationProbability = fmaxf(primaryAttenuation, secondaryAttenuation * 0.25f);
+
+    // In-scattering
+    const float depthProbability =
+        lerpf(0.05f + powf(density, remapClamped(heightFraction, 0.3f, 0.85f, 0.5f, 2.0f)), 1.0f, saturate(dl));
+    const float verticalProbability = powf(remapClamped(heightFraction, 0.07f, 0.14f, 0.1f, 1.0f), 0.8f);
+    const float lightEnergy = attenuationProbability + verticalProbability * depthProbability * hg;
+
+    return powf(fabsf(lightEnergy), pLayer->Contrast);
+}
+
+// GetDensity of the shader, returns the density and writes intensity, atmosphere blend factor and depth to pOut
+static float rayMarch(const CloudRayMarcherContext* pContext, const vec3& startPos, const vec3& dir, float raymarchOffset, float* pOut,
+                      uint32_t* pStepCount)
+{
+    const VolumetricCloudsCB* pCB = pContext->pCB;
+    const DataPerLayer*       pLayer = pContext->pLayer;
+
+    // Use the default far when nothing is hit, this preserves temporal reprojection
+    float intensity = 0.0f;
+    float atmosphericBlendFactor = 0.0f;
+    float depth = pCB->CameraFar;
+    *pStepCount = 0;
+
+    vec3 sampleStart;
+    if (!getRayMarchStart(pContext, startPos, dir, &sampleStart))
+    {
+        pOut[0] = intensity;
+        pOut[1] = atmosphericBlendFactor;
+        pOut[2] = depth;
+        return 1.0f;
+    }
+
+    // Sample count and step size depend on the angle between the view direction and the up vector
+    const vec3     upVector = normalize(startPos - pContext->earthCenter);
+    const float    horizon = fabsf(dot(dir, upVector));
+    const uint32_t sampleCount = (uint32_t)lerpf((float)pContext->maxSampleCount, (float)pContext->minSampleCount, horizon);
+    const float    sampleStep = lerpf(pCB->m_StepSize.getY(), pCB->m_StepSize.getX(), horizon);
+
+    const float distCameraToStart = length(sampleStart - startPos);
+    atmosphericBlendFactor = distCameraToStart / DEFAULT_MAX_DISTANCE;
+
+    float it1, it2;
+    traceSphere(startPos, dir, pContext->earthCenter, pCB->EarthRadius * pCB->EarthRadius, &it1, &it2);
+    const float distanceToEarthShell = it1 > 0.0f ? it1 : it2;
+    float       maxSamplingDistance =
+        distanceToEarthShell > 0.0f ? fminf(distanceToEarthShell, pCB->m_MaxSampleDistance) : pCB->m_MaxSampleDistance;
+
+    traceSphere(startPos, dir, pContext->earthCenter, pLayer->EarthRadiusAddCloudsLayerStart2, &it1, &it2);
+    const float innerShellIntersection = fmaxf(it1, it2);
+    traceSphere(startPos, dir, pContext->earthCenter, pLayer->EarthRadiusAddCloudsLayerEnd2, &it1, &it2);
+    const float outerShellIntersection = fmaxf(it1, it2);
+    maxSamplingDistance = fminf(maxSamplingDistance, fmaxf(innerShellIntersection, outerShellIntersection));
+
+    // Horizontal culling, rays hitting the earth before the atmosphere are discarded
+    if (distCameraToStart >= maxSamplingDistance)
+    {
+        pOut[0] = intensity;
+        pOut[1] = 1.0f;
+        pOut[2] = depth;
+        return 0.0f;
+    }
+
+    // Default value used for reprojection
+    depth = (float)sampleCount * sampleStep;
+
+    float alpha = 0.0f;
+    bool  detailedSample = false; // Start with cheap ray-marching
+    int   missedStepCount = 0;
+    bool  pickedFirstHit = false;
+
+    const vec3  smallStepMarching = sampleStep * dir;
+    const vec3  bigStepMarching = (sampleStep * 2.0f) * dir;
+    const float cosTheta = dot(dir, pContext->lightDirection);
+
+    // A random offset prevents ray-marching artifacts
+    vec3 raymarchingDistance = smallStepMarching * raymarchOffset;
+    vec3 rayPos = sampleStart;
+
+    for (uint32_t j = 0; j < sampleCount; ++j)
+    {
+        rayPos += raymarchingDistance;
+        const float distanceToRayPos = length(rayPos - startPos);
+        if (distanceToRayPos > maxSamplingDistance)
+            break;
+
+        ++*pStepCount;
+
+        const vec3  currentProj = getProjectedShellPoint(pContext, pLayer->EarthRadiusAddCloudsLayerStart, rayPos);
+        const float heightFraction =
+            saturate(fmaxf(length(rayPos - pContext->earthCenter) - pLayer->EarthRadiusAddCloudsLayerStart, 0.0f) / pLayer->LayerThickness);
+
+        const float sampleResult = sampleDensity(pContext, rayPos, LOW_FREQ_LOD, heightFraction, currentProj, !detailedSample);
+        if (!detailedSample)
+        {
+            if (sampleResult > 0.0f)
+            {
+                // The clouds were hit, step back and switch to the expensive ray-marching
+                detailedSample = true;
+                raymarchingDistance = -bigStepMarching;
+                missedStepCount = 0;
+                continue;
+            }
+
+            raymarchingDistance = bigStepMarching;
+            continue;
+        }
+
+        if (sampleResult == 0.0f)
+        {
+            // Go back to cheap ray-marching after more than 10 missed expensive steps
+            if (++missedStepCount > 10)
+                detailedSample = false;
+        }
+        else
+        {
+            // The first hit is used for reprojection
+            if (!pickedFirstHit)
+            {
+                depth = distanceToRayPos;
+                pickedFirstHit = true;
+            }
+
+            // A smooth gradient along the depth mocks atmospheric scattering on the cloud itself
+            float depthAttenuation = 1.0f - fminf(distanceToRayPos / pCB->m_MaxSampleDistance, 1.0f);
+            depthAttenuation = depthAttenuation * depthAttenuation;
+
+            const float sampledAlpha = sampleResult * pLayer->CloudDensity * depthAttenuation * (1.0f - alpha);
+            const float sampledEnergy = sampleEnergy(pContext, rayPos, heightFraction, sampleResult, cosTheta);
+
+            intensity += sampledAlpha * sampledEnergy;
+            alpha += sampledAlpha;
+
+            if (alpha >= 1.0f)
+            {
+                pOut[0] = intensity / alpha;
+                pOut[1] = atmosphericBlendFactor;
+                pOut[2] = depth * 0.001f;
+                return 1.0f;
+            }
+        }
+
+        raymarchingDistance = smallStepMarching;
+    }
+
+    pOut[0] = intensity;
+    pOut[1] = atmosphericBlendFactor;
+    pOut[2] = depth * 0.001f;
+    return alpha;
+}
+
+static void rayMarchTile(void* pUserData, uint32_t tileIndex)
+{
+    const CloudRayMarcherContext* pContext = (const CloudRayMarcherContext*)pUserData;
+    const VolumetricCloudsCB*     pCB = pContext->pCB;
+    CloudRayMarcherOutput*        pOutput = pContext->pOutput;
+
+    const float screenWidth = pCB->TimeAndScreenSize.getZ();
+    const float screenHeight = pCB->TimeAndScreenSize.getW();
+    const vec3  cameraPosition = pCB->m_DataPerEye[0].cameraPosition.getXYZ();
+
+    const uint32_t beginX = (tileIndex % pContext->tileCountX) * pContext->tileSize;
+    const uint32_t beginY = (tileIndex / pContext->tileCountX) * pContext->tileSize;
+    const uint32_t endX = beginX + pContext->tileSize < pContext->width ? beginX + pContext->tileSize : pContext->width;
+    const uint32_t endY = beginY + pContext->tileSize < pContext->height ? beginY + pContext->tileSize : pContext->height;
+    for (uint32_t y = beginY; y < endY; ++y)
+    {
+        for (uint32_t x = beginX; x < endX; ++x)
+        {
+            const float u = (float)x / screenWidth;
+            const float v = (float)y / screenHeight;
+
+            vec4 eyePos = pCB->m_DataPerEye[0].m_ProjToRelativeToEye * vec4(u * 2.0f - 1.0f, (1.0f - v) * 2.0f - 1.0f, 0.0f, 1.0f);
+            eyePos /= eyePos.getW();
+            const vec3 viewDir = normalize(eyePos.getXYZ());
+
+            const float screenRandom = fracf(sinf(u * screenWidth * 12.9898f + v * screenHeight * 78.233f) * 43758.5453f);
+            const float randomSeed = lerpf(fracf(screenRandom), pCB->Random00, pCB->m_UseRandomSeed);
+
+            const uint32_t pixel = y * pContext->width + x;
+            float*         pPixel = pOutput->pPixels + pixel * 4;
+            uint32_t       stepCount = 0;
+            pPixel[3] = rayMarch(pContext, cameraPosition, viewDir, randomSeed, pPixel, &stepCount);
+            if (pOutput->pStepCounts)
+                pOutput->pStepCounts[pixel] = stepCount;
+        }
+    }
+}
+
+void rayMarchClouds(const CloudRayMarcherDesc* pDesc, CloudRayMarcherOutput* pOutput)
+{
+    const VolumetricCloudsCB* pCB = pDesc->pCB;
+    ASSERT(pDesc->pTextures->pHighFrequencyNoise && pDesc->pTextures->pLowFrequencyNoise);
+    ASSERT(pDesc->pTextures->pCurlNoise && pDesc->pTextures->pWeatherMap);
+
+    CloudRayMarcherContext context = {};
+    context.pDesc = pDesc;
+    context.pOutput = pOutput;
+    context.pCB = pCB;
+    context.pLayer = &pCB->m_DataPerLayer[0];
+    context.width = getCloudRayMarcherWidth(pCB);
+    context.height = getCloudRayMarcherHeight(pCB);
+    context.tileSize = pDesc->mTileSize ? pDesc->mTileSize : CLOUD_RAY_MARCHER_DEFAULT_TILE_SIZE;
+    context.tileCountX = (context.width + context.tileSize - 1) / context.tileSize;
+    context.minSampleCount = pDesc->mMinSampleCount ? pDesc->mMinSampleCount : pCB->MIN_ITERATION_COUNT;
+    context.maxSampleCount = pDesc->mMaxSampleCount ? pDesc->mMaxSampleCount : pCB->MAX_ITERATION_COUNT;
+
+    context.pHalfToFloat = (float*)tf_malloc(sizeof(float) * 65536);
+    for (uint32_t i = 0; i < 65536; ++i)
+        context.pHalfToFloat[i] = cloudNoiseHalfToFloat((uint16_t)i);
+
+    const DataPerLayer* pLayer = context.pLayer;
+    context.earthCenter = pCB->EarthCenter.getXYZ();
+    context.lightDirection = pCB->lightDirection.getXYZ();
+    const vec3 magLightDirection = 2.0f * context.lightDirection;
+    for (uint32_t i = 0; i < TRANSMITTANCE_SAMPLE_STEP_COUNT; ++i)
+    {
+        const vec3 offset(gLightSampleOffsets[i][0], gLightSampleOffsets[i][1], gLightSampleOffsets[i][2]);
+        context.lightSampleDirections[i] = normalize(i ? magLightDirection + normalize(offset) : magLightDirection);
+    }
+    context.windWithVelocity = pLayer->StandardPosition;
+    context.biasedCloudPos = 4.5f * (pLayer->WindDirection.getXYZ() + vec3(0.0f, 0.1f, 0.0f));
+    context.cloudTopOffsetWithWindDir = pLayer->CloudTopOffset * pLayer->WindDirection.getXYZ();
+    context.detailShapeTilingDivCloudSize = pLayer->DetailShapeTiling / pLayer->CloudSize;
+    context.weatherRotationCos = cosf(pLayer->RotationAngle);
+    context.weatherRotationSin = sinf(pLayer->RotationAngle);
+
+    const uint32_t tileCountY = (context.height + context.tileSize - 1) / context.tileSize;
+    parallelFor(rayMarchTile, &context, context.tileCountX * tileCountY, pDesc->mThreadCount);
+
+    tf_free(context.pHalfToFloat);
+}
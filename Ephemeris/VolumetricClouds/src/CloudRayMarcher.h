@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include "CloudNoiseLoader.h"
+#include "VolumetricCloudsCB.h"
+
+// CPU reference of the RealTimeVolumetricCloud compute shader, for checking cloud shading and sample count
+// heuristics without a GPU. Textures are sampled like g_LinearWrapSampler does, with trilinear filtering and wrapping.
+
+// Inputs bound to the shader
+struct CloudRayMarcherTextures
+{
+    const CloudNoiseVolume* pHighFrequencyNoise;
+    const CloudNoiseVolume* pLowFrequencyNoise;
+    const CloudNoiseImage*  pCurlNoise;
+    const CloudNoiseImage*  pWeatherMap;
+};
+
+struct CloudRayMarcherDesc
+{
+    const VolumetricCloudsCB*      pCB;
+    const CloudRayMarcherTextures* pTextures;
+    // Replace MIN_ITERATION_COUNT and MAX_ITERATION_COUNT of pCB (AppSettings::m_MinSampleCount and m_MaxSampleCount) when not 0
+    uint32_t                       mMinSampleCount;
+    uint32_t                       mMaxSampleCount;
+    // Pixels are marched in square tiles of mTileSize, 0 uses the 16x16 thread groups of the shader
+    uint32_t                       mTileSize;
+    // Threads marching tiles. 0 uses every CPU core, 1 the calling thread. Doesn't change the output.
+    uint32_t                       mThreadCount;
+};
+
+// The image covers TimeAndScreenSize.zw of the CB like the dispatch of the shader does
+struct CloudRayMarcherOutput
+{
+    // 4 floats per pixel like volumetricCloudsDstTexture: intensity, atmosphere blend factor, packed depth and density
+    float*    pPixels;
+    // Ray-march iterations of every pixel, optional
+    uint32_t* pStepCounts;
+};
+
+static inline uint32_t getCloudRayMarcherWidth(const VolumetricCloudsCB* pCB) { return (uint32_t)pCB->TimeAndScreenSize.getZ(); }
+static inline uint32_t getCloudRayMarcherHeight(const VolumetricCloudsCB* pCB) { return (uint32_t)pCB->TimeAndScreenSize.getW(); }
+
+void rayMarchClouds(const CloudRayMarcherDesc* pDesc, CloudRayMarcherOutput* pOutput);
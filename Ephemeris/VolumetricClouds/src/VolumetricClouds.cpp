@@ -10,6 +10,8 @@
 
 #include "VolumetricClouds.h"
 
+#include "CloudNoiseLoader.h"
+
 #include "../../../../The-Forge/Common_3/Application/Interfaces/IUI.h"
 #include "../../../../The-Forge/Common_3/Game/Interfaces/IScripting.h"
 #include "../../../../The-Forge/Common_3/Resources/ResourceLoader/Interfaces/IResourceLoader.h"
@@ -182,6 +184,15 @@ Texture** gLowFrequencyOriginTextureStorage = NULL;
 char gHighFrequencyTextureNames[gHighFreq3DTextureSize][128];
 char gLowFrequencyTextureNames[gLowFreq3DTextureSize][128];
 
+const char* gHighFrequencySliceNameFormat = "VolumetricClouds/hiResCloudShape/hiResClouds (%u).tex";
+const char* gLowFrequencySliceNameFormat = "VolumetricClouds/lowResCloudShape/lowResCloud(%u).tex";
+
+// Packed noise volumes, see convertCloudNoiseSlices
+const CloudNoiseDesc gCloudNoiseDescs[] = {
+    { "VolumetricClouds/hiResCloudShape.cdn", "VolumetricCloudsHighFreq.cdn", gHighFrequencySliceNameFormat, gHighFreq3DTextureSize, 0 },
+    { "VolumetricClouds/lowResCloudShape.cdn", "VolumetricCloudsLowFreq.cdn", gLowFrequencySliceNameFormat, gLowFreq3DTextureSize, 0 },
+};
+
 Texture* pHighFrequency3DTexture;
 Texture* pLowFrequency3DTexture;
 
@@ -242,6 +253,14 @@ bool VolumetricClouds::Init(Renderer* renderer, PipelineCache* pCache)
     pRenderer = renderer;
     pPipelineCache = pCache;
 
+    // The noise volumes are decoded on worker threads while the rest of the resources get created
+    CloudNoiseVolume cloudNoiseVolumes[2] = {};
+    CloudNoiseLoad   cloudNoiseLoad = {};
+    cloudNoiseLoad.pDescs = gCloudNoiseDescs;
+    cloudNoiseLoad.pVolumes = cloudNoiseVolumes;
+    cloudNoiseLoad.mCount = 2;
+    beginLoadCloudNoise(&cloudNoiseLoad);
+
     g_StandardPosition = vec4(0.0f, 0.0f, 0.0f, 0.0f);
     g_StandardPosition_2nd = vec4(0.0f, 0.0f, 0.0f, 0.0f);
     g_ShadowInfo = vec4(0.0f, 0.0f, 1.0f, 0.0f);
@@ -301,33 +320,6 @@ bool VolumetricClouds::Init(Renderer* renderer, PipelineCache* pCache)
     screenQuadVbDesc.ppBuffer = &pTriangularScreenVertexBuffer;
     addResource(&screenQuadVbDesc, &token);
 
-    gHighFrequencyOriginTextureStorage = (Texture**)tf_malloc(sizeof(Texture*) * gHighFreq3DTextureSize);
-
-    for (uint32_t i = 0; i < gHighFreq3DTextureSize; ++i)
-    {
-        snprintf(gHighFrequencyTextureNames[i], 128, "VolumetricClouds/hiResCloudShape/hiResClouds (%u).tex", i);
-
-        TextureLoadDesc highFrequencyOrigin3DTextureDesc = {};
-        highFrequencyOrigin3DTextureDesc.pFileName = gHighFrequencyTextureNames[i];
-        highFrequencyOrigin3DTextureDesc.ppTexture = &gHighFrequencyOriginTextureStorage[i];
-        addResource(&highFrequencyOrigin3DTextureDesc, &token);
-    }
-
-    //////////////////////////////////////////////////////////////////////////////////////////
-    gLowFrequencyOriginTextureStorage = (Texture**)tf_malloc(sizeof(Texture*) * gLowFreq3DTextureSize);
-
-    for (uint32_t i = 0; i < gLowFreq3DTextureSize; ++i)
-    {
-        snprintf(gLowFrequencyTextureNames[i], 128, "VolumetricClouds/lowResCloudShape/lowResCloud(%u).tex", i);
-
-        TextureLoadDesc lowFrequencyOrigin3DTextureDesc = {};
-        lowFrequencyOrigin3DTextureDesc.pFileName = gLowFrequencyTextureNames[i];
-        lowFrequencyOrigin3DTextureDesc.ppTexture = &gLowFrequencyOriginTextureStorage[i];
-        addResource(&lowFrequencyOrigin3DTextureDesc, &token);
-    }
-
-    waitForToken(&token);
-
     ///////////////////////////////////////////////////////////////////////////////////////////////
     TextureDesc lowFreqImgDesc = {};
     lowFreqImgDesc.mArraySize = 1;
@@ -1286,7 +1278,18 @@ bool VolumetricClouds::Init(Renderer* renderer, PipelineCache* pCache)
     WeatherCompactTextureLoadDesc.pDesc = &WeatherCompactTextureDesc;
     addResource(&WeatherCompactTextureLoadDesc, &token);
 
-    GenerateCloudTextures();
+    if (waitLoadCloudNoise(&cloudNoiseLoad))
+    {
+        UploadCloudTextures(&cloudNoiseVolumes[0], &cloudNoiseVolumes[1]);
+        exitCloudNoiseVolume(&cloudNoiseVolumes[0]);
+        exitCloudNoiseVolume(&cloudNoiseVolumes[1]);
+    }
+    else
+    {
+        LOGF(LogLevel::eWARNING, "Cloud noise slices can't be decoded on the CPU, assembling them on the GPU");
+        AddCloudSliceTextures();
+        GenerateCloudTextures();
+    }
 
     return true;
 }
@@ -1302,20 +1305,24 @@ void VolumetricClouds::Exit()
     removeResource(pWeatherCompactTexture);
     removeResource(pCurlNoiseTexture);
 
-    // Remove Textures
-    for (uint32_t i = 0; i < gHighFreq3DTextureSize; ++i)
+    // Slice textures only exist when the noise volumes were assembled on the GPU
+    if (gHighFrequencyOriginTextureStorage)
     {
-        removeResource(gHighFrequencyOriginTextureStorage[i]);
-    }
+        for (uint32_t i = 0; i < gHighFreq3DTextureSize; ++i)
+        {
+            removeResource(gHighFrequencyOriginTextureStorage[i]);
+        }
 
-    // Remove Textures
-    for (uint32_t i = 0; i < gLowFreq3DTextureSize; ++i)
-    {
-        removeResource(gLowFrequencyOriginTextureStorage[i]);
-    }
+        for (uint32_t i = 0; i < gLowFreq3DTextureSize; ++i)
+        {
+            removeResource(gLowFrequencyOriginTextureStorage[i]);
+        }
 
-    tf_free(gHighFrequencyOriginTextureStorage);
-    tf_free(gLowFrequencyOriginTextureStorage);
+        tf_free(gHighFrequencyOriginTextureStorage);
+        tf_free(gLowFrequencyOriginTextureStorage);
+        gHighFrequencyOriginTextureStorage = NULL;
+        gLowFrequencyOriginTextureStorage = NULL;
+    }
 
     removeResource(pTriangularScreenVertexBuffer);
 
@@ -3431,6 +3438,109 @@ void VolumetricClouds::Initialize(ICameraController* InCameraController, Queue*
     pTransmittanceBuffer = InTransmittanceBuffer;
 }
 
+void VolumetricClouds::AddCloudSliceTextures()
+{
+    SyncToken token = {};
+
+    gHighFrequencyOriginTextureStorage = (Texture**)tf_malloc(sizeof(Texture*) * gHighFreq3DTextureSize);
+
+    for (uint32_t i = 0; i < gHighFreq3DTextureSize; ++i)
+    {
+        snprintf(gHighFrequencyTextureNames[i], 128, gHighFrequencySliceNameFormat, i);
+
+        TextureLoadDesc highFrequencyOrigin3DTextureDesc = {};
+        highFrequencyOrigin3DTextureDesc.pFileName = gHighFrequencyTextureNames[i];
+        highFrequencyOrigin3DTextureDesc.ppTexture = &gHighFrequencyOriginTextureStorage[i];
+        addResource(&highFrequencyOrigin3DTextureDesc, &token);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////
+    gLowFrequencyOriginTextureStorage = (Texture**)tf_malloc(sizeof(Texture*) * gLowFreq3DTextureSize);
+
+    for (uint32_t i = 0; i < gLowFreq3DTextureSize; ++i)
+    {
+        snprintf(gLowFrequencyTextureNames[i], 128, gLowFrequencySliceNameFormat, i);
+
+        TextureLoadDesc lowFrequencyOrigin3DTextureDesc = {};
+        lowFrequencyOrigin3DTextureDesc.pFileName = gLowFrequencyTextureNames[i];
+        lowFrequencyOrigin3DTextureDesc.ppTexture = &gLowFrequencyOriginTextureStorage[i];
+        addResource(&lowFrequencyOrigin3DTextureDesc, &token);
+    }
+
+    waitForToken(&token);
+}
+
+void VolumetricClouds::UploadCloudTextures(const CloudNoiseVolume* pHighFrequencyVolume, const CloudNoiseVolume* pLowFrequencyVolume)
+{
+    GpuCmdRing     uploadRing = {};
+    GpuCmdRingDesc cmdRingDesc = {};
+    cmdRingDesc.pQueue = pGraphicsQueue;
+    cmdRingDesc.mPoolCount = 1;
+    cmdRingDesc.mCmdPerPoolCount = 1;
+    cmdRingDesc.mAddSyncPrimitives = true;
+    addGpuCmdRing(pRenderer, &cmdRingDesc, &uploadRing);
+    GpuCmdRingElement elem = getNextGpuCmdRingElement(&uploadRing, true, 1);
+    Cmd*              cmd = elem.pCmds[0];
+
+    beginCmd(cmd);
+
+    TextureBarrier barriersForNoise[] = {
+        { pHighFrequency3DTexture, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_COPY_DEST },
+        { pLowFrequency3DTexture, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_COPY_DEST },
+    };
+    cmdResourceBarrier(cmd, 0, NULL, 2, barriersForNoise, 0, NULL);
+
+    Texture*                pTextures[2] = { pHighFrequency3DTexture, pLowFrequency3DTexture };
+    const CloudNoiseVolume* pVolumes[2] = { pHighFrequencyVolume, pLowFrequencyVolume };
+    for (uint32_t t = 0; t < 2; ++t)
+    {
+        TextureUpdateDesc updateDesc = { pTextures[t] };
+        updateDesc.mBaseMipLevel = 0;
+        updateDesc.mMipLevels = pVolumes[t]->mMipCount;
+        updateDesc.mBaseArrayLayer = 0;
+        updateDesc.mLayerCount = 1;
+        updateDesc.mCurrentState = RESOURCE_STATE_COPY_DEST;
+        updateDesc.pCmd = cmd;
+        beginUpdateResource(&updateDesc);
+
+        for (uint32_t mip = 0; mip < pVolumes[t]->mMipCount; ++mip)
+        {
+            TextureSubresourceUpdate subresource = updateDesc.getSubresourceUpdateDesc(mip, 0);
+
+            const uint32_t mipSize = pVolumes[t]->mDimension >> mip;
+            const uint32_t srcRowSize = mipSize * CLOUD_NOISE_CHANNEL_COUNT * sizeof(uint16_t);
+            const uint8_t* srcData = (const uint8_t*)(pVolumes[t]->pVoxels + getCloudNoiseMipOffset(pVolumes[t]->mDimension, mip));
+            for (uint32_t z = 0; z < mipSize; ++z)
+            {
+                for (uint32_t r = 0; r < subresource.mRowCount; ++r)
+                {
+                    memcpy(subresource.pMappedData + subresource.mDstSliceStride * z + subresource.mDstRowStride * r,
+                           srcData + (uint64_t)srcRowSize * (z * mipSize + r), srcRowSize);
+                }
+            }
+        }
+
+        endUpdateResource(&updateDesc);
+    }
+
+    TextureBarrier barriersForNoise2[] = {
+        { pHighFrequency3DTexture, RESOURCE_STATE_COPY_DEST, RESOURCE_STATE_SHADER_RESOURCE },
+        { pLowFrequency3DTexture, RESOURCE_STATE_COPY_DEST, RESOURCE_STATE_SHADER_RESOURCE },
+    };
+    cmdResourceBarrier(cmd, 0, NULL, 2, barriersForNoise2, 0, NULL);
+
+    endCmd(cmd);
+
+    QueueSubmitDesc submitDesc = {};
+    submitDesc.mCmdCount = 1;
+    submitDesc.ppCmds = &cmd;
+    submitDesc.mSubmitDone = true;
+    queueSubmit(pGraphicsQueue, &submitDesc);
+    waitQueueIdle(pGraphicsQueue);
+
+    removeGpuCmdRing(pRenderer, &uploadRing);
+}
+
 void VolumetricClouds::GenerateCloudTextures()
 {
     Shader*        pGenHighTopFreq3DTexShader = NULL;
@@ -314,6 +314,7 @@ public:
         gTerrain.pWeatherMap = gVolumetricClouds.GetWeatherMap();
 
         gSpaceObjects.Initialize(pCameraController, gGpuProfileToken, pTransmittanceBuffer);
+        gSpaceObjects.InitializeStarField(gSky.GetParticleData(), gSky.GetParticleCount());
         gSpaceObjects.Init(pRenderer, pPipelineCache);
 
         SamplerDesc samplerClampDesc = { FILTER_LINEAR,
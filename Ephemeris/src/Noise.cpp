@@ -0,0 +1,676 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#include "Noise.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
+
+#include "Perlin.h"
+
+// AVX2 is only used when the whole build targets it, there is no runtime dispatch
+#if defined(__AVX2__)
+#define NOISE_AVX2
+#include <immintrin.h>
+#elif defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_SSE2
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define NOISE_NEON
+#include <arm_neon.h>
+#endif
+
+/************************************************************************/
+// Vector helpers
+/************************************************************************/
+#if defined(NOISE_AVX2)
+#define NOISE_WIDTH     8
+#define NOISE_SIMD_NAME "AVX2"
+typedef __m256  VFloat;
+typedef __m256i VInt;
+
+static inline VFloat vSet1(float a) { return _mm256_set1_ps(a); }
+static inline VFloat vLoad(const float* p) { return _mm256_loadu_ps(p); }
+static inline void   vStore(float* p, VFloat a) { _mm256_storeu_ps(p, a); }
+static inline VFloat vAdd(VFloat a, VFloat b) { return _mm256_add_ps(a, b); }
+static inline VFloat vSub(VFloat a, VFloat b) { return _mm256_sub_ps(a, b); }
+static inline VFloat vMul(VFloat a, VFloat b) { return _mm256_mul_ps(a, b); }
+static inline VFloat vMin(VFloat a, VFloat b) { return _mm256_min_ps(a, b); }
+static inline VFloat vMax(VFloat a, VFloat b) { return _mm256_max_ps(a, b); }
+static inline VFloat vAbs(VFloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline VFloat vXorBits(VFloat a, VInt bits) { return _mm256_xor_ps(a, _mm256_castsi256_ps(bits)); }
+static inline VFloat vSelect(VInt mask, VFloat a, VFloat b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask)); }
+static inline VInt   vTruncToInt(VFloat a) { return _mm256_cvttps_epi32(a); }
+static inline VFloat vIntToFloat(VInt a) { return _mm256_cvtepi32_ps(a); }
+static inline VInt   vGreater(VFloat a, VFloat b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+
+static inline VInt iSet1(int32_t a) { return _mm256_set1_epi32(a); }
+static inline VInt iAdd(VInt a, VInt b) { return _mm256_add_epi32(a, b); }
+static inline VInt iMul(VInt a, VInt b) { return _mm256_mullo_epi32(a, b); }
+static inline VInt iXor(VInt a, VInt b) { return _mm256_xor_si256(a, b); }
+static inline VInt iAnd(VInt a, VInt b) { return _mm256_and_si256(a, b); }
+static inline VInt iShl(VInt a, int n) { return _mm256_slli_epi32(a, n); }
+static inline VInt iShr(VInt a, int n) { return _mm256_srli_epi32(a, n); }
+static inline VInt iEqual(VInt a, VInt b) { return _mm256_cmpeq_epi32(a, b); }
+static inline VInt iLess(VInt a, VInt b) { return _mm256_cmpgt_epi32(b, a); }
+#elif defined(NOISE_SSE2)
+#define NOISE_WIDTH     4
+#define NOISE_SIMD_NAME "SSE2"
+typedef __m128  VFloat;
+typedef __m128i VInt;
+
+static inline VFloat vSet1(float a) { return _mm_set1_ps(a); }
+static inline VFloat vLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void   vStore(float* p, VFloat a) { _mm_storeu_ps(p, a); }
+static inline VFloat vAdd(VFloat a, VFloat b) { return _mm_add_ps(a, b); }
+static inline VFloat vSub(VFloat a, VFloat b) { return _mm_sub_ps(a, b); }
+static inline VFloat vMul(VFloat a, VFloat b) { return _mm_mul_ps(a, b); }
+static inline VFloat vMin(VFloat a, VFloat b) { return _mm_min_ps(a, b); }
+static inline VFloat vMax(VFloat a, VFloat b) { return _mm_max_ps(a, b); }
+static inline VFloat vAbs(VFloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline VFloat vXorBits(VFloat a, VInt bits) { return _mm_xor_ps(a, _mm_castsi128_ps(bits)); }
+static inline VFloat vSelect(VInt mask, VFloat a, VFloat b)
+{
+    const __m128 m = _mm_castsi128_ps(mask);
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline VInt   vTruncToInt(VFloat a) { return _mm_cvttps_epi32(a); }
+static inline VFloat vIntToFloat(VInt a) { return _mm_cvtepi32_ps(a); }
+static inline VInt   vGreater(VFloat a, VFloat b) { return _mm_castps_si128(_mm_cmpgt_ps(a, b)); }
+
+static inline VInt iSet1(int32_t a) { return _mm_set1_epi32(a); }
+static inline VInt iAdd(VInt a, VInt b) { return _mm_add_epi32(a, b); }
+static inline VInt iMul(VInt a, VInt b)
+{
+#if defined(__SSE4_1__)
+    return _mm_mullo_epi32(a, b);
+#else
+    // Low halves of the even and the odd lanes, interleaved back together
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+static inline VInt iXor(VInt a, VInt b) { return _mm_xor_si128(a, b); }
+static inline VInt iAnd(VInt a, VInt b) { return _mm_and_si128(a, b); }
+static inline VInt iShl(VInt a, int n) { return _mm_slli_epi32(a, n); }
+static inline VInt iShr(VInt a, int n) { return _mm_srli_epi32(a, n); }
+static inline VInt iEqual(VInt a, VInt b) { return _mm_cmpeq_epi32(a, b); }
+static inline VInt iLess(VInt a, VInt b) { return _mm_cmplt_epi32(a, b); }
+#elif defined(NOISE_NEON)
+#define NOISE_WIDTH     4
+#define NOISE_SIMD_NAME "NEON"
+typedef float32x4_t VFloat;
+typedef int32x4_t   VInt;
+
+static inline VFloat vSet1(float a) { return vdupq_n_f32(a); }
+static inline VFloat vLoad(const float* p) { return vld1q_f32(p); }
+static inline void   vStore(float* p, VFloat a) { vst1q_f32(p, a); }
+static inline VFloat vAdd(VFloat a, VFloat b) { return vaddq_f32(a, b); }
+static inline VFloat vSub(VFloat a, VFloat b) { return vsubq_f32(a, b); }
+static inline VFloat vMul(VFloat a, VFloat b) { return vmulq_f32(a, b); }
+static inline VFloat vMin(VFloat a, VFloat b) { return vminq_f32(a, b); }
+static inline VFloat vMax(VFloat a, VFloat b) { return vmaxq_f32(a, b); }
+static inline VFloat vAbs(VFloat a) { return vabsq_f32(a); }
+static inline VFloat vXorBits(VFloat a, VInt bits) { return vreinterpretq_f32_s32(veorq_s32(vreinterpretq_s32_f32(a), bits)); }
+static inline VFloat vSelect(VInt mask, VFloat a, VFloat b) { return vbslq_f32(vreinterpretq_u32_s32(mask), a, b); }
+static inline VInt   vTruncToInt(VFloat a) { return vcvtq_s32_f32(a); }
+static inline VFloat vIntToFloat(VInt a) { return vcvtq_f32_s32(a); }
+static inline VInt   vGreater(VFloat a, VFloat b) { return vreinterpretq_s32_u32(vcgtq_f32(a, b)); }
+
+static inline VInt iSet1(int32_t a) { return vdupq_n_s32(a); }
+static inline VInt iAdd(VInt a, VInt b) { return vaddq_s32(a, b); }
+static inline VInt iMul(VInt a, VInt b) { return vmulq_s32(a, b); }
+static inline VInt iXor(VInt a, VInt b) { return veorq_s32(a, b); }
+static inline VInt iAnd(VInt a, VInt b) { return vandq_s32(a, b); }
+static inline VInt iShl(VInt a, int n) { return vshlq_s32(a, vdupq_n_s32(n)); }
+static inline VInt iShr(VInt a, int n) { return vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(a), vdupq_n_s32(-n))); }
+static inline VInt iEqual(VInt a, VInt b) { return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+static inline VInt iLess(VInt a, VInt b) { return vreinterpretq_s32_u32(vcltq_s32(a, b)); }
+#else
+#define NOISE_WIDTH     1
+#define NOISE_SIMD_NAME "Scalar"
+typedef float   VFloat;
+typedef int32_t VInt;
+
+static inline VFloat vSet1(float a) { return a; }
+static inline VFloat vLoad(const float* p) { return *p; }
+static inline void   vStore(float* p, VFloat a) { *p = a; }
+static inline VFloat vAdd(VFloat a, VFloat b) { return a + b; }
+static inline VFloat vSub(VFloat a, VFloat b) { return a - b; }
+static inline VFloat vMul(VFloat a, VFloat b) { return a * b; }
+static inline VFloat vMin(VFloat a, VFloat b) { return b < a ? b : a; }
+static inline VFloat vMax(VFloat a, VFloat b) { return b > a ? b : a; }
+static inline VFloat vAbs(VFloat a) { return fabsf(a); }
+static inline VFloat vXorBits(VFloat a, VInt bits)
+{
+    uint32_t u;
+    memcpy(&u, &a, sizeof(u));
+    u ^= (uint32_t)bits;
+    memcpy(&a, &u, sizeof(u));
+    return a;
+}
+static inline VFloat vSelect(VInt mask, VFloat a, VFloat b) { return mask ? a : b; }
+static inline VInt   vTruncToInt(VFloat a) { return (int32_t)a; }
+static inline VFloat vIntToFloat(VInt a) { return (float)a; }
+static inline VInt   vGreater(VFloat a, VFloat b) { return a > b ? -1 : 0; }
+
+// Integer math wraps like the vector units do
+static inline VInt iSet1(int32_t a) { return a; }
+static inline VInt iAdd(VInt a, VInt b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+static inline VInt iMul(VInt a, VInt b) { return (int32_t)((uint32_t)a * (uint32_t)b); }
+static inline VInt iXor(VInt a, VInt b) { return a ^ b; }
+static inline VInt iAnd(VInt a, VInt b) { return a & b; }
+static inline VInt iShl(VInt a, int n) { return (int32_t)((uint32_t)a << n); }
+static inline VInt iShr(VInt a, int n) { return (int32_t)((uint32_t)a >> n); }
+static inline VInt iEqual(VInt a, VInt b) { return a == b ? -1 : 0; }
+static inline VInt iLess(VInt a, VInt b) { return a < b ? -1 : 0; }
+#endif
+
+static inline VFloat vLoadPartial(const float* p, uint32_t count)
+{
+    float lanes[NOISE_WIDTH] = {};
+    memcpy(lanes, p, count * sizeof(float));
+    return vLoad(lanes);
+}
+
+static inline void vStorePartial(float* p, VFloat a, uint32_t count)
+{
+    float lanes[NOISE_WIDTH];
+    vStore(lanes, a);
+    memcpy(p, lanes, count * sizeof(float));
+}
+
+// Rounds towards negative infinity, valid for |a| < 2^31
+static inline VFloat vFloor(VFloat a, VInt* pInt)
+{
+    VInt i = vTruncToInt(a);
+    // Truncation rounded a negative value up, the comparison mask is -1 in those lanes
+    i = iAdd(i, vGreater(vIntToFloat(i), a));
+    *pInt = i;
+    return vIntToFloat(i);
+}
+
+static inline VFloat vLerp(VFloat a, VFloat b, VFloat t) { return vAdd(a, vMul(vSub(b, a), t)); }
+
+/************************************************************************/
+// Gradient noise
+/************************************************************************/
+// Lattice coordinates are multiplied by these primes and combined with the seed before hashing
+#define NOISE_PRIME_X 501125321
+#define NOISE_PRIME_Y 1136930381
+#define NOISE_PRIME_Z 1720413743
+#define NOISE_PRIME_W 1066037191
+
+// Measured peaks of the raw gradient sums are about 1.5 (2D), 1.0 (3D) and 1.1 (4D), these keep every octave within [-1, 1]
+#define NOISE_GRADIENT_SCALE_2D 0.6f
+#define NOISE_GRADIENT_SCALE_3D 0.9f
+#define NOISE_GRADIENT_SCALE_4D 0.8f
+
+static inline VInt hashLattice(VInt seed, VInt primedX, VInt primedY, VInt primedZ, VInt primedW)
+{
+    VInt h = iXor(iXor(seed, primedX), iXor(iXor(primedY, primedZ), primedW));
+    h = iMul(h, iSet1(0x27d4eb2d));
+    h = iXor(h, iShr(h, 15));
+    h = iMul(h, iSet1(0x2c1b3c6d));
+    // The top bits are the best mixed, the gradients are picked from them
+    return iXor(h, iShr(h, 12));
+}
+
+static inline VFloat fade(VFloat t)
+{
+    // 6t^5 - 15t^4 + 10t^3
+    return vMul(vMul(vMul(t, t), t), vAdd(vMul(t, vSub(vMul(t, vSet1(6.0f)), vSet1(15.0f))), vSet1(10.0f)));
+}
+
+// Eight gradients (+-1, +-2) and (+-2, +-1)
+static inline VFloat gradient2D(VInt hash, VFloat x, VFloat y)
+{
+    const VInt   g = iShr(hash, 29);
+    const VInt   low = iLess(g, iSet1(4));
+    const VFloat u = vSelect(low, x, y);
+    const VFloat v = vSelect(low, y, x);
+    return vAdd(vXorBits(u, iShl(g, 31)), vXorBits(vAdd(v, v), iShl(iAnd(g, iSet1(2)), 30)));
+}
+
+// Twelve cube edge gradients, four of them twice
+static inline VFloat gradient3D(VInt hash, VFloat x, VFloat y, VFloat z)
+{
+    const VInt   g = iShr(hash, 28);
+    const VFloat u = vSelect(iLess(g, iSet1(8)), x, y);
+    const VFloat v = vSelect(iLess(g, iSet1(4)), y, vSelect(iEqual(iAnd(g, iSet1(13)), iSet1(12)), x, z));
+    return vAdd(vXorBits(u, iShl(g, 31)), vXorBits(v, iShl(iAnd(g, iSet1(2)), 30)));
+}
+
+// 32 gradients towards the edges of the tesseract
+static inline VFloat gradient4D(VInt hash, VFloat x, VFloat y, VFloat z, VFloat w)
+{
+    const VInt   g = iShr(hash, 27);
+    const VFloat u = vSelect(iLess(g, iSet1(24)), x, y);
+    const VFloat v = vSelect(iLess(g, iSet1(16)), y, z);
+    const VFloat t = vSelect(iLess(g, iSet1(8)), z, w);
+    return vAdd(vAdd(vXorBits(u, iShl(g, 31)), vXorBits(v, iShl(iAnd(g, iSet1(2)), 30))), vXorBits(t, iShl(iAnd(g, iSet1(4)), 29)));
+}
+
+static inline VFloat gradientNoise2D(VInt seed, VFloat x, VFloat y)
+{
+    VInt         ix, iy;
+    const VFloat x0 = vSub(x, vFloor(x, &ix));
+    const VFloat y0 = vSub(y, vFloor(y, &iy));
+    const VFloat x1 = vSub(x0, vSet1(1.0f));
+    const VFloat y1 = vSub(y0, vSet1(1.0f));
+
+    const VInt px0 = iMul(ix, iSet1(NOISE_PRIME_X));
+    const VInt py0 = iMul(iy, iSet1(NOISE_PRIME_Y));
+    const VInt px1 = iAdd(px0, iSet1(NOISE_PRIME_X));
+    const VInt py1 = iAdd(py0, iSet1(NOISE_PRIME_Y));
+    const VInt zero = iSet1(0);
+
+    const VFloat u = fade(x0);
+    const VFloat n0 = vLerp(gradient2D(hashLattice(seed, px0, py0, zero, zero), x0, y0),
+                            gradient2D(hashLattice(seed, px1, py0, zero, zero), x1, y0), u);
+    const VFloat n1 = vLerp(gradient2D(hashLattice(seed, px0, py1, zero, zero), x0, y1),
+                            gradient2D(hashLattice(seed, px1, py1, zero, zero), x1, y1), u);
+    return vMul(vLerp(n0, n1, fade(y0)), vSet1(NOISE_GRADIENT_SCALE_2D));
+}
+
+static inline VFloat gradientNoise3D(VInt seed, VFloat x, VFloat y, VFloat z)
+{
+    VInt         ix, iy, iz;
+    const VFloat x0 = vSub(x, vFloor(x, &ix));
+    const VFloat y0 = vSub(y, vFloor(y, &iy));
+    const VFloat z0 = vSub(z, vFloor(z, &iz));
+    const VFloat x1 = vSub(x0, vSet1(1.0f));
+    const VFloat y1 = vSub(y0, vSet1(1.0f));
+    const VFloat z1 = vSub(z0, vSet1(1.0f));
+
+    VInt       px[2];
+    px[0] = iMul(ix, iSet1(NOISE_PRIME_X));
+    px[1] = iAdd(px[0], iSet1(NOISE_PRIME_X));
+    VInt       py[2];
+    py[0] = iMul(iy, iSet1(NOISE_PRIME_Y));
+    py[1] = iAdd(py[0], iSet1(NOISE_PRIME_Y));
+    VInt       pz[2];
+    pz[0] = iMul(iz, iSet1(NOISE_PRIME_Z));
+    pz[1] = iAdd(pz[0], iSet1(NOISE_PRIME_Z));
+    const VInt zero = iSet1(0);
+
+    const VFloat u = fade(x0);
+    const VFloat v = fade(y0);
+    VFloat       layers[2];
+    for (int k = 0; k < 2; ++k)
+    {
+        const VFloat tz = k ? z1 : z0;
+        const VFloat n0 = vLerp(gradient3D(hashLattice(seed, px[0], py[0], pz[k], zero), x0, y0, tz),
+                                gradient3D(hashLattice(seed, px[1], py[0], pz[k], zero), x1, y0, tz), u);
+        const VFloat n1 = vLerp(gradient3D(hashLattice(seed, px[0], py[1], pz[k], zero), x0, y1, tz),
+                                gradient3D(hashLattice(seed, px[1], py[1], pz[k], zero), x1, y1, tz), u);
+        layers[k] = vLerp(n0, n1, v);
+    }
+    return vMul(vLerp(layers[0], layers[1], fade(z0)), vSet1(NOISE_GRADIENT_SCALE_3D));
+}
+
+static inline VFloat gradientNoise4D(VInt seed, VFloat x, VFloat y, VFloat z, VFloat w)
+{
+    VInt         ix, iy, iz, iw;
+    const VFloat x0 = vSub(x, vFloor(x, &ix));
+    const VFloat y0 = vSub(y, vFloor(y, &iy));
+    const VFloat z0 = vSub(z, vFloor(z, &iz));
+    const VFloat w0 = vSub(w, vFloor(w, &iw));
+    const VFloat x1 = vSub(x0, vSet1(1.0f));
+    const VFloat y1 = vSub(y0, vSet1(1.0f));
+    const VFloat z1 = vSub(z0, vSet1(1.0f));
+    const VFloat w1 = vSub(w0, vSet1(1.0f));
+
+    VInt       px[2];
+    px[0] = iMul(ix, iSet1(NOISE_PRIME_X));
+    px[1] = iAdd(px[0], iSet1(NOISE_PRIME_X));
+    VInt       py[2];
+    py[0] = iMul(iy, iSet1(NOISE_PRIME_Y));
+    py[1] = iAdd(py[0], iSet1(NOISE_PRIME_Y));
+    VInt       pz[2];
+    pz[0] = iMul(iz, iSet1(NOISE_PRIME_Z));
+    pz[1] = iAdd(pz[0], iSet1(NOISE_PRIME_Z));
+    VInt       pw[2];
+    pw[0] = iMul(iw, iSet1(NOISE_PRIME_W));
+    pw[1] = iAdd(pw[0], iSet1(NOISE_PRIME_W));
+
+    const VFloat u = fade(x0);
+    const VFloat v = fade(y0);
+    const VFloat s = fade(z0);
+    VFloat       volumes[2];
+    for (int l = 0; l < 2; ++l)
+    {
+        const VFloat tw = l ? w1 : w0;
+        VFloat       layers[2];
+        for (int k = 0; k < 2; ++k)
+        {
+            const VFloat tz = k ? z1 : z0;
+            const VFloat n0 = vLerp(gradient4D(hashLattice(seed, px[0], py[0], pz[k], pw[l]), x0, y0, tz, tw),
+                                    gradient4D(hashLattice(seed, px[1], py[0], pz[k], pw[l]), x1, y0, tz, tw), u);
+            const VFloat n1 = vLerp(gradient4D(hashLattice(seed, px[0], py[1], pz[k], pw[l]), x0, y1, tz, tw),
+                                    gradient4D(hashLattice(seed, px[1], py[1], pz[k], pw[l]), x1, y1, tz, tw), u);
+            layers[k] = vLerp(n0, n1, v);
+        }
+        volumes[l] = vLerp(layers[0], layers[1], s);
+    }
+    return vMul(vLerp(volumes[0], volumes[1], fade(w0)), vSet1(NOISE_GRADIENT_SCALE_4D));
+}
+
+/************************************************************************/
+// Legacy value noise
+/************************************************************************/
+// Perlin::interpolatedNoise3D smooths 4x4x4 lattice values and every smoothed value hashes its 3x3x3 neighbourhood.
+// The 6x6x6 hashes they share are computed once per point here, and then summed in the same order as Perlin::smoothedNoise3D
+// so the result stays bit-exact.
+#define LEGACY_OFFSET_2D(x, z)    ((x) + 6 * (z))
+#define LEGACY_OFFSET_3D(x, y, z) ((x) + 6 * (y) + 36 * (z))
+
+static const int LEGACY_CORNER_OFFSETS_2D[4] = { LEGACY_OFFSET_2D(-1, -1), LEGACY_OFFSET_2D(1, -1), LEGACY_OFFSET_2D(-1, 1),
+                                                 LEGACY_OFFSET_2D(1, 1) };
+static const int LEGACY_SIDE_OFFSETS_2D[4] = { LEGACY_OFFSET_2D(-1, 0), LEGACY_OFFSET_2D(1, 0), LEGACY_OFFSET_2D(0, -1),
+                                               LEGACY_OFFSET_2D(0, 1) };
+
+static const int LEGACY_DIAG_OFFSETS_3D[8] = { LEGACY_OFFSET_3D(-1, 1, -1),  LEGACY_OFFSET_3D(1, 1, -1),  LEGACY_OFFSET_3D(1, 1, 1),
+                                               LEGACY_OFFSET_3D(-1, 1, 1),   LEGACY_OFFSET_3D(-1, -1, -1), LEGACY_OFFSET_3D(1, -1, -1),
+                                               LEGACY_OFFSET_3D(1, -1, 1),   LEGACY_OFFSET_3D(-1, -1, 1) };
+static const int LEGACY_CORNER_OFFSETS_3D[12] = { LEGACY_OFFSET_3D(-1, -1, 0), LEGACY_OFFSET_3D(1, -1, 0), LEGACY_OFFSET_3D(-1, 1, 0),
+                                                  LEGACY_OFFSET_3D(1, 1, 0),   LEGACY_OFFSET_3D(-1, 0, -1), LEGACY_OFFSET_3D(1, 0, -1),
+                                                  LEGACY_OFFSET_3D(-1, 0, 1),  LEGACY_OFFSET_3D(1, 0, 1),   LEGACY_OFFSET_3D(0, -1, -1),
+                                                  LEGACY_OFFSET_3D(0, 1, -1),  LEGACY_OFFSET_3D(0, -1, 1),  LEGACY_OFFSET_3D(0, 1, 1) };
+static const int LEGACY_SIDE_OFFSETS_3D[6] = { LEGACY_OFFSET_3D(-1, 0, 0), LEGACY_OFFSET_3D(1, 0, 0), LEGACY_OFFSET_3D(0, -1, 0),
+                                               LEGACY_OFFSET_3D(0, 1, 0),  LEGACY_OFFSET_3D(0, 0, 1), LEGACY_OFFSET_3D(0, 0, -1) };
+
+// Perlin::noise2D / Perlin::noise3D of the lattice point whose combined coordinate is n
+static inline VFloat legacyHash(VInt n)
+{
+    n = iXor(iShl(n, 13), n);
+    VInt t = iAdd(iMul(n, iAdd(iMul(iMul(n, n), iSet1(15731)), iSet1(789221))), iSet1(1376312589));
+    t = iAnd(t, iSet1(0x7fffffff));
+    return vSub(vSet1(1.0f), vMul(vIntToFloat(t), vSet1(1.0f / 1073741824.0f)));
+}
+
+static inline VFloat legacySum(const VFloat* pHashes, const int* pOffsets, int count)
+{
+    VFloat sum = pHashes[pOffsets[0]];
+    for (int i = 1; i < count; ++i)
+        sum = vAdd(sum, pHashes[pOffsets[i]]);
+    return sum;
+}
+
+// Interpolation weight for INTERP_METHOD
+static inline VFloat legacyWeight(VFloat u)
+{
+    if (INTERP_METHOD != PerlinInterpolate::COSINE)
+        return u;
+
+    float lanes[NOISE_WIDTH];
+    vStore(lanes, u);
+    for (int i = 0; i < NOISE_WIDTH; ++i)
+        lanes[i] = (1.f - cos(lanes[i] * 3.1415927f)) * .5f;
+    return vLoad(lanes);
+}
+
+static inline VFloat legacyInterpolate(VFloat v0, VFloat v1, VFloat v2, VFloat v3, VFloat u)
+{
+    if (INTERP_METHOD != PerlinInterpolate::CUBIC)
+        return vAdd(vMul(v1, vSub(vSet1(1.f), u)), vMul(v2, u));
+
+    const VFloat P = vSub(vSub(v3, v2), vSub(v0, v1));
+    const VFloat Q = vSub(vSub(v0, v1), P);
+    const VFloat R = vSub(v2, v0);
+    const VFloat uu = vMul(u, u);
+    return vAdd(vAdd(vAdd(vMul(P, vMul(uu, u)), vMul(Q, uu)), vMul(R, u)), v1);
+}
+
+static inline VFloat legacyValueNoise2D(VFloat x, VFloat z)
+{
+    const VInt   ix = vTruncToInt(x);
+    const VInt   iz = vTruncToInt(z);
+    const VFloat fx = legacyWeight(vAbs(vSub(x, vIntToFloat(ix))));
+    const VFloat fz = legacyWeight(vAbs(vSub(z, vIntToFloat(iz))));
+    const VInt   base = iAdd(ix, iMul(iz, iSet1(59)));
+
+    // Lattice offsets -2..3 around (ix, iz)
+    VFloat hashes[6 * 6];
+    for (int dz = -2; dz <= 3; ++dz)
+        for (int dx = -2; dx <= 3; ++dx)
+            hashes[LEGACY_OFFSET_2D(dx + 2, dz + 2)] = legacyHash(iAdd(base, iSet1(dx + dz * 59)));
+
+    // Offsets -1..2
+    VFloat smoothed[4 * 4];
+    for (int z = 0; z < 4; ++z)
+        for (int x = 0; x < 4; ++x)
+        {
+            const VFloat* pCenter = &hashes[LEGACY_OFFSET_2D(x + 1, z + 1)];
+            const VFloat  corners = vMul(legacySum(pCenter, LEGACY_CORNER_OFFSETS_2D, 4), vSet1(1.f / 16.f));
+            const VFloat  sides = vMul(legacySum(pCenter, LEGACY_SIDE_OFFSETS_2D, 4), vSet1(1.f / 8.f));
+            const VFloat  center = vMul(pCenter[0], vSet1(1.f / 4.f));
+            smoothed[z * 4 + x] = vAdd(vAdd(corners, sides), center);
+        }
+
+    VFloat rows[4];
+    for (int z = 0; z < 4; ++z)
+        rows[z] = legacyInterpolate(smoothed[z * 4 + 0], smoothed[z * 4 + 1], smoothed[z * 4 + 2], smoothed[z * 4 + 3], fx);
+    return legacyInterpolate(rows[0], rows[1], rows[2], rows[3], fz);
+}
+
+static inline VFloat legacyValueNoise3D(VFloat x, VFloat y, VFloat z)
+{
+    const VInt   ix = vTruncToInt(x);
+    const VInt   iy = vTruncToInt(y);
+    const VInt   iz = vTruncToInt(z);
+    const VFloat fx = legacyWeight(vAbs(vSub(x, vIntToFloat(ix))));
+    const VFloat fy = legacyWeight(vAbs(vSub(y, vIntToFloat(iy))));
+    const VFloat fz = legacyWeight(vAbs(vSub(z, vIntToFloat(iz))));
+    const VInt   base = iAdd(iAdd(ix, iMul(iy, iSet1(101))), iMul(iz, iSet1(59)));
+
+    VFloat hashes[6 * 6 * 6];
+    for (int dz = -2; dz <= 3; ++dz)
+        for (int dy = -2; dy <= 3; ++dy)
+            for (int dx = -2; dx <= 3; ++dx)
+                hashes[LEGACY_OFFSET_3D(dx + 2, dy + 2, dz + 2)] = legacyHash(iAdd(base, iSet1(dx + dy * 101 + dz * 59)));
+
+    VFloat smoothed[4 * 4 * 4];
+    for (int z = 0; z < 4; ++z)
+        for (int y = 0; y < 4; ++y)
+            for (int x = 0; x < 4; ++x)
+            {
+                const VFloat* pCenter = &hashes[LEGACY_OFFSET_3D(x + 1, y + 1, z + 1)];
+                const VFloat  diags = vMul(legacySum(pCenter, LEGACY_DIAG_OFFSETS_3D, 8), vSet1(1.f / 64.f));
+                const VFloat  corners = vMul(legacySum(pCenter, LEGACY_CORNER_OFFSETS_3D, 12), vSet1(1.f / 32.f));
+                const VFloat  sides = vMul(legacySum(pCenter, LEGACY_SIDE_OFFSETS_3D, 6), vSet1(1.f / 16.f));
+                const VFloat  center = vMul(pCenter[0], vSet1(1.f / 8.f));
+                smoothed[(z * 4 + y) * 4 + x] = vAdd(vAdd(vAdd(corners, sides), center), diags);
+            }
+
+    // Along x, then z, then y like Perlin::interpolatedNoise3D
+    VFloat layers[4];
+    for (int y = 0; y < 4; ++y)
+    {
+        VFloat rows[4];
+        for (int z = 0; z < 4; ++z)
+        {
+            const VFloat* pRow = &smoothed[(z * 4 + y) * 4];
+            rows[z] = legacyInterpolate(pRow[0], pRow[1], pRow[2], pRow[3], fx);
+        }
+        layers[y] = legacyInterpolate(rows[0], rows[1], rows[2], rows[3], fz);
+    }
+    return legacyInterpolate(layers[0], layers[1], layers[2], layers[3], fy);
+}
+
+/************************************************************************/
+// FBM
+/************************************************************************/
+static inline VFloat finishFBM(const NoiseFBM* pFBM, VFloat total)
+{
+    total = vMul(total, vSet1(pFBM->mScale));
+    if (pFBM->bClamp)
+        total = vMin(vMax(total, vSet1(-1.0f)), vSet1(1.0f));
+    return total;
+}
+
+static VFloat noiseFBM2D(const NoiseFBM* pFBM, VFloat x, VFloat y)
+{
+    VFloat total = vSet1(0.0f);
+    for (uint32_t o = 0; o < pFBM->mOctaveCount; ++o)
+    {
+        const VFloat f = vSet1(pFBM->mFrequencies[o]);
+        const VFloat n = pFBM->mType == NOISE_TYPE_LEGACY_VALUE
+                             ? legacyValueNoise2D(vMul(x, f), vMul(y, f))
+                             : gradientNoise2D(iSet1((int32_t)(pFBM->mSeed + o)), vMul(x, f), vMul(y, f));
+        total = vAdd(total, vMul(n, vSet1(pFBM->mAmplitudes[o])));
+    }
+    return finishFBM(pFBM, total);
+}
+
+static VFloat noiseFBM3D(const NoiseFBM* pFBM, VFloat x, VFloat y, VFloat z)
+{
+    VFloat total = vSet1(0.0f);
+    for (uint32_t o = 0; o < pFBM->mOctaveCount; ++o)
+    {
+        const VFloat f = vSet1(pFBM->mFrequencies[o]);
+        const VFloat n = pFBM->mType == NOISE_TYPE_LEGACY_VALUE
+                             ? legacyValueNoise3D(vMul(x, f), vMul(y, f), vMul(z, f))
+                             : gradientNoise3D(iSet1((int32_t)(pFBM->mSeed + o)), vMul(x, f), vMul(y, f), vMul(z, f));
+        total = vAdd(total, vMul(n, vSet1(pFBM->mAmplitudes[o])));
+    }
+    return finishFBM(pFBM, total);
+}
+
+static VFloat noiseFBM4D(const NoiseFBM* pFBM, VFloat x, VFloat y, VFloat z, VFloat w)
+{
+    VFloat total = vSet1(0.0f);
+    for (uint32_t o = 0; o < pFBM->mOctaveCount; ++o)
+    {
+        const VFloat f = vSet1(pFBM->mFrequencies[o]);
+        const VFloat n = gradientNoise4D(iSet1((int32_t)(pFBM->mSeed + o)), vMul(x, f), vMul(y, f), vMul(z, f), vMul(w, f));
+        total = vAdd(total, vMul(n, vSet1(pFBM->mAmplitudes[o])));
+    }
+    return finishFBM(pFBM, total);
+}
+
+void getDefaultNoiseFBMDesc(NoiseFBMDesc* pDesc)
+{
+    pDesc->mType = NOISE_TYPE_GRADIENT;
+    pDesc->mOctaveCount = 6;
+    pDesc->mFrequency = 1.0f;
+    pDesc->mLacunarity = 2.0f;
+    pDesc->mAmplitude = 1.0f;
+    pDesc->mGain = 0.5f;
+    pDesc->mScale = 1.0f;
+    pDesc->bNormalize = true;
+    pDesc->bClamp = true;
+    pDesc->mSeed = 0;
+}
+
+void getLegacyPerlinNoiseFBMDesc2D(NoiseFBMDesc* pDesc)
+{
+    pDesc->mType = NOISE_TYPE_LEGACY_VALUE;
+    pDesc->mOctaveCount = OCTAVES;
+    pDesc->mFrequency = 1.0f;
+    pDesc->mLacunarity = 2.0f;
+    pDesc->mAmplitude = 1.0f;
+    pDesc->mGain = (float)PERSISTANCE;
+    pDesc->mScale = SCALE2D;
+    pDesc->bNormalize = false;
+    pDesc->bClamp = false;
+    pDesc->mSeed = 0;
+}
+
+void getLegacyPerlinNoiseFBMDesc3D(NoiseFBMDesc* pDesc)
+{
+    getLegacyPerlinNoiseFBMDesc2D(pDesc);
+    // perlinNoise3D starts one octave weight lower and clamps the result
+    pDesc->mAmplitude = (float)PERSISTANCE;
+    pDesc->mScale = SCALE3D;
+    pDesc->bClamp = true;
+}
+
+void initNoiseFBM(const NoiseFBMDesc* pDesc, NoiseFBM* pFBM)
+{
+    ASSERT(pDesc->mOctaveCount > 0 && pDesc->mOctaveCount <= NOISE_MAX_OCTAVES);
+
+    pFBM->mType = pDesc->mType;
+    pFBM->mOctaveCount = pDesc->mOctaveCount;
+    pFBM->mSeed = pDesc->mSeed;
+    pFBM->bClamp = pDesc->bClamp;
+
+    double weightSum = 0.0;
+    for (uint32_t o = 0; o < pFBM->mOctaveCount; ++o)
+    {
+        pFBM->mFrequencies[o] = (float)((double)pDesc->mFrequency * pow((double)pDesc->mLacunarity, (double)o));
+        pFBM->mAmplitudes[o] = (float)((double)pDesc->mAmplitude * pow((double)pDesc->mGain, (double)o));
+        weightSum += fabs((double)pFBM->mAmplitudes[o]);
+    }
+
+    pFBM->mScale = pDesc->mScale;
+    if (pDesc->bNormalize && weightSum > 0.0)
+        pFBM->mScale = (float)(pDesc->mScale / weightSum);
+}
+
+void evaluateNoiseFBM2D(const NoiseFBM* pFBM, const float* pX, const float* pY, float* pOut, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i += NOISE_WIDTH)
+    {
+        const uint32_t laneCount = count - i < NOISE_WIDTH ? count - i : NOISE_WIDTH;
+        if (laneCount == NOISE_WIDTH)
+        {
+            vStore(pOut + i, noiseFBM2D(pFBM, vLoad(pX + i), vLoad(pY + i)));
+            continue;
+        }
+        vStorePartial(pOut + i, noiseFBM2D(pFBM, vLoadPartial(pX + i, laneCount), vLoadPartial(pY + i, laneCount)), laneCount);
+    }
+}
+
+void evaluateNoiseFBM3D(const NoiseFBM* pFBM, const float* pX, const float* pY, const float* pZ, float* pOut, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i += NOISE_WIDTH)
+    {
+        const uint32_t laneCount = count - i < NOISE_WIDTH ? count - i : NOISE_WIDTH;
+        if (laneCount == NOISE_WIDTH)
+        {
+            vStore(pOut + i, noiseFBM3D(pFBM, vLoad(pX + i), vLoad(pY + i), vLoad(pZ + i)));
+            continue;
+        }
+        vStorePartial(pOut + i,
+                      noiseFBM3D(pFBM, vLoadPartial(pX + i, laneCount), vLoadPartial(pY + i, laneCount), vLoadPartial(pZ + i, laneCount)),
+                      laneCount);
+    }
+}
+
+void evaluateNoiseFBM4D(const NoiseFBM* pFBM, const float* pX, const float* pY, const float* pZ, const float* pW, float* pOut,
+                        uint32_t count)
+{
+    ASSERT(pFBM->mType != NOISE_TYPE_LEGACY_VALUE);
+
+    for (uint32_t i = 0; i < count; i += NOISE_WIDTH)
+    {
+        const uint32_t laneCount = count - i < NOISE_WIDTH ? count - i : NOISE_WIDTH;
+        if (laneCount == NOISE_WIDTH)
+        {
+            vStore(pOut + i, noiseFBM4D(pFBM, vLoad(pX + i), vLoad(pY + i), vLoad(pZ + i), vLoad(pW + i)));
+            continue;
+        }
+        vStorePartial(pOut + i,
+                      noiseFBM4D(pFBM, vLoadPartial(pX + i, laneCount), vLoadPartial(pY + i, laneCount), vLoadPartial(pZ + i, laneCount),
+                                 vLoadPartial(pW + i, laneCount)),
+                      laneCount);
+    }
+}
+
+const char* getNoiseSIMDName() { return NOISE_SIMD_NAME; }
+
+uint32_t getNoiseSIMDWidth() { return NOISE_WIDTH; }
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define NOISE_MAX_OCTAVES 16
+
+enum NoiseType
+{
+    // Seeded gradient noise with quintic fade, every octave is in [-1, 1]
+    NOISE_TYPE_GRADIENT = 0,
+    // Same output as the Perlin class value noise (2D and 3D only), use it to keep existing content unchanged
+    NOISE_TYPE_LEGACY_VALUE,
+};
+
+typedef struct NoiseFBMDesc
+{
+    NoiseType mType;
+    uint32_t  mOctaveCount;
+    // Octave i is sampled at mFrequency * mLacunarity^i and weighted by mAmplitude * mGain^i
+    float     mFrequency;
+    float     mLacunarity;
+    float     mAmplitude;
+    float     mGain;
+    // Applied to the sum of all octaves. With bNormalize it is also divided by the sum of the weights.
+    float     mScale;
+    bool      bNormalize;
+    bool      bClamp; // Clamp the result to [-1, 1]
+    uint32_t  mSeed;  // Ignored by NOISE_TYPE_LEGACY_VALUE
+} NoiseFBMDesc;
+
+// Octave frequencies and weights are computed once here instead of per sample
+typedef struct NoiseFBM
+{
+    NoiseType mType;
+    uint32_t  mOctaveCount;
+    uint32_t  mSeed;
+    float     mScale;
+    bool      bClamp;
+    float     mFrequencies[NOISE_MAX_OCTAVES];
+    float     mAmplitudes[NOISE_MAX_OCTAVES];
+} NoiseFBM;
+
+// Six octaves of normalized, clamped gradient noise
+void getDefaultNoiseFBMDesc(NoiseFBMDesc* pDesc);
+// Same octaves, weights, scale and clamping as Perlin::perlinNoise2D / Perlin::perlinNoise3D
+void getLegacyPerlinNoiseFBMDesc2D(NoiseFBMDesc* pDesc);
+void getLegacyPerlinNoiseFBMDesc3D(NoiseFBMDesc* pDesc);
+
+void initNoiseFBM(const NoiseFBMDesc* pDesc, NoiseFBM* pFBM);
+
+// Evaluate count points given as separate coordinate arrays. A single octave FBM gives plain noise.
+// NOISE_TYPE_LEGACY_VALUE is not available in 4D.
+void evaluateNoiseFBM2D(const NoiseFBM* pFBM, const float* pX, const float* pY, float* pOut, uint32_t count);
+void evaluateNoiseFBM3D(const NoiseFBM* pFBM, const float* pX, const float* pY, const float* pZ, float* pOut, uint32_t count);
+void evaluateNoiseFBM4D(const NoiseFBM* pFBM, const float* pX, const float* pY, const float* pZ, const float* pW, float* pOut,
+                        uint32_t count);
+
+// Instruction set the batches are evaluated with ("AVX2", "SSE2", "NEON" or "Scalar") and how many points it processes at once
+const char* getNoiseSIMDName();
+uint32_t    getNoiseSIMDWidth();
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include "../../../The-Forge/Common_3/Utilities/Interfaces/IThread.h"
+#include "../../../The-Forge/Common_3/Utilities/Threading/Atomics.h"
+
+// Upper bound of threads used for startup work like terrain and sky generation
+#define PARALLEL_FOR_MAX_THREADS 16
+
+typedef void (*ParallelForTaskFunc)(void* pUserData, uint32_t taskIndex);
+
+struct ParallelForData
+{
+    ParallelForTaskFunc pTask;
+    void*               pUserData;
+    uint32_t            taskCount;
+    tfrg_atomic32_t     nextTask;
+};
+
+static inline void parallelForWorker(void* pData)
+{
+    ParallelForData* pFor = (ParallelForData*)pData;
+    for (uint32_t task = (uint32_t)tfrg_atomic32_add_relaxed(&pFor->nextTask, 1); task < pFor->taskCount;
+         task = (uint32_t)tfrg_atomic32_add_relaxed(&pFor->nextTask, 1))
+    {
+        pFor->pTask(pFor->pUserData, task);
+    }
+}
+
+// Tasks are picked up by the calling thread and up to threadCount - 1 helpers until all of them ran.
+// threadCount 0 uses one thread per CPU core, 1 runs every task on the calling thread.
+static inline void parallelFor(ParallelForTaskFunc pTask, void* pUserData, uint32_t taskCount, uint32_t threadCount = 0)
+{
+    ParallelForData data = {};
+    data.pTask = pTask;
+    data.pUserData = pUserData;
+    data.taskCount = taskCount;
+
+    if (threadCount == 0)
+        threadCount = (uint32_t)getNumCPUCores();
+    threadCount = threadCount < PARALLEL_FOR_MAX_THREADS ? threadCount : PARALLEL_FOR_MAX_THREADS;
+    threadCount = threadCount < taskCount ? threadCount : taskCount;
+    threadCount = threadCount > 1 ? threadCount : 1;
+
+    ThreadHandle helpers[PARALLEL_FOR_MAX_THREADS - 1];
+    for (uint32_t i = 0; i < threadCount - 1; ++i)
+    {
+        ThreadDesc threadDesc = {};
+        threadDesc.pFunc = parallelForWorker;
+        threadDesc.pData = &data;
+        initThread(&threadDesc, &helpers[i]);
+    }
+
+    parallelForWorker(&data);
+
+    for (uint32_t i = 0; i < threadCount - 1; ++i)
+        joinThread(helpers[i]);
+}
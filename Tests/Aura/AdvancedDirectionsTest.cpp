@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Propagation with advanced directions reads its neighbour/face terms from the tables built at load. It has to give what
+//	the kernel gave when it rebuilt the solid angle, the propagation direction, the SH basis and the cosine lobe of every pair
+//	per cell, on one thread and on worker tasks.
+
+#include "../../Aura/LightPropagation/LightPropagationCPUContext.h"
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gGridResolutions[] = { 16, 24 };
+static const int      gPropagationSteps = 8;
+
+static const float gSqrtPi = 1.7724538509055160272974217986853f;
+static const float gSHBand1 = 1.7320508075688772935274463415059f / (2.0f * gSqrtPi);
+static const vec4  gSHBasis(1.0f / (2.0f * gSqrtPi), -gSHBand1, gSHBand1, -gSHBand1);
+//	m_InputOffset order: +k, -k, +j, -j, +i, -i
+static const vec3  gConeDirs[6] = { vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1) };
+
+static vec4 rotateSH(vec3 dir, const vec2& zhCoeffs)
+{
+    if (1.0f - fabsf(dir.z) < 0.001f)
+    {
+        dir.x = 0.0f;
+        dir.y = 1.0f;
+    }
+    const vec2 theta = normalize(vec2(dir.x, dir.y));
+    const vec2 phi(sqrtf(1.0f - dir.z * dir.z), dir.z);
+    return vec4(zhCoeffs.x, -zhCoeffs.y * phi.x * theta.y, zhCoeffs.y * phi.y, -zhCoeffs.y * phi.x * theta.x);
+}
+
+static float getSolidAngle(const vec3& dir, const vec3& faceDir)
+{
+    const float faceType = dot(dir, faceDir);
+    if (faceType < -0.01f)
+        return 0.0f;
+    return faceType > 0.01f ? 0.40066966f : 0.42343134f;
+}
+
+//	What the neighbour in direction n sends through face v, rebuilt per cell like the kernel used to
+static vec4 propagateVirtualDir(const vec4& src, int n, int v)
+{
+    const vec3  nOffset = gConeDirs[n];
+    const vec3  virtDir = gConeDirs[v];
+    const float solidAngle = getSolidAngle(-nOffset, virtDir);
+    if (solidAngle <= 0)
+        return vec4(0.0f, 0.0f, 0.0f, 0.0f);
+
+    const vec3  propDir = normalize(-nOffset + 0.5f * virtDir);
+    const float luminance = dot(src, vec4(1.0f, propDir.y, propDir.z, propDir.x) * gSHBasis);
+    const float reprojLuminance = solidAngle * 0.5f * max(luminance, 0.0f);
+    return rotateSH(virtDir, gSqrtPi * vec2(0.25f, 0.5f)) * reprojLuminance;
+}
+
+//	Every step of every channel, the accumulated light ends up in pGrid
+static void propagateReference(vec4* pGrid, int res, int steps)
+{
+    const size_t      cellCount = (size_t)res * res * res;
+    std::vector<vec4> src(pGrid, pGrid + cellCount);
+    std::vector<vec4> step(cellCount);
+    for (int s = 0; s < steps; ++s)
+    {
+        for (int i = 0; i < res; ++i)
+        {
+            for (int j = 0; j < res; ++j)
+            {
+                for (int k = 0; k < res; ++k)
+                {
+                    //	Neighbour and face n exist on the same side of the cell
+                    const bool exists[6] = { k < res - 1, k > 0, j < res - 1, j > 0, i < res - 1, i > 0 };
+                    const int  offsets[6] = { 1, -1, res, -res, res * res, -res * res };
+                    const int  cell = (i * res + j) * res + k;
+                    vec4       result(0.0f, 0.0f, 0.0f, 0.0f);
+                    for (int n = 0; n < 6; ++n)
+                    {
+                        if (!exists[n])
+                            continue;
+                        vec4 neighbour(0.0f, 0.0f, 0.0f, 0.0f);
+                        for (int v = 0; v < 6; ++v)
+                        {
+                            if (exists[v])
+                                neighbour += propagateVirtualDir(src[cell + offsets[n]], n, v);
+                        }
+                        result += neighbour;
+                    }
+                    step[cell] = result;
+                    pGrid[cell] = s ? pGrid[cell] + result : result + src[cell];
+                }
+            }
+        }
+        src.swap(step);
+    }
+}
+
+static void injectLight(vec4* pGrid, int res, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    memset(pGrid, 0, (size_t)res * res * res * sizeof(vec4));
+    //	A few lights, one of them on a border
+    for (int light = 0; light < 6; ++light)
+    {
+        const int i = light ? (int)(rng() % res) : 0;
+        const int j = (int)(rng() % res);
+        const int k = (int)(rng() % res);
+        pGrid[(i * res + j) * res + k] = vec4(1.0f + dist(rng) * 0.5f, dist(rng) * 0.5f, dist(rng) * 0.5f, dist(rng) * 0.5f);
+    }
+}
+
+int main()
+{
+    ITaskManager* pTaskManager = NULL;
+    initDefaultTaskManager(3, &pTaskManager);
+    std::mt19937 rng(11);
+
+    for (uint32_t res : gGridResolutions)
+    {
+        const size_t cellCount = (size_t)res * res * res;
+
+        LightPropagationCPUContext context;
+        context.loadHeadless(res, NULL);
+        context.setAdvancedDirections(true);
+        context.setPropagationSteps(gPropagationSteps);
+
+        std::vector<vec4> injected[3];
+        std::vector<vec4> expected[3];
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            injected[c].resize(cellCount);
+            injectLight(injected[c].data(), (int)res, rng);
+            expected[c] = injected[c];
+            propagateReference(expected[c].data(), (int)res, gPropagationSteps);
+        }
+
+        const MTTypes modes[] = { MT_None, MT_ExtremeTasks };
+        for (MTTypes mode : modes)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+                memcpy(context.getCPUGrid(c), injected[c].data(), cellCount * sizeof(vec4));
+            context.propagate(pTaskManager, mode);
+
+            float maxError = 0.0f;
+            float maxValue = 0.0f;
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                const vec4* pGrid = context.getCPUGrid(c);
+                for (size_t i = 0; i < cellCount; ++i)
+                {
+                    const vec4 d = pGrid[i] - expected[c][i];
+                    maxError = max(maxError, max(max(fabsf(d.x), fabsf(d.y)), max(fabsf(d.z), fabsf(d.w))));
+                    maxValue = max(maxValue, fabsf(expected[c][i].x));
+                }
+            }
+            printf("res %u %s: max difference %g of %g\n", res, mode == MT_None ? "single thread" : "tasks", maxError, maxValue);
+            CHECK(maxValue > 0.0f);
+            CHECK(maxError <= 1e-6f * maxValue);
+        }
+
+        context.unloadHeadless(pTaskManager);
+    }
+
+    removeDefaultTaskManager(pTaskManager);
+    return TEST_RESULT();
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Default memory manager: repeated load/unload cycles of the CPU propagation and the task manager may not leak or keep
+//	growing the pools, and trimMemoryPools gives every chunk without live allocations back.
+
+#include "../../Aura/LightPropagation/LightPropagationCPUContext.h"
+
+#include <stdint.h>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gCycleCount = 8;
+
+//	What exitAura leaves behind for the CPU propagation: task manager, arena backed contexts and the incremental grids
+static void loadExitCycle(uint32_t cycle)
+{
+    ITaskManager* pTaskManager = NULL;
+    initDefaultTaskManager(2, &pTaskManager);
+
+    const uint32_t gridRes = cycle % 2 ? 32 : 16;
+    LinearArena    arena;
+    //	Room for two of the three contexts, the last one falls back to aura::alloc
+    initLinearArena(2 * LightPropagationCPUContext::getGridStorageSize(gridRes), &arena);
+
+    LightPropagationCPUContext contexts[3];
+    for (LightPropagationCPUContext& context : contexts)
+    {
+        CHECK(context.loadHeadless(gridRes, &arena));
+        context.setIncrementalPropagation(true);
+        context.getCPUGrid(0)[cycle] = vec4(1.0f, 0.0f, 0.0f, 0.0f);
+        context.propagate(pTaskManager, MT_ExtremeTasks);
+    }
+
+    //	Small allocations of every size class alongside
+    std::vector<void*> blocks;
+    for (uint32_t i = 0; i < 3000; ++i)
+        blocks.push_back(aura::alloc(1 + (i * 37) % 300));
+    for (void* ptr : blocks)
+        aura::dealloc(ptr);
+
+    for (LightPropagationCPUContext& context : contexts)
+        context.unloadHeadless(pTaskManager);
+    exitLinearArena(&arena);
+    removeDefaultTaskManager(pTaskManager);
+}
+
+static void testTrimKeepsLiveChunks()
+{
+    std::vector<void*> blocks;
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        void* ptr = aura::alloc(24);
+        CHECK(((uintptr_t)ptr & 15) == 0);
+        blocks.push_back(ptr);
+    }
+
+    MemoryStats full;
+    getMemoryStats(&full);
+
+    //	Keep every 5000th block, most chunks become empty
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        if (i % 5000)
+        {
+            aura::dealloc(blocks[i]);
+            blocks[i] = NULL;
+        }
+    }
+    trimMemoryPools();
+
+    MemoryStats trimmed;
+    getMemoryStats(&trimmed);
+    CHECK(trimmed.mLiveAllocations == 4);
+    CHECK(trimmed.mReservedBytes > 0);
+    CHECK(trimmed.mReservedBytes < full.mReservedBytes / 2);
+
+    //	Blocks of the surviving chunks are still handed out and the kept blocks are intact
+    for (size_t i = 0; i < blocks.size(); i += 5000)
+        *(uint64_t*)blocks[i] = i;
+    std::vector<void*> more;
+    for (uint32_t i = 0; i < 5000; ++i)
+        more.push_back(aura::alloc(20));
+    for (size_t i = 0; i < blocks.size(); i += 5000)
+        CHECK(*(uint64_t*)blocks[i] == i);
+
+    for (void* ptr : more)
+        aura::dealloc(ptr);
+    for (void* ptr : blocks)
+        aura::dealloc(ptr);
+    trimMemoryPools();
+}
+
+int main()
+{
+    size_t firstPeakReserved = 0;
+    for (uint32_t cycle = 0; cycle < gCycleCount; ++cycle)
+    {
+        loadExitCycle(cycle);
+
+        MemoryStats beforeTrim;
+        getMemoryStats(&beforeTrim);
+        CHECK(beforeTrim.mLiveAllocations == 0);
+        CHECK(beforeTrim.mLiveBytes == 0);
+        //	Pools keep their chunks until they are trimmed, but reuse them from cycle to cycle
+        if (cycle < 2)
+            firstPeakReserved = beforeTrim.mReservedBytes > firstPeakReserved ? beforeTrim.mReservedBytes : firstPeakReserved;
+        else
+            CHECK(beforeTrim.mReservedBytes <= firstPeakReserved);
+
+        trimMemoryPools();
+        MemoryStats afterTrim;
+        getMemoryStats(&afterTrim);
+        CHECK(afterTrim.mReservedBytes == 0);
+    }
+
+    testTrimKeepsLiveChunks();
+
+    MemoryStats final;
+    getMemoryStats(&final);
+    CHECK(final.mLiveAllocations == 0);
+    CHECK(final.mReservedBytes == 0);
+    return TEST_RESULT();
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Stress test of the default task manager: dependency order of chains and diamonds built by several threads at once,
+//	recycling of every task set slot many times over, stale handles, and worker contexts of two managers started together.
+
+#include "../../Aura/Interfaces/IAuraTaskManager.h"
+
+#include <atomic>
+#include <pthread.h>
+#include <thread>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+/************************************************************************/
+// Dependencies
+/************************************************************************/
+struct OrderRecord
+{
+    std::atomic<uint32_t>* pClock;
+    uint32_t               mStart; //	Clock when the first subtask started
+    uint32_t               mEnd;   //	Clock when the last subtask finished
+    std::atomic<uint32_t>  mStarted;
+    std::atomic<uint32_t>  mFinished;
+};
+
+static void recordOrder(void* pArg, int32_t, uint32_t, uint32_t count)
+{
+    OrderRecord* pRecord = (OrderRecord*)pArg;
+    if (pRecord->mStarted.fetch_add(1) == 0)
+        pRecord->mStart = pRecord->pClock->fetch_add(1);
+    if (pRecord->mFinished.fetch_add(1) == count - 1)
+        pRecord->mEnd = pRecord->pClock->fetch_add(1);
+}
+
+static void initRecord(OrderRecord* pRecord, std::atomic<uint32_t>* pClock)
+{
+    pRecord->pClock = pClock;
+    pRecord->mStart = pRecord->mEnd = 0;
+    pRecord->mStarted.store(0);
+    pRecord->mFinished.store(0);
+}
+
+//	Chains of sets, each with several subtasks, where every set depends on the previous one
+static void buildChains(ITaskManager* pTaskManager, uint32_t seed, std::atomic<int>* pFailures)
+{
+    const uint32_t           chainLength = 64;
+    std::atomic<uint32_t>    clock(0);
+    std::vector<OrderRecord> records(chainLength);
+    ITASKSETHANDLE           handles[chainLength];
+
+    for (uint32_t round = 0; round < 20; ++round)
+    {
+        clock.store(0);
+        for (uint32_t i = 0; i < chainLength; ++i)
+        {
+            initRecord(&records[i], &clock);
+            const uint32_t subtasks = 1 + (seed + i * 7 + round) % 9;
+            if (!pTaskManager->createTaskSet(0, recordOrder, &records[i], subtasks, i ? &handles[i - 1] : NULL, i ? 1 : 0, "Chain",
+                                             &handles[i]))
+                ++*pFailures;
+        }
+
+        pTaskManager->waitForTaskSet(handles[chainLength - 1]);
+        for (uint32_t i = 1; i < chainLength; ++i)
+        {
+            if (records[i].mStart < records[i - 1].mEnd)
+                ++*pFailures;
+        }
+        pTaskManager->releaseTasks(handles, chainLength);
+    }
+}
+
+//	A -> (B, C) -> D, with B and C released before D runs
+static void testDiamond(ITaskManager* pTaskManager)
+{
+    std::atomic<uint32_t> clock(0);
+    OrderRecord           records[4];
+    for (OrderRecord& record : records)
+        initRecord(&record, &clock);
+
+    ITASKSETHANDLE a, b, c, d;
+    CHECK(pTaskManager->createTaskSet(0, recordOrder, &records[0], 16, NULL, 0, "A", &a));
+    CHECK(pTaskManager->createTaskSet(0, recordOrder, &records[1], 7, &a, 1, "B", &b));
+    CHECK(pTaskManager->createTaskSet(0, recordOrder, &records[2], 3, &a, 1, "C", &c));
+    ITASKSETHANDLE bc[] = { b, c };
+    CHECK(pTaskManager->createTaskSet(0, recordOrder, &records[3], 5, bc, 2, "D", &d));
+    pTaskManager->releaseTask(b);
+    pTaskManager->releaseTask(c);
+    pTaskManager->waitForTaskSet(d);
+
+    CHECK(records[1].mStart > records[0].mEnd);
+    CHECK(records[2].mStart > records[0].mEnd);
+    CHECK(records[3].mStart > records[1].mEnd);
+    CHECK(records[3].mStart > records[2].mEnd);
+    ITASKSETHANDLE ad[] = { a, d };
+    pTaskManager->releaseTasks(ad, 2);
+    pTaskManager->waitAll();
+}
+
+/************************************************************************/
+// Slot recycling
+/************************************************************************/
+static void countTask(void* pArg, int32_t, uint32_t, uint32_t) { ((std::atomic<uint32_t>*)pArg)->fetch_add(1); }
+
+//	Far more sets than there are slots. Handles of released sets have to stay done once their slot belongs to a newer set.
+static void testRecycling(ITaskManager* pTaskManager)
+{
+    const uint32_t        setCount = 40000;
+    std::atomic<uint32_t> counter(0);
+    ITASKSETHANDLE        first = ITASKSETHANDLE_INVALID;
+    ITASKSETHANDLE        previous = ITASKSETHANDLE_INVALID;
+
+    for (uint32_t i = 0; i < setCount; ++i)
+    {
+        ITASKSETHANDLE handle;
+        CHECK(pTaskManager->createTaskSet(0, countTask, &counter, 1 + i % 3, NULL, 0, "Recycle", &handle));
+        if (i == 0)
+            first = handle;
+
+        //	Keep one set in flight while the previous one is released
+        if (previous != ITASKSETHANDLE_INVALID)
+        {
+            pTaskManager->waitForTaskSet(previous);
+            pTaskManager->releaseTask(previous);
+            CHECK(pTaskManager->isTaskDone(previous));
+        }
+        previous = handle;
+    }
+    pTaskManager->waitForTaskSet(previous);
+    pTaskManager->releaseTask(previous);
+    pTaskManager->waitAll();
+
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < setCount; ++i)
+        expected += 1 + i % 3;
+    CHECK(counter.load() == expected);
+    CHECK(pTaskManager->isTaskDone(first));
+    CHECK(pTaskManager->isTaskDone(ITASKSETHANDLE_INVALID));
+    //	Releasing a stale handle again mustn't free the slot of a newer set
+    pTaskManager->releaseTask(first);
+
+    ITASKSETHANDLE handle;
+    std::atomic<uint32_t> after(0);
+    CHECK(pTaskManager->createTaskSet(0, countTask, &after, 4, NULL, 0, "After", &handle));
+    pTaskManager->waitForTaskSet(handle);
+    CHECK(after.load() == 4);
+    pTaskManager->releaseTask(handle);
+}
+
+//	Threads poll handles while other threads recycle their slots
+static void testConcurrentPolling(ITaskManager* pTaskManager)
+{
+    std::atomic<bool>     stop(false);
+    std::atomic<uint32_t> counter(0);
+    std::vector<ITASKSETHANDLE> stale;
+
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        ITASKSETHANDLE handle;
+        pTaskManager->createTaskSet(0, countTask, &counter, 1, NULL, 0, "Stale", &handle);
+        pTaskManager->waitForTaskSet(handle);
+        pTaskManager->releaseTask(handle);
+        stale.push_back(handle);
+    }
+
+    std::atomic<uint32_t> notDone(0);
+    std::thread           poller([&]() {
+        while (!stop.load())
+        {
+            for (ITASKSETHANDLE handle : stale)
+            {
+                if (!pTaskManager->isTaskDone(handle))
+                    notDone.fetch_add(1);
+            }
+        }
+    });
+
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        ITASKSETHANDLE handle;
+        pTaskManager->createTaskSet(0, countTask, &counter, 2, NULL, 0, "Churn", &handle);
+        pTaskManager->releaseTask(handle);
+    }
+    pTaskManager->waitAll();
+    stop.store(true);
+    poller.join();
+
+    CHECK(notDone.load() == 0);
+}
+
+/************************************************************************/
+// Worker contexts
+/************************************************************************/
+static const uint32_t MAX_CONTEXTS = 64;
+
+struct ContextRecord
+{
+    uint32_t                 mThreadCount;
+    std::atomic<uint32_t>    mInvalid;
+    std::atomic<uintptr_t>   mThreadOfContext[MAX_CONTEXTS];
+    std::atomic<uint32_t>    mMismatches;
+};
+
+static void recordContext(void* pArg, int32_t context, uint32_t, uint32_t)
+{
+    ContextRecord* pRecord = (ContextRecord*)pArg;
+    if (context < 0 || (uint32_t)context >= pRecord->mThreadCount || (uint32_t)context >= MAX_CONTEXTS)
+    {
+        pRecord->mInvalid.fetch_add(1);
+        return;
+    }
+
+    //	A context belongs to one thread, otherwise per-context scratch memory of the tasks gets shared
+    uintptr_t self = (uintptr_t)pthread_self();
+    uintptr_t owner = 0;
+    if (!pRecord->mThreadOfContext[context].compare_exchange_strong(owner, self) && owner != self)
+        pRecord->mMismatches.fetch_add(1);
+
+    //	Long enough for every worker to pick up some of the items
+    volatile float sink = 0.0f;
+    for (int i = 0; i < 2000; ++i)
+        sink = sink + (float)i;
+}
+
+static void testContexts(ITaskManager* pTaskManager)
+{
+    ContextRecord record;
+    record.mThreadCount = pTaskManager->getThreadCount();
+    record.mInvalid.store(0);
+    record.mMismatches.store(0);
+    for (uint32_t i = 0; i < MAX_CONTEXTS; ++i)
+        record.mThreadOfContext[i].store(0);
+
+    for (uint32_t round = 0; round < 50; ++round)
+    {
+        ITASKSETHANDLE handle;
+        CHECK(pTaskManager->createTaskSet(0, recordContext, &record, 256, NULL, 0, "Contexts", &handle));
+        pTaskManager->waitForTaskSet(handle);
+        pTaskManager->releaseTask(handle);
+    }
+
+    CHECK(record.mInvalid.load() == 0);
+    CHECK(record.mMismatches.load() == 0);
+
+    //	Every worker thread has a context of its own
+    for (uint32_t i = 0; i < MAX_CONTEXTS; ++i)
+        for (uint32_t j = i + 1; j < MAX_CONTEXTS; ++j)
+        {
+            const uintptr_t thread = record.mThreadOfContext[i].load();
+            CHECK(thread == 0 || thread != record.mThreadOfContext[j].load());
+        }
+}
+
+int main()
+{
+    //	Two managers started at the same time
+    ITaskManager* pManagers[2] = {};
+    std::thread   starter([&]() { initDefaultTaskManager(5, &pManagers[1]); });
+    initDefaultTaskManager(3, &pManagers[0]);
+    starter.join();
+    CHECK(pManagers[0] && pManagers[1]);
+    CHECK(pManagers[0]->getThreadCount() == 4);
+    CHECK(pManagers[1]->getThreadCount() == 6);
+
+    for (ITaskManager* pTaskManager : pManagers)
+    {
+        testDiamond(pTaskManager);
+        testContexts(pTaskManager);
+        testRecycling(pTaskManager);
+        testConcurrentPolling(pTaskManager);
+    }
+
+    //	Chains built by several threads, on both managers at once
+    std::atomic<int>         failures(0);
+    std::vector<std::thread> creators;
+    for (uint32_t i = 0; i < 6; ++i)
+        creators.emplace_back(buildChains, pManagers[i % 2], i, &failures);
+    for (std::thread& creator : creators)
+        creator.join();
+    CHECK(failures.load() == 0);
+
+    removeDefaultTaskManager(pManagers[0]);
+    removeDefaultTaskManager(pManagers[1]);
+    return TEST_RESULT();
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	vec4a and the batched transforms have to give the vec4, mat3 and mat4 operators bit for bit, NaNs included, in place too.
+//	The inline math keeps the quirks of the out-of-line versions and still composes with the builders and inverses in AuraVector.cpp.
+
+#include "../../Aura/Math/AuraVectorSIMD.h"
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gSampleCount = 100000;
+//	Not a multiple of any SIMD width
+static const uint32_t gTransformCount = 1003;
+
+static bool isSameBits(const void* a, const void* b, size_t size) { return !memcmp(a, b, size); }
+
+static vec4 randomVec4(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+    return vec4(dist(rng), dist(rng), dist(rng), dist(rng));
+}
+
+static mat4 randomMat4(std::mt19937& rng) { return mat4(randomVec4(rng), randomVec4(rng), randomVec4(rng), randomVec4(rng)); }
+
+static float getMaxError(const mat4& m, const mat4& n)
+{
+    float maxError = 0.0f;
+    for (uint32_t r = 0; r < 4; ++r)
+        for (uint32_t c = 0; c < 4; ++c)
+            maxError = max(maxError, fabsf(m.rows[r][c] - n.rows[r][c]));
+    return maxError;
+}
+
+int main()
+{
+    std::mt19937 rng(7);
+
+    //	Every vec4a operation against the vec4 one
+    const float nan = nanf("");
+    for (uint32_t i = 0; i < gSampleCount; ++i)
+    {
+        vec4 u = randomVec4(rng);
+        vec4 v = randomVec4(rng);
+        if (i % 16 == 0)
+            u.y = nan;
+        if (i % 16 == 1)
+            v.z = nan;
+        const float s = randomVec4(rng).x;
+
+        const vec4 sum = vec4a(u) + vec4a(v);
+        const vec4 difference = vec4a(u) - vec4a(v);
+        const vec4 product = vec4a(u) * vec4a(v);
+        const vec4 scaled = vec4a(u) * s;
+        const vec4 maximum = max(vec4a(u), vec4a(v));
+        const vec4 splat = vec4a(s);
+        const vec4 expectedSum = u + v;
+        const vec4 expectedDifference = u - v;
+        const vec4 expectedProduct = u * v;
+        const vec4 expectedScaled = u * s;
+        const vec4 expectedMaximum = max(u, v);
+        const vec4 expectedSplat(s, s, s, s);
+        CHECK(isSameBits(&sum, &expectedSum, sizeof(vec4)));
+        CHECK(isSameBits(&difference, &expectedDifference, sizeof(vec4)));
+        CHECK(isSameBits(&product, &expectedProduct, sizeof(vec4)));
+        CHECK(isSameBits(&scaled, &expectedScaled, sizeof(vec4)));
+        CHECK(isSameBits(&maximum, &expectedMaximum, sizeof(vec4)));
+        CHECK(isSameBits(&splat, &expectedSplat, sizeof(vec4)));
+
+        const float d = dot(vec4a(u), vec4a(v));
+        const float expectedDot = dot(u, v);
+        CHECK(isSameBits(&d, &expectedDot, sizeof(float)));
+    }
+
+    //	Batched transforms against the operators, into another array and in place
+    std::vector<vec4> src4(gTransformCount);
+    std::vector<vec4> dst4(gTransformCount);
+    std::vector<vec3> src3(gTransformCount);
+    std::vector<vec3> dst3(gTransformCount);
+    for (uint32_t round = 0; round < 16; ++round)
+    {
+        const mat4 m = randomMat4(rng);
+        const mat3 m3(m.rows[0].xyz(), m.rows[1].xyz(), m.rows[2].xyz());
+        for (uint32_t i = 0; i < gTransformCount; ++i)
+        {
+            src4[i] = randomVec4(rng);
+            src3[i] = src4[i].xyz();
+        }
+
+        transformVec4(m, src4.data(), dst4.data(), gTransformCount);
+        transformVec3(m3, src3.data(), dst3.data(), gTransformCount);
+        for (uint32_t i = 0; i < gTransformCount; ++i)
+        {
+            const vec4 expected4 = m * src4[i];
+            const vec3 expected3 = m3 * src3[i];
+            CHECK(isSameBits(&dst4[i], &expected4, sizeof(vec4)));
+            CHECK(isSameBits(&dst3[i], &expected3, sizeof(vec3)));
+        }
+
+        transformVec4(m, src4.data(), src4.data(), gTransformCount);
+        transformVec3(m3, src3.data(), src3.data(), gTransformCount);
+        CHECK(isSameBits(src4.data(), dst4.data(), sizeof(vec4) * gTransformCount));
+        CHECK(isSameBits(src3.data(), dst3.data(), sizeof(vec3) * gTransformCount));
+    }
+    transformVec4(identity4(), src4.data(), dst4.data(), 0);
+
+    //	Quirks the inline versions kept from the out-of-line ones
+    const vec4 u(1.0f, 2.0f, 3.0f, 4.0f);
+    const vec4 v(1.0f, 2.0f, 3.0f, 5.0f);
+    const vec4 expectedReversed(-1.0f, 0.0f, 1.0f, 2.0f);
+    CHECK(2.0f - u == expectedReversed);
+    CHECK(u == v);
+    CHECK(distance(vec3(0.0f, 3.0f, 0.0f), vec3(4.0f, 0.0f, 0.0f)) == 25.0f);
+    CHECK(clamp(vec4(0.0f, 0.0f, 2.0f, -7.0f), 0.0f, 1.0f).w == 1.0f);
+
+    //	The inline products still compose with the out-of-line builders and inverses
+    const mat4 rotation = rotateZXY(0.3f, -1.1f, 2.0f);
+    CHECK(getMaxError(rotation * transpose(rotation), identity4()) < 1e-5f);
+    CHECK(getMaxError(rotateX(0.7f) * rotateX(-0.7f), identity4()) < 1e-5f);
+    const mat4 transform = translate(3.0f, -2.0f, 5.0f) * rotation * scale(2.0f, 3.0f, 0.5f);
+    CHECK(getMaxError(transform * !transform, identity4()) < 1e-5f);
+    CHECK_NEAR(det(mat3(rotation.rows[0].xyz(), rotation.rows[1].xyz(), rotation.rows[2].xyz())), 1.0f, 1e-5f);
+
+    mat4 translated = identity4();
+    translated.translate(vec3(1.0f, 2.0f, 3.0f));
+    CHECK(getMaxError(translated, translate(1.0f, 2.0f, 3.0f)) == 0.0f);
+
+    const mat3 m3(vec3(2.0f, 1.0f, 0.0f), vec3(0.0f, 3.0f, 1.0f), vec3(1.0f, 0.0f, 4.0f));
+    const mat3 p3 = m3 * !m3;
+    for (uint32_t r = 0; r < 3; ++r)
+        for (uint32_t c = 0; c < 3; ++c)
+            CHECK_NEAR(p3.rows[r][c], r == c ? 1.0f : 0.0f, 1e-6f);
+    const mat2 m2(4.0f, 7.0f, 2.0f, 6.0f);
+    const mat2 p2 = m2 * !m2;
+    CHECK_NEAR(p2.rows[0].x, 1.0f, 1e-6f);
+    CHECK_NEAR(p2.rows[0].y, 0.0f, 1e-6f);
+    CHECK_NEAR(p2.rows[1].x, 0.0f, 1e-6f);
+    CHECK_NEAR(p2.rows[1].y, 1.0f, 1e-6f);
+
+    const vec3 a(1.0f, 2.0f, 3.0f);
+    const vec3 b(-2.0f, 0.5f, 4.0f);
+    CHECK_NEAR(dot(cross(a, b), a), 0.0f, 1e-5f);
+    CHECK_NEAR(dot(cross(a, b), b), 0.0f, 1e-5f);
+    CHECK_NEAR(length(normalize(a)), 1.0f, 1e-6f);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Runs the decoupled propagation schedule over many frames against a simulated GPU. The GPU injects the light of the frame
+//	into the light grids, then executes the recorded readbacks and uploads in order. Every frame has to show exactly one
+//	propagation of the light injected contextCount + latency frames earlier, never light that was propagated twice.
+
+#include "../../Aura/LightPropagation/LightPropagationCPUContext.h"
+
+#include <string.h>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gGridRes = 16;
+static const uint32_t gContextCount = 3;
+static const uint32_t gCellCount = gGridRes * gGridRes * gGridRes;
+
+typedef std::vector<vec4> Grids; //	NUM_GRIDS_PER_CASCADE grids of gCellCount cells
+
+struct SimulatedCommand
+{
+    enum Type
+    {
+        CAPTURE,
+        APPLY
+    } mType;
+    uint32_t mContext; //	CAPTURE: readback buffer written
+    Grids    mUpload;  //	APPLY: propagated light, copied when recorded like applyData does
+    float    mApplyTag;
+};
+
+struct SimulatedGPU
+{
+    LightPropagationCPUContext*   pContexts;
+    ITaskManager*                 pTaskManager;
+    Grids                         mLightGrids;
+    Grids                         mReadback[gContextCount];
+    std::vector<SimulatedCommand> mCommands;
+    float                         mApplyTag; //	Frame tag of the capture the light grids show, -1 for raw injected light
+};
+
+static uint32_t contextIndex(const SimulatedGPU* pGPU, const LightPropagationCPUContext* pContext)
+{
+    return (uint32_t)(pContext - pGPU->pContexts);
+}
+
+static void captureSimulated(void* pUserData, LightPropagationCPUContext* pContext)
+{
+    SimulatedGPU*    pGPU = (SimulatedGPU*)pUserData;
+    SimulatedCommand command = { SimulatedCommand::CAPTURE, contextIndex(pGPU, pContext), Grids(), 0.0f };
+    pGPU->mCommands.push_back(command);
+}
+
+static void applySimulated(void* pUserData, LightPropagationCPUContext* pContext)
+{
+    SimulatedGPU*    pGPU = (SimulatedGPU*)pUserData;
+    SimulatedCommand command = { SimulatedCommand::APPLY, contextIndex(pGPU, pContext), Grids(), 0.0f };
+    command.mUpload.resize(NUM_GRIDS_PER_CASCADE * gCellCount);
+    for (uint32_t c = 0; c < NUM_GRIDS_PER_CASCADE; ++c)
+        memcpy(&command.mUpload[c * gCellCount], pContext->getCPUGrid(c), gCellCount * sizeof(vec4));
+    command.mApplyTag = pContext->getApplyState().mSmoothTCOffset.x;
+    pGPU->mCommands.push_back(command);
+}
+
+static void launchSimulated(void* pUserData, LightPropagationCPUContext* pContext)
+{
+    //	Stands in for the readback conversion of beginProcessData
+    SimulatedGPU*  pGPU = (SimulatedGPU*)pUserData;
+    const uint32_t index = contextIndex(pGPU, pContext);
+    for (uint32_t c = 0; c < NUM_GRIDS_PER_CASCADE; ++c)
+        memcpy(pContext->getCPUGrid(c), &pGPU->mReadback[index][c * gCellCount], gCellCount * sizeof(vec4));
+    pContext->beginPropagate(pGPU->pTaskManager, MT_ExtremeTasks);
+}
+
+//	One lit cell whose position and brightness depend on the frame
+static void injectLight(uint32_t frame, bool constantLight, Grids* pGrids)
+{
+    pGrids->assign(NUM_GRIDS_PER_CASCADE * gCellCount, vec4(0.0f));
+    const uint32_t f = constantLight ? 0 : frame;
+    const uint32_t cell = ((4 + f % 8) * gGridRes + 8) * gGridRes + 6 + f % 5;
+    for (uint32_t c = 0; c < NUM_GRIDS_PER_CASCADE; ++c)
+        (*pGrids)[c * gCellCount + cell] = vec4(1.0f + 0.25f * (float)(f % 7) + (float)c, 0.5f, -0.25f, 0.125f);
+}
+
+static void executeFrame(SimulatedGPU* pGPU, uint32_t frame, bool constantLight)
+{
+    injectLight(frame, constantLight, &pGPU->mLightGrids);
+    pGPU->mApplyTag = -1.0f;
+    for (const SimulatedCommand& command : pGPU->mCommands)
+    {
+        if (SimulatedCommand::CAPTURE == command.mType)
+        {
+            pGPU->mReadback[command.mContext] = pGPU->mLightGrids;
+        }
+        else
+        {
+            pGPU->mLightGrids = command.mUpload;
+            pGPU->mApplyTag = command.mApplyTag;
+        }
+    }
+    pGPU->mCommands.clear();
+}
+
+//	The light of the frame propagated once
+static Grids propagateOnce(LightPropagationCPUContext* pReference, uint32_t frame, bool constantLight)
+{
+    Grids light;
+    injectLight(frame, constantLight, &light);
+    for (uint32_t c = 0; c < NUM_GRIDS_PER_CASCADE; ++c)
+        memcpy(pReference->getCPUGrid(c), &light[c * gCellCount], gCellCount * sizeof(vec4));
+    pReference->propagate(NULL, MT_None);
+    for (uint32_t c = 0; c < NUM_GRIDS_PER_CASCADE; ++c)
+        memcpy(&light[c * gCellCount], pReference->getCPUGrid(c), gCellCount * sizeof(vec4));
+    return light;
+}
+
+static float maxDifference(const Grids& a, const Grids& b)
+{
+    float difference = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        difference = fmaxf(difference, fabsf(a[i].x - b[i].x));
+        difference = fmaxf(difference, fabsf(a[i].y - b[i].y));
+        difference = fmaxf(difference, fabsf(a[i].z - b[i].z));
+        difference = fmaxf(difference, fabsf(a[i].w - b[i].w));
+    }
+    return difference;
+}
+
+static void runFrames(ITaskManager* pTaskManager, uint32_t latency, bool constantLight)
+{
+    LightPropagationCPUContext contexts[gContextCount];
+    for (uint32_t i = 0; i < gContextCount; ++i)
+        contexts[i].loadHeadless(gGridRes, NULL);
+
+    LightPropagationCPUContext reference;
+    reference.loadHeadless(gGridRes, NULL);
+
+    SimulatedGPU gpu = {};
+    gpu.pContexts = contexts;
+    gpu.pTaskManager = pTaskManager;
+    for (uint32_t i = 0; i < gContextCount; ++i)
+        gpu.mReadback[i].assign(NUM_GRIDS_PER_CASCADE * gCellCount, vec4(0.0f));
+    const DecoupledPropagationOps ops = { captureSimulated, applySimulated, launchSimulated, &gpu };
+
+    //	A capture is launched when its context comes around again and applied latency frames later
+    const uint32_t delay = gContextCount + latency;
+    const uint32_t frameCount = 40;
+    uint32_t       appliedFrames = 0;
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        //	Propagations finish within the frame, so the latency alone decides when they are applied
+        pTaskManager->waitAll();
+
+        LightPropagationCascade::State captureState = {};
+        captureState.mSmoothTCOffset = vec3((float)frame, 0.0f, 0.0f);
+        scheduleDecoupledPropagation(contexts, gContextCount, frame % gContextCount, frame, latency, captureState, pTaskManager, ops);
+        executeFrame(&gpu, frame, constantLight);
+
+        if (frame < delay)
+        {
+            CHECK(gpu.mApplyTag < 0.0f);
+            continue;
+        }
+
+        ++appliedFrames;
+        CHECK(gpu.mApplyTag == (float)(frame - delay));
+        const Grids expected = propagateOnce(&reference, frame - delay, constantLight);
+        const float difference = maxDifference(gpu.mLightGrids, expected);
+        if (difference > 1e-6f)
+            fprintf(stderr, "latency %u frame %u: difference %g to one propagation\n", latency, frame, difference);
+        CHECK(difference <= 1e-6f);
+    }
+    CHECK(appliedFrames == frameCount - delay);
+
+    pTaskManager->waitAll();
+    for (uint32_t i = 0; i < gContextCount; ++i)
+    {
+        if (LightPropagationCPUContext::PROPAGATING_LIGHT == contexts[i].eState)
+            contexts[i].endProcessData(pTaskManager);
+        contexts[i].unloadHeadless(pTaskManager);
+    }
+    reference.unloadHeadless(pTaskManager);
+}
+
+int main()
+{
+    ITaskManager* pTaskManager = NULL;
+    initDefaultTaskManager(2, &pTaskManager);
+
+    for (uint32_t latency = 1; latency <= gContextCount; ++latency)
+    {
+        runFrames(pTaskManager, latency, true);
+        runFrames(pTaskManager, latency, false);
+    }
+
+    removeDefaultTaskManager(pTaskManager);
+    return TEST_RESULT();
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Every bulk half/float conversion the CPU supports against the scalar half class, on all 65536 halves: ±0, denormals, ±inf,
+//	signalling and quiet NaNs. Round trips are exact apart from NaNs coming back quiet, and floats between two halves round to
+//	nearest even where the half class rounds ties up.
+
+#include "../../Aura/Math/AuraHalf.h"
+
+#include <string.h>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gHalfCount = 65536;
+//	Not a multiple of any SIMD width, every call ends in a scalar tail
+static const size_t   gChunkSize = 13;
+//	Prime, the spread of floats hits every exponent with varied mantissas
+static const uint32_t gFloatStride = 65521;
+
+static uint32_t asUint(float x)
+{
+    uint32_t u;
+    memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+static float asFloat(uint32_t u)
+{
+    float x;
+    memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+static bool isNaN(uint16_t h) { return (h & 0x7C00) == 0x7C00 && (h & 0x03FF) != 0; }
+
+//	The half class keeps signalling NaNs signalling, the bulk paths quiet them like the hardware does
+static uint32_t getExpectedFloat(uint16_t h)
+{
+    half x;
+    x.sh = h;
+    const uint32_t f = asUint((float)x);
+    return isNaN(h) ? f | 0x00400000 : f;
+}
+
+static uint16_t getEvenHalf(uint16_t a, uint16_t b) { return (a & 1) ? b : a; }
+
+static void convertHalfToFloat(const HalfConversion& conversion, const half* pSrc, float* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; i += gChunkSize)
+        conversion.halfToFloat(pSrc + i, pDst + i, min(gChunkSize, count - i));
+}
+
+static void convertFloatToHalf(const HalfConversion& conversion, const float* pSrc, half* pDst, size_t count)
+{
+    for (size_t i = 0; i < count; i += gChunkSize)
+        conversion.floatToHalf(pSrc + i, pDst + i, min(gChunkSize, count - i));
+}
+
+int main()
+{
+    std::vector<half> halves(gHalfCount);
+    for (uint32_t i = 0; i < gHalfCount; ++i)
+        halves[i].sh = (uint16_t)i;
+
+    //	Floats halfway between two halves of the same sign, every finite magnitude up to the tie between 65504 and infinity
+    std::vector<float>    ties;
+    std::vector<uint16_t> expectedTies;
+    for (uint32_t sign = 0; sign < 2; ++sign)
+    {
+        for (uint32_t h = 0; h < 0x7C00; ++h)
+        {
+            const uint16_t a = (uint16_t)(h | (sign << 15));
+            const uint16_t b = (uint16_t)(a + 1);
+            //	Infinity takes the place of 65536 in the rounding
+            const float    next = h == 0x7BFF ? (sign ? -65536.0f : 65536.0f) : asFloat(getExpectedFloat(b));
+            const float    tie = 0.5f * (asFloat(getExpectedFloat(a)) + next);
+            ties.push_back(tie);
+            expectedTies.push_back(getEvenHalf(a, b));
+            //	One float either side of the tie is nearer to one of the halves
+            ties.push_back(asFloat(asUint(tie) - 1));
+            expectedTies.push_back(a);
+            ties.push_back(asFloat(asUint(tie) + 1));
+            expectedTies.push_back(b);
+        }
+    }
+
+    //	Signalling float NaNs lose the low bits of their payload, they have to come back quiet and NaN
+    std::vector<float> nans;
+    for (uint32_t payload = 1; payload < 0x00400000; payload = payload * 3 + 1)
+    {
+        nans.push_back(asFloat(0x7F800000 | payload));
+        nans.push_back(asFloat(0xFF800000 | payload));
+    }
+
+    //	A spread of all floats, every path has to give the bits of the table path
+    std::vector<float> spread;
+    for (uint64_t f = 0; f <= 0xFFFFFFFF; f += gFloatStride)
+        spread.push_back(asFloat((uint32_t)f));
+    std::vector<half> expectedSpread(spread.size());
+    convertFloatToHalf(getHalfConversion(HALF_CONVERSION_TABLE), spread.data(), expectedSpread.data(), spread.size());
+
+    std::vector<float> floats(gHalfCount);
+    std::vector<half>  roundTrip(gHalfCount);
+    for (int type = HALF_CONVERSION_TABLE; type < HALF_CONVERSION_COUNT; ++type)
+    {
+        if (!isHalfConversionSupported((HalfConversionType)type))
+            continue;
+        const HalfConversion& conversion = getHalfConversion((HalfConversionType)type);
+        uint32_t              errorCount = 0;
+
+        //	half -> float -> half, in chunks and in one call
+        for (int whole = 0; whole < 2; ++whole)
+        {
+            if (whole)
+            {
+                conversion.halfToFloat(halves.data(), floats.data(), gHalfCount);
+                conversion.floatToHalf(floats.data(), roundTrip.data(), gHalfCount);
+            }
+            else
+            {
+                convertHalfToFloat(conversion, halves.data(), floats.data(), gHalfCount);
+                convertFloatToHalf(conversion, floats.data(), roundTrip.data(), gHalfCount);
+            }
+
+            for (uint32_t i = 0; i < gHalfCount; ++i)
+            {
+                const uint16_t h = (uint16_t)i;
+                const uint32_t f = asUint(floats[i]);
+                errorCount += f != getExpectedFloat(h);
+                if (isNaN(h))
+                {
+                    //	Quiet NaNs stay as they are, signalling ones come back with the quiet bit
+                    errorCount += (f & 0x00400000) == 0;
+                    errorCount += roundTrip[i].sh != (h | 0x0200);
+                }
+                else
+                {
+                    //	Exact values, the half class doesn't round either
+                    errorCount += roundTrip[i].sh != h;
+                    errorCount += roundTrip[i].sh != half(floats[i]).sh;
+                }
+            }
+        }
+
+        std::vector<half> result(ties.size());
+        convertFloatToHalf(conversion, ties.data(), result.data(), ties.size());
+        for (size_t i = 0; i < ties.size(); ++i)
+            errorCount += result[i].sh != expectedTies[i];
+
+        result.resize(nans.size());
+        convertFloatToHalf(conversion, nans.data(), result.data(), nans.size());
+        for (size_t i = 0; i < nans.size(); ++i)
+        {
+            const uint32_t f = asUint(nans[i]);
+            errorCount += result[i].sh != (((f >> 16) & 0x8000) | 0x7E00 | ((f >> 13) & 0x03FF));
+        }
+
+        result.resize(spread.size());
+        convertFloatToHalf(conversion, spread.data(), result.data(), spread.size());
+        errorCount += memcmp(result.data(), expectedSpread.data(), spread.size() * sizeof(half)) != 0;
+
+        printf("%s: %u errors\n", conversion.pName, errorCount);
+        CHECK(errorCount == 0);
+    }
+
+    //	The half class rounds ties up, so it disagrees with the bulk paths on half of them
+    uint32_t tiesRoundedUp = 0;
+    for (size_t i = 0; i < ties.size(); i += 3)
+        tiesRoundedUp += half(ties[i]).sh != expectedTies[i];
+    CHECK(tiesRoundedUp > 0);
+
+    //	The default conversions use one of the paths above
+    const bool bAccelerated = isHalfConversionSupported(HALF_CONVERSION_F16C) || isHalfConversionSupported(HALF_CONVERSION_NEON);
+    CHECK(isHalfConversionAccelerated() == bAccelerated);
+    convertHalfToFloat(halves.data(), floats.data(), gHalfCount);
+    for (uint32_t i = 0; i < gHalfCount; ++i)
+        CHECK(asUint(floats[i]) == getExpectedFloat((uint16_t)i));
+
+    return TEST_RESULT();
+}
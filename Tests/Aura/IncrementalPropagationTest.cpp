@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Incremental propagation over frame sequences against propagating every frame in full. Full propagations give the full result
+//	bit for bit, reused ones the last result, and deltas keep every frame within gMaxRelativeError of it. The mode follows the
+//	light: unchanged light is reused, small changes with advanced directions are deltas, everything else runs in full.
+
+#include "../../Aura/LightPropagation/LightPropagationCPUContext.h"
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gGridResolutions[] = { 16, 32 };
+static const int      gPropagationSteps = 8;
+static const uint32_t gFrameCount = 48;
+//	Relative L2 error of a delta propagation over the three channels
+static const double   gMaxRelativeError = 0.01;
+
+typedef LightPropagationCPUContext::PropagationMode PropagationMode;
+
+struct Light
+{
+    int  mCell;
+    vec4 mColor[3];
+};
+
+struct Scene
+{
+    std::vector<Light> mLights;
+    vec4               mAmbient;
+    std::vector<vec4>  mGrids[3];
+};
+
+static void initScene(Scene* pScene, int res, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    pScene->mLights.resize(12);
+    pScene->mAmbient = vec4(0.0f, 0.0f, 0.0f, 0.0f);
+    for (Light& light : pScene->mLights)
+    {
+        light.mCell = (int)(rng() % ((uint32_t)res * res * res));
+        for (uint32_t c = 0; c < 3; ++c)
+            light.mColor[c] = vec4(dist(rng) + 1.5f, dist(rng), dist(rng), dist(rng));
+    }
+}
+
+static void injectScene(Scene* pScene, int res)
+{
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        pScene->mGrids[c].assign((size_t)res * res * res, pScene->mAmbient);
+        for (const Light& light : pScene->mLights)
+            pScene->mGrids[c][light.mCell] += light.mColor[c];
+    }
+}
+
+static void propagate(LightPropagationCPUContext* pContext, const Scene& scene, ITaskManager* pTaskManager, MTTypes mode)
+{
+    for (uint32_t c = 0; c < 3; ++c)
+        memcpy(pContext->getCPUGrid(c), scene.mGrids[c].data(), scene.mGrids[c].size() * sizeof(vec4));
+    pContext->propagate(pTaskManager, mode);
+}
+
+static bool isSameResult(LightPropagationCPUContext* pA, LightPropagationCPUContext* pB, size_t gridSize)
+{
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        if (memcmp(pA->getCPUGrid(c), pB->getCPUGrid(c), gridSize))
+            return false;
+    }
+    return true;
+}
+
+static bool isSameResult(LightPropagationCPUContext* pContext, const std::vector<vec4>* pResult, size_t gridSize)
+{
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        if (memcmp(pContext->getCPUGrid(c), pResult[c].data(), gridSize))
+            return false;
+    }
+    return true;
+}
+
+static double getRelativeError(LightPropagationCPUContext* pContext, LightPropagationCPUContext* pReference, size_t cellCount)
+{
+    double error = 0.0;
+    double norm = 0.0;
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        const float* pValues = (const float*)pContext->getCPUGrid(c);
+        const float* pExpected = (const float*)pReference->getCPUGrid(c);
+        for (size_t i = 0; i < cellCount * 4; ++i)
+        {
+            error += ((double)pValues[i] - pExpected[i]) * ((double)pValues[i] - pExpected[i]);
+            norm += (double)pExpected[i] * pExpected[i];
+        }
+    }
+    return sqrt(error / norm);
+}
+
+int main()
+{
+    ITaskManager* pTaskManager = NULL;
+    initDefaultTaskManager(3, &pTaskManager);
+    std::mt19937 rng(5);
+
+    for (uint32_t res : gGridResolutions)
+    {
+        for (int advanced = 0; advanced < 2; ++advanced)
+        {
+            const size_t cellCount = (size_t)res * res * res;
+            const size_t gridSize = cellCount * sizeof(vec4);
+
+            //	One reference propagating in full, incremental contexts on one thread and on tasks
+            LightPropagationCPUContext full;
+            LightPropagationCPUContext serial;
+            LightPropagationCPUContext tasks;
+            LightPropagationCPUContext* pContexts[3] = { &full, &serial, &tasks };
+            for (LightPropagationCPUContext* pContext : pContexts)
+            {
+                pContext->loadHeadless(res, NULL);
+                pContext->setAdvancedDirections(advanced != 0);
+                pContext->setPropagationSteps(gPropagationSteps);
+            }
+            serial.setIncrementalPropagation(true);
+            tasks.setIncrementalPropagation(true);
+
+            Scene scene;
+            initScene(&scene, (int)res, rng);
+            LightPropagationCascade::State state = {};
+
+            std::vector<vec4> lastResult[3];
+            int               steps = gPropagationSteps;
+            uint32_t          modeCounts[3] = {};
+            uint32_t          consecutiveDeltas = 0;
+            uint32_t          deltaLimitCount = 0;
+            double            maxError = 0.0;
+            for (uint32_t frame = 0; frame < gFrameCount; ++frame)
+            {
+                //	Mostly a flickering light, now and then nothing, light everywhere, the grid moving or fewer steps
+                PropagationMode expectedMode = advanced ? LightPropagationCPUContext::PROPAGATION_DELTA
+                                                        : LightPropagationCPUContext::PROPAGATION_FULL;
+                if (frame % 23 == 0)
+                {
+                    for (Light& light : scene.mLights)
+                        light.mCell = (int)(rng() % cellCount);
+                    scene.mAmbient = vec4(0.01f * (float)(frame % 3), 0.0f, 0.0f, 0.0f);
+                    expectedMode = LightPropagationCPUContext::PROPAGATION_FULL;
+                }
+                else if (frame % 7 == 0)
+                {
+                    expectedMode = LightPropagationCPUContext::PROPAGATION_REUSED;
+                }
+                else if (frame == 31)
+                {
+                    state.mWorldToGridTranslate.x += 1.0f;
+                    expectedMode = LightPropagationCPUContext::PROPAGATION_FULL;
+                }
+                else if (frame == 38 || frame == 45)
+                {
+                    steps = steps == gPropagationSteps ? gPropagationSteps - 1 : gPropagationSteps;
+                    expectedMode = LightPropagationCPUContext::PROPAGATION_FULL;
+                }
+                else
+                {
+                    const float flicker = 0.5f + 0.5f * sinf(frame * 1.3f);
+                    for (uint32_t c = 0; c < 3; ++c)
+                        scene.mLights[0].mColor[c].x = 1.0f + flicker;
+                }
+                //	Deltas are bounded, the one after the last one allowed runs in full
+                if (expectedMode == LightPropagationCPUContext::PROPAGATION_DELTA && consecutiveDeltas == 16)
+                {
+                    expectedMode = LightPropagationCPUContext::PROPAGATION_FULL;
+                    ++deltaLimitCount;
+                }
+                consecutiveDeltas = expectedMode == LightPropagationCPUContext::PROPAGATION_DELTA ? consecutiveDeltas + 1
+                                    : expectedMode == LightPropagationCPUContext::PROPAGATION_FULL ? 0
+                                                                                                    : consecutiveDeltas;
+
+                injectScene(&scene, (int)res);
+                for (LightPropagationCPUContext* pContext : pContexts)
+                {
+                    pContext->setApplyState(state);
+                    pContext->setPropagationSteps(steps);
+                }
+                propagate(&full, scene, pTaskManager, MT_None);
+                propagate(&serial, scene, pTaskManager, MT_None);
+                propagate(&tasks, scene, pTaskManager, MT_ExtremeTasks);
+
+                CHECK(full.getLastPropagationMode() == LightPropagationCPUContext::PROPAGATION_FULL);
+                CHECK(serial.getLastPropagationMode() == expectedMode);
+                CHECK(tasks.getLastPropagationMode() == expectedMode);
+                CHECK(isSameResult(&serial, &tasks, gridSize));
+                ++modeCounts[serial.getLastPropagationMode()];
+
+                //	Reusing gives the last result, which is only the full one when no delta came before it
+                if (serial.getLastPropagationMode() == LightPropagationCPUContext::PROPAGATION_REUSED)
+                    CHECK(isSameResult(&serial, lastResult, gridSize));
+                if (serial.getLastPropagationMode() == LightPropagationCPUContext::PROPAGATION_FULL)
+                    CHECK(isSameResult(&serial, &full, gridSize));
+                const double error = getRelativeError(&serial, &full, cellCount);
+                maxError = max(maxError, error);
+                CHECK(error <= gMaxRelativeError);
+
+                for (uint32_t c = 0; c < 3; ++c)
+                    lastResult[c].assign(serial.getCPUGrid(c), serial.getCPUGrid(c) + cellCount);
+            }
+
+            printf("res %u %s: %u full, %u reused, %u delta, max error %g\n", res, advanced ? "advanced" : "basic",
+                   modeCounts[LightPropagationCPUContext::PROPAGATION_FULL], modeCounts[LightPropagationCPUContext::PROPAGATION_REUSED],
+                   modeCounts[LightPropagationCPUContext::PROPAGATION_DELTA], maxError);
+            CHECK(!advanced || (modeCounts[LightPropagationCPUContext::PROPAGATION_DELTA] > 16 && deltaLimitCount > 0));
+
+            for (LightPropagationCPUContext* pContext : pContexts)
+                pContext->unloadHeadless(pTaskManager);
+        }
+    }
+
+    removeDefaultTaskManager(pTaskManager);
+    return TEST_RESULT();
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Propagation has to move the same amount of light at every grid resolution. A point light away from the borders
+//	gives the same band 0 energy per step at 16..64, and no step may add energy to the grid.
+
+#include "../../Aura/LightPropagation/LightPropagationCPUContext.h"
+
+#include <string.h>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gGridResolutions[] = { 16, 24, 32, 48, 64 };
+//	Stays inside the 16^3 grid for a light in its centre
+static const int      gPropagationSteps = 6;
+
+//	Sum of the band 0 coefficient over the accumulated grid
+static double propagateEnergy(LightPropagationCPUContext* pContext, ITaskManager* pTaskManager, int steps, int lightOffset)
+{
+    const int res = (int)pContext->getGridRes();
+    for (uint32_t c = 0; c < 3; ++c)
+        memset(pContext->getCPUGrid(c), 0, (size_t)res * res * res * sizeof(vec4));
+
+    const int centre = res / 2 + lightOffset;
+    for (uint32_t c = 0; c < 3; ++c)
+        pContext->getCPUGrid(c)[(centre * res + res / 2) * res + res / 2] = vec4(1.0f, 0.0f, 0.0f, 0.0f);
+
+    pContext->setPropagationSteps(steps);
+    pContext->propagate(pTaskManager, MT_ExtremeTasks);
+
+    double energy = 0.0;
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        const vec4* pGrid = pContext->getCPUGrid(c);
+        for (size_t i = 0; i < (size_t)res * res * res; ++i)
+            energy += pGrid[i].x;
+    }
+    return energy / 3.0;
+}
+
+int main()
+{
+    ITaskManager* pTaskManager = NULL;
+    initDefaultTaskManager(3, &pTaskManager);
+
+    double reference[gPropagationSteps + 1] = {};
+    for (uint32_t res : gGridResolutions)
+    {
+        LightPropagationCPUContext context;
+        context.loadHeadless(res, NULL);
+
+        //	The accumulated grid starts with the injected light
+        double energy[gPropagationSteps + 1] = { 1.0 };
+        for (int steps = 1; steps <= gPropagationSteps; ++steps)
+            energy[steps] = propagateEnergy(&context, pTaskManager, steps, 0);
+
+        for (int steps = 1; steps <= gPropagationSteps; ++steps)
+        {
+            //	Accumulated energy grows by what the last step moved, which can not exceed what the step before it moved
+            const double stepEnergy = energy[steps] - energy[steps - 1];
+            const double prevStepEnergy = steps > 1 ? energy[steps - 1] - energy[steps - 2] : energy[0];
+            CHECK(stepEnergy > 0.0);
+            CHECK(stepEnergy <= prevStepEnergy * (1.0 + 1e-5));
+
+            if (res == gGridResolutions[0])
+                reference[steps] = energy[steps];
+            else if (fabs(energy[steps] - reference[steps]) > 1e-5 * reference[steps])
+                fprintf(stderr, "res %u step %d: energy %.8g, %.8g at res %u\n", res, steps, energy[steps], reference[steps],
+                        gGridResolutions[0]);
+            CHECK_NEAR(energy[steps], reference[steps], 1e-5 * reference[steps]);
+        }
+
+        //	Near the border light leaves the grid, it must never come back as extra energy
+        const double borderEnergy = propagateEnergy(&context, pTaskManager, gPropagationSteps, (int)res / 2 - 2);
+        CHECK(borderEnergy > 0.0);
+        CHECK(borderEnergy < energy[gPropagationSteps]);
+
+        printf("res %u: energy %.6f after %d steps, %.6f near the border\n", res, energy[gPropagationSteps], gPropagationSteps,
+               borderEnergy);
+        context.unloadHeadless(pTaskManager);
+    }
+
+    removeDefaultTaskManager(pTaskManager);
+    return TEST_RESULT();
+}
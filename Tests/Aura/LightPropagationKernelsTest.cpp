@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Every SIMD propagation kernel the CPU supports has to match the scalar reference over a full 12 step propagation,
+//	single-threaded and on worker tasks, at every resolution.
+
+#include "../../Aura/LightPropagation/LightPropagationCPUContext.h"
+
+#include <random>
+#include <string.h>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gGridResolutions[] = { 16, 24, 32, 48, 64 };
+static const int      gPropagationSteps = 12;
+
+//	A few clusters of light with negative SH terms, the rest of the grid dark
+static void injectLight(LightPropagationCPUContext* pContext, uint32_t seed)
+{
+    const int                             res = (int)pContext->getGridRes();
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    for (uint32_t c = 0; c < 3; ++c)
+        memset(pContext->getCPUGrid(c), 0, (size_t)res * res * res * sizeof(vec4));
+
+    for (int cluster = 0; cluster < 4; ++cluster)
+    {
+        const int ci = (int)(rng() % res), cj = (int)(rng() % res), ck = (int)(rng() % res), r = 1 + (int)(rng() % 3);
+        for (int i = ci - r; i <= ci + r; ++i)
+            for (int j = cj - r; j <= cj + r; ++j)
+                for (int k = ck - r; k <= ck + r; ++k)
+                {
+                    if (i < 0 || j < 0 || k < 0 || i >= res || j >= res || k >= res)
+                        continue;
+                    for (uint32_t c = 0; c < 3; ++c)
+                        pContext->getCPUGrid(c)[(i * res + j) * res + k] =
+                            vec4(dist(rng) + 1.5f, dist(rng), dist(rng), dist(rng));
+                }
+    }
+}
+
+static void propagate(LightPropagationCPUContext* pContext, PropagationKernelType kernel, ITaskManager* pTaskManager, MTTypes mode,
+                      uint32_t seed)
+{
+    pContext->setPropagationKernel(kernel);
+    injectLight(pContext, seed);
+    pContext->propagate(pTaskManager, mode);
+}
+
+int main()
+{
+    ITaskManager* pTaskManager = NULL;
+    initDefaultTaskManager(3, &pTaskManager);
+
+    int testedKernels = 0;
+    for (int kernel = PROPAGATION_KERNEL_SCALAR + 1; kernel < PROPAGATION_KERNEL_COUNT; ++kernel)
+    {
+        const PropagationKernelType type = (PropagationKernelType)kernel;
+        if (!isPropagationKernelSupported(type))
+            continue;
+        ++testedKernels;
+        CHECK(getPropagationKernel(type).propagateRow != NULL);
+
+        for (uint32_t res : gGridResolutions)
+        {
+            LightPropagationCPUContext reference;
+            LightPropagationCPUContext simd;
+            reference.loadHeadless(res, NULL);
+            simd.loadHeadless(res, NULL);
+            reference.setPropagationSteps(gPropagationSteps);
+            simd.setPropagationSteps(gPropagationSteps);
+
+            for (int mt = 0; mt < 2; ++mt)
+            {
+                const MTTypes  mode = mt ? MT_ExtremeTasks : MT_None;
+                const uint32_t seed = res * 10 + mt;
+                propagate(&reference, PROPAGATION_KERNEL_SCALAR, pTaskManager, mode, seed);
+                propagate(&simd, type, pTaskManager, mode, seed);
+
+                //	Kernels may reassociate the sums, errors are relative to the brightest cell
+                float maxValue = 0.0f;
+                float maxError = 0.0f;
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    const float* pRef = (const float*)reference.getCPUGrid(c);
+                    const float* pSimd = (const float*)simd.getCPUGrid(c);
+                    for (size_t i = 0; i < (size_t)res * res * res * 4; ++i)
+                    {
+                        maxValue = fmaxf(maxValue, fabsf(pRef[i]));
+                        maxError = fmaxf(maxError, fabsf(pRef[i] - pSimd[i]));
+                    }
+                }
+                CHECK(maxValue > 0.0f);
+                if (!(maxError <= 1e-5f * maxValue))
+                    fprintf(stderr, "%s res %u %s: error %g of %g\n", getPropagationKernel(type).pName, res, mt ? "tasks" : "serial",
+                            maxError, maxValue);
+                CHECK(maxError <= 1e-5f * maxValue);
+            }
+
+            reference.unloadHeadless(pTaskManager);
+            simd.unloadHeadless(pTaskManager);
+        }
+    }
+    printf("%d SIMD kernel(s) tested, best %s\n", testedKernels, getPropagationKernel(getBestPropagationKernel()).pName);
+
+    //	Kernel detection is cached, every call has to agree
+    CHECK(getBestPropagationKernel() == getBestPropagationKernel());
+    CHECK(isPropagationKernelSupported(getBestPropagationKernel()));
+
+    removeDefaultTaskManager(pTaskManager);
+    return TEST_RESULT();
+}
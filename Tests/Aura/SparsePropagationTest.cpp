@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Sparse propagation skips the rows no light can reach in a step and has to give the dense result bit for bit, +0 in the
+//	dark rows included. Every kernel, basic and advanced directions, single-threaded and on worker tasks, for a small light,
+//	lights on the borders, a grid full of light and a dark grid. Small lights have to leave rows out.
+
+#include "../../Aura/LightPropagation/LightPropagationCPUContext.h"
+
+#include <random>
+#include <string.h>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace aura;
+
+static const uint32_t gGridResolutions[] = { 16, 32 };
+static const int      gPropagationSteps = 12;
+
+enum Scene
+{
+    SCENE_SMALL_LIGHT,
+    SCENE_BORDER_LIGHTS,
+    SCENE_FULL,
+    SCENE_DARK,
+    SCENE_COUNT
+};
+
+static const char* gSceneNames[SCENE_COUNT] = { "small light", "border lights", "full", "dark" };
+
+//	Negative SH terms everywhere, lit cells never cancel to 0
+static vec4 randomLight(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    return vec4(dist(rng) + 1.5f, dist(rng), dist(rng), dist(rng));
+}
+
+static void injectLight(std::vector<vec4>* pGrids, int res, Scene scene, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        std::vector<vec4>& grid = pGrids[c];
+        grid.assign((size_t)res * res * res, vec4(0.0f, 0.0f, 0.0f, 0.0f));
+        switch (scene)
+        {
+        case SCENE_SMALL_LIGHT:
+            grid[((res / 3) * res + res / 2) * res + res / 4] = randomLight(rng);
+            break;
+        case SCENE_BORDER_LIGHTS:
+            grid[0] = randomLight(rng);
+            grid[((res - 1) * res + res / 2) * res + res - 1] = randomLight(rng);
+            grid[((res / 2) * res + res - 1) * res + 3] = randomLight(rng);
+            break;
+        case SCENE_FULL:
+            for (vec4& cell : grid)
+                cell = randomLight(rng);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void propagate(LightPropagationCPUContext* pContext, const std::vector<vec4>* pInjected, ITaskManager* pTaskManager, MTTypes mode)
+{
+    const size_t gridSize = pInjected[0].size() * sizeof(vec4);
+    for (uint32_t c = 0; c < 3; ++c)
+        memcpy(pContext->getCPUGrid(c), pInjected[c].data(), gridSize);
+    pContext->propagate(pTaskManager, mode);
+}
+
+int main()
+{
+    ITaskManager* pTaskManager = NULL;
+    initDefaultTaskManager(3, &pTaskManager);
+
+    for (int kernel = PROPAGATION_KERNEL_SCALAR; kernel < PROPAGATION_KERNEL_COUNT; ++kernel)
+    {
+        const PropagationKernelType type = (PropagationKernelType)kernel;
+        if (type != PROPAGATION_KERNEL_SCALAR && !isPropagationKernelSupported(type))
+            continue;
+
+        for (uint32_t res : gGridResolutions)
+        {
+            const size_t      gridSize = (size_t)res * res * res * sizeof(vec4);
+            std::vector<vec4> injected[3];
+
+            LightPropagationCPUContext dense;
+            LightPropagationCPUContext sparse;
+            dense.loadHeadless(res, NULL);
+            sparse.loadHeadless(res, NULL);
+            dense.setSparsePropagation(false);
+            sparse.setSparsePropagation(true);
+            dense.setPropagationKernel(type);
+            sparse.setPropagationKernel(type);
+
+            for (int advanced = 0; advanced < 2; ++advanced)
+            {
+                //	Only the basic directions run through the SIMD kernels
+                if (advanced && type != PROPAGATION_KERNEL_SCALAR)
+                    continue;
+                dense.setAdvancedDirections(advanced != 0);
+                sparse.setAdvancedDirections(advanced != 0);
+
+                for (int scene = 0; scene < SCENE_COUNT; ++scene)
+                {
+                    //	The small light doesn't reach the far border of the bigger grid
+                    const int steps = scene == SCENE_SMALL_LIGHT ? gPropagationSteps : gPropagationSteps / 2;
+                    dense.setPropagationSteps(steps);
+                    sparse.setPropagationSteps(steps);
+                    injectLight(injected, (int)res, (Scene)scene, res * 100 + scene);
+
+                    for (int mt = 0; mt < 2; ++mt)
+                    {
+                        const MTTypes mode = mt ? MT_ExtremeTasks : MT_None;
+                        propagate(&dense, injected, pTaskManager, mode);
+                        propagate(&sparse, injected, pTaskManager, mode);
+
+                        bool bSame = true;
+                        for (uint32_t c = 0; c < 3; ++c)
+                            bSame = bSame && !memcmp(dense.getCPUGrid(c), sparse.getCPUGrid(c), gridSize);
+                        if (!bSame)
+                            fprintf(stderr, "%s res %u %s %s %s: sparse differs from dense\n", getPropagationKernel(type).pName, res,
+                                    advanced ? "advanced" : "basic", gSceneNames[scene], mt ? "tasks" : "serial");
+                        CHECK(bSame);
+
+                        const float occupancy = sparse.getPropagationOccupancy();
+                        CHECK(dense.getPropagationOccupancy() == 1.0f);
+                        CHECK(occupancy >= 0.0f && occupancy <= 1.0f);
+                        if (scene == SCENE_SMALL_LIGHT && res > 16)
+                            CHECK(occupancy < 0.5f);
+                        if (scene == SCENE_DARK)
+                            CHECK(occupancy == 0.0f);
+                        if (scene == SCENE_FULL)
+                            CHECK(occupancy == 1.0f);
+                    }
+                }
+            }
+
+            dense.unloadHeadless(pTaskManager);
+            sparse.unloadHeadless(pTaskManager);
+        }
+    }
+
+    removeDefaultTaskManager(pTaskManager);
+    return TEST_RESULT();
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Aura.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Command line front end of runCPUPropagationBenchmark.
+//
+//	LightPropagationBenchmark [--res 16,32,64] [--threads 1,3,7] [--extents 1,0.25] [--steps 12] [--warmup 2] [--iterations 10]
+//	                          [--density 0.05] [--seed 7] [--csv file] [--json file]
+//
+//	Without --csv or --json the CSV goes to stdout. Returns 1 if a sparse or incremental result didn't match the dense one.
+
+#include "../../Aura/LightPropagation/LightPropagationBenchmark.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_FSL_DEFINITIONS
+#include "../../Aura/Shaders/FSL/lightPropagation.h"
+
+using namespace aura;
+
+static const uint32_t MAX_LIST_SIZE = 16;
+
+static uint32_t parseUIntList(const char* pArg, uint32_t* pValues)
+{
+    uint32_t count = 0;
+    for (const char* p = pArg; *p && count < MAX_LIST_SIZE;)
+    {
+        char* pEnd = NULL;
+        pValues[count++] = (uint32_t)strtoul(p, &pEnd, 10);
+        p = (*pEnd == ',') ? pEnd + 1 : pEnd;
+        if (pEnd == p)
+            break;
+    }
+    return count;
+}
+
+static uint32_t parseFloatList(const char* pArg, float* pValues)
+{
+    uint32_t count = 0;
+    for (const char* p = pArg; *p && count < MAX_LIST_SIZE;)
+    {
+        char* pEnd = NULL;
+        pValues[count++] = strtof(p, &pEnd);
+        p = (*pEnd == ',') ? pEnd + 1 : pEnd;
+        if (pEnd == p)
+            break;
+    }
+    return count;
+}
+
+static bool writeResults(const char* pPath, const CPUPropagationBenchmarkResult* pResults, uint32_t resultCount, bool json)
+{
+    FILE* pFile = fopen(pPath, "w");
+    if (!pFile)
+    {
+        fprintf(stderr, "Can't open %s\n", pPath);
+        return false;
+    }
+    if (json)
+        writeCPUPropagationBenchmarkJSON(pResults, resultCount, pFile);
+    else
+        writeCPUPropagationBenchmarkCSV(pResults, resultCount, pFile);
+    fclose(pFile);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t    gridRes[MAX_LIST_SIZE] = { 16, 32, 64 };
+    uint32_t    threadCounts[MAX_LIST_SIZE] = { 1, 3, 7 };
+    float       extents[MAX_LIST_SIZE] = { 1.0f, 0.25f };
+    uint32_t    gridResCount = 3;
+    uint32_t    threadCountCount = 3;
+    uint32_t    extentCount = 2;
+    const char* pCSVPath = NULL;
+    const char* pJSONPath = NULL;
+
+    CPUPropagationBenchmarkDesc desc = {};
+    desc.mPropagationSteps = 12;
+    desc.mWarmupIterations = 2;
+    desc.mIterations = 10;
+    desc.mLightDensity = 0.05f;
+    desc.mSeed = 7;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* pArg = argv[i];
+        const char* pValue = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!pValue)
+        {
+            fprintf(stderr, "Missing value for %s\n", pArg);
+            return 2;
+        }
+        ++i;
+
+        if (!strcmp(pArg, "--res"))
+            gridResCount = parseUIntList(pValue, gridRes);
+        else if (!strcmp(pArg, "--threads"))
+            threadCountCount = parseUIntList(pValue, threadCounts);
+        else if (!strcmp(pArg, "--extents"))
+            extentCount = parseFloatList(pValue, extents);
+        else if (!strcmp(pArg, "--steps"))
+            desc.mPropagationSteps = (uint32_t)atoi(pValue);
+        else if (!strcmp(pArg, "--warmup"))
+            desc.mWarmupIterations = (uint32_t)atoi(pValue);
+        else if (!strcmp(pArg, "--iterations"))
+            desc.mIterations = (uint32_t)atoi(pValue);
+        else if (!strcmp(pArg, "--density"))
+            desc.mLightDensity = (float)atof(pValue);
+        else if (!strcmp(pArg, "--seed"))
+            desc.mSeed = (uint32_t)atoi(pValue);
+        else if (!strcmp(pArg, "--csv"))
+            pCSVPath = pValue;
+        else if (!strcmp(pArg, "--json"))
+            pJSONPath = pValue;
+        else
+        {
+            fprintf(stderr, "Unknown argument %s\n", pArg);
+            return 2;
+        }
+    }
+
+    for (uint32_t i = 0; i < gridResCount; ++i)
+    {
+        if (!isValidGridRes(gridRes[i]))
+        {
+            fprintf(stderr, "Invalid grid resolution %u\n", gridRes[i]);
+            return 2;
+        }
+    }
+    for (uint32_t i = 0; i < extentCount; ++i)
+    {
+        if (!(extents[i] > 0.0f && extents[i] <= 1.0f))
+        {
+            fprintf(stderr, "Light extent %g is outside (0, 1]\n", extents[i]);
+            return 2;
+        }
+    }
+    if (!desc.mPropagationSteps || !(desc.mLightDensity > 0.0f && desc.mLightDensity <= 1.0f))
+    {
+        fprintf(stderr, "Steps have to be positive and the density in (0, 1]\n");
+        return 2;
+    }
+
+    ITaskManager* pTaskManagers[MAX_LIST_SIZE] = {};
+    for (uint32_t i = 0; i < threadCountCount; ++i)
+        initDefaultTaskManager(threadCounts[i], &pTaskManagers[i]);
+
+    desc.pGridRes = gridRes;
+    desc.mCascadeCount = gridResCount;
+    desc.ppTaskManagers = pTaskManagers;
+    desc.mTaskManagerCount = threadCountCount;
+    desc.pLightExtents = extents;
+    desc.mLightExtentCount = extentCount;
+
+    const uint32_t                 resultCount = getCPUPropagationBenchmarkResultCount(&desc);
+    CPUPropagationBenchmarkResult* pResults = (CPUPropagationBenchmarkResult*)calloc(resultCount, sizeof(CPUPropagationBenchmarkResult));
+    const uint32_t                 writtenCount = runCPUPropagationBenchmark(&desc, pResults);
+
+    for (uint32_t i = 0; i < threadCountCount; ++i)
+        removeDefaultTaskManager(pTaskManagers[i]);
+
+    bool bResult = writtenCount == resultCount;
+    if (pCSVPath)
+        bResult &= writeResults(pCSVPath, pResults, writtenCount, false);
+    if (pJSONPath)
+        bResult &= writeResults(pJSONPath, pResults, writtenCount, true);
+    if (!pCSVPath && !pJSONPath)
+        writeCPUPropagationBenchmarkCSV(pResults, writtenCount, stdout);
+
+    for (uint32_t i = 0; i < writtenCount; ++i)
+    {
+        const CPUPropagationBenchmarkResult& r = pResults[i];
+        if (r.bSparseMatchesDense && r.bStaticMatchesFull)
+            continue;
+        fprintf(stderr, "res %u %s %s: sparse %s dense, static %s full\n", r.mGridRes, r.eMTMode == MT_None ? "none" : "extreme_tasks",
+                r.bAdvancedDirections ? "advanced" : "basic", r.bSparseMatchesDense ? "matches" : "differs from",
+                r.bStaticMatchesFull ? "matches" : "differs from");
+        bResult = false;
+    }
+
+    free(pResults);
+    return bResult ? 0 : 1;
+}
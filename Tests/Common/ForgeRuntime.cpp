@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Headless stand-in for the parts of the The-Forge runtime the CPU code of the middleware links against:
+//	memory, log, stdio file streams, pthread threads and renderer entry points that record nothing.
+//	Keeps the tests free of a window, a GPU and the OS/Renderer libraries.
+
+#include "../../../The-Forge/Common_3/Graphics/Interfaces/IGraphics.h"
+#include "../../../The-Forge/Common_3/Resources/ResourceLoader/Interfaces/IResourceLoader.h"
+#include "../../../The-Forge/Common_3/Utilities/Interfaces/IFileSystem.h"
+#include "../../../The-Forge/Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../The-Forge/Common_3/Utilities/Interfaces/IMemory.h"
+#include "../../../The-Forge/Common_3/Utilities/Interfaces/IThread.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/************************************************************************/
+// Memory
+/************************************************************************/
+void* tf_malloc_internal(size_t size, const char*, int, const char*) { return malloc(size); }
+
+void* tf_memalign_internal(size_t align, size_t size, const char*, int, const char*)
+{
+    if (align < sizeof(void*))
+        align = sizeof(void*);
+    void* ptr = NULL;
+    return posix_memalign(&ptr, align, size) == 0 ? ptr : NULL;
+}
+
+void* tf_calloc_internal(size_t count, size_t size, const char*, int, const char*) { return calloc(count, size); }
+
+void* tf_calloc_memalign_internal(size_t count, size_t align, size_t size, const char* f, int l, const char* sf)
+{
+    void* ptr = tf_memalign_internal(align, count * size, f, l, sf);
+    if (ptr)
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* tf_realloc_internal(void* ptr, size_t size, const char*, int, const char*) { return realloc(ptr, size); }
+
+void tf_free_internal(void* ptr, const char*, int, const char*) { free(ptr); }
+
+/************************************************************************/
+// Log
+/************************************************************************/
+void writeLog(uint32_t level, const char* filename, int line_number, const char* message, ...)
+{
+    if (level == eDEBUG)
+        return;
+
+    const char* pLevel = level == eERROR ? "ERROR" : level == eWARNING ? "WARNING" : "INFO";
+    fprintf(stderr, "%s(%d): %s: ", filename, line_number, pLevel);
+    va_list args;
+    va_start(args, message);
+    vfprintf(stderr, message, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+void _FailedAssert(const char* file, int line, const char* statement, const char* msgFmt, ...)
+{
+    fprintf(stderr, "%s(%d): Assertion failed: %s ", file, line, statement);
+    if (msgFmt)
+    {
+        va_list args;
+        va_start(args, msgFmt);
+        vfprintf(stderr, msgFmt, args);
+        va_end(args);
+    }
+    fputc('\n', stderr);
+    abort();
+}
+
+void _OutputDebugString(const char* str, ...)
+{
+    va_list args;
+    va_start(args, str);
+    vfprintf(stderr, str, args);
+    va_end(args);
+}
+
+/************************************************************************/
+// File system
+/************************************************************************/
+//	mUser.data: FILE*, memory mapped copy, size of the copy
+static char gResourceDirectory[FS_MAX_PATH] = ".";
+
+void setTestResourceDirectory(const char* path)
+{
+    strncpy(gResourceDirectory, path, sizeof(gResourceDirectory) - 1);
+    gResourceDirectory[sizeof(gResourceDirectory) - 1] = 0;
+}
+
+bool fsOpenStreamFromPath(ResourceDirectory, const char* fileName, FileMode mode, FileStream* pOut)
+{
+    char path[FS_MAX_PATH * 2];
+    snprintf(path, sizeof(path), "%s/%s", gResourceDirectory, fileName);
+
+    const char* pMode = (mode & FM_APPEND) ? "ab" : (mode & FM_WRITE) ? ((mode & FM_READ) ? "w+b" : "wb") : "rb";
+    FILE*       pFile = fopen(path, pMode);
+    if (!pFile)
+        return false;
+
+    memset(pOut, 0, sizeof(*pOut));
+    pOut->mMode = mode;
+    pOut->mUser.data[0] = (uintptr_t)pFile;
+    return true;
+}
+
+bool fsCloseStream(FileStream* pFile)
+{
+    FILE* pHandle = (FILE*)pFile->mUser.data[0];
+    free((void*)pFile->mUser.data[1]);
+    memset(pFile, 0, sizeof(*pFile));
+    return pHandle && fclose(pHandle) == 0;
+}
+
+size_t fsReadFromStream(FileStream* pStream, void* pOutputBuffer, size_t bufferSizeInBytes)
+{
+    return fread(pOutputBuffer, 1, bufferSizeInBytes, (FILE*)pStream->mUser.data[0]);
+}
+
+size_t fsWriteToStream(FileStream* pStream, const void* pSourceBuffer, size_t byteCount)
+{
+    return fwrite(pSourceBuffer, 1, byteCount, (FILE*)pStream->mUser.data[0]);
+}
+
+bool fsSeekStream(FileStream* pStream, SeekBaseOffset baseOffset, ssize_t seekOffset)
+{
+    int origin = baseOffset == SBO_START_OF_FILE ? SEEK_SET : baseOffset == SBO_CURRENT_POSITION ? SEEK_CUR : SEEK_END;
+    return fseeko((FILE*)pStream->mUser.data[0], (off_t)seekOffset, origin) == 0;
+}
+
+ssize_t fsGetStreamSeekPosition(FileStream* pStream) { return (ssize_t)ftello((FILE*)pStream->mUser.data[0]); }
+
+ssize_t fsGetStreamFileSize(FileStream* pStream)
+{
+    FILE* pFile = (FILE*)pStream->mUser.data[0];
+    off_t position = ftello(pFile);
+    fseeko(pFile, 0, SEEK_END);
+    off_t size = ftello(pFile);
+    fseeko(pFile, position, SEEK_SET);
+    return (ssize_t)size;
+}
+
+bool fsFlushStream(FileStream* pStream) { return fflush((FILE*)pStream->mUser.data[0]) == 0; }
+
+bool fsStreamAtEnd(FileStream* pStream)
+{
+    FILE* pFile = (FILE*)pStream->mUser.data[0];
+    int   c = fgetc(pFile);
+    if (c == EOF)
+        return true;
+    ungetc(c, pFile);
+    return false;
+}
+
+bool fsStreamMemoryMap(FileStream* pStream, size_t* pSize, void const** pData)
+{
+    if (!pStream->mUser.data[1])
+    {
+        ssize_t size = fsGetStreamFileSize(pStream);
+        if (size <= 0)
+            return false;
+
+        void* pCopy = malloc((size_t)size);
+        FILE* pFile = (FILE*)pStream->mUser.data[0];
+        off_t position = ftello(pFile);
+        fseeko(pFile, 0, SEEK_SET);
+        size_t read = fread(pCopy, 1, (size_t)size, pFile);
+        fseeko(pFile, position, SEEK_SET);
+        if (read != (size_t)size)
+        {
+            free(pCopy);
+            return false;
+        }
+        pStream->mUser.data[1] = (uintptr_t)pCopy;
+        pStream->mUser.data[2] = (uintptr_t)size;
+    }
+
+    *pSize = (size_t)pStream->mUser.data[2];
+    *pData = (const void*)pStream->mUser.data[1];
+    return true;
+}
+
+/************************************************************************/
+// Threads
+/************************************************************************/
+bool initMutex(Mutex* pMutex) { return pthread_mutex_init(&pMutex->pHandle, NULL) == 0; }
+void exitMutex(Mutex* pMutex) { pthread_mutex_destroy(&pMutex->pHandle); }
+void acquireMutex(Mutex* pMutex) { pthread_mutex_lock(&pMutex->pHandle); }
+bool tryAcquireMutex(Mutex* pMutex) { return pthread_mutex_trylock(&pMutex->pHandle) == 0; }
+void releaseMutex(Mutex* pMutex) { pthread_mutex_unlock(&pMutex->pHandle); }
+
+bool initConditionVariable(ConditionVariable* cv) { return pthread_cond_init(&cv->pHandle, NULL) == 0; }
+void exitConditionVariable(ConditionVariable* cv) { pthread_cond_destroy(&cv->pHandle); }
+
+void waitConditionVariable(ConditionVariable* cv, Mutex* pMutex, uint32_t msTimeout)
+{
+    if (msTimeout == TIMEOUT_INFINITE)
+    {
+        pthread_cond_wait(&cv->pHandle, &pMutex->pHandle);
+        return;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += msTimeout / 1000;
+    ts.tv_nsec += (long)(msTimeout % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_sec += 1;
+        ts.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&cv->pHandle, &pMutex->pHandle, &ts);
+}
+
+void wakeOneConditionVariable(ConditionVariable* cv) { pthread_cond_signal(&cv->pHandle); }
+void wakeAllConditionVariable(ConditionVariable* cv) { pthread_cond_broadcast(&cv->pHandle); }
+
+static void* threadFunctionStatic(void* pData)
+{
+    ThreadDesc desc = *(ThreadDesc*)pData;
+    free(pData);
+    desc.pFunc(desc.pData);
+    return NULL;
+}
+
+bool initThread(ThreadDesc* pItem, ThreadHandle* pHandle)
+{
+    ThreadDesc* pDesc = (ThreadDesc*)malloc(sizeof(ThreadDesc));
+    *pDesc = *pItem;
+    if (pthread_create(pHandle, NULL, threadFunctionStatic, pDesc) != 0)
+    {
+        free(pDesc);
+        return false;
+    }
+    return true;
+}
+
+void joinThread(ThreadHandle handle) { pthread_join(handle, NULL); }
+
+void threadSleep(unsigned mSec) { usleep(mSec * 1000); }
+
+unsigned int getNumCPUCores(void)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (unsigned int)cores : 1;
+}
+
+/************************************************************************/
+// Renderer, nothing is recorded
+/************************************************************************/
+PlatformParameters gPlatformParameters = {};
+
+static void addBufferHeadless(Renderer*, const BufferDesc* pDesc, Buffer** ppBuffer)
+{
+    Buffer* pBuffer = (Buffer*)calloc(1, sizeof(Buffer));
+    pBuffer->mSize = pDesc->mSize;
+    pBuffer->pCpuMappedAddress = calloc(1, (size_t)pDesc->mSize);
+    *ppBuffer = pBuffer;
+}
+
+static void removeBufferHeadless(Renderer*, Buffer* pBuffer)
+{
+    free(pBuffer->pCpuMappedAddress);
+    free(pBuffer);
+}
+
+static void mapBufferHeadless(Renderer*, Buffer*, ReadRange*) {}
+static void unmapBufferHeadless(Renderer*, Buffer*) {}
+static void cmdResourceBarrierHeadless(Cmd*, uint32_t, BufferBarrier*, uint32_t, TextureBarrier*, uint32_t, RenderTargetBarrier*) {}
+static void cmdBeginDebugMarkerHeadless(Cmd*, float, float, float, const char*) {}
+static void cmdEndDebugMarkerHeadless(Cmd*) {}
+
+addBufferFn          addBuffer = addBufferHeadless;
+removeBufferFn       removeBuffer = removeBufferHeadless;
+mapBufferFn          mapBuffer = mapBufferHeadless;
+unmapBufferFn        unmapBuffer = unmapBufferHeadless;
+cmdResourceBarrierFn cmdResourceBarrier = cmdResourceBarrierHeadless;
+cmdBeginDebugMarkerFn cmdBeginDebugMarker = cmdBeginDebugMarkerHeadless;
+cmdEndDebugMarkerFn   cmdEndDebugMarker = cmdEndDebugMarkerHeadless;
+
+#if defined(VULKAN)
+PFN_vkCmdCopyImageToBuffer vkCmdCopyImageToBuffer = NULL;
+#endif
+
+static uint32_t gBufferLoadCount = 0;
+static uint32_t gTokenWaitCount = 0;
+
+void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
+{
+    addBufferHeadless(NULL, &pBufferDesc->mDesc, pBufferDesc->ppBuffer);
+    if (pBufferDesc->pData)
+        memcpy((*pBufferDesc->ppBuffer)->pCpuMappedAddress, pBufferDesc->pData, (size_t)pBufferDesc->mDesc.mSize);
+    if (token)
+        *token = ++gBufferLoadCount;
+    else
+        ++gBufferLoadCount;
+}
+
+void removeResource(Buffer* pBuffer) { removeBufferHeadless(NULL, pBuffer); }
+
+void waitForToken(const SyncToken*) { ++gTokenWaitCount; }
+
+uint32_t getHeadlessBufferLoadCount() { return gBufferLoadCount; }
+uint32_t getHeadlessTokenWaitCount() { return gTokenWaitCount; }
+
+void beginUpdateResource(TextureUpdateDesc*) {}
+void endUpdateResource(TextureUpdateDesc*) {}
+
+TextureSubresourceUpdate TextureUpdateDesc::getSubresourceUpdateDesc(uint32_t, uint32_t)
+{
+    //	Headless textures have no storage, callers get an empty update
+    TextureSubresourceUpdate update = {};
+    return update;
+}
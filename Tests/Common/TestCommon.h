@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//	Every test is its own executable. CHECK keeps going after a failure, main returns TEST_RESULT().
+static int gTestFailures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++gTestFailures;                                                     \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                                                                               \
+    do                                                                                                                            \
+    {                                                                                                                             \
+        double checkA = (double)(a);                                                                                              \
+        double checkB = (double)(b);                                                                                              \
+        if (!(fabs(checkA - checkB) <= (double)(tolerance)))                                                                      \
+        {                                                                                                                         \
+            fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g, tolerance %g\n", __FILE__, __LINE__, #a, #b, checkA, checkB, \
+                    (double)(tolerance));                                                                                         \
+            ++gTestFailures;                                                                                                      \
+        }                                                                                                                         \
+    } while (0)
+
+#define TEST_RESULT() (gTestFailures ? (fprintf(stderr, "%d check(s) failed\n", gTestFailures), 1) : 0)
+
+//	Directory fsOpenStreamFromPath resolves every ResourceDirectory to, "." by default. Provided by ForgeRuntime.cpp.
+void setTestResourceDirectory(const char* path);
+//	Number of addResource buffer loads and waitForToken calls so far
+uint32_t getHeadlessBufferLoadCount();
+uint32_t getHeadlessTokenWaitCount();
+
+//	Fresh directory under /tmp that fsOpenStreamFromPath resolves to, removed again with its files by removeTestResourceDirectory
+static char gTestResourceDirectory[64];
+
+static inline const char* createTestResourceDirectory()
+{
+    snprintf(gTestResourceDirectory, sizeof(gTestResourceDirectory), "/tmp/middleware_test_XXXXXX");
+    if (!mkdtemp(gTestResourceDirectory))
+        return NULL;
+    setTestResourceDirectory(gTestResourceDirectory);
+    return gTestResourceDirectory;
+}
+
+static inline int removeTestResourceEntry(const char* path, const struct stat*, int, struct FTW*) { return remove(path); }
+
+static inline void removeTestResourceDirectory()
+{
+    if (gTestResourceDirectory[0])
+        nftw(gTestResourceDirectory, removeTestResourceEntry, 8, FTW_DEPTH | FTW_PHYS);
+    gTestResourceDirectory[0] = 0;
+    setTestResourceDirectory(".");
+}
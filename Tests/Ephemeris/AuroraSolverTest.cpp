@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	AuroraSolver against the legacy Aurora::update. Without shared particles the end states match, otherwise they only differ by
+//	the order constraints are relaxed in: no more than the legacy solver differs from itself with its constraints reversed.
+//	Colors never share a particle and the thread count doesn't change the result.
+
+#include "../../Ephemeris/Sky/src/Aurora.h"
+
+#include "TestCommon.h"
+
+static const float gDeltaTime = 1.0f / 60.0f;
+
+static void removeAurora(Aurora* pAurora)
+{
+    arrfree(pAurora->particles);
+    arrfree(pAurora->constraints);
+}
+
+//	Same particles, constraints in the opposite order
+static void initReversed(const Aurora& aurora, Aurora* pOut)
+{
+    pOut->numOfWidth = aurora.numOfWidth;
+    pOut->numOfHeight = aurora.numOfHeight;
+    arrsetlen(pOut->particles, arrlenu(aurora.particles));
+    memcpy(pOut->particles, aurora.particles, sizeof(AuroraParticle) * arrlenu(aurora.particles));
+    for (size_t i = arrlenu(aurora.constraints); i-- > 0;)
+        pOut->makeConstraint(pOut->particles + (aurora.constraints[i].p1 - aurora.particles),
+                             pOut->particles + (aurora.constraints[i].p2 - aurora.particles));
+}
+
+static void step(Aurora* pAurora, const vec3& force, const vec3& wind)
+{
+    pAurora->addForce(force);
+    pAurora->windForce(wind);
+    pAurora->update(gDeltaTime);
+}
+
+static void step(AuroraSolver* pSolver, const vec3& force, const vec3& wind)
+{
+    pSolver->addForce(force);
+    pSolver->windForce(wind);
+    pSolver->update(gDeltaTime);
+}
+
+static float getMaxDistance(const Aurora& aurora, const AuroraSolver& solver)
+{
+    float maxDistance = 0.0f;
+    for (uint32_t i = 0; i < solver.particleCount; ++i)
+        maxDistance = max(maxDistance, length(aurora.particles[i].position - solver.getPosition(i)));
+    return maxDistance;
+}
+
+static float getMaxDistance(const Aurora& a, const Aurora& b)
+{
+    float maxDistance = 0.0f;
+    for (size_t i = 0; i < arrlenu(a.particles); ++i)
+        maxDistance = max(maxDistance, length(a.particles[i].position - b.particles[i].position));
+    return maxDistance;
+}
+
+static bool isSameState(const AuroraSolver& a, const AuroraSolver& b)
+{
+    return a.particleCount == b.particleCount && !memcmp(a.positionX, b.positionX, sizeof(float) * a.particleCount) &&
+           !memcmp(a.positionY, b.positionY, sizeof(float) * a.particleCount) &&
+           !memcmp(a.positionZ, b.positionZ, sizeof(float) * a.particleCount);
+}
+
+//	Every constraint is in exactly one color and no two constraints of a color touch the same particle
+static bool isValidColoring(const AuroraSolver& solver, const Aurora& aurora)
+{
+    if (solver.constraintCount != arrlenu(aurora.constraints) || solver.colorOffsets[0] != 0 ||
+        solver.colorOffsets[solver.colorCount] != solver.constraintCount)
+        return false;
+
+    uint32_t* pLastColor = (uint32_t*)tf_malloc(sizeof(uint32_t) * solver.particleCount);
+    memset(pLastColor, 0xff, sizeof(uint32_t) * solver.particleCount);
+    bool bValid = true;
+    for (uint32_t c = 0; c < solver.colorCount; ++c)
+    {
+        for (uint32_t i = solver.colorOffsets[c]; i < solver.colorOffsets[c + 1]; ++i)
+        {
+            const AuroraSolverConstraint& constraint = solver.constraints[i];
+            bValid = bValid && pLastColor[constraint.p1] != c && pLastColor[constraint.p2] != c;
+            pLastColor[constraint.p1] = pLastColor[constraint.p2] = c;
+        }
+    }
+    tf_free(pLastColor);
+    return bValid;
+}
+
+//	The aurora of SpaceObjects: one row of particles, wind along the ground and a lift
+static void testChain(bool bPinned)
+{
+    Aurora aurora;
+    aurora.Init(100000.0f, 4000.0f, 64, 1);
+    if (bPinned)
+        aurora.getParticle(0, 0)->makeUnmovable();
+    const vec3 pinnedPosition = aurora.getParticle(0, 0)->position;
+
+    AuroraSolver solver;
+    solver.Init(aurora, 1);
+    AuroraSolver threaded;
+    threaded.Init(aurora, 4);
+    CHECK(isValidColoring(solver, aurora));
+    CHECK(solver.colorCount == 2);
+
+    const vec3 force = normalize(vec3(1.0f, 0.0f, 1.0f)) * 50.0f;
+    const vec3 wind = vec3(0.0f, 30.0f, 0.0f);
+    for (uint32_t frame = 0; frame < 600; ++frame)
+    {
+        step(&aurora, force, wind);
+        step(&solver, force, wind);
+        step(&threaded, force, wind);
+    }
+    CHECK(isSameState(solver, threaded));
+
+    float extent = 0.0f;
+    for (uint32_t i = 0; i < solver.particleCount; ++i)
+        extent = max(extent, length(aurora.particles[i].position - aurora.particles[0].position));
+    CHECK(getMaxDistance(aurora, solver) <= 1e-4f * extent);
+
+    float maxStretch = 0.0f;
+    for (uint32_t i = 0; i < solver.constraintCount; ++i)
+    {
+        const AuroraSolverConstraint& constraint = solver.constraints[i];
+        const float distance = length(solver.getPosition(constraint.p1) - solver.getPosition(constraint.p2));
+        maxStretch = max(maxStretch, fabsf(distance - constraint.restDistance) / constraint.restDistance);
+    }
+    CHECK(maxStretch < 0.01f);
+
+    if (bPinned)
+    {
+        const vec3 position = solver.getPosition(0);
+        CHECK(position.x == pinnedPosition.x && position.y == pinnedPosition.y && position.z == pinnedPosition.z);
+    }
+
+    solver.Exit();
+    threaded.Exit();
+    removeAurora(&aurora);
+}
+
+int main()
+{
+    //	A single constraint has no order to differ in
+    {
+        Aurora aurora;
+        aurora.Init(100.0f, 10.0f, 2, 1);
+        AuroraSolver solver;
+        solver.Init(aurora, 1);
+        for (uint32_t frame = 0; frame < 300; ++frame)
+        {
+            step(&aurora, vec3(0.0f, -9.8f, 0.0f), vec3(2.0f, 0.0f, 1.0f));
+            step(&solver, vec3(0.0f, -9.8f, 0.0f), vec3(2.0f, 0.0f, 1.0f));
+        }
+        CHECK(getMaxDistance(aurora, solver) <= 1e-3f);
+        solver.Exit();
+        removeAurora(&aurora);
+    }
+
+    testChain(false);
+    testChain(true);
+
+    //	A dense cloth with shear and bend constraints and three pinned particles
+    {
+        Aurora aurora;
+        aurora.Init(1000.0f, 1000.0f, 16, 16);
+        for (uint32_t x = 0; x < 16; ++x)
+        {
+            for (uint32_t y = 0; y < 16; ++y)
+            {
+                if (y < 15)
+                    aurora.makeConstraint(aurora.getParticle(x, y), aurora.getParticle(x, y + 1));
+                if (x < 15 && y < 15)
+                {
+                    aurora.makeConstraint(aurora.getParticle(x, y), aurora.getParticle(x + 1, y + 1));
+                    aurora.makeConstraint(aurora.getParticle(x + 1, y), aurora.getParticle(x, y + 1));
+                }
+                if (x < 14)
+                    aurora.makeConstraint(aurora.getParticle(x, y), aurora.getParticle(x + 2, y));
+            }
+        }
+        for (uint32_t i = 0; i < 3; ++i)
+            aurora.getParticle(i, 0)->makeUnmovable();
+
+        Aurora reversed;
+        initReversed(aurora, &reversed);
+        AuroraSolver solver;
+        solver.Init(aurora, 1);
+        AuroraSolver threaded;
+        threaded.Init(aurora, 0);
+        CHECK(isValidColoring(solver, aurora));
+
+        for (uint32_t frame = 0; frame < 300; ++frame)
+        {
+            step(&aurora, vec3(0.0f, -9.8f, 0.0f), vec3(2.0f, 0.0f, 1.0f));
+            step(&reversed, vec3(0.0f, -9.8f, 0.0f), vec3(2.0f, 0.0f, 1.0f));
+            step(&solver, vec3(0.0f, -9.8f, 0.0f), vec3(2.0f, 0.0f, 1.0f));
+            step(&threaded, vec3(0.0f, -9.8f, 0.0f), vec3(2.0f, 0.0f, 1.0f));
+        }
+        CHECK(isSameState(solver, threaded));
+
+        const float orderError = getMaxDistance(aurora, reversed);
+        const float solverError = getMaxDistance(aurora, solver);
+        printf("dense cloth: %u colors, solver %g, reversed legacy %g\n", solver.colorCount, solverError, orderError);
+        CHECK(solverError <= 2.0f * orderError);
+
+        solver.Exit();
+        threaded.Exit();
+        removeAurora(&reversed);
+        removeAurora(&aurora);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Cloud noise volumes from synthetic DDS and KTX slices: both formats and every thread count give the same voxels, the voxels are
+//	the slice bytes as halfs and every mip the 2x2x2 average of the one above. The packed file and the pipeline cache round-trip
+//	the volume, and loadCloudNoise prefers them over the slices.
+
+#include "../../Ephemeris/VolumetricClouds/src/CloudNoiseLoader.h"
+
+#include <vector>
+
+#include "TestCommon.h"
+
+static const uint32_t gDimension = 16;
+static const uint32_t gThreadCounts[] = { 1, 4, 0 };
+
+static uint8_t getVoxelByte(uint32_t x, uint32_t y, uint32_t z, uint32_t c)
+{
+    return (uint8_t)((x * 37 + y * 11 + z * 73 + c * 101 + ((x * y) ^ (z * 5))) & 0xff);
+}
+
+static void putUInt32(std::vector<uint8_t>& data, size_t offset, uint32_t value) { memcpy(data.data() + offset, &value, sizeof(value)); }
+
+static bool writeFile(const char* fileName, const std::vector<uint8_t>& data)
+{
+    FileStream stream = {};
+    if (!fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_WRITE, &stream))
+        return false;
+    const bool bResult = fsWriteToStream(&stream, data.data(), data.size()) == data.size();
+    fsCloseStream(&stream);
+    return bResult;
+}
+
+//	BGRX without an alpha mask, alpha reads as 1.0 like on the GPU
+static bool writeDDSSlice(const char* fileName, uint32_t z)
+{
+    std::vector<uint8_t> data(128 + gDimension * gDimension * 4);
+    putUInt32(data, 0, 0x20534444);
+    putUInt32(data, 4, 124);
+    putUInt32(data, 8, 0x1007);
+    putUInt32(data, 12, gDimension);
+    putUInt32(data, 16, gDimension);
+    putUInt32(data, 20, gDimension * 4);
+    putUInt32(data, 76, 32);
+    putUInt32(data, 80, 0x40);
+    putUInt32(data, 88, 32);
+    putUInt32(data, 92, 0x00FF0000);
+    putUInt32(data, 96, 0x0000FF00);
+    putUInt32(data, 100, 0x000000FF);
+    putUInt32(data, 108, 0x1000);
+    for (uint32_t y = 0; y < gDimension; ++y)
+    {
+        for (uint32_t x = 0; x < gDimension; ++x)
+        {
+            uint8_t* pTexel = data.data() + 128 + (y * gDimension + x) * 4;
+            pTexel[0] = getVoxelByte(x, y, z, 2);
+            pTexel[1] = getVoxelByte(x, y, z, 1);
+            pTexel[2] = getVoxelByte(x, y, z, 0);
+            pTexel[3] = 0;
+        }
+    }
+    return writeFile(fileName, data);
+}
+
+//	RGBA with an opaque alpha and some key/value data in front of the texels
+static bool writeKTXSlice(const char* fileName, uint32_t z)
+{
+    static const uint8_t identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    const uint32_t       keyValueSize = 16;
+    const uint32_t       imageSize = gDimension * gDimension * 4;
+    std::vector<uint8_t> data(64 + keyValueSize + 4 + imageSize);
+    memcpy(data.data(), identifier, sizeof(identifier));
+    putUInt32(data, 12, 0x04030201);
+    putUInt32(data, 16, 0x1401);
+    putUInt32(data, 20, 1);
+    putUInt32(data, 24, 0x1908);
+    putUInt32(data, 28, 0x8058);
+    putUInt32(data, 32, 0x1908);
+    putUInt32(data, 36, gDimension);
+    putUInt32(data, 40, gDimension);
+    putUInt32(data, 52, 1);
+    putUInt32(data, 56, 1);
+    putUInt32(data, 60, keyValueSize);
+    putUInt32(data, 64 + keyValueSize, imageSize);
+    for (uint32_t y = 0; y < gDimension; ++y)
+    {
+        for (uint32_t x = 0; x < gDimension; ++x)
+        {
+            uint8_t* pTexel = data.data() + 64 + keyValueSize + 4 + (y * gDimension + x) * 4;
+            for (uint32_t c = 0; c < 3; ++c)
+                pTexel[c] = getVoxelByte(x, y, z, c);
+            pTexel[3] = 255;
+        }
+    }
+    return writeFile(fileName, data);
+}
+
+static bool isSameVolume(const CloudNoiseVolume& a, const CloudNoiseVolume& b)
+{
+    return a.mDimension == b.mDimension && a.mMipCount == b.mMipCount && a.pVoxels && b.pVoxels &&
+           !memcmp(a.pVoxels, b.pVoxels, getCloudNoiseMipOffset(a.mDimension, a.mMipCount) * sizeof(uint16_t));
+}
+
+static float getVoxel(const CloudNoiseVolume& volume, uint32_t mip, uint32_t x, uint32_t y, uint32_t z, uint32_t c)
+{
+    const uint32_t size = volume.mDimension >> mip;
+    const uint64_t voxel = ((uint64_t)z * size + y) * size + x;
+    return cloudNoiseHalfToFloat(volume.pVoxels[getCloudNoiseMipOffset(volume.mDimension, mip) + voxel * CLOUD_NOISE_CHANNEL_COUNT + c]);
+}
+
+int main()
+{
+    //	Every finite half against its definition
+    for (uint32_t bits = 0; bits < 0x10000; ++bits)
+    {
+        const uint32_t exponent = (bits >> 10) & 0x1F;
+        if (exponent == 0x1F)
+            continue;
+        const float magnitude = exponent ? ldexpf(1.0f + (bits & 0x3FF) / 1024.0f, (int)exponent - 15) : ldexpf((float)(bits & 0x3FF), -24);
+        CHECK(cloudNoiseHalfToFloat((uint16_t)bits) == ((bits & 0x8000) ? -magnitude : magnitude));
+    }
+    CHECK(isinf(cloudNoiseHalfToFloat(0x7C00)) && isnan(cloudNoiseHalfToFloat(0x7E00)));
+
+    CHECK(getCloudNoiseMipCount(gDimension) == 5);
+    CHECK(getCloudNoiseMipOffset(gDimension, 1) == gDimension * gDimension * gDimension * CLOUD_NOISE_CHANNEL_COUNT);
+
+    CHECK(createTestResourceDirectory() != NULL);
+    for (uint32_t z = 0; z < gDimension; ++z)
+    {
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "slice_%u.dds", z);
+        CHECK(writeDDSSlice(fileName, z));
+        snprintf(fileName, sizeof(fileName), "slice_%u.ktx", z);
+        CHECK(writeKTXSlice(fileName, z));
+    }
+
+    CloudNoiseVolume volume = {};
+    CHECK(loadCloudNoiseSlices("slice_%u.dds", gDimension, 1, &volume));
+    CHECK(volume.mDimension == gDimension && volume.mMipCount == 5);
+
+    //	Top mip: the unorm bytes, rounded to half
+    for (uint32_t z = 0; z < gDimension; ++z)
+    {
+        for (uint32_t y = 0; y < gDimension; ++y)
+        {
+            for (uint32_t x = 0; x < gDimension; ++x)
+            {
+                for (uint32_t c = 0; c < 3; ++c)
+                    CHECK_NEAR(getVoxel(volume, 0, x, y, z, c), getVoxelByte(x, y, z, c) / 255.0f, 2.5e-4f);
+                CHECK(getVoxel(volume, 0, x, y, z, 3) == 1.0f);
+            }
+        }
+    }
+
+    //	Every mip is the average of the 8 voxels above it, within half precision
+    for (uint32_t mip = 1; mip < volume.mMipCount; ++mip)
+    {
+        const uint32_t size = gDimension >> mip;
+        for (uint32_t z = 0; z < size; ++z)
+        {
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                for (uint32_t x = 0; x < size; ++x)
+                {
+                    for (uint32_t c = 0; c < CLOUD_NOISE_CHANNEL_COUNT; ++c)
+                    {
+                        double sum = 0.0;
+                        for (uint32_t k = 0; k < 8; ++k)
+                            sum += getVoxel(volume, mip - 1, x * 2 + (k & 1), y * 2 + ((k >> 1) & 1), z * 2 + (k >> 2), c);
+                        CHECK_NEAR(getVoxel(volume, mip, x, y, z, c), sum / 8.0, 5e-4);
+                    }
+                }
+            }
+        }
+    }
+
+    for (uint32_t threadCount : gThreadCounts)
+    {
+        CloudNoiseVolume dds = {};
+        CloudNoiseVolume ktx = {};
+        CHECK(loadCloudNoiseSlices("slice_%u.dds", gDimension, threadCount, &dds));
+        CHECK(loadCloudNoiseSlices("slice_%u.ktx", gDimension, threadCount, &ktx));
+        CHECK(isSameVolume(volume, dds));
+        CHECK(isSameVolume(volume, ktx));
+        exitCloudNoiseVolume(&dds);
+        exitCloudNoiseVolume(&ktx);
+    }
+
+    //	Packed files hold the same voxels and only load for their dimension
+    CHECK(convertCloudNoiseSlices("slice_%u.ktx", gDimension, RD_TEXTURES, "noise.cdn"));
+    CloudNoiseVolume packed = {};
+    CHECK(loadPackedCloudNoise(RD_TEXTURES, "noise.cdn", gDimension, &packed));
+    CHECK(isSameVolume(volume, packed));
+    exitCloudNoiseVolume(&packed);
+    CHECK(!loadPackedCloudNoise(RD_TEXTURES, "noise.cdn", gDimension * 2, &packed));
+    CHECK(!packed.pVoxels);
+
+    //	Missing or wrongly sized slices fail without leaking the volume
+    CHECK(!loadCloudNoiseSlices("missing_%u.dds", gDimension, 0, &packed));
+    CHECK(!packed.pVoxels);
+    CHECK(!loadCloudNoiseSlices("slice_%u.dds", gDimension * 2, 0, &packed));
+    CHECK(!packed.pVoxels);
+
+    //	Without a packed file the slices are loaded once and cached, the next load only reads the cache
+    const CloudNoiseDesc descs[2] = {
+        { "missing.cdn", "dds.cache", "slice_%u.dds", gDimension, 0 },
+        { "noise.cdn", "unused.cache", "missing_%u.ktx", gDimension, 0 },
+    };
+    for (uint32_t run = 0; run < 2; ++run)
+    {
+        CloudNoiseVolume volumes[2] = {};
+        CloudNoiseLoad   load = {};
+        load.pDescs = descs;
+        load.pVolumes = volumes;
+        load.mCount = 2;
+        beginLoadCloudNoise(&load);
+        CHECK(waitLoadCloudNoise(&load));
+        CHECK(isSameVolume(volume, volumes[0]));
+        CHECK(isSameVolume(volume, volumes[1]));
+        exitCloudNoiseVolume(&volumes[0]);
+        exitCloudNoiseVolume(&volumes[1]);
+
+        if (!run)
+        {
+            CloudNoiseVolume cached = {};
+            CHECK(loadPackedCloudNoise(RD_PIPELINE_CACHE, "dds.cache", gDimension, &cached));
+            exitCloudNoiseVolume(&cached);
+            for (uint32_t z = 0; z < gDimension; ++z)
+            {
+                char path[128];
+                snprintf(path, sizeof(path), "%s/slice_%u.dds", gTestResourceDirectory, z);
+                CHECK(remove(path) == 0);
+            }
+        }
+    }
+
+    //	A failing volume frees the ones that did load
+    const CloudNoiseDesc failingDescs[2] = {
+        { "noise.cdn", "unused.cache", "missing_%u.ktx", gDimension, 0 },
+        { "missing.cdn", "missing.cache", "missing_%u.dds", gDimension, 0 },
+    };
+    CloudNoiseVolume volumes[2] = {};
+    CloudNoiseLoad   load = {};
+    load.pDescs = failingDescs;
+    load.pVolumes = volumes;
+    load.mCount = 2;
+    beginLoadCloudNoise(&load);
+    CHECK(!waitLoadCloudNoise(&load));
+    CHECK(!volumes[0].pVoxels && !volumes[1].pVoxels);
+
+    exitCloudNoiseVolume(&volume);
+    removeTestResourceDirectory();
+    return TEST_RESULT();
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	CPU cloud ray-marcher on the shipped cloud textures: finite pixels in range, clouds in a cloudy sky and none without coverage,
+//	step counts within the sample count bounds, and the same image for every tile size and thread count.
+
+#include "../../Ephemeris/VolumetricClouds/src/CloudRayMarcher.h"
+
+#include "TestCommon.h"
+
+static const uint32_t gWidth = 96;
+static const uint32_t gHeight = 54;
+
+//	Camera 1km above the ground looking slightly up, the default cloud layer of the sample
+static void initCB(VolumetricCloudsCB* pCB, float pitch)
+{
+    *pCB = VolumetricCloudsCB();
+    pCB->TimeAndScreenSize = vec4(1234.0f, 1234.0f, (float)gWidth, (float)gHeight);
+    pCB->CameraNear = 50.0f;
+    pCB->CameraFar = 100000000.0f;
+    const float aspect = (float)gHeight / gWidth;
+    pCB->m_DataPerEye[0].m_ProjToRelativeToEye =
+        mat4(vec4(1.0f, 0.0f, 0.0f, 0.0f), vec4(0.0f, aspect * cosf(pitch), -aspect * sinf(pitch), 0.0f), vec4(0.0f, 0.0f, 0.0f, 0.0f),
+             vec4(0.0f, sinf(pitch), cosf(pitch), 1.0f));
+    pCB->m_DataPerEye[0].cameraPosition = vec4(0.0f, 1000.0f, 0.0f, 1.0f);
+    pCB->EarthRadius = 6360000.0f;
+    pCB->EarthCenter = vec4(0.0f, -pCB->EarthRadius, 0.0f, 0.0f);
+    pCB->m_MaxSampleDistance = 800000.0f;
+    pCB->MIN_ITERATION_COUNT = 64;
+    pCB->MAX_ITERATION_COUNT = 192;
+    pCB->m_StepSize = vec4(256.0f, 1024.0f, 0.0f, 0.0f);
+    pCB->Random00 = 0.5f;
+
+    const vec3 lightDirection = normalize(vec3(0.3f, 0.5f, 0.8f));
+    pCB->lightDirection = vec4(lightDirection, 1340.0f);
+    pCB->Eccentricity = 0.65f;
+    pCB->SilverliningIntensity = 0.5f * (1.0f - lightDirection.getY()) * (1.0f - lightDirection.getY());
+    pCB->SilverliningSpread = 0.29f;
+
+    DataPerLayer& layer = pCB->m_DataPerLayer[0];
+    layer.CloudsLayerStart = 12500.0f;
+    layer.LayerThickness = 55000.0f;
+    layer.EarthRadiusAddCloudsLayerStart = pCB->EarthRadius + layer.CloudsLayerStart;
+    layer.EarthRadiusAddCloudsLayerStart2 = layer.EarthRadiusAddCloudsLayerStart * layer.EarthRadiusAddCloudsLayerStart;
+    layer.EarthRadiusAddCloudsLayerEnd = layer.EarthRadiusAddCloudsLayerStart + layer.LayerThickness;
+    layer.EarthRadiusAddCloudsLayerEnd2 = layer.EarthRadiusAddCloudsLayerEnd * layer.EarthRadiusAddCloudsLayerEnd;
+    layer.CloudDensity = 3.4f;
+    layer.CloudTopOffset = 500.0f;
+    layer.CloudSize = 103305.805f;
+    layer.BaseShapeTiling = 0.621f;
+    layer.DetailShapeTiling = 5.496f;
+    layer.DetailStrenth = 0.25f;
+    layer.CurlTextureTiling = 0.1f;
+    layer.CurlStrenth = 2000.0f;
+    layer.WeatherTextureSize = 867770.0f;
+    layer.AnvilBias = 1.0f;
+    layer.Contrast = 1.33f;
+    layer.Precipitation = 2.5f;
+    layer.WindDirection = vec4(1.0f, 0.0f, 0.0f, 20.0f);
+    layer.RisingVaporScale = 0.001f;
+    layer.RisingVaporUpDirection = -1.0f;
+    layer.RisingVaporIntensity = 5.0f;
+}
+
+struct Image
+{
+    float    pixels[gWidth * gHeight * 4];
+    uint32_t stepCounts[gWidth * gHeight];
+};
+
+static void render(const CloudRayMarcherDesc& desc, Image* pImage, bool bStepCounts = true)
+{
+    CloudRayMarcherOutput output = { pImage->pixels, bStepCounts ? pImage->stepCounts : NULL };
+    rayMarchClouds(&desc, &output);
+}
+
+static bool isSameImage(const Image& a, const Image& b, bool bStepCounts = true)
+{
+    return !memcmp(a.pixels, b.pixels, sizeof(a.pixels)) && (!bStepCounts || !memcmp(a.stepCounts, b.stepCounts, sizeof(a.stepCounts)));
+}
+
+int main()
+{
+    setTestResourceDirectory(EPHEMERIS_CLOUD_TEXTURE_DIR);
+    CloudNoiseVolume highFrequencyNoise = {};
+    CloudNoiseVolume lowFrequencyNoise = {};
+    CloudNoiseImage  curlNoise = {};
+    CloudNoiseImage  weatherMap = {};
+    CHECK(loadCloudNoiseSlices("hiResCloudShape/hiResClouds (%u).tex", 32, 0, &highFrequencyNoise));
+    CHECK(loadCloudNoiseSlices("lowResCloudShape/lowResCloud(%u).tex", 128, 0, &lowFrequencyNoise));
+    CHECK(loadCloudNoiseImage("CurlNoiseFBM.tex", &curlNoise));
+    CHECK(loadCloudNoiseImage("WeatherMap.tex", &weatherMap));
+    setTestResourceDirectory(".");
+    if (!highFrequencyNoise.pVoxels || !lowFrequencyNoise.pVoxels || !curlNoise.pTexels || !weatherMap.pTexels)
+        return TEST_RESULT();
+
+    VolumetricCloudsCB cb;
+    initCB(&cb, 0.35f);
+    CloudRayMarcherTextures textures = { &highFrequencyNoise, &lowFrequencyNoise, &curlNoise, &weatherMap };
+    CloudRayMarcherDesc     desc = { &cb, &textures, 0, 0, 0, 1 };
+
+    Image* pReference = (Image*)tf_malloc(sizeof(Image));
+    Image* pImage = (Image*)tf_malloc(sizeof(Image));
+    render(desc, pReference);
+
+    uint32_t cloudyPixelCount = 0;
+    for (uint32_t i = 0; i < gWidth * gHeight; ++i)
+    {
+        const float* pPixel = pReference->pixels + i * 4;
+        CHECK(isfinite(pPixel[0]) && isfinite(pPixel[1]) && isfinite(pPixel[2]) && isfinite(pPixel[3]));
+        CHECK(pPixel[0] >= 0.0f && pPixel[3] >= 0.0f && pPixel[3] <= 1.0f);
+        CHECK(pReference->stepCounts[i] < cb.MAX_ITERATION_COUNT);
+        cloudyPixelCount += pPixel[3] > 0.0f;
+    }
+    CHECK(cloudyPixelCount > gWidth * gHeight / 10 && cloudyPixelCount < gWidth * gHeight);
+
+    //	Tiles and threads only change the order pixels are marched in
+    const uint32_t configs[][2] = { { 0, 4 }, { 7, 3 }, { 16, 8 }, { 5, 0 } };
+    for (const uint32_t* pConfig : configs)
+    {
+        desc.mTileSize = pConfig[0];
+        desc.mThreadCount = pConfig[1];
+        render(desc, pImage);
+        CHECK(isSameImage(*pReference, *pImage));
+    }
+    render(desc, pImage, false);
+    CHECK(isSameImage(*pReference, *pImage, false));
+
+    //	Overridden sample counts bound the steps
+    desc.mMinSampleCount = 16;
+    desc.mMaxSampleCount = 32;
+    render(desc, pImage);
+    for (uint32_t i = 0; i < gWidth * gHeight; ++i)
+        CHECK(pImage->stepCounts[i] < desc.mMaxSampleCount);
+    desc.mMinSampleCount = 0;
+    desc.mMaxSampleCount = 0;
+
+    //	Without coverage in the weather map the sky is clear
+    CloudNoiseImage clearWeather = weatherMap;
+    const size_t    weatherSize = (size_t)getCloudNoiseImageMipOffset(&weatherMap, weatherMap.mMipCount) * sizeof(float);
+    clearWeather.pTexels = (float*)tf_malloc(weatherSize);
+    memset(clearWeather.pTexels, 0, weatherSize);
+    textures.pWeatherMap = &clearWeather;
+    render(desc, pImage);
+    for (uint32_t i = 0; i < gWidth * gHeight; ++i)
+        CHECK(pImage->pixels[i * 4 + 3] == 0.0f);
+    tf_free(clearWeather.pTexels);
+
+    tf_free(pReference);
+    tf_free(pImage);
+    exitCloudNoiseVolume(&highFrequencyNoise);
+    exitCloudNoiseVolume(&lowFrequencyNoise);
+    exitCloudNoiseImage(&curlNoise);
+    exitCloudNoiseImage(&weatherMap);
+    return TEST_RESULT();
+}
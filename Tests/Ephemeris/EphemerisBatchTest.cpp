@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Ephemeris::UpdateBatch against one Ephemeris::Update per instant: the double path matches it, the float path stays within
+//	its documented error. Shuffled times, a shared location and missing outputs don't change the results.
+
+#include "../../Ephemeris/Sky/src/Ephemeris.h"
+
+#include <random>
+#include <vector>
+
+#include "TestCommon.h"
+
+using namespace confetti;
+
+static const uint32_t gRandomCount = 20000;
+static const uint32_t gTimelineCount = 1440 * 3;
+
+static const double gDoubleTolerance = 1e-6;
+static const double gFloatTolerance = 1e-5;
+
+struct Directions
+{
+    std::vector<float3> sun;
+    std::vector<float3> moon;
+    std::vector<float3> sunLocalToMoon;
+
+    explicit Directions(uint32_t count): sun(count), moon(count), sunLocalToMoon(count) {}
+    EphemerisBatchOutput getOutput() { return { sun.data(), moon.data(), sunLocalToMoon.data() }; }
+};
+
+static double getAngle(const float3& a, const float3& b)
+{
+    const double cx = (double)a.y * b.z - (double)a.z * b.y;
+    const double cy = (double)a.z * b.x - (double)a.x * b.z;
+    const double cz = (double)a.x * b.y - (double)a.y * b.x;
+    return atan2(sqrt(cx * cx + cy * cy + cz * cz), (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z);
+}
+
+static double getLength(const float3& v) { return sqrt((double)v.x * v.x + (double)v.y * v.y + (double)v.z * v.z); }
+
+//	Largest angle to the directions of Update, lengths have to match as well
+static double getMaxError(const Directions& directions, const LocalTime* pTimes, const Location* pLocations, uint32_t locationCount)
+{
+    double maxError = 0.0;
+    for (uint32_t i = 0; i < (uint32_t)directions.sun.size(); ++i)
+    {
+        Ephemeris ephemeris;
+        ephemeris.Update(pLocations[locationCount == 1 ? 0 : i], pTimes[i]);
+        const float3 expected[3] = { ephemeris.getSunDirection(), ephemeris.getMoonDirection(), ephemeris.getSunLocalToMoonDirection() };
+        const float3 actual[3] = { directions.sun[i], directions.moon[i], directions.sunLocalToMoon[i] };
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            maxError = fmax(maxError, getAngle(expected[c], actual[c]));
+            CHECK_NEAR(getLength(actual[c]) / getLength(expected[c]), 1.0, 1e-5);
+        }
+    }
+    return maxError;
+}
+
+int main()
+{
+    //	Random instants and places over a century, in no particular order
+    std::mt19937                           rng(1);
+    std::uniform_int_distribution<int>     dist(0, 1 << 30);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<LocalTime>                 times(gRandomCount);
+    std::vector<Location>                  locations(gRandomCount);
+    for (uint32_t i = 0; i < gRandomCount; ++i)
+    {
+        LocalTime& time = times[i];
+        time.setLocalYear(1950 + dist(rng) % 100);
+        time.setLocalMonth(1 + dist(rng) % 12);
+        time.setLocalDay(1 + dist(rng) % 28);
+        time.setLocalHours(dist(rng) % 24);
+        time.setLocalMinutes(dist(rng) % 60);
+        time.setLocalSeconds((dist(rng) % 600) / 10.0);
+        time.setGMTOffset(dist(rng) % 25 - 12);
+        time.setDayLightSavingEnabled(dist(rng) & 1);
+        locations[i] = Location((unit(rng) - 0.5) * PI, unit(rng) * 2.0 * PI);
+    }
+
+    Directions          directions(gRandomCount);
+    EphemerisBatchDesc desc = { times.data(), locations.data(), gRandomCount, gRandomCount, EPHEMERIS_PRECISION_DOUBLE };
+    Ephemeris::UpdateBatch(desc, directions.getOutput());
+    const double doubleError = getMaxError(directions, times.data(), locations.data(), gRandomCount);
+    CHECK(doubleError <= gDoubleTolerance);
+
+    desc.mPrecision = EPHEMERIS_PRECISION_FLOAT;
+    Ephemeris::UpdateBatch(desc, directions.getOutput());
+    const double floatError = getMaxError(directions, times.data(), locations.data(), gRandomCount);
+    CHECK(floatError <= gFloatTolerance);
+    printf("max error double %.3g, float %.3g radians\n", doubleError, floatError);
+
+    //	A minute by minute timeline at one place, the case the cached precession is for
+    std::vector<LocalTime> timeline(gTimelineCount);
+    for (uint32_t i = 0; i < gTimelineCount; ++i)
+    {
+        timeline[i].setLocalYear(2024);
+        timeline[i].setLocalMonth(3);
+        timeline[i].setLocalDay(19 + i / 1440);
+        timeline[i].setLocalHours((i / 60) % 24);
+        timeline[i].setLocalMinutes(i % 60);
+    }
+    const Location location(0.6, 2.1);
+    Directions     timelineDirections(gTimelineCount);
+    desc = { timeline.data(), &location, gTimelineCount, 1, EPHEMERIS_PRECISION_DOUBLE };
+    Ephemeris::UpdateBatch(desc, timelineDirections.getOutput());
+    CHECK(getMaxError(timelineDirections, timeline.data(), &location, 1) <= gDoubleTolerance);
+
+    //	Outputs are independent, leaving some out doesn't change the others
+    Directions partial(gTimelineCount);
+    Ephemeris::UpdateBatch(desc, { NULL, partial.moon.data(), NULL });
+    CHECK(!memcmp(partial.moon.data(), timelineDirections.moon.data(), sizeof(float3) * gTimelineCount));
+    Ephemeris::UpdateBatch(desc, { partial.sun.data(), NULL, partial.sunLocalToMoon.data() });
+    CHECK(!memcmp(partial.sun.data(), timelineDirections.sun.data(), sizeof(float3) * gTimelineCount));
+    CHECK(!memcmp(partial.sunLocalToMoon.data(), timelineDirections.sunLocalToMoon.data(), sizeof(float3) * gTimelineCount));
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	EphemerisCache lookups stay within mMaxAngularError of Ephemeris::Update at random times, tighter bounds take more nodes,
+//	a saved cache loads with the same results and only for its own desc.
+
+#include "../../Ephemeris/Sky/src/EphemerisCache.h"
+
+#include <random>
+
+#include "TestCommon.h"
+
+using namespace confetti;
+
+static const double   gDurationSeconds = 10.0 * 86400.0;
+static const double   gErrorBounds[] = { 1e-3, 1e-4, 1e-5 };
+static const uint32_t gSampleCount = 20000;
+
+static double getAngle(const float3& a, const float3& b)
+{
+    const double cx = (double)a.y * b.z - (double)a.z * b.y;
+    const double cy = (double)a.z * b.x - (double)a.x * b.z;
+    const double cz = (double)a.x * b.y - (double)a.y * b.x;
+    return atan2(sqrt(cx * cx + cy * cy + cz * cz), (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z);
+}
+
+static double getMaxError(const EphemerisCache& cache, const EphemerisCacheDesc& desc, std::mt19937& rng)
+{
+    std::uniform_real_distribution<double> dist(0.0, gDurationSeconds);
+    double                                 maxError = 0.0;
+    for (uint32_t i = 0; i < gSampleCount; ++i)
+    {
+        LocalTime localTime = desc.mBegin;
+        localTime.setLocalSeconds(dist(rng));
+
+        float3 actual[3];
+        cache.Lookup(localTime, &actual[0], &actual[1], &actual[2]);
+        Ephemeris ephemeris;
+        ephemeris.Update(desc.mLocation, localTime);
+        const float3 expected[3] = { ephemeris.getSunDirection(), ephemeris.getMoonDirection(), ephemeris.getSunLocalToMoonDirection() };
+        for (uint32_t c = 0; c < 3; ++c)
+            maxError = fmax(maxError, getAngle(actual[c], expected[c]));
+    }
+    return maxError;
+}
+
+static bool isSameLookup(const EphemerisCache& a, const EphemerisCache& b, double seconds)
+{
+    float3 valuesA[3];
+    float3 valuesB[3];
+    a.Lookup(seconds, &valuesA[0], &valuesA[1], &valuesA[2]);
+    b.Lookup(seconds, &valuesB[0], &valuesB[1], &valuesB[2]);
+    return !memcmp(valuesA, valuesB, sizeof(valuesA));
+}
+
+int main()
+{
+    CHECK(createTestResourceDirectory() != NULL);
+
+    LocalTime begin;
+    begin.setLocalYear(2031);
+    begin.setLocalMonth(7);
+    begin.setLocalDay(11);
+    begin.setLocalHours(5);
+    begin.setGMTOffset(-3);
+    const Location location(0.7, 5.2);
+
+    std::mt19937 rng(7);
+    uint32_t     previousNodeCount = 0;
+    for (double errorBound : gErrorBounds)
+    {
+        EphemerisCacheDesc desc = getDefaultEphemerisCacheDesc(location, begin, gDurationSeconds);
+        desc.mMaxAngularError = errorBound;
+        EphemerisCache cache;
+        cache.Init(desc);
+        CHECK(cache.getNodeCount() > previousNodeCount);
+        previousNodeCount = cache.getNodeCount();
+
+        const double maxError = getMaxError(cache, desc, rng);
+        printf("bound %.0e: %u nodes, max error %.3g radians\n", errorBound, cache.getNodeCount(), maxError);
+        CHECK(maxError <= errorBound);
+
+        //	Times outside of the range are clamped to its ends
+        float3 before;
+        float3 first;
+        float3 after;
+        float3 last;
+        cache.Lookup(-1000.0, &before, NULL, NULL);
+        cache.Lookup(0.0, &first, NULL, NULL);
+        cache.Lookup(gDurationSeconds + 1000.0, &after, NULL, NULL);
+        cache.Lookup(gDurationSeconds, &last, NULL, NULL);
+        CHECK(!memcmp(&before, &first, sizeof(float3)) && !memcmp(&after, &last, sizeof(float3)));
+
+        CHECK(cache.Save(RD_PIPELINE_CACHE, "ephemeris.cache"));
+        EphemerisCache loaded;
+        CHECK(loaded.Load(RD_PIPELINE_CACHE, "ephemeris.cache", desc));
+        CHECK(loaded.getNodeCount() == cache.getNodeCount());
+        for (uint32_t i = 0; i <= 100; ++i)
+            CHECK(isSameLookup(cache, loaded, gDurationSeconds * i / 100.0 + 0.5));
+        loaded.Exit();
+
+        EphemerisCacheDesc otherDesc = desc;
+        otherDesc.mMaxAngularError *= 2.0;
+        CHECK(!loaded.Load(RD_PIPELINE_CACHE, "ephemeris.cache", otherDesc));
+        otherDesc = desc;
+        otherDesc.mLocation.setLatitude(0.71);
+        CHECK(!loaded.Load(RD_PIPELINE_CACHE, "ephemeris.cache", otherDesc));
+        otherDesc = desc;
+        otherDesc.mBegin.setLocalDay(12);
+        CHECK(!loaded.Load(RD_PIPELINE_CACHE, "ephemeris.cache", otherDesc));
+
+        cache.Exit();
+    }
+
+    EphemerisCache missing;
+    CHECK(!missing.Load(RD_PIPELINE_CACHE, "missing.cache", getDefaultEphemerisCacheDesc(location, begin, gDurationSeconds)));
+
+    removeTestResourceDirectory();
+    return TEST_RESULT();
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Tiled height maps have to sample exactly like the raw map they were converted from, for every tile size, and the batched
+//	sampling exactly like the single one. Broken or missing files leave the height data unloaded.
+
+#include "../../Ephemeris/Terrain/src/HeightData.h"
+
+#include <random>
+
+#include "TestCommon.h"
+
+//	Not a power of two plus one, so loading pads the grid
+static const uint32_t gHeightMapSize = 300;
+static const uint32_t gTileSizes[] = { 16, 64, 128 };
+static const int      gSteps[] = { 1, 2, 4 };
+static const uint32_t gSampleCount = 1000;
+
+static bool writeFile(const char* fileName, const void* pData, size_t size)
+{
+    FileStream stream = {};
+    if (!fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_WRITE, &stream))
+        return false;
+    const bool bResult = fsWriteToStream(&stream, pData, size) == size;
+    fsCloseStream(&stream);
+    return bResult;
+}
+
+static bool writeHeightMap(const char* fileName)
+{
+    float* pHeights = (float*)tf_malloc(sizeof(float) * gHeightMapSize * gHeightMapSize);
+    for (uint32_t row = 0; row < gHeightMapSize; ++row)
+        for (uint32_t col = 0; col < gHeightMapSize; ++col)
+            pHeights[row * gHeightMapSize + col] = sinf(col * 0.05f) * cosf(row * 0.03f) + 0.001f * (float)((row * 31 + col * 17) % 101);
+    const bool bResult = writeFile(fileName, pHeights, sizeof(float) * gHeightMapSize * gHeightMapSize);
+    tf_free(pHeights);
+    return bResult;
+}
+
+//	Coordinates inside and far outside the map, sampling mirrors them back
+static void getSampleCoords(float2* pCoords, uint32_t count)
+{
+    std::mt19937                          rng(17);
+    std::uniform_real_distribution<float> dist(-2000.0f, 2000.0f);
+    for (uint32_t i = 0; i < count; ++i)
+        pCoords[i] = float2(dist(rng), dist(rng));
+    pCoords[0] = float2(0.0f, 0.0f);
+    pCoords[1] = float2(3.0f, 7.0f);
+}
+
+int main()
+{
+    CHECK(createTestResourceDirectory() != NULL);
+    CHECK(writeHeightMap("height.r32"));
+
+    HeightData raw("height.r32", HEIGHT_DATA_RAW);
+    CHECK(raw.isLoaded());
+    CHECK(raw.colCount == 513 && raw.rowCount == 513);
+
+    float2* pCoords = (float2*)tf_malloc(sizeof(float2) * gSampleCount);
+    float*  pExpected = (float*)tf_malloc(sizeof(float) * gSampleCount);
+    float*  pBatch = (float*)tf_malloc(sizeof(float) * gSampleCount);
+    getSampleCoords(pCoords, gSampleCount);
+
+    //	Heights are interpolated linearly inside a cell
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        const float col = (float)(i * 13);
+        const float row = (float)(i * 7);
+        const float mid = raw.getInterpolatedHeight(col + 0.5f, row);
+        CHECK_NEAR(mid, 0.5f * (raw.getInterpolatedHeight(col, row) + raw.getInterpolatedHeight(col + 1.0f, row)), 1e-5f);
+    }
+
+    for (uint32_t tileSize : gTileSizes)
+    {
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "height_%u.hdt", tileSize);
+        CHECK(HeightData::convertToTiled("height.r32", RD_TEXTURES, fileName, tileSize));
+
+        HeightData tiled(fileName, HEIGHT_DATA_TILED);
+        CHECK(tiled.isLoaded());
+        CHECK(tiled.colCount == raw.colCount && tiled.rowCount == raw.rowCount);
+
+        for (int step : gSteps)
+        {
+            for (uint32_t i = 0; i < gSampleCount; ++i)
+            {
+                pExpected[i] = raw.getInterpolatedHeight(pCoords[i].x, pCoords[i].y, step);
+                CHECK(tiled.getInterpolatedHeight(pCoords[i].x, pCoords[i].y, step) == pExpected[i]);
+            }
+
+            //	Batches that don't fill the last prefetch group
+            for (uint32_t count : { 1u, 7u, 64u, gSampleCount })
+            {
+                raw.getInterpolatedHeights(pCoords, pBatch, count, step);
+                CHECK(!memcmp(pBatch, pExpected, sizeof(float) * count));
+                tiled.getInterpolatedHeights(pCoords, pBatch, count, step);
+                CHECK(!memcmp(pBatch, pExpected, sizeof(float) * count));
+            }
+        }
+    }
+
+    CHECK(!raw.saveTiled(RD_TEXTURES, "invalid.hdt", 48));
+
+    //	A truncated file and a file with a wrong magic are rejected, so callers can fall back to the raw map
+    TiledHeightDataHeader header = {};
+    header.magic = TILED_HEIGHT_DATA_MAGIC;
+    header.version = TILED_HEIGHT_DATA_VERSION;
+    header.colCount = header.rowCount = 513;
+    header.tileSize = 64;
+    header.tileColCount = header.tileRowCount = 9;
+    CHECK(writeFile("truncated.hdt", &header, sizeof(header)));
+    header.magic = 0;
+    CHECK(writeFile("magic.hdt", &header, sizeof(header)));
+    {
+        HeightData truncated("truncated.hdt", HEIGHT_DATA_TILED);
+        HeightData badMagic("magic.hdt", HEIGHT_DATA_TILED);
+        HeightData missing("missing.hdt", HEIGHT_DATA_TILED);
+        CHECK(!truncated.isLoaded());
+        CHECK(!badMagic.isLoaded());
+        CHECK(!missing.isLoaded());
+    }
+
+    tf_free(pCoords);
+    tf_free(pExpected);
+    tf_free(pBatch);
+    removeTestResourceDirectory();
+    return TEST_RESULT();
+}
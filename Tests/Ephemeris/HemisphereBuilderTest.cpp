@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	HemisphereBuilder on a synthetic height map: one index buffer upload, well formed and joined strips, boxes around the vertices
+//	of their segments and a hierarchy around its children. Vertices, strips without their joins and boxes are the ones the
+//	single-threaded builder with one index buffer per segment made, and building twice on worker threads gives the same bytes.
+
+#include "../../Ephemeris/Terrain/src/Hemisphere.h"
+
+#include <vector>
+
+#include "TestCommon.h"
+
+static const uint32_t gHeightMapSize = 200;
+static const float    gPlanetRadius = 6000.0f;
+static const float    gSamplingStep = 64.0f;
+static const uint32_t gRingCount = 5;
+static const uint32_t gGridDimensions[] = { 33, 129 };
+
+//	The builder before it went parallel, without the index buffer uploads
+struct LegacyMeshSegment
+{
+    std::vector<uint32_t> indices;
+    TerrainBoundingBox    boundingBox;
+};
+
+static void buildLegacyTriangleStrip(uint32_t startIndex, uint32_t colStart, uint32_t rowStart, uint32_t colCount, uint32_t rowCount,
+                                     TriangulationOrder triangleType, uint32_t pitch, std::vector<uint32_t>& indices)
+{
+    uint32_t iFirstTerrainVertex = startIndex + colStart + (rowStart + (triangleType == ORDER_00_TO_11 ? 1 : 0)) * pitch;
+    if (triangleType == ORDER_01_TO_10)
+        indices.push_back(iFirstTerrainVertex);
+
+    for (uint32_t iRow = 0; iRow < rowCount - 1; ++iRow)
+    {
+        for (uint32_t iCol = 0; iCol < colCount; ++iCol)
+        {
+            uint32_t iV00 = startIndex + (colStart + iCol) + (rowStart + iRow) * pitch;
+            uint32_t iV01 = startIndex + (colStart + iCol) + (rowStart + iRow + 1) * pitch;
+            if (triangleType == ORDER_01_TO_10)
+            {
+                indices.push_back(iV00);
+                indices.push_back(iV01);
+            }
+            else
+            {
+                indices.push_back(iV01);
+                indices.push_back(iV00);
+            }
+        }
+
+        if (iRow < rowCount - 2)
+        {
+            uint32_t lastIndex = indices.back();
+            indices.push_back(lastIndex);
+            indices.push_back(startIndex + colStart + (rowStart + iRow + 1 + (triangleType == ORDER_00_TO_11 ? 1 : 0)) * pitch);
+        }
+    }
+}
+
+struct LegacyHemisphereBuilder
+{
+    HeightData* heightmap;
+    float       sampleScale, samplingStep, planetRadius;
+    uint32_t    gridDimension;
+    uint32_t    gridPitch;
+    uint32_t    gridStart;
+
+    void build(HeightData* a_heightMap, const float a_planetRadius, float a_sampleScale, float a_samplingStep, uint32_t a_ringCount,
+               uint32_t a_gridDimension, std::vector<TerrainVertex>& vertices, std::vector<LegacyMeshSegment>& meshSegments)
+    {
+        heightmap = a_heightMap;
+        samplingStep = a_samplingStep;
+        sampleScale = a_sampleScale;
+        planetRadius = a_planetRadius;
+        gridDimension = a_gridDimension;
+
+        vertices.resize(2 * a_ringCount * gridDimension * gridDimension);
+        meshSegments.clear();
+
+        uint32_t currGridStart = a_ringCount * gridDimension * gridDimension;
+        for (uint32_t currRing = 0; currRing < a_ringCount; ++currRing)
+        {
+            float gridScale = 1.f / (float)(1 << (a_ringCount - 1 - currRing));
+
+            for (uint32_t row = 0; row < gridDimension; ++row)
+                for (uint32_t col = 0; col < gridDimension; ++col)
+                    vertices[currGridStart + col + row * gridDimension] = createTerrainVertex(col, row, gridScale);
+
+            // Aligns vertices on the outer boundary
+            if (currRing < a_ringCount - 1)
+            {
+                for (uint32_t i = 1; i < gridDimension - 1; i += 2)
+                {
+                    for (uint32_t row = 0; row < gridDimension; row += gridDimension - 1)
+                    {
+                        float3& v0 = vertices[currGridStart + i - 1 + row * gridDimension].wsPos;
+                        float3& v1 = vertices[currGridStart + i + row * gridDimension].wsPos;
+                        float3& v2 = vertices[currGridStart + i + 1 + row * gridDimension].wsPos;
+                        v1 = v3ToF3((f3Tov3(v0) + f3Tov3(v2)) * 0.5f);
+                    }
+
+                    for (uint32_t col = 0; col < gridDimension; col += gridDimension - 1)
+                    {
+                        float3& v0 = vertices[currGridStart + col + (i - 1) * gridDimension].wsPos;
+                        float3& v1 = vertices[currGridStart + col + i * gridDimension].wsPos;
+                        float3& v2 = vertices[currGridStart + col + (i + 1) * gridDimension].wsPos;
+                        v1 = v3ToF3((f3Tov3(v0) + f3Tov3(v2)) * 0.5f);
+                    }
+                }
+            }
+
+            uint32_t gridMiddle = (gridDimension - 1) / 2;
+            uint32_t gridQuarter = (gridDimension - 1) / 4;
+
+            gridPitch = gridDimension;
+            gridStart = currGridStart;
+            if (currRing == 0)
+            {
+                buildMeshSegment(0, 0, gridMiddle + 1, gridMiddle + 1, ORDER_00_TO_11, vertices, meshSegments);
+                buildMeshSegment(gridMiddle, 0, gridMiddle + 1, gridMiddle + 1, ORDER_01_TO_10, vertices, meshSegments);
+                buildMeshSegment(0, gridMiddle, gridMiddle + 1, gridMiddle + 1, ORDER_01_TO_10, vertices, meshSegments);
+                buildMeshSegment(gridMiddle, gridMiddle, gridMiddle + 1, gridMiddle + 1, ORDER_00_TO_11, vertices, meshSegments);
+            }
+            else
+            {
+                const uint32_t n = gridQuarter + 1;
+                buildMeshSegment(0, 0, n, n, ORDER_00_TO_11, vertices, meshSegments);
+                buildMeshSegment(gridQuarter, 0, n, n, ORDER_00_TO_11, vertices, meshSegments);
+                buildMeshSegment(gridMiddle, 0, n, n, ORDER_01_TO_10, vertices, meshSegments);
+                buildMeshSegment(gridQuarter * 3, 0, n, n, ORDER_01_TO_10, vertices, meshSegments);
+                buildMeshSegment(0, gridQuarter, n, n, ORDER_00_TO_11, vertices, meshSegments);
+                buildMeshSegment(0, gridMiddle, n, n, ORDER_01_TO_10, vertices, meshSegments);
+                buildMeshSegment(gridQuarter * 3, gridQuarter, n, n, ORDER_01_TO_10, vertices, meshSegments);
+                buildMeshSegment(gridQuarter * 3, gridMiddle, n, n, ORDER_00_TO_11, vertices, meshSegments);
+                buildMeshSegment(0, gridQuarter * 3, n, n, ORDER_01_TO_10, vertices, meshSegments);
+                buildMeshSegment(gridQuarter, gridQuarter * 3, n, n, ORDER_01_TO_10, vertices, meshSegments);
+                buildMeshSegment(gridMiddle, gridQuarter * 3, n, n, ORDER_00_TO_11, vertices, meshSegments);
+                buildMeshSegment(gridQuarter * 3, gridQuarter * 3, n, n, ORDER_00_TO_11, vertices, meshSegments);
+            }
+
+            currGridStart += gridDimension * gridDimension;
+        }
+    }
+
+    void buildMeshSegment(uint32_t colStart, uint32_t rowStart, uint32_t colCount, uint32_t rowCount, TriangulationOrder quadTriangType,
+                          const std::vector<TerrainVertex>& vertices, std::vector<LegacyMeshSegment>& meshSegments)
+    {
+        LegacyMeshSegment mesh;
+        buildLegacyTriangleStrip(gridStart, colStart, rowStart, colCount, rowCount, quadTriangType, gridPitch, mesh.indices);
+
+        auto& bounds = mesh.boundingBox;
+        bounds.max = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        bounds.min = float3(FLT_MAX, FLT_MAX, FLT_MAX);
+        for (uint32_t index : mesh.indices)
+        {
+            const auto& vert = vertices[index].wsPos;
+            bounds.min.x = min(bounds.min.x, vert.x);
+            bounds.min.y = min(bounds.min.y, vert.y);
+            bounds.min.z = min(bounds.min.z, vert.z);
+
+            bounds.max.x = max(bounds.max.x, vert.x);
+            bounds.max.y = max(bounds.max.y, vert.y);
+            bounds.max.z = max(bounds.max.z, vert.z);
+        }
+        meshSegments.push_back(mesh);
+    }
+
+    void computeTerrainVertexHeight(TerrainVertex& TerrainVertex)
+    {
+        float3& posWs = TerrainVertex.wsPos;
+
+        float col = posWs.x / samplingStep;
+        float row = posWs.z / samplingStep;
+        float displacement = heightmap->getInterpolatedHeight(col, row);
+        TerrainVertex.maskUV.x = (col + (float)heightmap->colOffset + 0.5f) / (float)heightmap->colCount;
+        TerrainVertex.maskUV.y = (row + (float)heightmap->rowOffset + 0.5f) / (float)heightmap->rowCount;
+
+        float3 sphereNormal;
+        sphereNormal = v3ToF3(normalize(f3Tov3(posWs)));
+        displacement = displacement * displacement * displacement;
+        displacement *= 1.5f;
+        posWs = v3ToF3(f3Tov3(posWs) + f3Tov3(sphereNormal) * displacement * sampleScale * MaxMountainHeight);
+    }
+
+    TerrainVertex createTerrainVertex(uint32_t col, uint32_t row, float gridScale)
+    {
+        TerrainVertex currVert;
+        auto&         pos = currVert.wsPos;
+        pos.x = static_cast<float>(col) / static_cast<float>(gridDimension - 1);
+        pos.z = static_cast<float>(row) / static_cast<float>(gridDimension - 1);
+        pos.x = pos.x * 2 - 1;
+        pos.z = pos.z * 2 - 1;
+        pos.y = 0;
+        float fDirectionScale = 1;
+        if (pos.x != 0 || pos.z != 0)
+        {
+            float fDX = fabsf(pos.x);
+            float fDZ = fabsf(pos.z);
+            float fMaxD = max(fDX, fDZ);
+            float fMinD = min(fDX, fDZ);
+            float fTan = fMinD / fMaxD;
+            fDirectionScale = 1 / sqrtf(1 + fTan * fTan);
+        }
+
+        pos.x *= fDirectionScale * gridScale;
+        pos.z *= fDirectionScale * gridScale;
+        pos.y = sqrtf(max(0.0f, 1 - (pos.x * pos.x + pos.z * pos.z)));
+
+        pos = v3ToF3(f3Tov3(pos) * planetRadius);
+
+        computeTerrainVertexHeight(currVert);
+
+        pos.y -= planetRadius;
+
+        return currVert;
+    }
+};
+
+struct Hemisphere
+{
+    uint32_t            vertexCount;
+    TerrainVertex*      pVertices;
+    uint32_t            segmentCount;
+    MeshSegment*        pSegments;
+    Buffer*             pIndexBuffer;
+    uint32_t            nodeCount;
+    TerrainSegmentNode* pNodes;
+};
+
+static bool writeHeightMap(const char* fileName)
+{
+    float* pHeights = (float*)tf_malloc(sizeof(float) * gHeightMapSize * gHeightMapSize);
+    for (uint32_t row = 0; row < gHeightMapSize; ++row)
+        for (uint32_t col = 0; col < gHeightMapSize; ++col)
+            pHeights[row * gHeightMapSize + col] = 0.5f + 0.25f * sinf(col * 0.11f) * cosf(row * 0.07f);
+
+    FileStream stream = {};
+    bool       bResult = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_WRITE, &stream);
+    if (bResult)
+    {
+        bResult = fsWriteToStream(&stream, pHeights, sizeof(float) * gHeightMapSize * gHeightMapSize) ==
+                  sizeof(float) * gHeightMapSize * gHeightMapSize;
+        fsCloseStream(&stream);
+    }
+    tf_free(pHeights);
+    return bResult;
+}
+
+static void buildHemisphere(HeightData* pHeightData, uint32_t gridDimension, Hemisphere* pOut)
+{
+    HemisphereBuilder builder;
+    builder.build(NULL, pHeightData, gPlanetRadius, 1.0f, gSamplingStep, gRingCount, gridDimension, &pOut->vertexCount, &pOut->pVertices,
+                  &pOut->segmentCount, &pOut->pSegments, &pOut->pIndexBuffer, &pOut->nodeCount, &pOut->pNodes);
+}
+
+static void removeHemisphere(Hemisphere* pHemisphere)
+{
+    removeResource(pHemisphere->pIndexBuffer);
+    tf_free(pHemisphere->pVertices);
+    tf_free(pHemisphere->pSegments);
+    tf_free(pHemisphere->pNodes);
+}
+
+static bool containsPoint(const TerrainBoundingBox& box, const float3& p)
+{
+    return p.x >= box.min.x && p.y >= box.min.y && p.z >= box.min.z && p.x <= box.max.x && p.y <= box.max.y && p.z <= box.max.z;
+}
+
+static bool containsBox(const TerrainBoundingBox& outer, const TerrainBoundingBox& inner)
+{
+    return containsPoint(outer, inner.min) && containsPoint(outer, inner.max);
+}
+
+int main()
+{
+    CHECK(createTestResourceDirectory() != NULL);
+    CHECK(writeHeightMap("height.r32"));
+    HeightData heightData("height.r32", HEIGHT_DATA_RAW);
+    CHECK(heightData.isLoaded());
+
+    for (uint32_t gridDimension : gGridDimensions)
+    {
+        const uint32_t loadsBefore = getHeadlessBufferLoadCount();
+        const uint32_t waitsBefore = getHeadlessTokenWaitCount();
+        Hemisphere     hemisphere = {};
+        buildHemisphere(&heightData, gridDimension, &hemisphere);
+
+        //	All segments share a single index buffer that is uploaded with one wait
+        CHECK(getHeadlessBufferLoadCount() - loadsBefore == 1);
+        CHECK(getHeadlessTokenWaitCount() - waitsBefore == 1);
+
+        CHECK(hemisphere.vertexCount == 2 * gRingCount * gridDimension * gridDimension);
+        CHECK(hemisphere.segmentCount == 4 + (gRingCount - 1) * 12);
+
+        const uint32_t* pIndices = (const uint32_t*)hemisphere.pIndexBuffer->pCpuMappedAddress;
+        const uint32_t  indexCount = (uint32_t)(hemisphere.pIndexBuffer->mSize / sizeof(uint32_t));
+        const uint32_t  firstGridVertex = gRingCount * gridDimension * gridDimension;
+
+        for (uint32_t i = firstGridVertex; i < hemisphere.vertexCount; ++i)
+        {
+            //	Heights only push vertices out of the sphere around the planet center
+            const float3& pos = hemisphere.pVertices[i].wsPos;
+            const float   radius = sqrtf(pos.x * pos.x + (pos.y + gPlanetRadius) * (pos.y + gPlanetRadius) + pos.z * pos.z);
+            CHECK(radius >= gPlanetRadius * (1.0f - 1e-5f));
+        }
+
+        uint32_t nextFreeIndex = 0;
+        for (uint32_t s = 0; s < hemisphere.segmentCount; ++s)
+        {
+            const MeshSegment& segment = hemisphere.pSegments[s];
+            CHECK(segment.indexBuffer == hemisphere.pIndexBuffer);
+            CHECK(segment.firstIndex % 2 == 0);
+            CHECK(segment.firstIndex >= nextFreeIndex);
+            CHECK(segment.indexCount > 0 && segment.firstIndex + segment.indexCount <= indexCount);
+
+            for (uint32_t i = segment.firstIndex; i < segment.firstIndex + segment.indexCount; ++i)
+            {
+                CHECK(pIndices[i] >= firstGridVertex && pIndices[i] < hemisphere.vertexCount);
+                CHECK(containsPoint(segment.boundingBox, hemisphere.pVertices[pIndices[i]].wsPos));
+            }
+
+            //	Degenerate join: last index of the previous segment, then the first index of this one
+            if (s)
+            {
+                CHECK(pIndices[nextFreeIndex] == pIndices[nextFreeIndex - 1]);
+                for (uint32_t i = nextFreeIndex + 1; i < segment.firstIndex; ++i)
+                    CHECK(pIndices[i] == pIndices[segment.firstIndex]);
+            }
+            nextFreeIndex = segment.firstIndex + segment.indexCount;
+        }
+        CHECK(nextFreeIndex == indexCount);
+
+        //	Hierarchy: the root covers every segment, children split the range of their parent and sit in its box
+        CHECK(hemisphere.nodeCount > 0);
+        CHECK(hemisphere.pNodes[0].firstSegment == 0 && hemisphere.pNodes[0].segmentCount == hemisphere.segmentCount);
+        uint32_t leafCount = 0;
+        for (uint32_t n = 0; n < hemisphere.nodeCount; ++n)
+        {
+            const TerrainSegmentNode& node = hemisphere.pNodes[n];
+            if (!node.childCount)
+            {
+                CHECK(node.segmentCount == 1);
+                CHECK(containsBox(node.boundingBox, hemisphere.pSegments[node.firstSegment].boundingBox));
+                ++leafCount;
+                continue;
+            }
+
+            CHECK(node.firstChild > n && node.firstChild + node.childCount <= hemisphere.nodeCount);
+            uint32_t nextSegment = node.firstSegment;
+            for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c)
+            {
+                CHECK(hemisphere.pNodes[c].firstSegment == nextSegment);
+                CHECK(containsBox(node.boundingBox, hemisphere.pNodes[c].boundingBox));
+                nextSegment += hemisphere.pNodes[c].segmentCount;
+            }
+            CHECK(nextSegment == node.firstSegment + node.segmentCount);
+        }
+        CHECK(leafCount == hemisphere.segmentCount);
+
+        //	The single-threaded builder made the same vertices, the same strips between the joins and the same boxes. Segments are
+        //	grouped by ray now, so each one is matched to the old segment with its strip.
+        std::vector<TerrainVertex>     legacyVertices;
+        std::vector<LegacyMeshSegment> legacySegments;
+        LegacyHemisphereBuilder        legacyBuilder = {};
+        legacyBuilder.build(&heightData, gPlanetRadius, 1.0f, gSamplingStep, gRingCount, gridDimension, legacyVertices, legacySegments);
+        CHECK(legacyVertices.size() == hemisphere.vertexCount && legacySegments.size() == hemisphere.segmentCount);
+        CHECK(!memcmp(legacyVertices.data() + firstGridVertex, hemisphere.pVertices + firstGridVertex,
+                      sizeof(TerrainVertex) * (hemisphere.vertexCount - firstGridVertex)));
+        std::vector<char> matched(legacySegments.size());
+        for (uint32_t s = 0; s < hemisphere.segmentCount; ++s)
+        {
+            const MeshSegment& segment = hemisphere.pSegments[s];
+            uint32_t           match = 0;
+            while (match < legacySegments.size() &&
+                   (matched[match] || legacySegments[match].indices.size() != segment.indexCount ||
+                    memcmp(legacySegments[match].indices.data(), pIndices + segment.firstIndex, sizeof(uint32_t) * segment.indexCount)))
+                ++match;
+            CHECK(match < legacySegments.size());
+            if (match == legacySegments.size())
+                continue;
+            matched[match] = 1;
+            CHECK(!memcmp(&legacySegments[match].boundingBox, &segment.boundingBox, sizeof(TerrainBoundingBox)));
+        }
+
+        //	Vertices and strips are built on worker threads, the result must not depend on their timing
+        Hemisphere rebuilt = {};
+        buildHemisphere(&heightData, gridDimension, &rebuilt);
+        CHECK(rebuilt.vertexCount == hemisphere.vertexCount && rebuilt.segmentCount == hemisphere.segmentCount);
+        CHECK(!memcmp(rebuilt.pVertices + firstGridVertex, hemisphere.pVertices + firstGridVertex,
+                      sizeof(TerrainVertex) * (hemisphere.vertexCount - firstGridVertex)));
+        CHECK(rebuilt.pIndexBuffer->mSize == hemisphere.pIndexBuffer->mSize);
+        CHECK(!memcmp(rebuilt.pIndexBuffer->pCpuMappedAddress, pIndices, (size_t)hemisphere.pIndexBuffer->mSize));
+        for (uint32_t s = 0; s < hemisphere.segmentCount; ++s)
+        {
+            CHECK(rebuilt.pSegments[s].firstIndex == hemisphere.pSegments[s].firstIndex);
+            CHECK(rebuilt.pSegments[s].indexCount == hemisphere.pSegments[s].indexCount);
+            CHECK(!memcmp(&rebuilt.pSegments[s].boundingBox, &hemisphere.pSegments[s].boundingBox, sizeof(TerrainBoundingBox)));
+        }
+
+        removeHemisphere(&rebuilt);
+        removeHemisphere(&hemisphere);
+    }
+
+    removeTestResourceDirectory();
+    return TEST_RESULT();
+}
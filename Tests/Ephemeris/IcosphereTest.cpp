@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	The parallel icosphere has to give the same vertices and indices, in the same order, as the serial midpoint map
+//	subdivision it replaced, for every thread count. Every level is a closed mesh.
+
+#include "../../Ephemeris/Sky/src/Icosahedron.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include "TestCommon.h"
+
+static const uint32_t gMaxSubdivisions = 7;
+static const uint32_t gThreadCounts[] = { 1, 4, 0 };
+
+struct ReferenceIcosphere
+{
+    std::vector<VertexF3> vertices;
+    std::vector<uint32_t> indices;
+};
+
+static uint64_t getEdgeKey(uint32_t a, uint32_t b) { return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a; }
+
+//	One level of the old subdivision: faces in order, a midpoint is appended the first time its edge is seen
+static void subdivideReference(ReferenceIcosphere* pSphere)
+{
+    std::unordered_map<uint64_t, uint32_t> midpoints;
+    std::vector<uint32_t>                  indices;
+    indices.reserve(pSphere->indices.size() * 4);
+
+    auto getMidpoint = [&](uint32_t a, uint32_t b)
+    {
+        auto it = midpoints.find(getEdgeKey(a, b));
+        if (it != midpoints.end())
+            return it->second;
+        const VertexF3 va = pSphere->vertices[a];
+        const VertexF3 vb = pSphere->vertices[b];
+        const uint32_t index = (uint32_t)pSphere->vertices.size();
+        pSphere->vertices.push_back(
+            VertexF3{ { (va.pos[0] + vb.pos[0]) / 2, (va.pos[1] + vb.pos[1]) / 2, (va.pos[2] + vb.pos[2]) / 2 } });
+        midpoints[getEdgeKey(a, b)] = index;
+        return index;
+    };
+
+    for (size_t f = 0; f < pSphere->indices.size(); f += 3)
+    {
+        const uint32_t t0 = pSphere->indices[f + 0];
+        const uint32_t t1 = pSphere->indices[f + 1];
+        const uint32_t t2 = pSphere->indices[f + 2];
+        const uint32_t m0 = getMidpoint(t0, t1);
+        const uint32_t m1 = getMidpoint(t1, t2);
+        const uint32_t m2 = getMidpoint(t2, t0);
+        indices.insert(indices.end(), { t0, m0, m2, m0, t1, m1, m0, m1, m2, m2, m1, t2 });
+    }
+    pSphere->indices.swap(indices);
+}
+
+//	Every edge is shared by exactly two faces that walk it in opposite directions
+static bool isClosedMesh(const IndexStbDsArray indices, uint32_t indexCount)
+{
+    std::unordered_map<uint64_t, int> edges;
+    edges.reserve(indexCount);
+    for (uint32_t f = 0; f < indexCount; f += 3)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            const uint32_t a = indices[f + c];
+            const uint32_t b = indices[f + (c + 1) % 3];
+            edges[getEdgeKey(a, b)] += a < b ? 1 : 2;
+        }
+    }
+    for (const auto& edge : edges)
+        if (edge.second != 3)
+            return false;
+    return edges.size() == indexCount / 2;
+}
+
+int main()
+{
+    //	The base icosahedron seeds the reference
+    VertexStbDsArray baseVertices = NULL;
+    IndexStbDsArray  baseIndices = NULL;
+    CreateIcosphere(0, &baseVertices, &baseIndices);
+    CHECK(arrlenu(baseVertices) == 12 && arrlenu(baseIndices) == 60);
+
+    ReferenceIcosphere reference;
+    reference.vertices.assign(baseVertices, baseVertices + arrlenu(baseVertices));
+    reference.indices.assign(baseIndices, baseIndices + arrlenu(baseIndices));
+    for (uint32_t v = 0; v < 12; ++v)
+        CHECK_NEAR(sqrtf(baseVertices[v].pos[0] * baseVertices[v].pos[0] + baseVertices[v].pos[1] * baseVertices[v].pos[1] +
+                         baseVertices[v].pos[2] * baseVertices[v].pos[2]),
+                   1.0f, 1e-6f);
+    arrfree(baseVertices);
+    arrfree(baseIndices);
+
+    for (uint32_t level = 0; level <= gMaxSubdivisions; ++level)
+    {
+        if (level)
+            subdivideReference(&reference);
+        CHECK(reference.vertices.size() == getIcosphereVertexCount(level));
+        CHECK(reference.indices.size() == getIcosphereIndexCount(level));
+
+        for (uint32_t threadCount : gThreadCounts)
+        {
+            VertexStbDsArray vertices = NULL;
+            IndexStbDsArray  indices = NULL;
+            CreateIcosphere(level, &vertices, &indices, threadCount);
+
+            CHECK(arrlenu(vertices) == reference.vertices.size() && arrlenu(indices) == reference.indices.size());
+            if (arrlenu(vertices) == reference.vertices.size() && arrlenu(indices) == reference.indices.size())
+            {
+                CHECK(!memcmp(vertices, reference.vertices.data(), sizeof(VertexF3) * reference.vertices.size()));
+                CHECK(!memcmp(indices, reference.indices.data(), sizeof(uint32_t) * reference.indices.size()));
+                if (threadCount == 1)
+                    CHECK(isClosedMesh(indices, (uint32_t)arrlenu(indices)));
+            }
+
+            arrfree(vertices);
+            arrfree(indices);
+        }
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	The legacy noise type has to reproduce Perlin::perlinNoise2D/3D. Gradient noise has to stay in [-1, 1], be continuous,
+//	depend on the seed only and give the same values whatever the batch sizes are.
+
+#include "../../Ephemeris/src/Noise.h"
+#include "../../Ephemeris/src/Perlin.h"
+
+#include <random>
+
+#include "TestCommon.h"
+
+static const uint32_t gLegacySampleCount = 3001;
+static const uint32_t gSampleCount = 200003;
+//	Odd, so every batch ends with a partial SIMD group
+static const uint32_t gChunkSize = 997;
+
+static void evaluate(const NoiseFBM* pFBM, uint32_t dim, const float* const* ppCoords, float* pOut, uint32_t count)
+{
+    if (dim == 2)
+        evaluateNoiseFBM2D(pFBM, ppCoords[0], ppCoords[1], pOut, count);
+    else if (dim == 3)
+        evaluateNoiseFBM3D(pFBM, ppCoords[0], ppCoords[1], ppCoords[2], pOut, count);
+    else
+        evaluateNoiseFBM4D(pFBM, ppCoords[0], ppCoords[1], ppCoords[2], ppCoords[3], pOut, count);
+}
+
+int main()
+{
+    printf("%s, %u points per batch\n", getNoiseSIMDName(), getNoiseSIMDWidth());
+
+    std::mt19937 rng(7);
+    float*       pCoords[4];
+    for (uint32_t c = 0; c < 4; ++c)
+        pCoords[c] = (float*)tf_malloc(sizeof(float) * gSampleCount);
+    float* pOut = (float*)tf_malloc(sizeof(float) * gSampleCount);
+    float* pChunked = (float*)tf_malloc(sizeof(float) * gSampleCount);
+
+    //	Legacy value noise, in the coordinate range the sky uses it with
+    {
+        std::uniform_real_distribution<float> dist(0.0f, 1.453f);
+        for (uint32_t c = 0; c < 3; ++c)
+            for (uint32_t i = 0; i < gLegacySampleCount; ++i)
+                pCoords[c][i] = dist(rng);
+
+        NoiseFBMDesc desc = {};
+        NoiseFBM     fbm = {};
+        getLegacyPerlinNoiseFBMDesc2D(&desc);
+        initNoiseFBM(&desc, &fbm);
+        evaluateNoiseFBM2D(&fbm, pCoords[0], pCoords[1], pOut, gLegacySampleCount);
+        float maxError = 0.0f;
+        for (uint32_t i = 0; i < gLegacySampleCount; ++i)
+            maxError = fmaxf(maxError, fabsf(pOut[i] - Perlin::perlinNoise2D(pCoords[0][i], pCoords[1][i])));
+        CHECK(maxError <= 1e-5f);
+
+        getLegacyPerlinNoiseFBMDesc3D(&desc);
+        initNoiseFBM(&desc, &fbm);
+        evaluateNoiseFBM3D(&fbm, pCoords[0], pCoords[1], pCoords[2], pOut, gLegacySampleCount);
+        maxError = 0.0f;
+        for (uint32_t i = 0; i < gLegacySampleCount; ++i)
+            maxError = fmaxf(maxError, fabsf(pOut[i] - Perlin::perlinNoise3D(pCoords[0][i], pCoords[1][i], pCoords[2][i])));
+        CHECK(maxError <= 1e-5f);
+    }
+
+    std::uniform_real_distribution<float> dist(-300.0f, 300.0f);
+    for (uint32_t c = 0; c < 4; ++c)
+        for (uint32_t i = 0; i < gSampleCount; ++i)
+            pCoords[c][i] = dist(rng);
+
+    NoiseFBMDesc desc = {};
+    getDefaultNoiseFBMDesc(&desc);
+    desc.mOctaveCount = 1;
+    desc.bClamp = false;
+    desc.mSeed = 42;
+    NoiseFBM fbm = {};
+    initNoiseFBM(&desc, &fbm);
+
+    for (uint32_t dim = 2; dim <= 4; ++dim)
+    {
+        evaluate(&fbm, dim, pCoords, pOut, gSampleCount);
+
+        //	A single unclamped octave is in [-1, 1] and centered on 0
+        float  minValue = 1.0f;
+        float  maxValue = -1.0f;
+        double sum = 0.0;
+        for (uint32_t i = 0; i < gSampleCount; ++i)
+        {
+            minValue = fminf(minValue, pOut[i]);
+            maxValue = fmaxf(maxValue, pOut[i]);
+            sum += pOut[i];
+        }
+        CHECK(minValue >= -1.0f && maxValue <= 1.0f);
+        CHECK(maxValue - minValue > 1.0f);
+        CHECK(fabs(sum / gSampleCount) < 0.02);
+
+        for (uint32_t i = 0; i < gSampleCount; i += gChunkSize)
+        {
+            const float* pChunkCoords[4] = { pCoords[0] + i, pCoords[1] + i, pCoords[2] + i, pCoords[3] + i };
+            evaluate(&fbm, dim, pChunkCoords, pChunked + i, min(gChunkSize, gSampleCount - i));
+        }
+        CHECK(!memcmp(pOut, pChunked, sizeof(float) * gSampleCount));
+
+        //	Another seed gives other noise
+        NoiseFBMDesc otherDesc = desc;
+        otherDesc.mSeed = 43;
+        NoiseFBM otherFBM = {};
+        initNoiseFBM(&otherDesc, &otherFBM);
+        evaluate(&otherFBM, dim, pCoords, pChunked, gSampleCount);
+        uint32_t differentCount = 0;
+        for (uint32_t i = 0; i < gSampleCount; ++i)
+            differentCount += pOut[i] != pChunked[i];
+        CHECK(differentCount > gSampleCount / 2);
+    }
+
+    //	Continuity: points 1e-4 apart along a line never jump
+    float maxStep = 0.0f;
+    for (uint32_t i = 0; i < 100000; ++i)
+    {
+        const float x[2] = { i * 0.001f - 50.0f, i * 0.001f - 50.0f + 0.0001f };
+        const float y[2] = { 3.3f, 3.3f };
+        const float z[2] = { 1.7f, 1.7f };
+        float       values[2];
+        evaluateNoiseFBM3D(&fbm, x, y, z, values, 2);
+        maxStep = fmaxf(maxStep, fabsf(values[1] - values[0]));
+    }
+    CHECK(maxStep < 0.01f);
+
+    //	The default FBM is normalized and clamped
+    getDefaultNoiseFBMDesc(&desc);
+    initNoiseFBM(&desc, &fbm);
+    evaluateNoiseFBM3D(&fbm, pCoords[0], pCoords[1], pCoords[2], pOut, gSampleCount);
+    for (uint32_t i = 0; i < gSampleCount; ++i)
+        CHECK(pOut[i] >= -1.0f && pOut[i] <= 1.0f);
+
+    for (uint32_t c = 0; c < 4; ++c)
+        tf_free(pCoords[c]);
+    tf_free(pOut);
+    tf_free(pChunked);
+    return TEST_RESULT();
+}
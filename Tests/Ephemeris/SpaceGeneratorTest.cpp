@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Serial, parallel and cached space generation give the same nebula and star set. The nebula is the per vertex Perlin
+//	lookup the sky used to do, the star count follows from it, and a cache written for another desc is not loaded.
+
+#include "../../Ephemeris/Sky/src/SpaceGenerator.h"
+#include "../../Ephemeris/src/Perlin.h"
+
+#include "TestCommon.h"
+
+static const uint32_t gSubdivisions = 5;
+static const float    gPlanetRadius = 6360000.0f;
+
+struct Space
+{
+    float3*            pPoints;
+    ParticleStbDsArray pStars;
+};
+
+static void generate(const SpaceGeneratorDesc* pDesc, const VertexStbDsArray vertices, Space* pOut)
+{
+    const uint32_t vertexCount = (uint32_t)arrlenu(vertices);
+    pOut->pPoints = (float3*)tf_malloc(sizeof(float3) * 3 * vertexCount);
+    pOut->pStars = NULL;
+    generateSpace(pDesc, vertices, vertexCount, pOut->pPoints, &pOut->pStars);
+}
+
+static void removeSpace(Space* pSpace)
+{
+    tf_free(pSpace->pPoints);
+    arrfree(pSpace->pStars);
+}
+
+static bool isSameSpace(const Space& a, const Space& b, uint32_t vertexCount)
+{
+    return !memcmp(a.pPoints, b.pPoints, sizeof(float3) * 3 * vertexCount) && arrlenu(a.pStars) == arrlenu(b.pStars) &&
+           !memcmp(a.pStars, b.pStars, sizeof(ParticleData) * arrlenu(a.pStars));
+}
+
+int main()
+{
+    CHECK(createTestResourceDirectory() != NULL);
+
+    VertexStbDsArray vertices = NULL;
+    IndexStbDsArray  indices = NULL;
+    CreateIcosphere(gSubdivisions, &vertices, &indices);
+    const uint32_t vertexCount = (uint32_t)arrlenu(vertices);
+
+    SpaceGeneratorDesc desc = {};
+    desc.mSeed = 1;
+    desc.mSpaceScale = gPlanetRadius * 10.0f;
+    desc.mPlanetRadius = gPlanetRadius;
+    desc.mNebulaScale = 1.453f;
+    desc.mStarDensity = 10.0f;
+    desc.mStarDistribution = 20000000.0f;
+    desc.mStarIntensity = 1.5f;
+    desc.mParticleSize = 100000.0f;
+    desc.mThreadCount = 1;
+
+    Space serial = {};
+    generate(&desc, vertices, &serial);
+    CHECK(arrlenu(serial.pStars) > 0);
+
+    //	Nebula: three mirrored Perlin lookups per vertex, normalized over all of them
+    float* pReference = (float*)tf_malloc(sizeof(float) * 3 * vertexCount);
+    float  minValue = FLT_MAX;
+    float  maxValue = -FLT_MAX;
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        const vec3 normal = normalize(vec3(vertices[i].pos[0], vertices[i].pos[1], vertices[i].pos[2]));
+        const vec3 mirrored[3] = { normal, vec3(normal.getX(), -normal.getY(), normal.getZ()),
+                                   vec3(-normal.getX(), normal.getY(), -normal.getZ()) };
+        for (uint32_t n = 0; n < 3; ++n)
+        {
+            const vec3 noisePosition = (mirrored[n] + vec3(1.0f, 1.0f, 1.0f)) * 0.5f * desc.mNebulaScale;
+            pReference[i * 3 + n] = Perlin::perlinNoise3D(noisePosition.getX(), noisePosition.getY(), noisePosition.getZ());
+            minValue = min(minValue, pReference[i * 3 + n]);
+            maxValue = max(maxValue, pReference[i * 3 + n]);
+        }
+    }
+
+    uint32_t expectedStarCount = 0;
+    for (uint32_t i = 0; i < vertexCount; ++i)
+    {
+        const float3& nebula = serial.pPoints[i * 3 + 2];
+        for (uint32_t n = 0; n < 3; ++n)
+            CHECK_NEAR(nebula[n], (pReference[i * 3 + n] - minValue) / (maxValue - minValue), 1e-4f);
+
+        const float3& normal = serial.pPoints[i * 3 + 1];
+        CHECK_NEAR(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z, 1.0f, 1e-5f);
+
+        const float density = powf((nebula.x + nebula.y + nebula.z) / 3.0f, 1.5f);
+        expectedStarCount += (uint32_t)(int)(desc.mStarDensity * density);
+    }
+    CHECK(arrlenu(serial.pStars) == expectedStarCount);
+
+    //	Stars sit on the sky sphere around the planet center
+    for (uint32_t s = 0; s < (uint32_t)arrlenu(serial.pStars); ++s)
+    {
+        const vec4& position = serial.pStars[s].ParticlePositions;
+        const float radius = length(vec3(position.getX(), position.getY() + gPlanetRadius, position.getZ()));
+        CHECK_NEAR(radius / desc.mSpaceScale, 1.0f, 1e-4f);
+    }
+
+    //	Worker threads only change the timing
+    for (uint32_t threadCount : { 4u, 0u })
+    {
+        desc.mThreadCount = threadCount;
+        Space parallel = {};
+        generate(&desc, vertices, &parallel);
+        CHECK(isSameSpace(serial, parallel, vertexCount));
+        removeSpace(&parallel);
+    }
+
+    CHECK(saveSpaceCache(RD_PIPELINE_CACHE, "space.cache", &desc, vertexCount, serial.pPoints, serial.pStars,
+                         (uint32_t)arrlenu(serial.pStars)));
+    Space cached = {};
+    cached.pPoints = (float3*)tf_malloc(sizeof(float3) * 3 * vertexCount);
+    CHECK(loadSpaceCache(RD_PIPELINE_CACHE, "space.cache", &desc, vertexCount, cached.pPoints, &cached.pStars));
+    CHECK(isSameSpace(serial, cached, vertexCount));
+    removeSpace(&cached);
+
+    //	The thread count isn't part of the output, the seed and the sphere are
+    SpaceGeneratorDesc otherDesc = desc;
+    otherDesc.mThreadCount = 1;
+    cached.pPoints = (float3*)tf_malloc(sizeof(float3) * 3 * vertexCount);
+    CHECK(loadSpaceCache(RD_PIPELINE_CACHE, "space.cache", &otherDesc, vertexCount, cached.pPoints, &cached.pStars));
+    removeSpace(&cached);
+
+    otherDesc.mSeed = 2;
+    cached.pPoints = (float3*)tf_malloc(sizeof(float3) * 3 * vertexCount);
+    CHECK(!loadSpaceCache(RD_PIPELINE_CACHE, "space.cache", &otherDesc, vertexCount, cached.pPoints, &cached.pStars));
+    CHECK(!loadSpaceCache(RD_PIPELINE_CACHE, "space.cache", &desc, vertexCount - 1, cached.pPoints, &cached.pStars));
+    CHECK(!loadSpaceCache(RD_PIPELINE_CACHE, "missing.cache", &desc, vertexCount, cached.pPoints, &cached.pStars));
+    removeSpace(&cached);
+
+    Space otherSeed = {};
+    generate(&otherDesc, vertices, &otherSeed);
+    CHECK(!isSameSpace(serial, otherSeed, vertexCount));
+    removeSpace(&otherSeed);
+
+    tf_free(pReference);
+    removeSpace(&serial);
+    arrfree(vertices);
+    arrfree(indices);
+    removeTestResourceDirectory();
+    return TEST_RESULT();
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	The binned starfield keeps exactly the stars a brute-force test of every star keeps, for random cameras, sky rotations and
+//	brightness cutoffs. Bins are sorted brightest first and bounded by their spheres, the build doesn't depend on the thread count.
+
+#include "../../Ephemeris/SpaceObjects/src/StarField.h"
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "TestCommon.h"
+
+static const uint32_t gStarCount = 200000;
+static const uint32_t gFrameCount = 40;
+static const float    gPlanetRadius = 6360000.0f;
+static const float    gSpaceScale = gPlanetRadius * 10.0f;
+
+typedef std::tuple<float, float, float, float, float> StarKey;
+
+static StarKey getStarKey(const ParticleData& star)
+{
+    return StarKey(star.ParticlePositions.getX(), star.ParticlePositions.getY(), star.ParticlePositions.getZ(), star.ParticleInfo.getZ(),
+                   star.ParticleInfo.getW());
+}
+
+//	Same rotation around the planet center as the sky
+static mat4 getRotMat(float azimuth, float elevation)
+{
+    return mat4::translation(vec3(0.0f, -gPlanetRadius, 0.0f)) * (mat4::rotationY(-azimuth) * mat4::rotationZ(elevation)) *
+           mat4::translation(vec3(0.0f, gPlanetRadius, 0.0f));
+}
+
+static mat4 getViewProjMat(float yaw, float pitch, const vec3& eye)
+{
+    const vec3 forward(cosf(pitch) * sinf(yaw), sinf(pitch), cosf(pitch) * cosf(yaw));
+    const vec3 right = normalize(cross(vec3(0.0f, 1.0f, 0.0f), forward));
+    const vec3 up = cross(forward, right);
+    const mat4 view(vec4(right.getX(), up.getX(), forward.getX(), 0.0f), vec4(right.getY(), up.getY(), forward.getY(), 0.0f),
+                    vec4(right.getZ(), up.getZ(), forward.getZ(), 0.0f), vec4(-dot(right, eye), -dot(up, eye), -dot(forward, eye), 1.0f));
+    return mat4::perspectiveLH_ReverseZ(PI / 3.0f, 9.0f / 16.0f, 100000.0f, 2000000000.0f) * view;
+}
+
+int main()
+{
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> signedDist(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unitDist(0.0f, 1.0f);
+
+    //	Stars on the sky sphere like generateSpace places them
+    std::vector<ParticleData> stars(gStarCount);
+    for (ParticleData& star : stars)
+    {
+        vec3 direction;
+        do
+            direction = vec3(signedDist(rng), signedDist(rng), signedDist(rng));
+        while (dot(direction, direction) > 1.0f || dot(direction, direction) < 1e-4f);
+        vec3 position = normalize(direction) * gSpaceScale;
+        position.setY(position.getY() - gPlanetRadius);
+        float size = unitDist(rng) * 1.1f + 0.5f;
+        size *= size;
+        star.ParticlePositions = vec4(position, 1.0f);
+        star.ParticleColors = vec4(1.0f, 1.0f, 1.0f, (unitDist(rng) * 0.9f + 0.1f) * 1.5f);
+        star.ParticleInfo = vec4(5000.0f, size * 100000.0f, unitDist(rng), unitDist(rng));
+    }
+
+    StarFieldDesc desc = {};
+    desc.pStars = stars.data();
+    desc.mStarCount = gStarCount;
+    desc.mCenter = vec3(0.0f, -gPlanetRadius, 0.0f);
+    StarField field = {};
+    initStarField(&desc, &field);
+    CHECK(field.mStarCount == gStarCount && field.mBinCount == 6 * 16 * 16);
+
+    desc.mThreadCount = 1;
+    StarField serialField = {};
+    initStarField(&desc, &serialField);
+    CHECK(serialField.mBinCount == field.mBinCount);
+    CHECK(!memcmp(serialField.pStars, field.pStars, sizeof(ParticleData) * gStarCount));
+    CHECK(!memcmp(serialField.pBinOffsets, field.pBinOffsets, sizeof(uint32_t) * (field.mBinCount + 1)));
+    CHECK(!memcmp(serialField.pBinBounds, field.pBinBounds, sizeof(vec4) * field.mBinCount));
+    exitStarField(&serialField);
+
+    //	Every star is kept once, sorted brightest first inside its bin and inside the bounds of the bin
+    CHECK(field.pBinOffsets[0] == 0 && field.pBinOffsets[field.mBinCount] == gStarCount);
+    float maxBrightness = 0.0f;
+    for (const ParticleData& star : stars)
+        maxBrightness = max(maxBrightness, getStarBrightness(&star));
+    CHECK(field.mMaxBrightness == maxBrightness);
+    for (uint32_t bin = 0; bin < field.mBinCount; ++bin)
+    {
+        CHECK(field.pBinOffsets[bin] <= field.pBinOffsets[bin + 1]);
+        const vec4& bounds = field.pBinBounds[bin];
+        for (uint32_t i = field.pBinOffsets[bin]; i < field.pBinOffsets[bin + 1]; ++i)
+        {
+            CHECK(field.pBrightness[i] == getStarBrightness(&field.pStars[i]));
+            CHECK(i == field.pBinOffsets[bin] || field.pBrightness[i] <= field.pBrightness[i - 1]);
+            const float distance = length(field.pStars[i].ParticlePositions.getXYZ() - bounds.getXYZ());
+            CHECK(distance <= bounds.getW() * (1.0f + 1e-5f));
+        }
+    }
+    std::vector<StarKey> expected;
+    std::vector<StarKey> actual;
+    for (uint32_t i = 0; i < gStarCount; ++i)
+    {
+        expected.push_back(getStarKey(stars[i]));
+        actual.push_back(getStarKey(field.pStars[i]));
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    CHECK(expected == actual);
+
+    std::vector<ParticleData> visible(gStarCount);
+    uint64_t                  totalVisibleCount = 0;
+    for (uint32_t frame = 0; frame < gFrameCount; ++frame)
+    {
+        StarFieldCullDesc cullDesc = {};
+        cullDesc.mRotMat = getRotMat(unitDist(rng) * 2.0f * PI, unitDist(rng) * 2.0f * PI);
+        cullDesc.mViewProjMat = getViewProjMat(unitDist(rng) * 2.0f * PI, signedDist(rng) * 1.5f,
+                                               vec3(signedDist(rng) * 1e5f, 1000.0f + unitDist(rng) * 1e5f, signedDist(rng) * 1e5f));
+        cullDesc.mMinBrightness = (frame % 4) ? unitDist(rng) * 0.5f : 0.0f;
+        const uint32_t visibleCount = cullStarField(&field, &cullDesc, visible.data());
+        CHECK(visibleCount < gStarCount);
+        totalVisibleCount += visibleCount;
+
+        //	Brute force: every star in its original order
+        StarFieldFrustum frustum;
+        getStarFieldFrustum(&cullDesc, &frustum);
+        const mat4 starToClip = cullDesc.mViewProjMat * cullDesc.mRotMat;
+        expected.clear();
+        for (const ParticleData& star : stars)
+        {
+            const bool bBright = getStarBrightness(&star) >= cullDesc.mMinBrightness * field.mMaxBrightness;
+            if (bBright && isStarInFrustum(&frustum, &star))
+                expected.push_back(getStarKey(star));
+
+            //	The plane test is conservative: a star whose center is on screen is never culled
+            const vec4 clip = starToClip * star.ParticlePositions;
+            if (clip.getW() > 0.0f && fabsf(clip.getX()) < clip.getW() && fabsf(clip.getY()) < clip.getW())
+                CHECK(isStarInFrustum(&frustum, &star));
+        }
+
+        actual.clear();
+        for (uint32_t i = 0; i < visibleCount; ++i)
+            actual.push_back(getStarKey(visible[i]));
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        CHECK(expected == actual);
+    }
+    CHECK(totalVisibleCount > 0);
+
+    exitStarField(&field);
+    return TEST_RESULT();
+}
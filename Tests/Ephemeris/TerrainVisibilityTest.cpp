@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Hierarchical terrain culling against testing every segment on its own, from cameras on the ground up to orbit. Runs are sorted
+//	and merged, segments with a vertex on screen are never culled, and the horizon only culls segments the planet hides entirely.
+
+#include "../../Ephemeris/Terrain/src/Hemisphere.h"
+
+#include <random>
+#include <vector>
+
+#include "TestCommon.h"
+
+static const uint32_t gHeightMapSize = 200;
+static const float    gPlanetRadius = 6360000.0f;
+static const uint32_t gRingCount = 10;
+static const uint32_t gGridDimension = 65;
+static const uint32_t gCameraCount = 1000;
+
+static bool writeHeightMap(const char* fileName)
+{
+    float* pHeights = (float*)tf_malloc(sizeof(float) * gHeightMapSize * gHeightMapSize);
+    for (uint32_t row = 0; row < gHeightMapSize; ++row)
+        for (uint32_t col = 0; col < gHeightMapSize; ++col)
+            pHeights[row * gHeightMapSize + col] = 0.5f + 0.25f * sinf(col * 0.13f) * cosf(row * 0.21f);
+
+    FileStream stream = {};
+    bool       bResult = fsOpenStreamFromPath(RD_TEXTURES, fileName, FM_WRITE, &stream);
+    if (bResult)
+    {
+        bResult = fsWriteToStream(&stream, pHeights, sizeof(float) * gHeightMapSize * gHeightMapSize) ==
+                  sizeof(float) * gHeightMapSize * gHeightMapSize;
+        fsCloseStream(&stream);
+    }
+    tf_free(pHeights);
+    return bResult;
+}
+
+//	Left handed, depth from 0 at the near plane to w at the far plane like getFrustumFromMatrix expects
+static mat4 getViewProjMat(const vec3& eye, const vec3& forward)
+{
+    const vec3  right = normalize(cross(vec3(0.0f, 1.0f, 0.0f), forward));
+    const vec3  up = cross(forward, right);
+    const mat4  view(vec4(right.getX(), up.getX(), forward.getX(), 0.0f), vec4(right.getY(), up.getY(), forward.getY(), 0.0f),
+                     vec4(right.getZ(), up.getZ(), forward.getZ(), 0.0f), vec4(-dot(right, eye), -dot(up, eye), -dot(forward, eye), 1.0f));
+    const float zNear = 50.0f;
+    const float zFar = 1e8f;
+    const float scaleX = 1.0f / tanf(PI / 6.0f);
+    const mat4  proj(vec4(scaleX, 0.0f, 0.0f, 0.0f), vec4(0.0f, scaleX * 16.0f / 9.0f, 0.0f, 0.0f),
+                     vec4(0.0f, 0.0f, zFar / (zFar - zNear), 1.0f), vec4(0.0f, 0.0f, -zNear * zFar / (zFar - zNear), 0.0f));
+    return proj * view;
+}
+
+//	The segment from the eye to the point enters the planet before reaching it, in double
+static bool isHiddenByPlanet(const vec3& eye, const float3& point)
+{
+    const double ox = eye.getX();
+    const double oy = (double)eye.getY() + gPlanetRadius;
+    const double oz = eye.getZ();
+    const double dx = point.x - ox;
+    const double dy = ((double)point.y + gPlanetRadius) - oy;
+    const double dz = point.z - oz;
+    const double a = dx * dx + dy * dy + dz * dz;
+    const double b = 2.0 * (ox * dx + oy * dy + oz * dz);
+    const double c = ox * ox + oy * oy + oz * oz - (double)gPlanetRadius * gPlanetRadius;
+    const double discriminant = b * b - 4.0 * a * c;
+    if (discriminant < 0.0)
+        return false;
+    const double t = (-b - sqrt(discriminant)) / (2.0 * a);
+    return t > 0.0 && t < 1.0;
+}
+
+static void markRuns(const TerrainSegmentRun* pRuns, uint32_t runCount, std::vector<char>& visible)
+{
+    std::fill(visible.begin(), visible.end(), 0);
+    for (uint32_t r = 0; r < runCount; ++r)
+    {
+        //	Sorted, and adjacent runs are merged
+        CHECK(pRuns[r].segmentCount > 0);
+        CHECK(!r || pRuns[r - 1].firstSegment + pRuns[r - 1].segmentCount < pRuns[r].firstSegment);
+        for (uint32_t s = 0; s < pRuns[r].segmentCount; ++s)
+            visible[pRuns[r].firstSegment + s] = 1;
+    }
+}
+
+int main()
+{
+    CHECK(createTestResourceDirectory() != NULL);
+    CHECK(writeHeightMap("height.r32"));
+    HeightData heightData("height.r32", HEIGHT_DATA_RAW);
+    CHECK(heightData.isLoaded());
+
+    uint32_t            vertexCount = 0;
+    TerrainVertex*      pVertices = NULL;
+    uint32_t            segmentCount = 0;
+    MeshSegment*        pSegments = NULL;
+    Buffer*             pIndexBuffer = NULL;
+    uint32_t            nodeCount = 0;
+    TerrainSegmentNode* pNodes = NULL;
+    HemisphereBuilder   builder;
+    builder.build(NULL, &heightData, gPlanetRadius, 1.0f, 64, gRingCount, gGridDimension, &vertexCount, &pVertices, &segmentCount,
+                  &pSegments, &pIndexBuffer, &nodeCount, &pNodes);
+    const uint32_t* pIndices = (const uint32_t*)pIndexBuffer->pCpuMappedAddress;
+
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<TerrainSegmentRun>        runs(segmentCount);
+    std::vector<char>                     visible(segmentCount);
+    uint32_t                              horizonEnabledCount = 0;
+    uint32_t                              horizonCulledCount = 0;
+    uint64_t                              visibleCount = 0;
+
+    for (uint32_t camera = 0; camera < gCameraCount; ++camera)
+    {
+        //	On the ground, in the clouds, in the stratosphere and in orbit
+        const float heights[4] = { 2.0f + dist(rng) * 100.0f, 500.0f + dist(rng) * 20000.0f, 20000.0f + dist(rng) * 500000.0f,
+                                   1e6f + dist(rng) * 2e7f };
+        const float angle = dist(rng) * 2.0f * PI;
+        const float distance = dist(rng) * (camera % 8 == 7 ? 3e6f : 2e4f);
+        const vec3  eye(cosf(angle) * distance, heights[camera % 4], sinf(angle) * distance);
+        const float yaw = dist(rng) * 2.0f * PI;
+        const float pitch = (dist(rng) - 0.7f) * 3.0f;
+        const vec3  forward(cosf(yaw) * cosf(pitch), sinf(pitch), sinf(yaw) * cosf(pitch));
+        const mat4  viewProj = getViewProjMat(eye, forward);
+
+        TerrainFrustum frustum;
+        getFrustumFromMatrix(viewProj, frustum);
+        TerrainHorizon horizon;
+        getTerrainHorizon(eye, vec3(0.0f, -gPlanetRadius, 0.0f), gPlanetRadius, horizon);
+        horizonEnabledCount += horizon.enabled;
+
+        //	Frustum only: exactly the segments whose box intersects
+        uint32_t runCount = cullTerrainSegments(pNodes, frustum, NULL, runs.data());
+        markRuns(runs.data(), runCount, visible);
+        for (uint32_t s = 0; s < segmentCount; ++s)
+            CHECK(visible[s] == (char)boxIntersects(frustum, pSegments[s].boundingBox));
+
+        //	A vertex well inside the clip volume keeps its segment
+        for (uint32_t s = 0; s < segmentCount; ++s)
+        {
+            if (visible[s])
+                continue;
+            const MeshSegment& segment = pSegments[s];
+            for (uint32_t i = segment.firstIndex; i < segment.firstIndex + segment.indexCount; ++i)
+            {
+                const vec4 clip = viewProj * vec4(f3Tov3(pVertices[pIndices[i]].wsPos), 1.0f);
+                const float w = clip.getW() * 0.99f;
+                CHECK(!(w > 0.0f && fabsf(clip.getX()) < w && fabsf(clip.getY()) < w && clip.getZ() > 0.01f * w && clip.getZ() < w));
+            }
+        }
+
+        //	With the horizon: every segment on its own, and the culled ones are hidden by the planet
+        runCount = cullTerrainSegments(pNodes, frustum, &horizon, runs.data());
+        markRuns(runs.data(), runCount, visible);
+        for (uint32_t s = 0; s < segmentCount; ++s)
+        {
+            const bool bInFrustum = boxIntersects(frustum, pSegments[s].boundingBox);
+            const bool bVisible = bInFrustum && !isBoxBelowHorizon(horizon, pSegments[s].boundingBox);
+            CHECK(visible[s] == (char)bVisible);
+            visibleCount += bVisible;
+
+            if (bInFrustum && !bVisible)
+            {
+                ++horizonCulledCount;
+                const MeshSegment& segment = pSegments[s];
+                for (uint32_t i = segment.firstIndex; i < segment.firstIndex + segment.indexCount; ++i)
+                    CHECK(isHiddenByPlanet(eye, pVertices[pIndices[i]].wsPos));
+            }
+        }
+    }
+
+    printf("horizon enabled for %u of %u cameras, %u segments culled by it, %.1f visible segments per camera\n", horizonEnabledCount,
+           gCameraCount, horizonCulledCount, (double)visibleCount / gCameraCount);
+    CHECK(horizonEnabledCount > 0 && horizonCulledCount > 0 && visibleCount > 0);
+
+    removeResource(pIndexBuffer);
+    tf_free(pVertices);
+    tf_free(pSegments);
+    tf_free(pNodes);
+    removeTestResourceDirectory();
+    return TEST_RESULT();
+}
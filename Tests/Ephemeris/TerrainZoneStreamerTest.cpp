@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This is a part of Ephemeris.
+ * This file(code) is licensed under a Creative Commons Attribution-NonCommercial 4.0 International License
+ * (https://creativecommons.org/licenses/by-nc/4.0/legalcode) Based on a work at https://github.com/ConfettiFX/The-Forge. You can not use
+ * this code for commercial purposes.
+ *
+ */
+
+//	Terrain zones generated on the workers are the vertices Terrain used to generate inline. Every requested zone arrives exactly
+//	once, one worker generates them nearest first, and replacing the requests drops the zones nobody asks for anymore. A scripted
+//	camera path through the zone set of Terrain keeps the resident zones in budget, never evicts a zone the GPU may still read,
+//	never generates a zone that is resident again, and its per frame update doesn't wait for zones to be generated.
+
+#include "../../Ephemeris/Terrain/src/TerrainZoneStreamer.h"
+#include "../../Ephemeris/src/Perlin.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "TestCommon.h"
+
+static const int32_t  gLegacyTileCenter = 50;
+static const int32_t  gGridSize = 17;
+//	Zones on the camera path take a few milliseconds to generate, much longer than an update
+static const uint32_t gPathGridSize = 33;
+static const uint32_t gResidentBudget = 32;
+static const uint32_t gFramesInFlight = 3;
+
+//	The inline generation of Terrain with GRID_SIZE as a parameter, zone X of the old zone map is zone X - TILE_CENTER of the streamer
+static void generateLegacyZone(uint32_t gridSize, int32_t X, int32_t Z, std::vector<float>& posAndUVs)
+{
+    const int32_t XInit = (X - gLegacyTileCenter) * (int32_t)gridSize;
+    const int32_t ZInit = (Z - gLegacyTileCenter) * (int32_t)gridSize;
+    const float   gap = (float)gridSize / (float)(gridSize - 1);
+
+    float i = (float)XInit;
+    for (uint32_t X_index = 0; X_index < gridSize; X_index++)
+    {
+        float j = (float)ZInit;
+        for (uint32_t Z_index = 0; Z_index < gridSize; Z_index++)
+        {
+            posAndUVs.push_back(i * OVERALLSCALE);
+            posAndUVs.push_back(Perlin::perlinNoise2D((i + (float)gLegacyTileCenter) * 0.125f, (j + (float)gLegacyTileCenter) * 0.125f) *
+                                OVERALLSCALE);
+            posAndUVs.push_back(j * OVERALLSCALE);
+            posAndUVs.push_back((j - ZInit) / gridSize);
+            posAndUVs.push_back((i - XInit) / gridSize);
+            j += gap;
+        }
+        i += gap;
+    }
+}
+
+//	Workers push in front, so every popped batch is reversed to get the order the zones were finished in
+static void popInOrder(TerrainZoneStreamer* pStreamer, std::vector<TerrainZoneData*>& zones)
+{
+    const size_t first = zones.size();
+    for (TerrainZoneData* pZone = popFinishedTerrainZones(pStreamer); pZone; pZone = pZone->pNext)
+        zones.push_back(pZone);
+    std::reverse(zones.begin() + first, zones.end());
+}
+
+static bool isIdle(TerrainZoneStreamer* pStreamer)
+{
+    acquireMutex(&pStreamer->mMutex);
+    bool bIdle = pStreamer->mRequestCount == 0;
+    for (uint32_t t = 0; t < pStreamer->mThreadCount; ++t)
+        bIdle = bIdle && !pStreamer->mBusy[t];
+    releaseMutex(&pStreamer->mMutex);
+    return bIdle;
+}
+
+//	Workers push a zone before they stop being busy, so once idle every generated zone is in the finished list
+static bool waitForIdle(TerrainZoneStreamer* pStreamer)
+{
+    const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (!isIdle(pStreamer))
+    {
+        if (std::chrono::steady_clock::now() > timeout)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static bool isGenerated(const TerrainZoneStreamerDesc& desc, const TerrainZoneData* pZone, std::vector<float>& scratch)
+{
+    scratch.resize(desc.mGridSize * desc.mGridSize * TERRAIN_ZONE_VERTEX_FLOATS);
+    generateTerrainZone(&desc, pZone->mX, pZone->mZ, scratch.data());
+    return !memcmp(scratch.data(), pZone->pPosAndUVs, scratch.size() * sizeof(float));
+}
+
+static void freeZones(std::vector<TerrainZoneData*>& zones)
+{
+    for (TerrainZoneData* pZone : zones)
+        freeTerrainZoneData(pZone);
+    zones.clear();
+}
+
+//	What the renderer sees of the zone set through its callbacks
+struct ZoneTracker
+{
+    TerrainZoneSet*                        pSet;
+    std::unordered_set<uint64_t>           resident;
+    std::unordered_map<uint64_t, uint32_t> addedCount;
+    std::unordered_map<uint64_t, uint32_t> removedCount;
+    uint32_t                               errorCount;
+};
+
+static void addZoneResource(void* pUserData, TerrainZone* pZone)
+{
+    ZoneTracker*   pTracker = (ZoneTracker*)pUserData;
+    const uint64_t key = getTerrainZoneKey(pZone->mX, pZone->mZ);
+    //	A zone is generated again only after it was evicted
+    pTracker->errorCount += !pTracker->resident.insert(key).second;
+    pTracker->errorCount += pZone->pData->mX != pZone->mX || pZone->pData->mZ != pZone->mZ;
+    const auto removed = pTracker->removedCount.find(key);
+    pTracker->errorCount += ++pTracker->addedCount[key] > (removed == pTracker->removedCount.end() ? 0 : removed->second) + 1;
+    pZone->pResource = pZone->pData;
+}
+
+static void removeZoneResource(void* pUserData, TerrainZone* pZone)
+{
+    ZoneTracker*   pTracker = (ZoneTracker*)pUserData;
+    const uint64_t key = getTerrainZoneKey(pZone->mX, pZone->mZ);
+    pTracker->errorCount += pTracker->resident.erase(key) != 1 || pZone->pResource != pZone->pData;
+    ++pTracker->removedCount[key];
+    //	Not drawn during the frames in flight, unless the whole set goes away
+    if (pTracker->pSet)
+        pTracker->errorCount += pZone->mLastUsedFrame + gFramesInFlight >= pTracker->pSet->mFrame;
+}
+
+static uint32_t countResidentZones(const TerrainZoneSet& set)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < set.mZoneCount; ++i)
+        count += set.pZones[i].mResident;
+    return count;
+}
+
+static double getSeconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//	Updates the set with the camera at (x, z) until every zone around it is resident
+static bool waitForZonesAround(TerrainZoneSet* pSet, TerrainZoneStreamer* pStreamer, float x, float z)
+{
+    const uint32_t areaSize = 2 + 2 * (uint32_t)pSet->mDesc.mPrefetchRadius;
+    const auto     timeout = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    for (;;)
+    {
+        updateTerrainZones(pSet, pStreamer, x, z);
+        uint32_t residentCount = 0;
+        for (uint32_t i = 0; i < pSet->mZoneCount; ++i)
+            residentCount += pSet->pZones[i].mResident && pSet->pZones[i].mLastUsedFrame == pSet->mFrame;
+        if (residentCount == areaSize * areaSize)
+            return true;
+        if (std::chrono::steady_clock::now() > timeout)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static void runCameraPath()
+{
+    const TerrainZoneStreamerDesc streamerDesc = { gPathGridSize, OVERALLSCALE, (float)gLegacyTileCenter, 0 };
+    const float                   zoneSize = gPathGridSize * OVERALLSCALE;
+
+    //	Generating a zone on this thread, what an update would take if it waited for one
+    std::vector<float> scratch(gPathGridSize * gPathGridSize * TERRAIN_ZONE_VERTEX_FLOATS);
+    auto               start = std::chrono::steady_clock::now();
+    generateTerrainZone(&streamerDesc, 1000, 1000, scratch.data());
+    const double generateTime = getSeconds(start);
+
+    TerrainZoneStreamer streamer;
+    initTerrainZoneStreamer(&streamerDesc, &streamer);
+
+    ZoneTracker        tracker = {};
+    TerrainZoneSet     set;
+    TerrainZoneSetDesc setDesc = {};
+    setDesc.mZoneSize = zoneSize;
+    setDesc.mPrefetchRadius = 1;
+    setDesc.mResidentBudget = gResidentBudget;
+    setDesc.mFramesInFlight = gFramesInFlight;
+    setDesc.pAddResource = addZoneResource;
+    setDesc.pRemoveResource = removeZoneResource;
+    setDesc.pUserData = &tracker;
+    initTerrainZoneSet(&setDesc, &set);
+    tracker.pSet = &set;
+
+    //	Back and forth over two zones while the zones catch up: every zone fits in the budget and is generated exactly once
+    for (uint32_t frame = 0; frame < 64; ++frame)
+    {
+        const float x = zoneSize * 2.0f * fabsf(sinf((float)frame * 0.1f));
+        CHECK(waitForZonesAround(&set, &streamer, x, 0.0f));
+    }
+    CHECK(tracker.removedCount.empty() && set.mDroppedCount == 0);
+    for (const auto& added : tracker.addedCount)
+        CHECK(added.second == 1);
+
+    //	A long flight at up to a quarter zone per frame with a turn and a way back, paced like frames and never waiting for zones
+    std::vector<double> updateTimes;
+    float               x = 0.0f;
+    float               z = 0.0f;
+    for (uint32_t frame = 0; frame < 600; ++frame)
+    {
+        const float heading = frame < 200 ? 0.0f : (frame < 400 ? 1.2f : 3.6f);
+        x += 0.25f * zoneSize * cosf(heading);
+        z += 0.25f * zoneSize * sinf(heading);
+
+        start = std::chrono::steady_clock::now();
+        updateTerrainZones(&set, &streamer, x, z);
+        updateTimes.push_back(getSeconds(start));
+
+        CHECK(set.mResidentCount <= gResidentBudget);
+        CHECK(set.mResidentCount == countResidentZones(set) && set.mResidentCount == tracker.resident.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(waitForZonesAround(&set, &streamer, x, z));
+    CHECK(set.mResidentCount <= gResidentBudget);
+    CHECK(!tracker.removedCount.empty());
+
+    std::sort(updateTimes.begin(), updateTimes.end());
+    const double typicalUpdateTime = updateTimes[updateTimes.size() * 95 / 100];
+    printf("camera path: %zu zones generated, %u dropped, update %.3f ms (95%%) %.3f ms (max), zone generation %.3f ms\n",
+           tracker.addedCount.size(), set.mDroppedCount, typicalUpdateTime * 1e3, updateTimes.back() * 1e3, generateTime * 1e3);
+    CHECK(typicalUpdateTime < generateTime);
+
+    exitTerrainZoneStreamer(&streamer);
+    tracker.pSet = NULL;
+    exitTerrainZoneSet(&set);
+    CHECK(tracker.resident.empty());
+    CHECK(tracker.errorCount == 0);
+}
+
+int main()
+{
+    //	The grid size of Terrain once, smaller zones elsewhere
+    const int32_t      legacyZones[][3] = { { 256, 0, 0 }, { gGridSize, -1, 2 }, { gGridSize, 3, -4 } };
+    std::vector<float> scratch;
+    for (const int32_t* pZone : legacyZones)
+    {
+        const TerrainZoneStreamerDesc legacyDesc = { (uint32_t)pZone[0], OVERALLSCALE, (float)gLegacyTileCenter, 1 };
+        std::vector<float>            expected;
+        generateLegacyZone(legacyDesc.mGridSize, pZone[1] + gLegacyTileCenter, pZone[2] + gLegacyTileCenter, expected);
+        scratch.resize(legacyDesc.mGridSize * legacyDesc.mGridSize * TERRAIN_ZONE_VERTEX_FLOATS);
+        generateTerrainZone(&legacyDesc, pZone[1], pZone[2], scratch.data());
+        CHECK(expected.size() == scratch.size() && !memcmp(expected.data(), scratch.data(), scratch.size() * sizeof(float)));
+    }
+
+    //	Negative coordinates don't collide, and zones ahead win over zones as far behind
+    CHECK(getTerrainZoneKey(-1, 0) != getTerrainZoneKey(0, -1));
+    CHECK(getTerrainZoneKey(1, 11) != getTerrainZoneKey(11, 1));
+    CHECK(getTerrainZonePriority(100.0f, 0.0f, 1.0f, 0.0f) < getTerrainZonePriority(-100.0f, 0.0f, 1.0f, 0.0f));
+    CHECK(getTerrainZonePriority(50.0f, 0.0f, 1.0f, 0.0f) < getTerrainZonePriority(100.0f, 0.0f, 1.0f, 0.0f));
+
+    //	A 9x9 block around the camera moving along +x
+    std::vector<TerrainZoneRequest> requests;
+    for (int32_t z = -4; z <= 4; ++z)
+        for (int32_t x = -4; x <= 4; ++x)
+            requests.push_back({ x, z, getTerrainZonePriority((float)x, (float)z, 1.0f, 0.0f) });
+
+    const uint32_t threadCounts[] = { 1, 3, 0 };
+    for (uint32_t threadCount : threadCounts)
+    {
+        const TerrainZoneStreamerDesc desc = { (uint32_t)gGridSize, OVERALLSCALE, (float)gLegacyTileCenter, threadCount };
+        TerrainZoneStreamer           streamer;
+        initTerrainZoneStreamer(&desc, &streamer);
+        CHECK(streamer.mThreadCount >= 1 && streamer.mThreadCount <= TERRAIN_ZONE_MAX_THREADS);
+
+        //	Asking again while the zones are generated or waiting to be taken doesn't generate them twice
+        std::vector<TerrainZoneData*> zones;
+        requestTerrainZones(&streamer, requests.data(), (uint32_t)requests.size());
+        for (uint32_t i = 0; i < 20; ++i)
+        {
+            requestTerrainZones(&streamer, requests.data(), (uint32_t)requests.size());
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        CHECK(waitForIdle(&streamer));
+        popInOrder(&streamer, zones);
+        CHECK(zones.size() == requests.size());
+
+        std::vector<char> arrived(requests.size());
+        for (TerrainZoneData* pZone : zones)
+        {
+            CHECK(pZone->mX >= -4 && pZone->mX <= 4 && pZone->mZ >= -4 && pZone->mZ <= 4);
+            arrived[(pZone->mZ + 4) * 9 + pZone->mX + 4]++;
+            CHECK(isGenerated(desc, pZone, scratch));
+        }
+        for (char count : arrived)
+            CHECK(count == 1);
+
+        //	The heap is built before a worker can take from it, so one worker finishes the zones nearest first
+        if (streamer.mThreadCount == 1)
+        {
+            for (size_t i = 1; i < zones.size(); ++i)
+                CHECK(getTerrainZonePriority((float)zones[i - 1]->mX, (float)zones[i - 1]->mZ, 1.0f, 0.0f) <=
+                      getTerrainZonePriority((float)zones[i]->mX, (float)zones[i]->mZ, 1.0f, 0.0f));
+        }
+        freeZones(zones);
+
+        //	Replacing the requests drops the pending ones: only the new requests are left, the far zones taken in between finish,
+        //	and nothing arrives once the workers are idle
+        std::vector<TerrainZoneRequest> farRequests;
+        for (int32_t x = 100; x < 356; ++x)
+            farRequests.push_back({ x, 100, (float)x });
+        requestTerrainZones(&streamer, farRequests.data(), (uint32_t)farRequests.size());
+        requestTerrainZones(&streamer, requests.data(), 4);
+        acquireMutex(&streamer.mMutex);
+        CHECK(streamer.mRequestCount <= 4);
+        for (uint32_t i = 0; i < streamer.mRequestCount; ++i)
+            CHECK(streamer.pRequests[i].mZ != 100);
+        releaseMutex(&streamer.mMutex);
+
+        CHECK(waitForIdle(&streamer));
+        popInOrder(&streamer, zones);
+        uint32_t keptCount = 0;
+        for (TerrainZoneData* pZone : zones)
+        {
+            CHECK(isGenerated(desc, pZone, scratch));
+            keptCount += pZone->mZ != 100;
+        }
+        CHECK(keptCount == 4);
+        freeZones(zones);
+        CHECK(isIdle(&streamer));
+        CHECK(!popFinishedTerrainZones(&streamer));
+
+        //	Exiting with pending requests and zones nobody took
+        requestTerrainZones(&streamer, farRequests.data(), (uint32_t)farRequests.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        exitTerrainZoneStreamer(&streamer);
+    }
+
+    runCameraPath();
+
+    return TEST_RESULT();
+}